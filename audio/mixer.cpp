@@ -22,11 +22,13 @@
 
 #include "gui/EventRecorder.h"
 
+#include "common/config-manager.h"
 #include "common/util.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 
 #include "audio/mixer_intern.h"
+#include "audio/prefetch.h"
 #include "audio/rate.h"
 #include "audio/audiostream.h"
 #include "audio/timestamp.h"
@@ -38,13 +40,18 @@ namespace Audio {
 #pragma mark --- Channel classes ---
 #pragma mark -
 
+static Timestamp calcElapsedTime(uint rate, uint32 samplesConsumed, uint32 mixerTimeStamp,
+                                 uint32 pauseStartTime, uint32 pauseTime, bool paused);
+
 
 /**
  * Channel used by the default Mixer implementation.
  */
 class Channel {
+	friend class MixerImpl;
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent,
+	        RateConverterQuality quality);
 	~Channel();
 
 	/**
@@ -54,14 +61,16 @@ public:
 	 * @param len  number of sample *pairs*. So a value of
 	 *             10 means that the buffer contains twice 10 sample, each
 	 *             16 bits, for a total of 40 bytes.
+	 * @param decodeMicros if not 0, receives the time spent reading the
+	 *             stream (in microseconds)
 	 * @return number of sample pairs processed (which can still be silence!)
 	 */
-	int mix(int16 *data, uint len);
+	int mix(int16 *data, uint len, uint32 *decodeMicros = 0);
 
 	/**
 	 * Queries whether the channel is still playing or not.
 	 */
-	bool isFinished() const { return _stream->endOfStream(); }
+	bool isFinished() const { return _stream->endOfStream() && !_converter->hasPendingOutput(); }
 
 	/**
 	 * Queries whether the channel is a permanent channel.
@@ -88,6 +97,11 @@ public:
 	 */
 	bool isPaused() const { return (_pauseLevel != 0); }
 
+	/**
+	 * Returns how often the channel is currently paused.
+	 */
+	int getPauseLevel() const { return _pauseLevel; }
+
 	/**
 	 * Sets the channel's own volume.
 	 *
@@ -169,29 +183,119 @@ private:
 	Common::DisposablePtr<AudioStream> _stream;
 };
 
+/**
+ * Forwards to another stream, adding up the time spent reading from it.
+ * Used by the mixer profiling to tell decoding from resampling costs.
+ */
+class TimedAudioStream : public AudioStream {
+public:
+	TimedAudioStream(AudioStream &stream) : _stream(stream), _micros(0) {}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		const uint32 start = g_system->getMicros();
+		const int samples = _stream.readBuffer(buffer, numSamples);
+		_micros += g_system->getMicros() - start;
+		return samples;
+	}
+
+	bool isStereo() const { return _stream.isStereo(); }
+	int getRate() const { return _stream.getRate(); }
+	bool endOfData() const { return _stream.endOfData(); }
+	bool endOfStream() const { return _stream.endOfStream(); }
+
+	uint32 getMicros() const { return _micros; }
+
+private:
+	AudioStream &_stream;
+	uint32 _micros;
+};
+
 #pragma mark -
 #pragma mark --- Mixer ---
 #pragma mark -
 
 // TODO: parameter "system" is unused
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings(),
+	  _prefetch(0), _resamplingQuality(kRateConverterQualityFast), _commandQueueMode(false) {
 
 	assert(sampleRate > 0);
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	if (ConfMan.hasKey("resampling_quality")) {
+		const Common::String quality = ConfMan.get("resampling_quality");
+		if (quality.equalsIgnoreCase("best"))
+			_resamplingQuality = kRateConverterQualityBest;
+		else if (quality.equalsIgnoreCase("good"))
+			_resamplingQuality = kRateConverterQualityGood;
+		else if (!quality.equalsIgnoreCase("fast"))
+			warning("Unknown resampling_quality '%s', using 'fast'", quality.c_str());
+	}
+
+	for (int i = 0; i != NUM_CHANNELS; i++) {
 		_channels[i] = 0;
+		_appliedSettings[i] = 0;
+	}
 }
 
 MixerImpl::~MixerImpl() {
+	if (_commandQueueMode) {
+		// Execute whatever is still queued, so that channels which were
+		// never picked up by the mixer callback get freed as well.
+		processCommands();
+		collectRetiredChannels();
+	}
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		delete _channels[i];
+
+	// The channels' streams unregister from the prefetch manager, so it
+	// has to outlive them.
+	delete _prefetch;
 }
 
 void MixerImpl::setReady(bool ready) {
 	_mixerReady = ready;
 }
 
+void MixerImpl::setCommandQueueMode(bool enable) {
+	// Switching while the callback is running would make the engine side
+	// bookkeeping and the actual channels disagree.
+	assert(!_mixerReady);
+	for (int i = 0; i != NUM_CHANNELS; i++)
+		assert(!_channels[i] && _slots[i].status == SlotState::kFree);
+	assert(enable || !_prefetch);
+
+	_commandQueueMode = enable;
+}
+
+void MixerImpl::setPrefetchThreads(uint numThreads) {
+	assert(!_mixerReady);
+	for (int i = 0; i != NUM_CHANNELS; i++)
+		assert(!_channels[i] && _slots[i].status == SlotState::kFree);
+
+	delete _prefetch;
+	_prefetch = 0;
+
+	if (numThreads == 0)
+		return;
+
+	_prefetch = new PrefetchManager(numThreads);
+	if (_prefetch->getThreadCount() == 0) {
+		warning("Audio prefetching disabled: no worker threads available");
+		delete _prefetch;
+		_prefetch = 0;
+		return;
+	}
+
+	// Finished channels must be deleted on the engine side, since deleting
+	// a prefetched stream waits for the worker decoding it
+	_commandQueueMode = true;
+}
+
+uint32 MixerImpl::getPrefetchUnderrunCount() const {
+	return _prefetch ? _prefetch->getUnderrunCount() : 0;
+}
+
 uint MixerImpl::getOutputRate() const {
 	return _sampleRate;
 }
@@ -199,7 +303,7 @@ uint MixerImpl::getOutputRate() const {
 void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 	int index = -1;
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] == 0) {
+		if (_commandQueueMode ? _slots[i].status == SlotState::kFree : _channels[i] == 0) {
 			index = i;
 			break;
 		}
@@ -210,8 +314,6 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 		return;
 	}
 
-	_channels[index] = chan;
-
 	SoundHandle chanHandle;
 	chanHandle._val = index + (_handleSeed * NUM_CHANNELS);
 
@@ -219,6 +321,23 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 	_handleSeed++;
 	if (handle)
 		*handle = chanHandle;
+
+	if (_commandQueueMode) {
+		SlotState &slot = _slots[index];
+		slot.status = SlotState::kPlaying;
+		slot.handle = chanHandle._val;
+		slot.id = chan->getId();
+		slot.type = chan->getType();
+		slot.volume = chan->getVolume();
+		slot.balance = chan->getBalance();
+		slot.pauseLevel = 0;
+		slot.permanent = chan->isPermanent();
+
+		publishSettings(index);
+		postCommand(Command::kPlay, index, chan);
+	} else {
+		_channels[index] = chan;
+	}
 }
 
 void MixerImpl::playStream(
@@ -229,7 +348,7 @@ void MixerImpl::playStream(
 			DisposeAfterUse::Flag autofreeStream,
 			bool permanent,
 			bool reverseStereo) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandQueueMode ? _producerMutex : _mutex);
 
 	if (stream == 0) {
 		warning("stream is 0");
@@ -239,10 +358,14 @@ void MixerImpl::playStream(
 
 	assert(_mixerReady);
 
+	if (_commandQueueMode)
+		collectRetiredChannels();
+
 	// Prevent duplicate sounds
 	if (id != -1) {
 		for (int i = 0; i != NUM_CHANNELS; i++)
-			if (_channels[i] != 0 && _channels[i]->getId() == id) {
+			if (_commandQueueMode ? (_slots[i].status == SlotState::kPlaying && _slots[i].id == id)
+			                      : (_channels[i] != 0 && _channels[i]->getId() == id)) {
 				// Delete the stream if were asked to auto-dispose it.
 				// Note: This could cause trouble if the client code does not
 				// yet expect the stream to be gone. The primary example to
@@ -259,8 +382,14 @@ void MixerImpl::playStream(
 	reverseStereo = !reverseStereo;
 #endif
 
+	// Let the workers decode the stream from now on
+	if (_prefetch) {
+		stream = _prefetch->wrap(stream, autofreeStream);
+		autofreeStream = DisposeAfterUse::YES;
+	}
+
 	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
+	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent, _resamplingQuality);
 	chan->setVolume(volume);
 	chan->setBalance(balance);
 	insertChannel(handle, chan);
@@ -269,9 +398,28 @@ void MixerImpl::playStream(
 int MixerImpl::mixCallback(byte *samples, uint len) {
 	assert(samples);
 
-	Common::StackLock lock(_mutex);
+	const bool profiling = _profile.isEnabled();
+	if (profiling)
+		_profile.beginCallback(g_system->getMicros(), len / 4, _sampleRate);
+
+	int res;
+	if (_commandQueueMode) {
+		// The engine threads never hold anything we need here, so
+		// execute their requests and mix without locking.
+		processCommands();
+		res = mixChannels((int16 *)samples, len);
+	} else {
+		Common::StackLock lock(_mutex);
+		res = mixChannels((int16 *)samples, len);
+	}
+
+	if (profiling)
+		_profile.endCallback(g_system->getMicros(), getPrefetchUnderrunCount());
 
-	int16 *buf = (int16 *)samples;
+	return res;
+}
+
+int MixerImpl::mixChannels(int16 *buf, uint len) {
 	// we store stereo, 16-bit samples
 	assert(len % 4 == 0);
 	len >>= 2;
@@ -282,25 +430,217 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	//  zero the buf
 	memset(buf, 0, 2 * len * sizeof(int16));
 
+	const bool profiling = _profile.isEnabled();
+
 	// mix all channels
 	int res = 0, tmp;
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i]) {
 			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = 0;
+				removeChannel(i);
 			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
+				tmp = profiling ? mixChannel(i, buf, len) : _channels[i]->mix(buf, len);
 
 				if (tmp > res)
 					res = tmp;
+
+				if (_commandQueueMode)
+					publishTiming(i);
 			}
 		}
 
+		if (profiling && !_channels[i])
+			_profile.setChannelInactive(i);
+	}
+
 	return res;
 }
 
+int MixerImpl::mixChannel(int index, int16 *buf, uint len) {
+	Channel *chan = _channels[index];
+	uint32 decodeMicros = 0;
+
+	const uint32 start = g_system->getMicros();
+	const int res = chan->mix(buf, len, &decodeMicros);
+	const uint32 micros = g_system->getMicros() - start;
+
+	_profile.recordChannel(index, chan->getHandle()._val, chan->getId(), chan->getType(),
+	                       res, decodeMicros, micros);
+	return res;
+}
+
+void MixerImpl::removeChannel(int index) {
+	Channel *chan = _channels[index];
+	_channels[index] = 0;
+
+	// In command queue mode, the engine side deletes the channel (and
+	// with it the stream), keeping the destructors out of the callback.
+	// The engine side only reuses a slot after it got the channel back,
+	// so there is always room for it.
+	if (!_commandQueueMode || !_retiredChannels.push(chan))
+		delete chan;
+}
+
+#pragma mark -
+#pragma mark --- Command queue ---
+#pragma mark -
+
+void MixerImpl::postCommand(Command::Type type, int index, Channel *channel) {
+	Command cmd;
+	cmd.type = type;
+	cmd.index = index;
+	cmd.handle = _slots[index].handle;
+	cmd.channel = channel;
+
+	// The queue is big enough for all commands a slot can have outstanding
+	if (!_commands.push(cmd))
+		error("MixerImpl: Command queue overflow");
+}
+
+void MixerImpl::publishSettings(int index) {
+	const SlotState &slot = _slots[index];
+	SlotSettings &settings = _settings[index];
+
+	// An odd sequence number tells the mixer that an update is in progress
+	settings.sequence++;
+	Common::memoryBarrier();
+	settings.handle = slot.handle;
+	settings.volume = slot.volume;
+	settings.balance = slot.balance;
+	settings.pauseLevel = slot.pauseLevel;
+	Common::memoryBarrier();
+	settings.sequence++;
+}
+
+void MixerImpl::processCommands() {
+	Command cmd;
+	while (_commands.pop(cmd)) {
+		if (cmd.type == Command::kPlay) {
+			assert(!_channels[cmd.index]);
+			_channels[cmd.index] = cmd.channel;
+			_appliedSettings[cmd.index] = 0;
+			publishTiming(cmd.index);
+			continue;
+		}
+
+		// The channel may have finished on its own in the meantime
+		Channel *chan = _channels[cmd.index];
+		if (!chan || chan->getHandle()._val != cmd.handle)
+			continue;
+
+		if (cmd.type == Command::kStop)
+			removeChannel(cmd.index);
+	}
+
+	for (int i = 0; i != NUM_CHANNELS; i++) {
+		if (_channels[i] && _settings[i].sequence != _appliedSettings[i])
+			applySettings(i);
+	}
+}
+
+void MixerImpl::applySettings(int index) {
+	const SlotSettings &settings = _settings[index];
+
+	const uint32 sequence = settings.sequence;
+	Common::memoryBarrier();
+	SlotSettings copy;
+	copy.handle = settings.handle;
+	copy.volume = settings.volume;
+	copy.balance = settings.balance;
+	copy.pauseLevel = settings.pauseLevel;
+	Common::memoryBarrier();
+
+	// Never wait for the engine thread; if it is just changing the
+	// settings, pick them up in the next callback.
+	if ((sequence & 1) || sequence != settings.sequence)
+		return;
+
+	// The settings may already belong to the channel queued next
+	Channel *chan = _channels[index];
+	if (chan->getHandle()._val != copy.handle)
+		return;
+
+	chan->setVolume(copy.volume);
+	chan->setBalance(copy.balance);
+	chan->notifyGlobalVolChange();
+
+	const bool wasPaused = chan->isPaused();
+	while (chan->getPauseLevel() < copy.pauseLevel)
+		chan->pause(true);
+	while (chan->getPauseLevel() > copy.pauseLevel)
+		chan->pause(false);
+	if (chan->isPaused() != wasPaused)
+		publishTiming(index);
+
+	_appliedSettings[index] = sequence;
+}
+
+void MixerImpl::collectRetiredChannels() {
+	Channel *chan;
+	while (_retiredChannels.pop(chan)) {
+		SlotState &slot = _slots[chan->getHandle()._val % NUM_CHANNELS];
+		assert(slot.handle == chan->getHandle()._val);
+		slot.status = SlotState::kFree;
+		delete chan;
+	}
+}
+
+void MixerImpl::publishTiming(int index) {
+	const Channel *chan = _channels[index];
+	TimingSnapshot &timing = _timing[index];
+
+	// An odd sequence number tells readers that an update is in progress
+	timing.sequence++;
+	Common::memoryBarrier();
+	timing.handle = chan->getHandle()._val;
+	timing.samplesConsumed = chan->_samplesConsumed;
+	timing.mixerTimeStamp = chan->_mixerTimeStamp;
+	timing.pauseStartTime = chan->_pauseStartTime;
+	timing.pauseTime = chan->_pauseTime;
+	timing.paused = chan->isPaused();
+	Common::memoryBarrier();
+	timing.sequence++;
+}
+
+MixerImpl::SlotState *MixerImpl::getPlayingSlot(SoundHandle handle) {
+	collectRetiredChannels();
+
+	SlotState *slot = &_slots[handle._val % NUM_CHANNELS];
+	if (slot->status != SlotState::kPlaying || slot->handle != handle._val)
+		return 0;
+	return slot;
+}
+
+void MixerImpl::stopSlot(int index) {
+	_slots[index].status = SlotState::kStopped;
+	postCommand(Command::kStop, index);
+}
+
+void MixerImpl::pauseSlot(int index, bool paused) {
+	// Same as Channel::pause()
+	SlotState &slot = _slots[index];
+	if (paused)
+		slot.pauseLevel++;
+	else if (slot.pauseLevel > 0)
+		slot.pauseLevel--;
+	publishSettings(index);
+}
+
+#pragma mark -
+#pragma mark --- Mixer ---
+#pragma mark -
+
 void MixerImpl::stopAll() {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		collectRetiredChannels();
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_slots[i].status == SlotState::kPlaying && !_slots[i].permanent)
+				stopSlot(i);
+		}
+		return;
+	}
+
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
@@ -311,6 +651,16 @@ void MixerImpl::stopAll() {
 }
 
 void MixerImpl::stopID(int id) {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		collectRetiredChannels();
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_slots[i].status == SlotState::kPlaying && _slots[i].id == id)
+				stopSlot(i);
+		}
+		return;
+	}
+
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != 0 && _channels[i]->getId() == id) {
@@ -321,6 +671,13 @@ void MixerImpl::stopID(int id) {
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		if (getPlayingSlot(handle))
+			stopSlot(handle._val % NUM_CHANNELS);
+		return;
+	}
+
 	Common::StackLock lock(_mutex);
 
 	// Simply ignore stop requests for handles of sounds that already terminated
@@ -336,6 +693,16 @@ void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= type && type < ARRAYSIZE(_soundTypeSettings));
 	_soundTypeSettings[type].mute = mute;
 
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		collectRetiredChannels();
+		for (int i = 0; i != NUM_CHANNELS; ++i) {
+			if (_slots[i].status == SlotState::kPlaying && _slots[i].type == type)
+				publishSettings(i);
+		}
+		return;
+	}
+
 	for (int i = 0; i != NUM_CHANNELS; ++i) {
 		if (_channels[i] && _channels[i]->getType() == type)
 			_channels[i]->notifyGlobalVolChange();
@@ -348,6 +715,16 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		SlotState *slot = getPlayingSlot(handle);
+		if (slot) {
+			slot->volume = volume;
+			publishSettings(handle._val % NUM_CHANNELS);
+		}
+		return;
+	}
+
 	Common::StackLock lock(_mutex);
 
 	const int index = handle._val % NUM_CHANNELS;
@@ -358,6 +735,12 @@ void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		const SlotState *slot = getPlayingSlot(handle);
+		return slot ? slot->volume : 0;
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return 0;
@@ -366,6 +749,16 @@ byte MixerImpl::getChannelVolume(SoundHandle handle) {
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		SlotState *slot = getPlayingSlot(handle);
+		if (slot) {
+			slot->balance = balance;
+			publishSettings(handle._val % NUM_CHANNELS);
+		}
+		return;
+	}
+
 	Common::StackLock lock(_mutex);
 
 	const int index = handle._val % NUM_CHANNELS;
@@ -376,6 +769,12 @@ void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		const SlotState *slot = getPlayingSlot(handle);
+		return slot ? slot->balance : 0;
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return 0;
@@ -388,6 +787,35 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 }
 
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		if (!getPlayingSlot(handle))
+			return Timestamp(0, _sampleRate);
+
+		// Take a consistent copy of what the mixer thread last published
+		const TimingSnapshot &timing = _timing[handle._val % NUM_CHANNELS];
+		TimingSnapshot copy;
+		uint32 sequence;
+		do {
+			sequence = timing.sequence;
+			Common::memoryBarrier();
+			copy.handle = timing.handle;
+			copy.samplesConsumed = timing.samplesConsumed;
+			copy.mixerTimeStamp = timing.mixerTimeStamp;
+			copy.pauseStartTime = timing.pauseStartTime;
+			copy.pauseTime = timing.pauseTime;
+			copy.paused = timing.paused;
+			Common::memoryBarrier();
+		} while ((sequence & 1) || sequence != timing.sequence);
+
+		// The channel has not been picked up by the callback yet
+		if (copy.handle != handle._val)
+			return Timestamp(0, _sampleRate);
+
+		return calcElapsedTime(_sampleRate, copy.samplesConsumed, copy.mixerTimeStamp,
+		                       copy.pauseStartTime, copy.pauseTime, copy.paused);
+	}
+
 	Common::StackLock lock(_mutex);
 
 	const int index = handle._val % NUM_CHANNELS;
@@ -398,6 +826,16 @@ Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
 }
 
 void MixerImpl::pauseAll(bool paused) {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		collectRetiredChannels();
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_slots[i].status == SlotState::kPlaying)
+				pauseSlot(i, paused);
+		}
+		return;
+	}
+
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != 0) {
@@ -407,6 +845,18 @@ void MixerImpl::pauseAll(bool paused) {
 }
 
 void MixerImpl::pauseID(int id, bool paused) {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		collectRetiredChannels();
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_slots[i].status == SlotState::kPlaying && _slots[i].id == id) {
+				pauseSlot(i, paused);
+				return;
+			}
+		}
+		return;
+	}
+
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != 0 && _channels[i]->getId() == id) {
@@ -417,6 +867,13 @@ void MixerImpl::pauseID(int id, bool paused) {
 }
 
 void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		if (getPlayingSlot(handle))
+			pauseSlot(handle._val % NUM_CHANNELS, paused);
+		return;
+	}
+
 	Common::StackLock lock(_mutex);
 
 	// Simply ignore (un)pause requests for sounds that already terminated
@@ -428,12 +885,20 @@ void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
 }
 
 bool MixerImpl::isSoundIDActive(int id) {
-	Common::StackLock lock(_mutex);
-
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		collectRetiredChannels();
+		for (int i = 0; i != NUM_CHANNELS; i++)
+			if (_slots[i].status == SlotState::kPlaying && _slots[i].id == id)
+				return true;
+		return false;
+	}
+
+	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		if (_channels[i] && _channels[i]->getId() == id)
 			return true;
@@ -441,6 +906,12 @@ bool MixerImpl::isSoundIDActive(int id) {
 }
 
 int MixerImpl::getSoundID(SoundHandle handle) {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		const SlotState *slot = getPlayingSlot(handle);
+		return slot ? slot->id : 0;
+	}
+
 	Common::StackLock lock(_mutex);
 	const int index = handle._val % NUM_CHANNELS;
 	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
@@ -449,17 +920,30 @@ int MixerImpl::getSoundID(SoundHandle handle) {
 }
 
 bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
-
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		return getPlayingSlot(handle) != 0;
+	}
+
+	Common::StackLock lock(_mutex);
 	const int index = handle._val % NUM_CHANNELS;
 	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		collectRetiredChannels();
+		for (int i = 0; i != NUM_CHANNELS; i++)
+			if (_slots[i].status == SlotState::kPlaying && _slots[i].type == type)
+				return true;
+		return false;
+	}
+
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		if (_channels[i] && _channels[i]->getType() == type)
@@ -479,6 +963,18 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	// TODO: Maybe we should do logarithmic (not linear) volume
 	// scaling? See also Player_V2::setMasterVolume
 
+	if (_commandQueueMode) {
+		Common::StackLock lock(_producerMutex);
+		_soundTypeSettings[type].volume = volume;
+
+		collectRetiredChannels();
+		for (int i = 0; i != NUM_CHANNELS; ++i) {
+			if (_slots[i].status == SlotState::kPlaying && _slots[i].type == type)
+				publishSettings(i);
+		}
+		return;
+	}
+
 	Common::StackLock lock(_mutex);
 	_soundTypeSettings[type].volume = volume;
 
@@ -500,7 +996,8 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark -
 
 Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
+                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent,
+                 RateConverterQuality quality)
     : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
       _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
       _pauseStartTime(0), _pauseTime(0), _converter(0), _volL(0), _volR(0),
@@ -509,7 +1006,7 @@ Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo);
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo, quality);
 }
 
 Channel::~Channel() {
@@ -580,22 +1077,27 @@ void Channel::pause(bool paused) {
 }
 
 Timestamp Channel::getElapsedTime() {
-	const uint32 rate = _mixer->getOutputRate();
+	return calcElapsedTime(_mixer->getOutputRate(), _samplesConsumed, _mixerTimeStamp,
+	                       _pauseStartTime, _pauseTime, isPaused());
+}
+
+static Timestamp calcElapsedTime(uint rate, uint32 samplesConsumed, uint32 mixerTimeStamp,
+                                 uint32 pauseStartTime, uint32 pauseTime, bool paused) {
 	uint32 delta = 0;
 
 	Audio::Timestamp ts(0, rate);
 
-	if (_mixerTimeStamp == 0)
+	if (mixerTimeStamp == 0)
 		return ts;
 
-	if (isPaused())
-		delta = _pauseStartTime - _mixerTimeStamp;
+	if (paused)
+		delta = pauseStartTime - mixerTimeStamp;
 	else
-		delta = g_system->getMillis(true) - _mixerTimeStamp - _pauseTime;
+		delta = g_system->getMillis(true) - mixerTimeStamp - pauseTime;
 
 	// Convert the number of samples into a time duration.
 
-	ts = ts.addFrames(_samplesConsumed);
+	ts = ts.addFrames(samplesConsumed);
 	ts = ts.addMsecs(delta);
 
 	// In theory it would seem like a good idea to limit the approximation
@@ -607,18 +1109,26 @@ Timestamp Channel::getElapsedTime() {
 	return ts;
 }
 
-int Channel::mix(int16 *data, uint len) {
+int Channel::mix(int16 *data, uint len, uint32 *decodeMicros) {
 	assert(_stream);
 
 	int res = 0;
-	if (_stream->endOfData()) {
+	if (_stream->endOfData() && !_converter->hasPendingOutput()) {
 		// TODO: call drain method
 	} else {
 		assert(_converter);
 		_samplesConsumed = _samplesDecoded;
 		_mixerTimeStamp = g_system->getMillis(true);
 		_pauseTime = 0;
-		res = _converter->flow(*_stream, data, len, _volL, _volR);
+
+		if (decodeMicros) {
+			TimedAudioStream input(*_stream);
+			res = _converter->flow(input, data, len, _volL, _volR);
+			*decodeMicros = input.getMicros();
+		} else {
+			res = _converter->flow(*_stream, data, len, _volL, _volR);
+		}
+
 		_samplesDecoded += res;
 	}
 
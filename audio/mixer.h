@@ -30,6 +30,7 @@ namespace Audio {
 
 class AudioStream;
 class Channel;
+class MixerProfile;
 class Timestamp;
 
 /**
@@ -277,6 +278,15 @@ public:
 	 * @return the output sample rate in Hz
 	 */
 	virtual uint getOutputRate() const = 0;
+
+	/**
+	 * Query the mixer's profiling statistics, e.g. to find out which sounds
+	 * take too long to mix.
+	 *
+	 * @return the profiling statistics, or 0 if the mixer does not support
+	 *         profiling
+	 */
+	virtual MixerProfile *getProfile() { return 0; }
 };
 
 
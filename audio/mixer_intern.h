@@ -25,10 +25,15 @@
 
 #include "common/scummsys.h"
 #include "common/mutex.h"
+#include "common/spsc-queue.h"
 #include "audio/mixer.h"
+#include "audio/mixer_profile.h"
+#include "audio/rate.h"
 
 namespace Audio {
 
+class PrefetchManager;
+
 /**
  * The (default) implementation of the ScummVM audio mixing subsystem.
  *
@@ -42,6 +47,12 @@ namespace Audio {
  * 4) Change the mixer into ready mode via setReady(true).
  * 5) Start audio processing (e.g. by resuming the audio thread, if applicable).
  *
+ * Backends running the mixer callback from a real-time audio thread may
+ * switch the mixer into command queue mode (see setCommandQueueMode()) before
+ * step 4. In that mode the mixer callback never locks a mutex: calls made by
+ * engines are turned into commands which the callback executes before mixing,
+ * and queries are answered from engine side bookkeeping instead.
+ *
  * In the future, we might make it possible for backends to provide
  * (partial) alternative implementations of the mixer, e.g. to make
  * better use of native sound mixing support on low-end devices.
@@ -51,7 +62,8 @@ namespace Audio {
 class MixerImpl : public Mixer {
 private:
 	enum {
-		NUM_CHANNELS = 16
+		// The profile keeps statistics for each channel slot
+		NUM_CHANNELS = MixerProfile::kMaxChannels
 	};
 
 	Common::Mutex _mutex;
@@ -70,6 +82,106 @@ private:
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
 
+	/** Decodes new streams on worker threads, if enabled. */
+	PrefetchManager *_prefetch;
+
+	MixerProfile _profile;
+
+	/** Quality of the rate converters for new channels. */
+	RateConverterQuality _resamplingQuality;
+
+	/**
+	 * A request made by an engine, executed by mixCallback() before mixing.
+	 * Only used in command queue mode. Changes to the settings of a playing
+	 * channel are not queued, but published in a SlotSettings.
+	 */
+	struct Command {
+		enum Type {
+			kPlay,
+			kStop
+		};
+
+		Type type;
+		int index;
+		uint32 handle;
+		Channel *channel;
+	};
+
+	/**
+	 * The engine side view of a channel slot. Only used in command queue
+	 * mode, and only accessed with _producerMutex held.
+	 */
+	struct SlotState {
+		enum Status {
+			kFree,		///< Slot may be reused
+			kPlaying,	///< A channel was queued for playback
+			kStopped	///< Stop was requested, channel not yet returned by the mixer
+		};
+
+		SlotState() : status(kFree), handle(0), id(-1), type(kPlainSoundType),
+			volume(kMaxChannelVolume), balance(0), pauseLevel(0), permanent(false) {}
+
+		Status status;
+		uint32 handle;
+		int id;
+		SoundType type;
+		byte volume;
+		int8 balance;
+		/** Same as Channel::_pauseLevel once the mixer has caught up */
+		int pauseLevel;
+		bool permanent;
+	};
+
+	/**
+	 * The settings the engines last requested for the channel in a slot.
+	 * Written with _producerMutex held, read by mixCallback() with a
+	 * sequence lock. Repeated changes simply overwrite each other, so
+	 * engines can change them any number of times while the callback is
+	 * not running.
+	 */
+	struct SlotSettings {
+		SlotSettings() : sequence(0), handle(0), volume(kMaxChannelVolume), balance(0), pauseLevel(0) {}
+
+		volatile uint32 sequence;
+		uint32 handle;
+		byte volume;
+		int8 balance;
+		int pauseLevel;
+	};
+
+	/**
+	 * Playback position of a channel as last published by mixCallback().
+	 * Written by the mixer thread only, read with a sequence lock.
+	 */
+	struct TimingSnapshot {
+		TimingSnapshot() : sequence(0), handle(0), samplesConsumed(0),
+			mixerTimeStamp(0), pauseStartTime(0), pauseTime(0), paused(false) {}
+
+		volatile uint32 sequence;
+		uint32 handle;
+		uint32 samplesConsumed;
+		uint32 mixerTimeStamp;
+		uint32 pauseStartTime;
+		uint32 pauseTime;
+		bool paused;
+	};
+
+	bool _commandQueueMode;
+	Common::Mutex _producerMutex;
+	/**
+	 * A slot only has three commands outstanding at most: a stop for a
+	 * channel which finished on its own, a play for the next one and a stop
+	 * for that one. A slot is only reused once the mixer returned its
+	 * channel, and by then it has executed all commands before.
+	 */
+	Common::SPSCQueue<Command, 4 * NUM_CHANNELS> _commands;
+	Common::SPSCQueue<Channel *, NUM_CHANNELS> _retiredChannels;
+	SlotState _slots[NUM_CHANNELS];
+	SlotSettings _settings[NUM_CHANNELS];
+	/** Sequence number of the _settings applied to each channel; mixer thread only */
+	uint32 _appliedSettings[NUM_CHANNELS];
+	TimingSnapshot _timing[NUM_CHANNELS];
+
 
 public:
 
@@ -118,9 +230,25 @@ public:
 
 	virtual uint getOutputRate() const;
 
+	virtual MixerProfile *getProfile() { return &_profile; }
+
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
+	int mixChannels(int16 *buf, uint len);
+	int mixChannel(int index, int16 *buf, uint len);
+	void removeChannel(int index);
+
+	void postCommand(Command::Type type, int index, Channel *channel = 0);
+	void publishSettings(int index);
+	void processCommands();
+	void applySettings(int index);
+	void collectRetiredChannels();
+	void publishTiming(int index);
+	SlotState *getPlayingSlot(SoundHandle handle);
+	void stopSlot(int index);
+	void pauseSlot(int index, bool paused);
+
 public:
 	/**
 	 * The mixer callback function, to be called at regular intervals by
@@ -139,6 +267,44 @@ public:
 	 * their audio system has been completed.
 	 */
 	void setReady(bool ready);
+
+	/**
+	 * Enable or disable command queue mode. In this mode, mixCallback()
+	 * never blocks on a mutex held by an engine thread (and vice versa):
+	 * channel changes are posted to a lock-free queue which the callback
+	 * drains before mixing, so they take effect with the next callback.
+	 * Channels which finished playing are handed back to the engine side
+	 * and destroyed there, during the next call into the mixer.
+	 *
+	 * Must be called before the mixer is set ready and before any sound
+	 * is played. It cannot be disabled while prefetching is enabled (see
+	 * setPrefetchThreads()).
+	 */
+	void setCommandQueueMode(bool enable);
+
+	bool isCommandQueueMode() const { return _commandQueueMode; }
+
+	/**
+	 * Decode streams played from now on ahead of time, using the given
+	 * number of worker threads, so that the mixer callback only has to mix
+	 * samples which are already decoded. Passing 0 disables prefetching.
+	 * If the backend does not support threads, prefetching stays disabled.
+	 *
+	 * Prefetching turns on command queue mode, so that the prefetched
+	 * streams are never created or destroyed in the mixer callback.
+	 *
+	 * Must be called before the mixer is set ready and before any sound
+	 * is played.
+	 */
+	void setPrefetchThreads(uint numThreads);
+
+	bool isPrefetching() const { return _prefetch != 0; }
+
+	/**
+	 * Returns how often a prefetched stream was not decoded in time and
+	 * had to play silence instead.
+	 */
+	uint32 getPrefetchUnderrunCount() const;
 };
 
 
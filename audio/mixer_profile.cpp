@@ -0,0 +1,164 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "audio/mixer_profile.h"
+
+#include "common/str.h"
+#include "common/stream.h"
+#include "common/util.h"
+
+namespace Audio {
+
+MixerProfile::MixerProfile() : _enabled(false), _resetPending(false),
+	_callbackStart(0), _lastCallbackStart(0), _callbackBudget(0) {
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+void MixerProfile::setEnabled(bool enable) {
+	if (enable && !_enabled)
+		reset();
+	_enabled = enable;
+}
+
+void MixerProfile::reset() {
+	_resetPending = true;
+}
+
+uint32 MixerProfile::getBucketLimit(int bucket) {
+	// 128us, 256us, ..., 32.8ms, unlimited
+	if (bucket >= kHistogramBuckets - 1)
+		return 0;
+	return 128 << bucket;
+}
+
+const char *MixerProfile::getSoundTypeName(Mixer::SoundType type) {
+	switch (type) {
+	case Mixer::kMusicSoundType:
+		return "music";
+	case Mixer::kSFXSoundType:
+		return "sfx";
+	case Mixer::kSpeechSoundType:
+		return "speech";
+	default:
+		return "plain";
+	}
+}
+
+void MixerProfile::beginCallback(uint32 now, uint frames, uint rate) {
+	if (_resetPending) {
+		memset(&_stats, 0, sizeof(_stats));
+		_lastCallbackStart = 0;
+		_resetPending = false;
+	}
+
+	// frames * 1000000 / rate, without overflowing 32 bits
+	const uint32 millis = frames * 1000;
+	_callbackBudget = millis / rate * 1000 + millis % rate * 1000 / rate;
+
+	if (_lastCallbackStart != 0 && now - _lastCallbackStart > 2 * _callbackBudget)
+		_stats.late++;
+
+	_callbackStart = now;
+}
+
+void MixerProfile::endCallback(uint32 now, uint32 prefetchUnderruns) {
+	const uint32 micros = now - _callbackStart;
+
+	_stats.callbacks++;
+	_stats.totalMicros += micros;
+	if (micros > _stats.maxMicros)
+		_stats.maxMicros = micros;
+	if (micros > _callbackBudget)
+		_stats.overBudget++;
+
+	int bucket = 0;
+	while (bucket < kHistogramBuckets - 1 && micros >= getBucketLimit(bucket))
+		bucket++;
+	_stats.histogram[bucket]++;
+
+	_stats.prefetchUnderruns = prefetchUnderruns;
+	_lastCallbackStart = _callbackStart;
+}
+
+void MixerProfile::recordChannel(int index, uint32 handle, int id, Mixer::SoundType type,
+                                 uint frames, uint32 decodeMicros, uint32 totalMicros) {
+	assert(index >= 0 && index < kMaxChannels);
+	ChannelStats &chan = _stats.channels[index];
+
+	// A new sound in this slot starts with fresh statistics
+	if (chan.handle != handle) {
+		memset(&chan, 0, sizeof(chan));
+		chan.handle = handle;
+		chan.id = id;
+		chan.type = type;
+	}
+
+	const uint32 convertMicros = totalMicros - MIN(decodeMicros, totalMicros);
+
+	chan.active = true;
+	chan.mixes++;
+	chan.frames += frames;
+	chan.decodeMicros += decodeMicros;
+	chan.convertMicros += convertMicros;
+	if (totalMicros > chan.maxMicros)
+		chan.maxMicros = totalMicros;
+
+	_stats.typeDecodeMicros[type] += decodeMicros;
+	_stats.typeConvertMicros[type] += convertMicros;
+}
+
+void MixerProfile::dump(Common::WriteStream &out) const {
+	const Stats &stats = _stats;
+
+	out.writeString(Common::String::format("mixer callbacks %u\n", stats.callbacks));
+	out.writeString(Common::String::format("mixer total_us %u\n", stats.totalMicros));
+	out.writeString(Common::String::format("mixer max_us %u\n", stats.maxMicros));
+	out.writeString(Common::String::format("mixer over_budget %u\n", stats.overBudget));
+	out.writeString(Common::String::format("mixer late %u\n", stats.late));
+	out.writeString(Common::String::format("mixer prefetch_underruns %u\n", stats.prefetchUnderruns));
+
+	for (int i = 0; i < kHistogramBuckets; i++) {
+		const uint32 limit = getBucketLimit(i);
+		if (limit)
+			out.writeString(Common::String::format("histogram %u %u\n", limit, stats.histogram[i]));
+		else
+			out.writeString(Common::String::format("histogram inf %u\n", stats.histogram[i]));
+	}
+
+	for (int i = 0; i < 4; i++) {
+		const char *name = getSoundTypeName((Mixer::SoundType)i);
+		out.writeString(Common::String::format("type %s decode_us %u\n", name, stats.typeDecodeMicros[i]));
+		out.writeString(Common::String::format("type %s convert_us %u\n", name, stats.typeConvertMicros[i]));
+	}
+
+	for (int i = 0; i < kMaxChannels; i++) {
+		const ChannelStats &chan = stats.channels[i];
+		if (!chan.mixes)
+			continue;
+
+		out.writeString(Common::String::format("channel %d handle %u id %d type %s active %d mixes %u frames %u decode_us %u convert_us %u max_us %u\n",
+			i, chan.handle, chan.id, getSoundTypeName(chan.type), chan.active ? 1 : 0,
+			chan.mixes, chan.frames, chan.decodeMicros, chan.convertMicros, chan.maxMicros));
+	}
+}
+
+} // End of namespace Audio
@@ -0,0 +1,148 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef AUDIO_MIXER_PROFILE_H
+#define AUDIO_MIXER_PROFILE_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+#include "audio/mixer.h"
+
+namespace Common {
+class WriteStream;
+}
+
+namespace Audio {
+
+/**
+ * Timing statistics collected by the mixer, to find out which sounds make
+ * the mixer callback too slow (and thus cause audio dropouts).
+ *
+ * Profiling is disabled by default, as it needs a few calls to
+ * OSystem::getMicros() per channel and callback. Once enabled, the mixer
+ * thread records how long each callback takes, how much of that each
+ * channel spent decoding its stream and converting (resampling and mixing)
+ * it, and counts callbacks which likely caused an underrun.
+ *
+ * The statistics are written by the mixer thread without any locking, so
+ * readers may see a callback half recorded. This is fine for their purpose,
+ * but the numbers should be treated as approximate.
+ */
+class MixerProfile : Common::NonCopyable {
+public:
+	enum {
+		/** The number of channel slots of the mixer, see MixerImpl. */
+		kMaxChannels = 16,
+		kHistogramBuckets = 10
+	};
+
+	struct ChannelStats {
+		bool active;		///< Whether the slot is currently playing a sound
+		uint32 handle;		///< Sound handle of the last sound played in the slot
+		int id;
+		Mixer::SoundType type;
+		uint32 mixes;		///< Number of callbacks the sound was mixed in
+		uint32 frames;		///< Number of output frames produced
+		uint32 decodeMicros;	///< Time spent reading from the stream
+		uint32 convertMicros;	///< Time spent resampling and mixing
+		uint32 maxMicros;	///< Longest time spent in a single callback
+	};
+
+	struct Stats {
+		uint32 callbacks;
+		uint32 totalMicros;
+		uint32 maxMicros;
+		/** Callback durations, see getBucketLimit(). */
+		uint32 histogram[kHistogramBuckets];
+		/** Callbacks which took longer than the audio they produced lasts. */
+		uint32 overBudget;
+		/**
+		 * Callbacks which came more than twice the buffer length after the
+		 * previous one, i.e. the backend was most likely out of audio.
+		 */
+		uint32 late;
+		/** Prefetched streams which were not decoded in time. */
+		uint32 prefetchUnderruns;
+		/** Decode and convert times summed up per sound type. */
+		uint32 typeDecodeMicros[4];
+		uint32 typeConvertMicros[4];
+		ChannelStats channels[kMaxChannels];
+	};
+
+	MixerProfile();
+
+	bool isEnabled() const { return _enabled; }
+
+	/** Start or stop collecting statistics. Enabling also resets them. */
+	void setEnabled(bool enable);
+
+	/**
+	 * Clear all statistics. As the mixer thread owns them, this only
+	 * takes effect with the next mixer callback.
+	 */
+	void reset();
+
+	const Stats &getStats() const { return _stats; }
+
+	/**
+	 * Returns the exclusive upper limit of the given histogram bucket in
+	 * microseconds, or 0 for the last bucket, which has no limit.
+	 */
+	static uint32 getBucketLimit(int bucket);
+
+	/** Returns a short name for the sound type, e.g. "music". */
+	static const char *getSoundTypeName(Mixer::SoundType type);
+
+	/**
+	 * Write the statistics in a machine-readable form: one record per
+	 * line, consisting of space separated fields. The first field names
+	 * the record type ("mixer", "histogram", "type" or "channel").
+	 */
+	void dump(Common::WriteStream &out) const;
+
+	/** @name Mixer thread side */
+	//@{
+
+	void beginCallback(uint32 now, uint frames, uint rate);
+	void endCallback(uint32 now, uint32 prefetchUnderruns);
+	void recordChannel(int index, uint32 handle, int id, Mixer::SoundType type,
+	                   uint frames, uint32 decodeMicros, uint32 totalMicros);
+	void setChannelInactive(int index) { _stats.channels[index].active = false; }
+
+	//@}
+
+private:
+	volatile bool _enabled;
+	volatile bool _resetPending;
+
+	Stats _stats;
+
+	/** Start of the current and the previous callback; 0 if unknown. */
+	uint32 _callbackStart;
+	uint32 _lastCallbackStart;
+	/** Duration of the audio produced by the current callback. */
+	uint32 _callbackBudget;
+};
+
+} // End of namespace Audio
+
+#endif
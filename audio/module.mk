@@ -10,9 +10,13 @@ MODULE_OBJS := \
 	midiparser.o \
 	midiplayer.o \
 	mixer.o \
+	mixer_profile.o \
 	mpu401.o \
 	musicplugin.o \
 	null.o \
+	prefetch.o \
+	rate_kernels.o \
+	rate_sinc.o \
 	timestamp.o \
 	decoders/aac.o \
 	decoders/adpcm.o \
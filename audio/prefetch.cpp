@@ -0,0 +1,246 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "audio/prefetch.h"
+
+#include "common/system.h"
+#include "common/util.h"
+
+namespace Audio {
+
+/** Returns the number of samples needed for kPrefetchMsecs, rounded up to a power of two. */
+static uint calcRingSize(const AudioStream &stream, uint chunkSize, uint msecs) {
+	const uint samples = stream.getRate() * (stream.isStereo() ? 2 : 1) * msecs / 1000;
+
+	uint size = 2 * chunkSize;
+	while (size < samples)
+		size <<= 1;
+	return size;
+}
+
+PrefetchingAudioStream::PrefetchingAudioStream(PrefetchManager &manager, AudioStream *stream, DisposeAfterUse::Flag disposeAfterUse)
+	: _manager(manager), _source(stream, disposeAfterUse), _isStereo(stream->isStereo()), _rate(stream->getRate()),
+	  _ring(calcRingSize(*stream, kDecodeChunkSize, kPrefetchMsecs)),
+	  _sourceEndOfData(false), _sourceEndOfStream(false), _primed(false),
+	  _needsRefill(true), _busy(false), _unregisterSemaphore(0), _underruns(0) {
+	// The first worker to see the stream primes it, see wrap()
+}
+
+PrefetchingAudioStream::~PrefetchingAudioStream() {
+	_manager.unregisterStream(this);
+}
+
+int PrefetchingAudioStream::readBuffer(int16 *buffer, const int numSamples) {
+	// Check the source state before the ring: everything decoded before
+	// the source reported its end is then guaranteed to be visible.
+	const bool primed = _primed;
+	const bool sourceEnded = _sourceEndOfData;
+	Common::memoryBarrier();
+
+	int samples = _ring.read(buffer, numSamples);
+
+	if (samples < numSamples && !sourceEnded) {
+		// The workers did not keep up. Play silence instead of returning
+		// a short read, to keep the channel's timing intact. Waiting for
+		// the initial part of the stream does not count as an underrun.
+		memset(buffer + samples, 0, (numSamples - samples) * sizeof(int16));
+		samples = numSamples;
+		if (primed) {
+			++_underruns;
+			++_manager._underruns;
+		}
+	}
+
+	if (_ring.space() >= _ring.capacity() / 2)
+		requestRefill();
+
+	return samples;
+}
+
+bool PrefetchingAudioStream::endOfData() const {
+	const bool sourceEnded = _sourceEndOfData;
+	Common::memoryBarrier();
+
+	if (_ring.size() != 0)
+		return false;
+
+	// The source may get more data later (e.g. a QueuingAudioStream), so
+	// keep polling it while we are out of samples.
+	requestRefill();
+	return sourceEnded;
+}
+
+bool PrefetchingAudioStream::endOfStream() const {
+	const bool sourceEnded = _sourceEndOfStream;
+	Common::memoryBarrier();
+
+	return sourceEnded && _ring.size() == 0;
+}
+
+void PrefetchingAudioStream::decode() {
+	while (_ring.space() >= kDecodeChunkSize) {
+		const int samples = _source->readBuffer(_decodeBuffer, kDecodeChunkSize);
+		if (samples > 0)
+			_ring.write(_decodeBuffer, samples);
+		if (samples < kDecodeChunkSize)
+			break;
+	}
+
+	// Published after the samples, see readBuffer()
+	_sourceEndOfData = _source->endOfData();
+	_sourceEndOfStream = _source->endOfStream();
+	Common::memoryBarrier();
+	_primed = true;
+}
+
+void PrefetchingAudioStream::requestRefill() const {
+	// Only the reading thread sets the flag, and the workers clear it
+	// before decoding. Waking a worker once per request is thus enough.
+	if (_needsRefill)
+		return;
+
+	_needsRefill = true;
+	_manager.wakeWorker();
+}
+
+#pragma mark -
+
+PrefetchManager::PrefetchManager(uint numThreads)
+	: _nextStream(0), _quit(false), _workSemaphore(0), _underruns(0), _pool(numThreads) {
+
+	if (_pool.getThreadCount() == 0)
+		return;
+
+	_workSemaphore = g_system->createSemaphore(0);
+	if (!_workSemaphore)
+		error("PrefetchManager: Could not create semaphore");
+
+	// Without threads, the jobs would run right here and never return
+	for (uint i = 0; i < _pool.getThreadCount(); ++i)
+		_pool.addJob(workerJob, this);
+}
+
+PrefetchManager::~PrefetchManager() {
+	// All streams must have been deleted before the manager
+	assert(_streams.empty());
+
+	if (!_workSemaphore)
+		return;
+
+	// Wake up all workers, so that they see they have to exit
+	_quit = true;
+	for (uint i = 0; i < _pool.getThreadCount(); ++i)
+		g_system->postSemaphore(_workSemaphore);
+
+	_pool.waitForJobs();
+	g_system->deleteSemaphore(_workSemaphore);
+}
+
+PrefetchingAudioStream *PrefetchManager::wrap(AudioStream *stream, DisposeAfterUse::Flag disposeAfterUse) {
+	PrefetchingAudioStream *prefetchingStream = new PrefetchingAudioStream(*this, stream, disposeAfterUse);
+
+	{
+		Common::StackLock lock(_mutex);
+		_streams.push_back(prefetchingStream);
+	}
+
+	// The stream asks for a refill from the start, to be primed
+	wakeWorker();
+	return prefetchingStream;
+}
+
+void PrefetchManager::unregisterStream(PrefetchingAudioStream *stream) {
+	OSystem::SemaphoreRef semaphore = 0;
+
+	{
+		Common::StackLock lock(_mutex);
+		for (uint i = 0; i < _streams.size(); ++i) {
+			if (_streams[i] == stream) {
+				_streams.remove_at(i);
+				break;
+			}
+		}
+
+		if (stream->_busy) {
+			semaphore = g_system->createSemaphore(0);
+			stream->_unregisterSemaphore = semaphore;
+		}
+	}
+
+	// A worker is decoding the stream right now; wait until it is done
+	if (semaphore) {
+		g_system->waitSemaphore(semaphore);
+		g_system->deleteSemaphore(semaphore);
+	}
+}
+
+PrefetchingAudioStream *PrefetchManager::claimStream() {
+	Common::StackLock lock(_mutex);
+
+	const uint count = _streams.size();
+	for (uint i = 0; i < count; ++i) {
+		const uint index = (_nextStream + i) % count;
+		PrefetchingAudioStream *stream = _streams[index];
+		if (!stream->_needsRefill || stream->_busy)
+			continue;
+
+		// Cleared before decoding, so that requests made in the
+		// meantime are not lost
+		stream->_needsRefill = false;
+		stream->_busy = true;
+		_nextStream = index + 1;
+		return stream;
+	}
+
+	return 0;
+}
+
+void PrefetchManager::releaseStream(PrefetchingAudioStream *stream) {
+	Common::StackLock lock(_mutex);
+	stream->_busy = false;
+	if (stream->_unregisterSemaphore)
+		g_system->postSemaphore(stream->_unregisterSemaphore);
+}
+
+void PrefetchManager::wakeWorker() {
+	g_system->postSemaphore(_workSemaphore);
+}
+
+void PrefetchManager::workerJob(void *param) {
+	PrefetchManager *manager = (PrefetchManager *)param;
+
+	while (!manager->_quit) {
+		// A worker only sleeps after finding nothing to do. Requests for
+		// a stream which is busy are thus picked up by the worker busy
+		// with it, once it is done.
+		PrefetchingAudioStream *stream = manager->claimStream();
+		if (!stream) {
+			g_system->waitSemaphore(manager->_workSemaphore);
+			continue;
+		}
+
+		stream->decode();
+		manager->releaseStream(stream);
+	}
+}
+
+} // End of namespace Audio
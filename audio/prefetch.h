@@ -0,0 +1,163 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef AUDIO_PREFETCH_H
+#define AUDIO_PREFETCH_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/mutex.h"
+#include "common/ptr.h"
+#include "common/spsc-queue.h"
+#include "common/threadpool.h"
+#include "common/types.h"
+#include "audio/audiostream.h"
+
+namespace Audio {
+
+class PrefetchingAudioStream;
+
+/**
+ * Decodes audio streams ahead of time on a pool of worker threads.
+ *
+ * Streams wrapped by the manager (see wrap()) are read by the workers into
+ * per-stream lock-free ring buffers. The mixer callback then only copies
+ * already decoded samples, so expensive decoders (Vorbis, MP3, FLAC, ...)
+ * no longer run in the audio thread. If a worker falls behind, the stream
+ * plays silence for the missing samples and an underrun is counted.
+ *
+ * The mixer thread only copies samples. When a stream wants more of them,
+ * it sets a flag and posts a semaphore to wake up a worker; it never waits
+ * for a worker. Streams are created and destroyed by the engine threads
+ * only, which is why the mixer uses command queue mode for prefetching (see
+ * MixerImpl::setPrefetchThreads()). Destroying a stream waits for the
+ * worker decoding it, if any.
+ */
+class PrefetchManager : Common::NonCopyable {
+	friend class PrefetchingAudioStream;
+public:
+	explicit PrefetchManager(uint numThreads);
+	~PrefetchManager();
+
+	/** Returns the number of worker threads; 0 means prefetching is pointless. */
+	uint getThreadCount() const { return _pool.getThreadCount(); }
+
+	/**
+	 * Wrap the given stream so that it is decoded by the worker threads.
+	 * The initial part of the stream is decoded by a worker as well; until
+	 * it is done, the stream plays silence.
+	 */
+	PrefetchingAudioStream *wrap(AudioStream *stream, DisposeAfterUse::Flag disposeAfterUse);
+
+	/** Returns the number of underruns of all streams prefetched so far. */
+	uint32 getUnderrunCount() const { return _underruns; }
+
+private:
+	void unregisterStream(PrefetchingAudioStream *stream);
+
+	/** Find a stream asking for a refill and mark it busy, or return 0. */
+	PrefetchingAudioStream *claimStream();
+	void releaseStream(PrefetchingAudioStream *stream);
+
+	/** Wake up a worker, to look for streams asking for a refill. */
+	void wakeWorker();
+
+	/** Runs in each worker thread until the manager is destroyed. */
+	static void workerJob(void *param);
+
+	Common::Mutex _mutex;
+	/** All streams wrapped by the manager; protected by _mutex. */
+	Common::Array<PrefetchingAudioStream *> _streams;
+	/** Where claimStream() starts looking, so that all streams get their turn; protected by _mutex. */
+	uint _nextStream;
+
+	volatile bool _quit;
+	/** Posted whenever there may be work, and once per worker to quit. */
+	OSystem::SemaphoreRef _workSemaphore;
+
+	/** Only incremented by the thread reading the streams (the mixer). */
+	volatile uint32 _underruns;
+
+	/** Declared last, so that its destructor waits for the workers before anything else is destroyed. */
+	Common::ThreadPool _pool;
+};
+
+/**
+ * An audio stream handing out samples which a PrefetchManager decoded ahead
+ * of time. Must only be read from a single thread.
+ */
+class PrefetchingAudioStream : public AudioStream {
+	friend class PrefetchManager;
+public:
+	~PrefetchingAudioStream();
+
+	int readBuffer(int16 *buffer, const int numSamples);
+	bool isStereo() const { return _isStereo; }
+	int getRate() const { return _rate; }
+	bool endOfData() const;
+	bool endOfStream() const;
+
+	/** Returns how often this stream ran out of decoded samples. */
+	uint32 getUnderrunCount() const { return _underruns; }
+
+private:
+	PrefetchingAudioStream(PrefetchManager &manager, AudioStream *stream, DisposeAfterUse::Flag disposeAfterUse);
+
+	/** Fill the ring buffer from the source stream. Worker thread only. */
+	void decode();
+
+	void requestRefill() const;
+
+	enum {
+		/** Number of samples decoded in one go. */
+		kDecodeChunkSize = 2048,
+		/** Amount of audio to decode ahead of the mixer. */
+		kPrefetchMsecs = 250
+	};
+
+	PrefetchManager &_manager;
+	Common::DisposablePtr<AudioStream> _source;
+	const bool _isStereo;
+	const int _rate;
+
+	Common::SPSCRingBuffer<int16> _ring;
+	int16 _decodeBuffer[kDecodeChunkSize];
+
+	/** State of the source as seen by the last decode() call. */
+	volatile bool _sourceEndOfData;
+	volatile bool _sourceEndOfStream;
+	/** Set once a worker decoded the initial part of the stream. */
+	volatile bool _primed;
+
+	/** Set by the reading thread when the ring buffer should be filled up, and on creation. */
+	mutable volatile bool _needsRefill;
+	/** A worker is currently running decode(); protected by the manager mutex. */
+	bool _busy;
+	/** Posted when the worker is done, if the stream is being destroyed; protected by the manager mutex. */
+	OSystem::SemaphoreRef _unregisterSemaphore;
+
+	uint32 _underruns;
+};
+
+} // End of namespace Audio
+
+#endif
@@ -30,6 +30,8 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_sinc.h"
+#include "audio/rate_kernels.h"
 #include "audio/mixer.h"
 #include "common/frac.h"
 #include "common/textconsole.h"
@@ -46,6 +48,26 @@ namespace Audio {
  */
 #define INTERMEDIATE_BUFFER_SIZE 512
 
+/**
+ * The number of output frames the converters produce in one go, before
+ * handing them to the mixing kernels.
+ */
+#define OUTPUT_BLOCK_FRAMES (INTERMEDIATE_BUFFER_SIZE / 2)
+
+
+/**
+ * Mix a block of converted frames into the output buffer.
+ */
+template<bool stereo, bool reverseStereo>
+static inline void mixBlock(const RateKernels &kernels, st_sample_t *obuf, const st_sample_t *buf, st_size_t frames, st_volume_t vol_l, st_volume_t vol_r) {
+	if (stereo)
+		kernels.mixStereo(obuf, buf, frames, vol_l, vol_r, reverseStereo);
+	else if (reverseStereo)
+		kernels.mixMono(obuf, buf, frames, vol_r, vol_l);
+	else
+		kernels.mixMono(obuf, buf, frames, vol_l, vol_r);
+}
+
 
 /**
  * Audio rate converter based on simple resampling. Used when no
@@ -60,6 +82,11 @@ protected:
 	const st_sample_t *inPtr;
 	int inLen;
 
+	/** picked input samples, waiting to be mixed */
+	st_sample_t outBuf[OUTPUT_BLOCK_FRAMES * 2];
+
+	const RateKernels &kernels;
+
 	/** position of how far output is ahead of input */
 	/** Holds what would have been opos-ipos */
 	long opos;
@@ -80,7 +107,8 @@ public:
  * Prepare processing.
  */
 template<bool stereo, bool reverseStereo>
-SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate, st_rate_t outrate) {
+SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate, st_rate_t outrate)
+	: kernels(getRateKernels()) {
 	if ((inrate % outrate) != 0) {
 		error("Input rate must be a multiple of output rate to use rate effect");
 	}
@@ -108,38 +136,45 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 	ostart = obuf;
 	oend = obuf + osamp * 2;
 
-	while (obuf < oend) {
-
-		// read enough input samples so that opos >= 0
-		do {
-			// Check if we have to refill the buffer
-			if (inLen == 0) {
-				inPtr = inBuf;
-				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
-					return (obuf - ostart) / 2;
-			}
-			inLen -= (stereo ? 2 : 1);
-			opos--;
-			if (opos >= 0) {
-				inPtr += (stereo ? 2 : 1);
-			}
-		} while (opos >= 0);
-
-		st_sample_t out0, out1;
-		out0 = *inPtr++;
-		out1 = (stereo ? *inPtr++ : out0);
+	bool endOfInput = false;
+	while (obuf < oend && !endOfInput) {
+		const st_size_t blockFrames = MIN<st_size_t>((oend - obuf) / 2, OUTPUT_BLOCK_FRAMES);
+		st_sample_t *out = outBuf;
+		st_size_t frames = 0;
+
+		while (frames < blockFrames) {
+			// read enough input samples so that opos >= 0
+			do {
+				// Check if we have to refill the buffer
+				if (inLen == 0) {
+					inPtr = inBuf;
+					inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+					if (inLen <= 0) {
+						endOfInput = true;
+						break;
+					}
+				}
+				inLen -= (stereo ? 2 : 1);
+				opos--;
+				if (opos >= 0) {
+					inPtr += (stereo ? 2 : 1);
+				}
+			} while (opos >= 0);
+
+			if (endOfInput)
+				break;
+
+			*out++ = *inPtr++;
+			if (stereo)
+				*out++ = *inPtr++;
 
-		// Increment output position
-		opos += opos_inc;
-
-		// output left channel
-		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-		// output right channel
-		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+			// Increment output position
+			opos += opos_inc;
+			frames++;
+		}
 
-		obuf += 2;
+		mixBlock<stereo, reverseStereo>(kernels, obuf, outBuf, frames, vol_l, vol_r);
+		obuf += frames * 2;
 	}
 	return (obuf - ostart) / 2;
 }
@@ -173,6 +208,16 @@ protected:
 	/** current sample(s) in the input stream (left/right channel) */
 	st_sample_t icur0, icur1;
 
+	/** interpolation input for the current block of output samples */
+	st_sample_t lastBuf[OUTPUT_BLOCK_FRAMES * 2];
+	st_sample_t curBuf[OUTPUT_BLOCK_FRAMES * 2];
+	frac_t posBuf[OUTPUT_BLOCK_FRAMES * 2];
+
+	/** interpolated samples, waiting to be mixed */
+	st_sample_t outBuf[OUTPUT_BLOCK_FRAMES * 2];
+
+	const RateKernels &kernels;
+
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
@@ -186,7 +231,8 @@ public:
  * Prepare processing.
  */
 template<bool stereo, bool reverseStereo>
-LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate, st_rate_t outrate) {
+LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate, st_rate_t outrate)
+	: kernels(getRateKernels()) {
 	if (inrate >= 65536 || outrate >= 65536) {
 		error("rate effect can only handle rates < 65536");
 	}
@@ -217,48 +263,59 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 	ostart = obuf;
 	oend = obuf + osamp * 2;
 
-	while (obuf < oend) {
-
-		// read enough input samples so that opos < 0
-		while ((frac_t)FRAC_ONE <= opos) {
-			// Check if we have to refill the buffer
-			if (inLen == 0) {
-				inPtr = inBuf;
-				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
-					return (obuf - ostart) / 2;
+	bool endOfInput = false;
+	while (obuf < oend && !endOfInput) {
+		const st_size_t blockFrames = MIN<st_size_t>((oend - obuf) / 2, OUTPUT_BLOCK_FRAMES);
+		st_size_t frames = 0;
+
+		while (frames < blockFrames) {
+			// read enough input samples so that opos < 0
+			while ((frac_t)FRAC_ONE <= opos) {
+				// Check if we have to refill the buffer
+				if (inLen == 0) {
+					inPtr = inBuf;
+					inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+					if (inLen <= 0) {
+						endOfInput = true;
+						break;
+					}
+				}
+				inLen -= (stereo ? 2 : 1);
+				ilast0 = icur0;
+				icur0 = *inPtr++;
+				if (stereo) {
+					ilast1 = icur1;
+					icur1 = *inPtr++;
+				}
+				opos -= FRAC_ONE;
 			}
-			inLen -= (stereo ? 2 : 1);
-			ilast0 = icur0;
-			icur0 = *inPtr++;
-			if (stereo) {
-				ilast1 = icur1;
-				icur1 = *inPtr++;
+
+			if (endOfInput)
+				break;
+
+			// Loop as long as the outpos trails behind, and as long as there is
+			// still space in the block. The actual interpolation is done by
+			// the kernel, once the block is complete.
+			while (opos < (frac_t)FRAC_ONE && frames < blockFrames) {
+				const st_size_t i = (stereo ? frames * 2 : frames);
+				lastBuf[i] = ilast0;
+				curBuf[i] = icur0;
+				posBuf[i] = opos;
+				if (stereo) {
+					lastBuf[i + 1] = ilast1;
+					curBuf[i + 1] = icur1;
+					posBuf[i + 1] = opos;
+				}
+				frames++;
+
+				// Increment output position
+				opos += opos_inc;
 			}
-			opos -= FRAC_ONE;
 		}
 
-		// Loop as long as the outpos trails behind, and as long as there is
-		// still space in the output buffer.
-		while (opos < (frac_t)FRAC_ONE && obuf < oend) {
-			// interpolate
-			st_sample_t out0, out1;
-			out0 = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF) >> FRAC_BITS));
-			out1 = (stereo ?
-						  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF) >> FRAC_BITS)) :
-						  out0);
-
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
-
-			// Increment output position
-			opos += opos_inc;
-		}
+		kernels.interpolate(outBuf, lastBuf, curBuf, posBuf, stereo ? frames * 2 : frames);
+		mixBlock<stereo, reverseStereo>(kernels, obuf, outBuf, frames, vol_l, vol_r);
+		obuf += frames * 2;
 	}
 	return (obuf - ostart) / 2;
 }
@@ -274,8 +331,9 @@ template<bool stereo, bool reverseStereo>
 class CopyRateConverter : public RateConverter {
 	st_sample_t *_buffer;
 	st_size_t _bufferSize;
+	const RateKernels &_kernels;
 public:
-	CopyRateConverter() : _buffer(0), _bufferSize(0) {}
+	CopyRateConverter() : _buffer(0), _bufferSize(0), _kernels(getRateKernels()) {}
 	~CopyRateConverter() {
 		free(_buffer);
 	}
@@ -283,11 +341,8 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
 		st_size_t len;
 
-		st_sample_t *ostart = obuf;
-
 		if (stereo)
 			osamp *= 2;
 
@@ -305,21 +360,9 @@ public:
 		len = input.readBuffer(_buffer, osamp);
 
 		// Mix the data into the output buffer
-		ptr = _buffer;
-		for (; len > 0; len -= (stereo ? 2 : 1)) {
-			st_sample_t out0, out1;
-			out0 = *ptr++;
-			out1 = (stereo ? *ptr++ : out0);
-
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
-		}
-		return (obuf - ostart) / 2;
+		const st_size_t frames = (stereo ? len / 2 : len);
+		mixBlock<stereo, reverseStereo>(_kernels, obuf, _buffer, frames, vol_l, vol_r);
+		return frames;
 	}
 
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
@@ -346,7 +389,10 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, RateConverterQuality quality) {
+	if (inrate != outrate && quality != kRateConverterQualityFast)
+		return makeSincRateConverter(inrate, outrate, stereo, reverseStereo, quality);
+
 	if (stereo) {
 		if (reverseStereo)
 			return makeRateConverter<true, true>(inrate, outrate);
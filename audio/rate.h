@@ -76,9 +76,36 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) = 0;
 
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
+
+	/**
+	 * Returns true if the input stream has ended, but the converter still
+	 * holds input it did not output yet. The mixer keeps calling flow()
+	 * until all of it has been output.
+	 */
+	virtual bool hasPendingOutput() const { return false; }
+};
+
+/**
+ * Resampling quality levels, trading CPU time for sound quality.
+ */
+enum RateConverterQuality {
+	/** Nearest neighbour or linear interpolation. Very cheap, but dull/aliased. */
+	kRateConverterQualityFast,
+	/** Polyphase windowed sinc filter with 16 taps. */
+	kRateConverterQualityGood,
+	/** Polyphase windowed sinc filter with 32 taps. */
+	kRateConverterQualityBest
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
+/**
+ * Create a rate converter for the given input and output rates.
+ *
+ * @note Converters of a quality other than kRateConverterQualityFast share
+ * precomputed filter tables. Creating and destroying those converters is
+ * not thread safe; the mixer always does it with its lock held.
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false,
+                                 RateConverterQuality quality = kRateConverterQualityFast);
 
 } // End of namespace Audio
 
@@ -0,0 +1,385 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "audio/rate_kernels.h"
+#include "audio/mixer.h"
+#include "common/cpudetect.h"
+
+#ifdef SCUMMVM_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SCUMMVM_AVX2
+#include <immintrin.h>
+#endif
+
+namespace Audio {
+
+// The SIMD kernels divide by kMaxMixerVolume with a shift. They also use
+// saturating 16 bit additions, which do not match what clampedAdd() does
+// for unsigned output.
+#if defined(OUTPUT_UNSIGNED_AUDIO)
+#undef SCUMMVM_SSE2
+#undef SCUMMVM_AVX2
+#endif
+
+enum {
+	kVolumeShift = 8
+};
+
+#pragma mark -
+#pragma mark --- Plain C++ kernels ---
+#pragma mark -
+
+template<bool reverseStereo>
+static void mixStereoTemplate(st_sample_t *dst, const st_sample_t *src, uint frames, st_volume_t volL, st_volume_t volR) {
+	for (; frames > 0; --frames) {
+		// output left channel
+		clampedAdd(dst[reverseStereo    ], (src[0] * (int)volL) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(dst[reverseStereo ^ 1], (src[1] * (int)volR) / Audio::Mixer::kMaxMixerVolume);
+
+		src += 2;
+		dst += 2;
+	}
+}
+
+static void mixStereoScalar(st_sample_t *dst, const st_sample_t *src, uint frames, st_volume_t volL, st_volume_t volR, bool reverseStereo) {
+	if (reverseStereo)
+		mixStereoTemplate<true>(dst, src, frames, volL, volR);
+	else
+		mixStereoTemplate<false>(dst, src, frames, volL, volR);
+}
+
+static void mixMonoScalar(st_sample_t *dst, const st_sample_t *src, uint frames, st_volume_t volL, st_volume_t volR) {
+	for (; frames > 0; --frames) {
+		const st_sample_t sample = *src++;
+		clampedAdd(dst[0], (sample * (int)volL) / Audio::Mixer::kMaxMixerVolume);
+		clampedAdd(dst[1], (sample * (int)volR) / Audio::Mixer::kMaxMixerVolume);
+		dst += 2;
+	}
+}
+
+static void interpolateScalar(st_sample_t *dst, const st_sample_t *last, const st_sample_t *cur, const frac_t *pos, uint count) {
+	for (uint i = 0; i < count; ++i)
+		dst[i] = (st_sample_t)(last[i] + (((cur[i] - last[i]) * pos[i] + FRAC_HALF) >> FRAC_BITS));
+}
+
+static int32 convolveScalar(const st_sample_t *samples, const int16 *coefs, uint taps) {
+	int32 sum = 0;
+	for (uint i = 0; i < taps; ++i)
+		sum += samples[i] * coefs[i];
+	return sum;
+}
+
+static const RateKernels s_scalarKernels = {
+	"C++",
+	mixStereoScalar,
+	mixMonoScalar,
+	interpolateScalar,
+	convolveScalar
+};
+
+#ifdef SCUMMVM_SSE2
+
+#pragma mark -
+#pragma mark --- SSE2 kernels ---
+#pragma mark -
+
+/**
+ * Scale eight samples by eight 16 bit volumes, dividing the result by
+ * kMaxMixerVolume the same way the C++ code does (rounding towards zero).
+ */
+static inline __m128i scaleSSE2(__m128i samples, __m128i volume) {
+	const __m128i lo = _mm_mullo_epi16(samples, volume);
+	const __m128i hi = _mm_mulhi_epi16(samples, volume);
+	__m128i p0 = _mm_unpacklo_epi16(lo, hi);
+	__m128i p1 = _mm_unpackhi_epi16(lo, hi);
+
+	// Add (kMaxMixerVolume - 1) to negative products before shifting
+	const __m128i bias = _mm_set1_epi32(Audio::Mixer::kMaxMixerVolume - 1);
+	p0 = _mm_add_epi32(p0, _mm_and_si128(_mm_srai_epi32(p0, 31), bias));
+	p1 = _mm_add_epi32(p1, _mm_and_si128(_mm_srai_epi32(p1, 31), bias));
+
+	return _mm_packs_epi32(_mm_srai_epi32(p0, kVolumeShift), _mm_srai_epi32(p1, kVolumeShift));
+}
+
+static void mixStereoSSE2(st_sample_t *dst, const st_sample_t *src, uint frames, st_volume_t volL, st_volume_t volR, bool reverseStereo) {
+	if (volL > 0x7FFF || volR > 0x7FFF) {
+		mixStereoScalar(dst, src, frames, volL, volR, reverseStereo);
+		return;
+	}
+
+	// With reversed stereo, swap the input channels, and hence also
+	// the volumes which apply to them.
+	const __m128i volume = reverseStereo ?
+		_mm_setr_epi16(volR, volL, volR, volL, volR, volL, volR, volL) :
+		_mm_setr_epi16(volL, volR, volL, volR, volL, volR, volL, volR);
+
+	for (; frames >= 4; frames -= 4) {
+		__m128i in = _mm_loadu_si128((const __m128i *)src);
+		if (reverseStereo)
+			in = _mm_shufflehi_epi16(_mm_shufflelo_epi16(in, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+
+		const __m128i out = _mm_loadu_si128((const __m128i *)dst);
+		_mm_storeu_si128((__m128i *)dst, _mm_adds_epi16(out, scaleSSE2(in, volume)));
+
+		src += 8;
+		dst += 8;
+	}
+
+	mixStereoScalar(dst, src, frames, volL, volR, reverseStereo);
+}
+
+static void mixMonoSSE2(st_sample_t *dst, const st_sample_t *src, uint frames, st_volume_t volL, st_volume_t volR) {
+	if (volL > 0x7FFF || volR > 0x7FFF) {
+		mixMonoScalar(dst, src, frames, volL, volR);
+		return;
+	}
+
+	const __m128i volume = _mm_setr_epi16(volL, volR, volL, volR, volL, volR, volL, volR);
+
+	for (; frames >= 8; frames -= 8) {
+		const __m128i in = _mm_loadu_si128((const __m128i *)src);
+
+		// Duplicate each sample for the left and right channel
+		const __m128i in0 = _mm_unpacklo_epi16(in, in);
+		const __m128i in1 = _mm_unpackhi_epi16(in, in);
+
+		const __m128i out0 = _mm_loadu_si128((const __m128i *)dst);
+		const __m128i out1 = _mm_loadu_si128((const __m128i *)(dst + 8));
+		_mm_storeu_si128((__m128i *)dst, _mm_adds_epi16(out0, scaleSSE2(in0, volume)));
+		_mm_storeu_si128((__m128i *)(dst + 8), _mm_adds_epi16(out1, scaleSSE2(in1, volume)));
+
+		src += 8;
+		dst += 16;
+	}
+
+	mixMonoScalar(dst, src, frames, volL, volR);
+}
+
+/** Sign extend the four 16 bit values in the low half of v to 32 bit. */
+static inline __m128i widenSSE2(__m128i v) {
+	return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+}
+
+/** 32 bit multiplication keeping the low 32 bits (_mm_mullo_epi32 is SSE4.1). */
+static inline __m128i mullo32SSE2(__m128i a, __m128i b) {
+	const __m128i even = _mm_mul_epu32(a, b);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	                          _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static void interpolateSSE2(st_sample_t *dst, const st_sample_t *last, const st_sample_t *cur, const frac_t *pos, uint count) {
+	const __m128i half = _mm_set1_epi32(FRAC_HALF);
+
+	for (; count >= 4; count -= 4) {
+		const __m128i l = widenSSE2(_mm_loadl_epi64((const __m128i *)last));
+		const __m128i c = widenSSE2(_mm_loadl_epi64((const __m128i *)cur));
+		const __m128i p = _mm_loadu_si128((const __m128i *)pos);
+
+		__m128i out = mullo32SSE2(_mm_sub_epi32(c, l), p);
+		out = _mm_add_epi32(l, _mm_srai_epi32(_mm_add_epi32(out, half), FRAC_BITS));
+
+		// Truncate (rather than saturate) to 16 bit, like the C++ cast
+		out = _mm_srai_epi32(_mm_slli_epi32(out, 16), 16);
+		_mm_storel_epi64((__m128i *)dst, _mm_packs_epi32(out, out));
+
+		dst += 4;
+		last += 4;
+		cur += 4;
+		pos += 4;
+	}
+
+	interpolateScalar(dst, last, cur, pos, count);
+}
+
+static int32 convolveSSE2(const st_sample_t *samples, const int16 *coefs, uint taps) {
+	__m128i sum = _mm_setzero_si128();
+
+	for (uint i = 0; i < taps; i += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(samples + i));
+		const __m128i c = _mm_loadu_si128((const __m128i *)(coefs + i));
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(s, c));
+	}
+
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(sum);
+}
+
+static const RateKernels s_sse2Kernels = {
+	"SSE2",
+	mixStereoSSE2,
+	mixMonoSSE2,
+	interpolateSSE2,
+	convolveSSE2
+};
+
+#endif
+
+#ifdef SCUMMVM_AVX2
+
+#pragma mark -
+#pragma mark --- AVX2 kernels ---
+#pragma mark -
+
+SCUMMVM_TARGET_AVX2
+static inline __m256i scaleAVX2(__m256i samples, __m256i volume) {
+	const __m256i lo = _mm256_mullo_epi16(samples, volume);
+	const __m256i hi = _mm256_mulhi_epi16(samples, volume);
+	// unpack and pack both work per 128 bit lane, so the order is kept
+	__m256i p0 = _mm256_unpacklo_epi16(lo, hi);
+	__m256i p1 = _mm256_unpackhi_epi16(lo, hi);
+
+	const __m256i bias = _mm256_set1_epi32(Audio::Mixer::kMaxMixerVolume - 1);
+	p0 = _mm256_add_epi32(p0, _mm256_and_si256(_mm256_srai_epi32(p0, 31), bias));
+	p1 = _mm256_add_epi32(p1, _mm256_and_si256(_mm256_srai_epi32(p1, 31), bias));
+
+	return _mm256_packs_epi32(_mm256_srai_epi32(p0, kVolumeShift), _mm256_srai_epi32(p1, kVolumeShift));
+}
+
+SCUMMVM_TARGET_AVX2
+static void mixStereoAVX2(st_sample_t *dst, const st_sample_t *src, uint frames, st_volume_t volL, st_volume_t volR, bool reverseStereo) {
+	if (volL > 0x7FFF || volR > 0x7FFF) {
+		mixStereoScalar(dst, src, frames, volL, volR, reverseStereo);
+		return;
+	}
+
+	const int16 first = reverseStereo ? volR : volL;
+	const int16 second = reverseStereo ? volL : volR;
+	const __m256i volume = _mm256_setr_epi16(first, second, first, second, first, second, first, second,
+	                                         first, second, first, second, first, second, first, second);
+
+	for (; frames >= 8; frames -= 8) {
+		__m256i in = _mm256_loadu_si256((const __m256i *)src);
+		if (reverseStereo)
+			in = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(in, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+
+		const __m256i out = _mm256_loadu_si256((const __m256i *)dst);
+		_mm256_storeu_si256((__m256i *)dst, _mm256_adds_epi16(out, scaleAVX2(in, volume)));
+
+		src += 16;
+		dst += 16;
+	}
+
+	mixStereoScalar(dst, src, frames, volL, volR, reverseStereo);
+}
+
+SCUMMVM_TARGET_AVX2
+static void mixMonoAVX2(st_sample_t *dst, const st_sample_t *src, uint frames, st_volume_t volL, st_volume_t volR) {
+	if (volL > 0x7FFF || volR > 0x7FFF) {
+		mixMonoScalar(dst, src, frames, volL, volR);
+		return;
+	}
+
+	const int16 l = volL, r = volR;
+	const __m256i volume = _mm256_setr_epi16(l, r, l, r, l, r, l, r, l, r, l, r, l, r, l, r);
+
+	for (; frames >= 8; frames -= 8) {
+		const __m128i in = _mm_loadu_si128((const __m128i *)src);
+
+		// Duplicate each sample for the left and right channel
+		const __m256i stereo = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(in, in)),
+		                                               _mm_unpackhi_epi16(in, in), 1);
+
+		const __m256i out = _mm256_loadu_si256((const __m256i *)dst);
+		_mm256_storeu_si256((__m256i *)dst, _mm256_adds_epi16(out, scaleAVX2(stereo, volume)));
+
+		src += 8;
+		dst += 16;
+	}
+
+	mixMonoScalar(dst, src, frames, volL, volR);
+}
+
+SCUMMVM_TARGET_AVX2
+static void interpolateAVX2(st_sample_t *dst, const st_sample_t *last, const st_sample_t *cur, const frac_t *pos, uint count) {
+	const __m256i half = _mm256_set1_epi32(FRAC_HALF);
+
+	for (; count >= 8; count -= 8) {
+		const __m256i l = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)last));
+		const __m256i c = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)cur));
+		const __m256i p = _mm256_loadu_si256((const __m256i *)pos);
+
+		__m256i out = _mm256_mullo_epi32(_mm256_sub_epi32(c, l), p);
+		out = _mm256_add_epi32(l, _mm256_srai_epi32(_mm256_add_epi32(out, half), FRAC_BITS));
+
+		// Truncate (rather than saturate) to 16 bit, like the C++ cast
+		out = _mm256_srai_epi32(_mm256_slli_epi32(out, 16), 16);
+		_mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(_mm256_castsi256_si128(out), _mm256_extracti128_si256(out, 1)));
+
+		dst += 8;
+		last += 8;
+		cur += 8;
+		pos += 8;
+	}
+
+	interpolateScalar(dst, last, cur, pos, count);
+}
+
+SCUMMVM_TARGET_AVX2
+static int32 convolveAVX2(const st_sample_t *samples, const int16 *coefs, uint taps) {
+	__m256i sum = _mm256_setzero_si256();
+
+	for (uint i = 0; i < taps; i += 16) {
+		const __m256i s = _mm256_loadu_si256((const __m256i *)(samples + i));
+		const __m256i c = _mm256_loadu_si256((const __m256i *)(coefs + i));
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(s, c));
+	}
+
+	__m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(sum128);
+}
+
+static const RateKernels s_avx2Kernels = {
+	"AVX2",
+	mixStereoAVX2,
+	mixMonoAVX2,
+	interpolateAVX2,
+	convolveAVX2
+};
+
+#endif
+
+#pragma mark -
+
+const RateKernels &getRateKernels() {
+#ifdef SCUMMVM_AVX2
+	if (Common::hasCPUFeature(Common::kCpuFeatureAVX2))
+		return s_avx2Kernels;
+#endif
+#ifdef SCUMMVM_SSE2
+	if (Common::hasCPUFeature(Common::kCpuFeatureSSE2))
+		return s_sse2Kernels;
+#endif
+	return s_scalarKernels;
+}
+
+const RateKernels &getScalarRateKernels() {
+	return s_scalarKernels;
+}
+
+} // End of namespace Audio
@@ -0,0 +1,83 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef AUDIO_RATE_KERNELS_H
+#define AUDIO_RATE_KERNELS_H
+
+#include "common/scummsys.h"
+#include "common/frac.h"
+#include "audio/rate.h"
+
+namespace Audio {
+
+/**
+ * The inner loops of the rate converters. Each set of kernels produces
+ * exactly the same output; they only differ in the instruction set used.
+ *
+ * Volumes follow the RateConverter::flow conventions, i.e. a sample is
+ * scaled by vol / Mixer::kMaxMixerVolume (rounding towards zero) before
+ * it is added to the output with saturation.
+ */
+struct RateKernels {
+	/** Name of the implementation, for debug output and benchmarks. */
+	const char *name;
+
+	/**
+	 * Mix 'frames' interleaved stereo frames from src into dst. If
+	 * reverseStereo is set, the left input channel goes to the right
+	 * output channel and vice versa.
+	 */
+	void (*mixStereo)(st_sample_t *dst, const st_sample_t *src, uint frames, st_volume_t volL, st_volume_t volR, bool reverseStereo);
+
+	/**
+	 * Mix 'frames' mono samples from src into both channels of dst.
+	 */
+	void (*mixMono)(st_sample_t *dst, const st_sample_t *src, uint frames, st_volume_t volL, st_volume_t volR);
+
+	/**
+	 * Linearly interpolate 'count' samples:
+	 *   dst[i] = last[i] + (((cur[i] - last[i]) * pos[i] + FRAC_HALF) >> FRAC_BITS)
+	 */
+	void (*interpolate)(st_sample_t *dst, const st_sample_t *last, const st_sample_t *cur, const frac_t *pos, uint count);
+
+	/**
+	 * Compute the dot product of 'taps' samples and filter coefficients.
+	 * 'taps' must be a multiple of 16. The caller has to make sure that
+	 * the sum cannot overflow 32 bits.
+	 */
+	int32 (*convolve)(const st_sample_t *samples, const int16 *coefs, uint taps);
+};
+
+/**
+ * Return the fastest kernels the CPU supports, taking features disabled
+ * with Common::setDisabledCPUFeatures() into account.
+ */
+const RateKernels &getRateKernels();
+
+/**
+ * Return the plain C++ reference kernels.
+ */
+const RateKernels &getScalarRateKernels();
+
+} // End of namespace Audio
+
+#endif
@@ -0,0 +1,388 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "audio/audiostream.h"
+#include "audio/rate_sinc.h"
+#include "audio/rate_kernels.h"
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#include <math.h>
+
+namespace Audio {
+
+enum {
+	/** Filter coefficients are fixed point numbers with this many fractional bits. */
+	kSincCoefBits = 14,
+
+	/**
+	 * Upper limit for the number of filter phases in a table. Rate pairs
+	 * which need more phases (e.g. 44100 -> 48000 needs 160, but 8000 ->
+	 * 44100 needs 441) use the phase closest to the exact position.
+	 */
+	kSincMaxPhases = 512,
+
+	/** Number of output frames converted before mixing them. */
+	kSincBlockFrames = 256,
+
+	/** Input frames read from the stream at once. */
+	kSincReadFrames = 512,
+
+	/** Size of the per channel input history. */
+	kSincHistorySize = 1024
+};
+
+#pragma mark -
+#pragma mark --- Filter tables ---
+#pragma mark -
+
+/**
+ * Zeroth order modified Bessel function of the first kind, needed for the
+ * Kaiser window.
+ */
+static double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32; ++k) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+/**
+ * Windowed sinc low pass filters for one resampling ratio, one filter per
+ * fractional position ("phase") of the output samples between two input
+ * samples. Shared by all converters which use the same ratio and number of
+ * taps.
+ */
+class SincFilter {
+public:
+	SincFilter(uint upFactor, uint downFactor, uint taps);
+	~SincFilter() { delete[] _coefs; }
+
+	/**
+	 * Return the filter for an output sample at 'phase' / upFactor input
+	 * samples after the center of the filter window.
+	 */
+	const int16 *getPhase(uint phase) const {
+		const uint index = (phase * _phases + _upFactor / 2) / _upFactor;
+		return _coefs + index * _taps;
+	}
+
+	uint getUpFactor() const { return _upFactor; }
+	uint getDownFactor() const { return _downFactor; }
+	uint getTaps() const { return _taps; }
+
+	int _refCount;
+
+private:
+	const uint _upFactor;
+	const uint _downFactor;
+	const uint _taps;
+	uint _phases;
+
+	/** (_phases + 1) rows of _taps coefficients each. */
+	int16 *_coefs;
+};
+
+SincFilter::SincFilter(uint upFactor, uint downFactor, uint taps)
+	: _refCount(0), _upFactor(upFactor), _downFactor(downFactor), _taps(taps) {
+	_phases = MIN<uint>(upFactor, kSincMaxPhases);
+	_coefs = new int16[(_phases + 1) * taps];
+
+	// When downsampling, the cutoff has to move down to the new Nyquist
+	// frequency. The transition band of a short filter is wide, so start it
+	// a bit below that to reduce aliasing.
+	const double cutoff = 0.5 * MIN<double>(1.0, (double)upFactor / downFactor) * (taps >= 32 ? 0.94 : 0.88);
+	const double beta = (taps >= 32) ? 8.0 : 6.0;
+	const double halfWidth = taps / 2.0;
+	const double center = taps / 2 - 1;
+
+	double *filter = new double[taps];
+
+	// Row 'phases' is the filter for the position of the next input
+	// sample, which getPhase() rounds to for phases close to upFactor.
+	for (uint p = 0; p <= _phases; ++p) {
+		const double offset = center + (double)p / _phases;
+		double sum = 0.0;
+
+		for (uint i = 0; i < taps; ++i) {
+			const double x = i - offset;
+			const double sinc = (x == 0.0) ? 1.0 : sin(2 * M_PI * cutoff * x) / (2 * M_PI * cutoff * x);
+			const double r = x / halfWidth;
+			const double window = (r <= -1.0 || r >= 1.0) ? 0.0 : besselI0(beta * sqrt(1.0 - r * r)) / besselI0(beta);
+			filter[i] = 2 * cutoff * sinc * window;
+			sum += filter[i];
+		}
+
+		// Normalize to unity gain, so that a constant signal stays the same,
+		// and put the rounding error into the largest coefficient.
+		int16 *row = _coefs + p * taps;
+		int total = 0;
+		uint peak = 0;
+		for (uint i = 0; i < taps; ++i) {
+			row[i] = (int16)floor(filter[i] / sum * (1 << kSincCoefBits) + 0.5);
+			total += row[i];
+			if (row[i] > row[peak])
+				peak = i;
+		}
+		row[peak] += (1 << kSincCoefBits) - total;
+	}
+
+	delete[] filter;
+}
+
+/**
+ * All filters currently in use. Access is not synchronized; see the note
+ * on makeRateConverter().
+ */
+static Common::Array<SincFilter *> *s_sincFilters = 0;
+
+static SincFilter *acquireSincFilter(uint upFactor, uint downFactor, uint taps) {
+	if (!s_sincFilters)
+		s_sincFilters = new Common::Array<SincFilter *>();
+
+	SincFilter *filter = 0;
+	for (uint i = 0; i < s_sincFilters->size(); ++i) {
+		SincFilter *f = (*s_sincFilters)[i];
+		if (f->getUpFactor() == upFactor && f->getDownFactor() == downFactor && f->getTaps() == taps) {
+			filter = f;
+			break;
+		}
+	}
+
+	if (!filter) {
+		filter = new SincFilter(upFactor, downFactor, taps);
+		s_sincFilters->push_back(filter);
+	}
+
+	filter->_refCount++;
+	return filter;
+}
+
+static void releaseSincFilter(SincFilter *filter) {
+	if (--filter->_refCount > 0)
+		return;
+
+	for (uint i = 0; i < s_sincFilters->size(); ++i) {
+		if ((*s_sincFilters)[i] == filter) {
+			s_sincFilters->remove_at(i);
+			break;
+		}
+	}
+	delete filter;
+
+	if (s_sincFilters->empty()) {
+		delete s_sincFilters;
+		s_sincFilters = 0;
+	}
+}
+
+#pragma mark -
+#pragma mark --- Converter ---
+#pragma mark -
+
+/**
+ * Audio rate converter using a polyphase windowed sinc filter.
+ *
+ * The input is kept per channel in a history buffer, so that each output
+ * sample is a single dot product of the input window and the filter phase
+ * for the output position. Output is produced in blocks, which are then
+ * mixed into the output buffer in one go.
+ */
+template<bool stereo, bool reverseStereo>
+class SincRateConverter : public RateConverter {
+public:
+	SincRateConverter(st_rate_t inrate, st_rate_t outrate, uint taps);
+	~SincRateConverter();
+
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+		return ST_SUCCESS;
+	}
+
+	bool hasPendingOutput() const {
+		return _endOfInput && _readPos + _taps <= _historyLen;
+	}
+
+private:
+	bool fillWindow(AudioStream &input);
+
+	st_sample_t filterSample(const st_sample_t *window, const int16 *coefs) const {
+		int32 val = (_kernels.convolve(window, coefs, _taps) + (1 << (kSincCoefBits - 1))) >> kSincCoefBits;
+		return (st_sample_t)CLIP<int32>(val, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+	}
+
+	SincFilter *_filter;
+	const RateKernels &_kernels;
+	const uint _taps;
+
+	/** Input position advance per output sample: _step + _phaseStep / upFactor. */
+	uint _step, _phaseStep;
+	uint _phase;
+
+	/** De-interleaved input; the filter window starts at _readPos. */
+	st_sample_t _history[stereo ? 2 : 1][kSincHistorySize];
+	uint _historyLen;
+	uint _readPos;
+	/** The input stream ended, and the history has been padded with silence. */
+	bool _endOfInput;
+
+	st_sample_t _inBuf[kSincReadFrames * 2];
+	st_sample_t _outBuf[kSincBlockFrames * 2];
+};
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::SincRateConverter(st_rate_t inrate, st_rate_t outrate, uint taps)
+	: _kernels(getRateKernels()), _taps(taps), _phase(0), _readPos(0), _endOfInput(false) {
+	if (inrate >= 65536 || outrate >= 65536) {
+		error("rate effect can only handle rates < 65536");
+	}
+
+	const uint g = Common::gcd<uint>(inrate, outrate);
+	_filter = acquireSincFilter(outrate / g, inrate / g, taps);
+
+	_step = _filter->getDownFactor() / _filter->getUpFactor();
+	_phaseStep = _filter->getDownFactor() % _filter->getUpFactor();
+
+	// The output position is at the center of the filter window, so start
+	// with half a window of silence.
+	_historyLen = taps / 2 - 1;
+	memset(_history, 0, sizeof(_history));
+}
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::~SincRateConverter() {
+	releaseSincFilter(_filter);
+}
+
+/**
+ * Make sure the whole filter window is in the history buffer.
+ *
+ * @return false if the input stream ran out of data
+ */
+template<bool stereo, bool reverseStereo>
+bool SincRateConverter<stereo, reverseStereo>::fillWindow(AudioStream &input) {
+	while (_readPos + _taps > _historyLen) {
+		// Discard the input we do not need anymore
+		const uint discard = MIN(_readPos, _historyLen);
+		if (discard) {
+			for (int c = 0; c < (stereo ? 2 : 1); ++c)
+				memmove(_history[c], _history[c] + discard, (_historyLen - discard) * sizeof(st_sample_t));
+			_historyLen -= discard;
+			_readPos -= discard;
+		}
+
+		if (_endOfInput)
+			return false;
+
+		const uint frames = MIN<uint>(kSincHistorySize - _historyLen, kSincReadFrames);
+		const int len = input.readBuffer(_inBuf, frames * (stereo ? 2 : 1));
+
+		const st_sample_t *in = _inBuf;
+		for (int i = 0; i < len / (stereo ? 2 : 1); ++i) {
+			_history[0][_historyLen] = *in++;
+			if (stereo)
+				_history[stereo ? 1 : 0][_historyLen] = *in++;
+			_historyLen++;
+		}
+
+		if (input.endOfStream()) {
+			// The filter window has to move past the last input frames to
+			// output them, as at the start of the stream. There is always
+			// room, since at most kSincReadFrames were added after less
+			// than a window of old input.
+			for (int c = 0; c < (stereo ? 2 : 1); ++c)
+				memset(_history[c] + _historyLen, 0, (_taps / 2) * sizeof(st_sample_t));
+			_historyLen += _taps / 2;
+			_endOfInput = true;
+		} else if (len <= 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template<bool stereo, bool reverseStereo>
+int SincRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t *ostart = obuf;
+	st_sample_t *oend = obuf + osamp * 2;
+	const uint upFactor = _filter->getUpFactor();
+
+	bool endOfInput = false;
+	while (obuf < oend && !endOfInput) {
+		const st_size_t blockFrames = MIN<st_size_t>((oend - obuf) / 2, kSincBlockFrames);
+		st_sample_t *out = _outBuf;
+		st_size_t frames = 0;
+
+		while (frames < blockFrames) {
+			if (!fillWindow(input)) {
+				endOfInput = true;
+				break;
+			}
+
+			const int16 *coefs = _filter->getPhase(_phase);
+			*out++ = filterSample(_history[0] + _readPos, coefs);
+			if (stereo)
+				*out++ = filterSample(_history[stereo ? 1 : 0] + _readPos, coefs);
+
+			// Advance to the next output position
+			_readPos += _step;
+			_phase += _phaseStep;
+			if (_phase >= upFactor) {
+				_phase -= upFactor;
+				_readPos++;
+			}
+			frames++;
+		}
+
+		if (stereo)
+			_kernels.mixStereo(obuf, _outBuf, frames, vol_l, vol_r, reverseStereo);
+		else if (reverseStereo)
+			_kernels.mixMono(obuf, _outBuf, frames, vol_r, vol_l);
+		else
+			_kernels.mixMono(obuf, _outBuf, frames, vol_l, vol_r);
+		obuf += frames * 2;
+	}
+
+	return (obuf - ostart) / 2;
+}
+
+RateConverter *makeSincRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo,
+                                     RateConverterQuality quality) {
+	const uint taps = (quality == kRateConverterQualityBest) ? 32 : 16;
+
+	if (stereo) {
+		if (reverseStereo)
+			return new SincRateConverter<true, true>(inrate, outrate, taps);
+		else
+			return new SincRateConverter<true, false>(inrate, outrate, taps);
+	} else
+		return new SincRateConverter<false, false>(inrate, outrate, taps);
+}
+
+} // End of namespace Audio
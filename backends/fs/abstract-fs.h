@@ -168,6 +168,18 @@ public:
 	 */
 	virtual Common::SeekableReadStream *createReadStream() = 0;
 
+	/**
+	 * Creates a SeekableReadStream instance corresponding to the file
+	 * referred by this node, which may map the file into memory, so that
+	 * it can be accessed in place with getView().
+	 *
+	 * The default implementation just calls createReadStream().
+	 *
+	 * @see Common::FSNode::createMappedReadStream()
+	 * @return pointer to the stream object, 0 in case of a failure
+	 */
+	virtual Common::SeekableReadStream *createMappedReadStream() { return createReadStream(); }
+
 	/**
 	 * Creates a WriteStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
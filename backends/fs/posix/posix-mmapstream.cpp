@@ -0,0 +1,104 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#if defined(POSIX)
+
+// Disable symbol overrides so that we can use open, mmap etc.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "backends/fs/posix/posix-mmapstream.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+PosixMmapStream::PosixMmapStream(const byte *data, uint32 size)
+	: _data(data), _size(size), _pos(0), _eos(false) {
+}
+
+PosixMmapStream::~PosixMmapStream() {
+	munmap(const_cast<byte *>(_data), _size);
+}
+
+PosixMmapStream *PosixMmapStream::makeFromPath(const Common::String &path) {
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return 0;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < (off_t)kMinMapSize || st.st_size > 0x7FFFFFFF) {
+		close(fd);
+		return 0;
+	}
+
+	void *data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after closing the file
+	close(fd);
+	if (data == MAP_FAILED)
+		return 0;
+
+	return new PosixMmapStream((const byte *)data, st.st_size);
+}
+
+bool PosixMmapStream::seek(int32 offs, int whence) {
+	int32 newPos;
+	switch (whence) {
+	case SEEK_END:
+		newPos = _size + offs;
+		break;
+	case SEEK_CUR:
+		newPos = _pos + offs;
+		break;
+	case SEEK_SET:
+	default:
+		newPos = offs;
+		break;
+	}
+
+	// Like fseek(), allow seeking past the end, but not before the start
+	if (newPos < 0)
+		return false;
+
+	_pos = newPos;
+	_eos = false;
+	return true;
+}
+
+uint32 PosixMmapStream::read(void *dataPtr, uint32 dataSize) {
+	if (_pos >= _size || dataSize > _size - _pos) {
+		dataSize = (_pos < _size) ? _size - _pos : 0;
+		_eos = true;
+	}
+
+	memcpy(dataPtr, _data + _pos, dataSize);
+	_pos += dataSize;
+	return dataSize;
+}
+
+const byte *PosixMmapStream::getView(uint32 offset, uint32 dataSize) {
+	if (offset > _size || dataSize > _size - offset)
+		return 0;
+	return _data + offset;
+}
+
+#endif
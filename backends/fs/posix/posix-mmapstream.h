@@ -0,0 +1,85 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef BACKENDS_FS_POSIX_MMAPSTREAM_H
+#define BACKENDS_FS_POSIX_MMAPSTREAM_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+#include "common/stream.h"
+#include "common/str.h"
+
+/**
+ * A read stream for a file which is mapped into memory with mmap().
+ *
+ * Reading only copies from the mapping, without any system calls, and
+ * getView() gives direct access to all of the file data. The pages are
+ * loaded on demand and shared with the system's file cache, so even huge
+ * archives don't use up memory of their own.
+ *
+ * Only created by POSIXFilesystemNode::createMappedReadStream(), for callers
+ * which asked for it.
+ *
+ * @note The file must not be truncated while it is mapped, since accessing
+ *       the missing part of the mapping would crash. The same goes for read
+ *       errors of the underlying storage.
+ */
+class PosixMmapStream : public Common::SeekableReadStream, public Common::NonCopyable {
+protected:
+	const byte *_data;
+	uint32 _size;
+	uint32 _pos;
+	bool _eos;
+
+	PosixMmapStream(const byte *data, uint32 size);
+
+public:
+	enum {
+		/**
+		 * Files smaller than this are not worth mapping; reading them
+		 * with stdio is just as fast.
+		 */
+		kMinMapSize = 64 * 1024
+	};
+
+	/**
+	 * Maps the file with the given path into memory.
+	 *
+	 * @return the new stream, or NULL if the file could not be opened or
+	 *         mapped, or is smaller than kMinMapSize
+	 */
+	static PosixMmapStream *makeFromPath(const Common::String &path);
+
+	virtual ~PosixMmapStream();
+
+	virtual bool eos() const { return _eos; }
+	virtual void clearErr() { _eos = false; }
+
+	virtual int32 pos() const { return _pos; }
+	virtual int32 size() const { return _size; }
+	virtual bool seek(int32 offs, int whence = SEEK_SET);
+	virtual uint32 read(void *dataPtr, uint32 dataSize);
+
+	virtual const byte *getView(uint32 offset, uint32 dataSize);
+};
+
+#endif
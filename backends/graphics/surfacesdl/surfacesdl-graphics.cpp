@@ -129,7 +129,7 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #endif
 	_overlayVisible(false),
 	_overlayscreen(0), _tmpscreen2(0),
-	_scalerProc(0), _screenChangeCount(0),
+	_scalerProc(0), _parallelScaler(0), _screenChangeCount(0), _numDirtyRects(0),
 	_mouseVisible(false), _mouseNeedsRedraw(false), _mouseData(0), _mouseSurface(0),
 	_mouseOrigSurface(0), _cursorDontScale(false), _cursorPaletteDisabled(true),
 	_currentShakePos(0), _newShakePos(0),
@@ -157,6 +157,7 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_mouseBackup.x = _mouseBackup.y = _mouseBackup.w = _mouseBackup.h = 0;
 
 	memset(&_mouseCurState, 0, sizeof(_mouseCurState));
+	memset(&_updateStats, 0, sizeof(_updateStats));
 
 	_graphicsMutex = g_system->createMutex();
 
@@ -165,6 +166,9 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 		_enableFocusRectDebugCode = ConfMan.getBool("use_sdl_debug_focusrect");
 #endif
 
+	if (ConfMan.hasKey("scaler_threads") && ConfMan.getInt("scaler_threads") > 0)
+		_parallelScaler = new Graphics::ParallelScaler(ConfMan.getInt("scaler_threads"));
+
 	SDL_ShowCursor(SDL_DISABLE);
 
 	memset(&_oldVideoMode, 0, sizeof(_oldVideoMode));
@@ -204,6 +208,7 @@ SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
 	if (_mouseOrigSurface)
 		SDL_FreeSurface(_mouseOrigSurface);
 	_mouseOrigSurface = 0;
+	delete _parallelScaler;
 	g_system->deleteMutex(_graphicsMutex);
 
 	free(_currentPalette);
@@ -1047,6 +1052,8 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	if (_mouseNeedsRedraw)
 		undrawMouse();
 
+	collectDirtyRects();
+
 	// Force a full redraw if requested
 	if (_forceFull) {
 		_numDirtyRects = 1;
@@ -1063,6 +1070,12 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		uint32 srcPitch, dstPitch;
 		SDL_Rect *lastRect = _dirtyRectList + _numDirtyRects;
 
+		_updateStats.updates++;
+		if (_forceFull)
+			_updateStats.fullUpdates++;
+		_updateStats.rects = _numDirtyRects;
+		_updateStats.scaledPixels = 0;
+
 		for (r = _dirtyRectList; r != lastRect; ++r) {
 			dst = *r;
 			dst.x++;	// Shift rect by one since 2xSai needs to access the data around
@@ -1096,8 +1109,14 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+				const byte *srcPtr = (byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch;
+				byte *dstPtr = (byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch;
+				if (_parallelScaler)
+					_parallelScaler->scale(scalerProc, scale1, srcPtr, srcPitch, dstPtr, dstPitch, r->w, dst_h);
+				else
+					scalerProc(srcPtr, srcPitch, dstPtr, dstPitch, r->w, dst_h);
+
+				_updateStats.scaledPixels += r->w * dst_h;
 			}
 
 			r->x = rx1;
@@ -1113,6 +1132,10 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		SDL_UnlockSurface(srcSurf);
 		SDL_UnlockSurface(_hwscreen);
 
+		debug(8, "updateScreen: %u rects, %u of %d pixels scaled, %u of %u updates full",
+			_updateStats.rects, _updateStats.scaledPixels, width * height,
+			_updateStats.fullUpdates, _updateStats.updates);
+
 		// Readjust the dirty rect list in case we are doing a full update.
 		// This is necessary if shaking is active.
 		if (_forceFull) {
@@ -1347,7 +1370,7 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 	if (_forceFull)
 		return;
 
-	if (_numDirtyRects == NUM_DIRTY_RECT) {
+	if (realCoordinates && _numDirtyRects == NUM_DIRTY_RECT) {
 		_forceFull = true;
 		return;
 	}
@@ -1390,18 +1413,82 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 		h = height - y;
 	}
 
-#ifdef USE_SCALERS
-	if (_videoMode.aspectRatioCorrection && !_overlayVisible && !realCoordinates) {
-		makeRectStretchable(x, y, w, h);
+	if (w == width && h == height) {
+		_forceFull = true;
+		return;
 	}
-#endif
 
-	if (w == width && h == height) {
+	if (w <= 0 || h <= 0)
+		return;
+
+	if (realCoordinates) {
+		// These are added while the screen is updated, after the dirty rects
+		// have been scaled, and go to the list directly.
+		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
+
+		r->x = x;
+		r->y = y;
+		r->w = w;
+		r->h = h;
+		return;
+	}
+
+	if (_dirtyTracker.getWidth() != width || _dirtyTracker.getHeight() != height) {
+		// The screen size changed since the last update
+		_dirtyTracker.resize(width, height);
+		_forceFull = true;
+		return;
+	}
+
+	_dirtyTracker.addRect(Common::Rect(x, y, x + w, y + h));
+}
+
+void SurfaceSdlGraphicsManager::collectDirtyRects() {
+	int height, width;
+
+	if (!_overlayVisible) {
+		width = _videoMode.screenWidth;
+		height = _videoMode.screenHeight;
+	} else {
+		width = _videoMode.overlayWidth;
+		height = _videoMode.overlayHeight;
+	}
+
+	if (_dirtyTracker.getWidth() != width || _dirtyTracker.getHeight() != height) {
+		_dirtyTracker.resize(width, height);
+		_forceFull = true;
+	}
+
+	if (_forceFull || _dirtyTracker.isEmpty()) {
+		_dirtyTracker.clear();
+		return;
+	}
+
+	// Updating the whole screen at once is cheaper than doing most of it in
+	// many small pieces
+	if (_dirtyTracker.getDirtyArea() >= (uint32)width * height / 4 * 3) {
+		_dirtyTracker.clear();
 		_forceFull = true;
 		return;
 	}
 
-	if (w > 0 && h > 0) {
+	// Leave room for the mouse cursor, which is added after scaling
+	Common::Rect rects[NUM_DIRTY_RECT];
+	const int numRects = _dirtyTracker.getRects(rects, NUM_DIRTY_RECT - 1 - _numDirtyRects);
+	_dirtyTracker.clear();
+
+	for (int i = 0; i < numRects; ++i) {
+		int x = rects[i].left;
+		int y = rects[i].top;
+		int w = rects[i].width();
+		int h = rects[i].height();
+
+#ifdef USE_SCALERS
+		if (_videoMode.aspectRatioCorrection && !_overlayVisible) {
+			makeRectStretchable(x, y, w, h);
+		}
+#endif
+
 		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
 
 		r->x = x;
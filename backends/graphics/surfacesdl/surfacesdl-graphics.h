@@ -25,8 +25,10 @@
 
 #include "backends/graphics/graphics.h"
 #include "backends/graphics/sdl/sdl-graphics.h"
+#include "graphics/dirtyrects.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
+#include "graphics/scaler/parallel.h"
 #include "common/events.h"
 #include "common/system.h"
 
@@ -232,6 +234,9 @@ protected:
 	int _scalerType;
 	int _transactionMode;
 
+	/** Scales big dirty rects on several threads; NULL if disabled */
+	Graphics::ParallelScaler *_parallelScaler;
+
 	// Indicates whether it is needed to free _hwsurface in destructor
 	bool _displayDisabled;
 
@@ -249,6 +254,21 @@ protected:
 	SDL_Rect _dirtyRectList[NUM_DIRTY_RECT];
 	int _numDirtyRects;
 
+	/**
+	 * The dirty parts of the game screen or overlay since the last update.
+	 * They are moved to _dirtyRectList by collectDirtyRects().
+	 */
+	Graphics::DirtyRectTracker _dirtyTracker;
+
+	/** Counters for the screen updates, shown at debug level 8 */
+	struct UpdateStats {
+		uint32 updates;         ///< screen updates which redrew anything
+		uint32 fullUpdates;     ///< of those, the ones which redrew the whole screen
+		uint32 rects;           ///< dirty rects drawn in the last update
+		uint32 scaledPixels;    ///< source pixels scaled in the last update
+	};
+	UpdateStats _updateStats;
+
 	struct MousePos {
 		// The mouse position, using either virtual (game) or real
 		// (overlay) coordinates.
@@ -317,6 +337,14 @@ protected:
 
 	virtual void addDirtyRect(int x, int y, int w, int h, bool realCoordinates = false);
 
+	/**
+	 * Fill _dirtyRectList with the dirty parts of the screen, as combined by
+	 * _dirtyTracker. If they cover most of the screen, _forceFull is set
+	 * instead, since redrawing it in one go is faster. Has to be called by
+	 * internUpdateScreen() after undrawing the mouse.
+	 */
+	void collectDirtyRects();
+
 	virtual void drawMouse();
 	virtual void undrawMouse();
 	virtual void blitCursor();
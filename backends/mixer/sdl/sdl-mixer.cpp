@@ -93,6 +93,15 @@ void SdlMixerManager::init() {
 
 		_mixer = new Audio::MixerImpl(g_system, _obtained.freq);
 		assert(_mixer);
+
+		// Keep the SDL audio thread from ever waiting on engine threads
+		if (ConfMan.hasKey("mixer_command_queue") && ConfMan.getBool("mixer_command_queue"))
+			_mixer->setCommandQueueMode(true);
+
+		// Decode streams on worker threads instead of in the audio thread
+		if (ConfMan.hasKey("mixer_prefetch_threads"))
+			_mixer->setPrefetchThreads(ConfMan.getInt("mixer_prefetch_threads"));
+
 		_mixer->setReady(true);
 
 		startAudio();
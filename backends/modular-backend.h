@@ -115,6 +115,18 @@ public:
 
 	//@}
 
+	/** @name Thread handling */
+	//@{
+
+	virtual ThreadRef createThread(ThreadProc proc, void *param);
+	virtual void joinThread(ThreadRef thread);
+	virtual SemaphoreRef createSemaphore(uint initialValue);
+	virtual void waitSemaphore(SemaphoreRef semaphore);
+	virtual void postSemaphore(SemaphoreRef semaphore);
+	virtual void deleteSemaphore(SemaphoreRef semaphore);
+
+	//@}
+
 	/** @name Sound */
 	//@{
 
@@ -38,6 +38,17 @@ public:
 	virtual void lockMutex(OSystem::MutexRef mutex) = 0;
 	virtual void unlockMutex(OSystem::MutexRef mutex) = 0;
 	virtual void deleteMutex(OSystem::MutexRef mutex) = 0;
+
+	/**
+	 * Thread support is optional, the default implementations report that
+	 * no threads can be created.
+	 */
+	virtual OSystem::ThreadRef createThread(OSystem::ThreadProc proc, void *param) { return 0; }
+	virtual void joinThread(OSystem::ThreadRef thread) {}
+	virtual OSystem::SemaphoreRef createSemaphore(uint initialValue) { return 0; }
+	virtual void waitSemaphore(OSystem::SemaphoreRef semaphore) {}
+	virtual void postSemaphore(OSystem::SemaphoreRef semaphore) {}
+	virtual void deleteSemaphore(OSystem::SemaphoreRef semaphore) {}
 };
 
 #endif
@@ -44,4 +44,32 @@ void SdlMutexManager::deleteMutex(OSystem::MutexRef mutex) {
 	SDL_DestroyMutex((SDL_mutex *)mutex);
 }
 
+OSystem::ThreadRef SdlMutexManager::createThread(OSystem::ThreadProc proc, void *param) {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	return (OSystem::ThreadRef) SDL_CreateThread(proc, "ScummVM worker", param);
+#else
+	return (OSystem::ThreadRef) SDL_CreateThread(proc, param);
+#endif
+}
+
+void SdlMutexManager::joinThread(OSystem::ThreadRef thread) {
+	SDL_WaitThread((SDL_Thread *)thread, NULL);
+}
+
+OSystem::SemaphoreRef SdlMutexManager::createSemaphore(uint initialValue) {
+	return (OSystem::SemaphoreRef) SDL_CreateSemaphore(initialValue);
+}
+
+void SdlMutexManager::waitSemaphore(OSystem::SemaphoreRef semaphore) {
+	SDL_SemWait((SDL_sem *)semaphore);
+}
+
+void SdlMutexManager::postSemaphore(OSystem::SemaphoreRef semaphore) {
+	SDL_SemPost((SDL_sem *)semaphore);
+}
+
+void SdlMutexManager::deleteSemaphore(OSystem::SemaphoreRef semaphore) {
+	SDL_DestroySemaphore((SDL_sem *)semaphore);
+}
+
 #endif
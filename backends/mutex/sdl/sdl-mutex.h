@@ -26,7 +26,7 @@
 #include "backends/mutex/mutex.h"
 
 /**
- * SDL mutex manager
+ * SDL mutex manager, also providing threads and semaphores
  */
 class SdlMutexManager : public MutexManager {
 public:
@@ -34,6 +34,13 @@ public:
 	virtual void lockMutex(OSystem::MutexRef mutex);
 	virtual void unlockMutex(OSystem::MutexRef mutex);
 	virtual void deleteMutex(OSystem::MutexRef mutex);
+
+	virtual OSystem::ThreadRef createThread(OSystem::ThreadProc proc, void *param);
+	virtual void joinThread(OSystem::ThreadRef thread);
+	virtual OSystem::SemaphoreRef createSemaphore(uint initialValue);
+	virtual void waitSemaphore(OSystem::SemaphoreRef semaphore);
+	virtual void postSemaphore(OSystem::SemaphoreRef semaphore);
+	virtual void deleteSemaphore(OSystem::SemaphoreRef semaphore);
 };
 
 
@@ -37,6 +37,7 @@
 
 #include <errno.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -79,6 +80,12 @@ bool OSystem_POSIX::hasFeature(Feature f) {
 	return OSystem_SDL::hasFeature(f);
 }
 
+uint32 OSystem_POSIX::getMicros() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint32)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
 Common::String OSystem_POSIX::getDefaultConfigFileName() {
 	char configFile[MAXPATHLEN];
 
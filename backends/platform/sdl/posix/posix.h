@@ -33,6 +33,8 @@ public:
 
 	virtual bool hasFeature(Feature f);
 
+	virtual uint32 getMicros();
+
 	virtual bool displayLogFile();
 
 	virtual void init();
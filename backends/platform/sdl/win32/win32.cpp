@@ -91,6 +91,17 @@ bool OSystem_Win32::hasFeature(Feature f) {
 	return OSystem_SDL::hasFeature(f);
 }
 
+uint32 OSystem_Win32::getMicros() {
+	LARGE_INTEGER frequency, counter;
+	if (!QueryPerformanceFrequency(&frequency) || !QueryPerformanceCounter(&counter))
+		return OSystem_SDL::getMicros();
+
+	// Split up to avoid overflowing on systems with a long uptime
+	const LONGLONG seconds = counter.QuadPart / frequency.QuadPart;
+	const LONGLONG rest = counter.QuadPart % frequency.QuadPart;
+	return (uint32)(seconds * 1000000 + rest * 1000000 / frequency.QuadPart);
+}
+
 bool OSystem_Win32::displayLogFile() {
 	if (_logFilePath.empty())
 		return false;
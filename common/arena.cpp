@@ -0,0 +1,349 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "common/arena.h"
+#include "common/mutex.h"
+#include "common/util.h"
+
+namespace Common {
+
+namespace {
+
+const size_t s_classSizes[SizeClassAllocator::kNumSizeClasses] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512
+};
+
+/** Like StackLock, but does nothing for allocators which are not thread safe. */
+class AllocatorLock {
+	Mutex *_mutex;
+public:
+	explicit AllocatorLock(Mutex *mutex) : _mutex(mutex) {
+		if (_mutex)
+			_mutex->lock();
+	}
+	~AllocatorLock() {
+		if (_mutex)
+			_mutex->unlock();
+	}
+};
+
+void clearStats(AllocatorStats &stats) {
+	stats.allocations = 0;
+	stats.deallocations = 0;
+	stats.mallocs = 0;
+	stats.peakBytesInUse = stats.bytesInUse;
+}
+
+void addBytesInUse(AllocatorStats &stats, int bytes) {
+	stats.bytesInUse += bytes;
+	if (stats.peakBytesInUse < stats.bytesInUse)
+		stats.peakBytesInUse = stats.bytesInUse;
+}
+
+/** Round ptr up to the next multiple of alignment, which must be a power of two. */
+byte *alignPointer(byte *ptr, size_t alignment) {
+	return (byte *)(((size_t)ptr + alignment - 1) & ~(alignment - 1));
+}
+
+} // End of anonymous namespace
+
+#pragma mark -
+
+SizeClassAllocator::SizeClassAllocator(bool threadSafe)
+	: _mutex(threadSafe ? new Mutex() : 0), _cacheCount(0) {
+	for (int i = 0; i < kNumSizeClasses; ++i)
+		_pools[i] = new MemoryPool(s_classSizes[i]);
+
+	_stats.bytesInUse = 0;
+	clearStats(_stats);
+}
+
+SizeClassAllocator::~SizeClassAllocator() {
+	assert(_cacheCount == 0);
+
+	for (int i = 0; i < kNumSizeClasses; ++i)
+		delete _pools[i];
+	delete _mutex;
+}
+
+int SizeClassAllocator::getSizeClass(size_t size) {
+	if (size <= 64)
+		return (MAX<size_t>(size, 1) + 15) / 16 - 1;
+
+	for (int i = 4; i < kNumSizeClasses; ++i) {
+		if (size <= s_classSizes[i])
+			return i;
+	}
+	return -1;
+}
+
+size_t SizeClassAllocator::getClassSize(int sizeClass) {
+	assert(sizeClass >= 0 && sizeClass < kNumSizeClasses);
+	return s_classSizes[sizeClass];
+}
+
+void *SizeClassAllocator::allocLocked(int sizeClass) {
+	MemoryPool &pool = *_pools[sizeClass];
+	const size_t pages = pool.getPageCount();
+	void *ptr = pool.allocChunk();
+	_stats.mallocs += pool.getPageCount() - pages;
+	return ptr;
+}
+
+void *SizeClassAllocator::allocate(size_t size) {
+	const int sizeClass = getSizeClass(size);
+	AllocatorLock lock(_mutex);
+
+	_stats.allocations++;
+	addBytesInUse(_stats, size);
+
+	if (sizeClass < 0) {
+		_stats.mallocs++;
+		return ::malloc(size);
+	}
+	return allocLocked(sizeClass);
+}
+
+void SizeClassAllocator::deallocate(void *ptr, size_t size) {
+	if (!ptr)
+		return;
+
+	const int sizeClass = getSizeClass(size);
+	AllocatorLock lock(_mutex);
+
+	_stats.deallocations++;
+	_stats.bytesInUse -= size;
+
+	if (sizeClass < 0)
+		::free(ptr);
+	else
+		_pools[sizeClass]->freeChunk(ptr);
+}
+
+void SizeClassAllocator::freeUnusedPages() {
+	AllocatorLock lock(_mutex);
+	for (int i = 0; i < kNumSizeClasses; ++i)
+		_pools[i]->freeUnusedPages();
+}
+
+AllocatorStats SizeClassAllocator::getStats() const {
+	AllocatorLock lock(_mutex);
+	return _stats;
+}
+
+void SizeClassAllocator::resetStats() {
+	AllocatorLock lock(_mutex);
+	clearStats(_stats);
+}
+
+void SizeClassAllocator::mergeStats(const AllocatorStats &stats, int bytesInUse) {
+	// Called with the mutex locked
+	_stats.allocations += stats.allocations;
+	_stats.deallocations += stats.deallocations;
+	_stats.mallocs += stats.mallocs;
+	addBytesInUse(_stats, bytesInUse);
+}
+
+#pragma mark -
+
+SizeClassAllocator::Cache::Cache(SizeClassAllocator &allocator)
+	: _allocator(allocator), _bytesInUse(0) {
+	for (int i = 0; i < kNumSizeClasses; ++i) {
+		_free[i].head = 0;
+		_free[i].count = 0;
+	}
+
+	_stats.bytesInUse = 0;
+	clearStats(_stats);
+
+	AllocatorLock lock(_allocator._mutex);
+	_allocator._cacheCount++;
+}
+
+SizeClassAllocator::Cache::~Cache() {
+	flush();
+
+	AllocatorLock lock(_allocator._mutex);
+	_allocator._cacheCount--;
+}
+
+void *SizeClassAllocator::Cache::allocate(size_t size) {
+	_stats.allocations++;
+	_bytesInUse += size;
+
+	const int sizeClass = getSizeClass(size);
+	if (sizeClass < 0) {
+		_stats.mallocs++;
+		return ::malloc(size);
+	}
+
+	FreeList &list = _free[sizeClass];
+	if (!list.head)
+		refill(sizeClass);
+
+	void *ptr = list.head;
+	list.head = *(void **)ptr;
+	list.count--;
+	return ptr;
+}
+
+void SizeClassAllocator::Cache::deallocate(void *ptr, size_t size) {
+	if (!ptr)
+		return;
+
+	_stats.deallocations++;
+	_bytesInUse -= size;
+
+	const int sizeClass = getSizeClass(size);
+	if (sizeClass < 0) {
+		::free(ptr);
+		return;
+	}
+
+	FreeList &list = _free[sizeClass];
+	*(void **)ptr = list.head;
+	list.head = ptr;
+
+	// Don't hoard memory other threads might need
+	if (++list.count >= 2 * kBatchSize) {
+		AllocatorLock lock(_allocator._mutex);
+		release(sizeClass, kBatchSize);
+
+		_allocator.mergeStats(_stats, _bytesInUse);
+		clearStats(_stats);
+		_bytesInUse = 0;
+	}
+}
+
+void SizeClassAllocator::Cache::refill(int sizeClass) {
+	FreeList &list = _free[sizeClass];
+	AllocatorLock lock(_allocator._mutex);
+
+	for (uint i = 0; i < kBatchSize; ++i) {
+		void *ptr = _allocator.allocLocked(sizeClass);
+		*(void **)ptr = list.head;
+		list.head = ptr;
+	}
+	list.count += kBatchSize;
+
+	_allocator.mergeStats(_stats, _bytesInUse);
+	clearStats(_stats);
+	_bytesInUse = 0;
+}
+
+void SizeClassAllocator::Cache::release(int sizeClass, uint count) {
+	// Called with the mutex locked
+	FreeList &list = _free[sizeClass];
+	MemoryPool &pool = *_allocator._pools[sizeClass];
+
+	for (uint i = 0; i < count && list.head; ++i) {
+		void *ptr = list.head;
+		list.head = *(void **)ptr;
+		list.count--;
+		pool.freeChunk(ptr);
+	}
+}
+
+void SizeClassAllocator::Cache::flush() {
+	AllocatorLock lock(_allocator._mutex);
+
+	for (int i = 0; i < kNumSizeClasses; ++i)
+		release(i, _free[i].count);
+
+	_allocator.mergeStats(_stats, _bytesInUse);
+	clearStats(_stats);
+	_bytesInUse = 0;
+}
+
+#pragma mark -
+
+FrameArena::FrameArena(size_t blockSize)
+	: _blockSize(blockSize), _currentBlock(0), _pos(0), _end(0), _frameAllocations(0) {
+	assert(blockSize >= 4 * kAlignment);
+	_stats.bytesInUse = 0;
+	clearStats(_stats);
+}
+
+FrameArena::~FrameArena() {
+	reset();
+	for (uint i = 0; i < _blocks.size(); ++i)
+		::free(_blocks[i]);
+}
+
+void *FrameArena::allocate(size_t size) {
+	size = (size + kAlignment - 1) & ~(size_t)(kAlignment - 1);
+
+	_stats.allocations++;
+	_frameAllocations++;
+	addBytesInUse(_stats, size);
+
+	if (size > _blockSize / 4) {
+		// malloc() only guarantees the alignment of fundamental types
+		byte *block = (byte *)::malloc(size + kAlignment - 1);
+		assert(block);
+		_bigBlocks.push_back(block);
+		_stats.mallocs++;
+		return alignPointer(block, kAlignment);
+	}
+
+	if (size > (size_t)(_end - _pos))
+		nextBlock(size);
+
+	void *ptr = _pos;
+	_pos += size;
+	return ptr;
+}
+
+void FrameArena::nextBlock(size_t size) {
+	if (_pos)
+		_currentBlock++;
+
+	if (_currentBlock == _blocks.size()) {
+		byte *block = (byte *)::malloc(_blockSize + kAlignment - 1);
+		assert(block);
+		_blocks.push_back(block);
+		_stats.mallocs++;
+	}
+
+	_pos = alignPointer(_blocks[_currentBlock], kAlignment);
+	_end = _pos + _blockSize;
+	assert(size <= _blockSize);
+}
+
+void FrameArena::reset() {
+	for (uint i = 0; i < _bigBlocks.size(); ++i)
+		::free(_bigBlocks[i]);
+	_bigBlocks.clear();
+
+	_stats.deallocations += _frameAllocations;
+	_stats.bytesInUse = 0;
+	_frameAllocations = 0;
+
+	_currentBlock = 0;
+	_pos = _end = 0;
+}
+
+void FrameArena::resetStats() {
+	clearStats(_stats);
+}
+
+} // End of namespace Common
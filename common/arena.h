@@ -0,0 +1,249 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef COMMON_ARENA_H
+#define COMMON_ARENA_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/memorypool.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+class Mutex;
+
+/**
+ * Allocation statistics of a SizeClassAllocator or FrameArena.
+ *
+ * The counters only ever grow (until resetStats() is called), so the
+ * number of e.g. mallocs per frame is the difference between two samples.
+ */
+struct AllocatorStats {
+	uint32 allocations;       ///< calls to allocate()
+	uint32 deallocations;     ///< calls to deallocate()
+	uint32 mallocs;           ///< memory blocks the allocator got from malloc()
+	uint32 bytesInUse;        ///< bytes currently handed out to callers
+	uint32 peakBytesInUse;    ///< the maximum of bytesInUse so far
+};
+
+/**
+ * A general purpose allocator for small objects.
+ *
+ * Requests are rounded up to one of a few size classes (see kMaxSize), each
+ * of which is served by its own MemoryPool. Bigger requests are passed to
+ * malloc(). Like for the C++ sized delete operator, the caller must pass the
+ * size it allocated to deallocate(); classes can simply forward their
+ * operator new / operator delete to an allocator.
+ *
+ * All methods may be called from any thread, if the allocator was created
+ * thread safe. To avoid locking for every allocation, each thread may in
+ * addition use a Cache, which keeps some free chunks of each size class for
+ * itself.
+ */
+class SizeClassAllocator : NonCopyable {
+public:
+	enum {
+		kNumSizeClasses = 10,
+		/** Allocations bigger than this are passed to malloc(). */
+		kMaxSize = 512
+	};
+
+	class Cache;
+
+	/**
+	 * Create an allocator. If threadSafe is false, the allocator and its
+	 * caches may only be used by one thread at a time, but do not need a
+	 * backend mutex.
+	 */
+	explicit SizeClassAllocator(bool threadSafe = true);
+
+	/**
+	 * Destroy the allocator, and the memory of all size classes with it.
+	 * All caches must have been destroyed before.
+	 */
+	~SizeClassAllocator();
+
+	/**
+	 * Allocate a block of at least the given size. All size classes are
+	 * multiples of 16 bytes, but the pool pages come from malloc(), so
+	 * blocks are only aligned like memory returned by malloc(). That is
+	 * not necessarily enough for SSE types on 32 bit systems.
+	 */
+	void *allocate(size_t size);
+
+	/**
+	 * Return a block obtained from allocate() (of this allocator or one of
+	 * its caches), which must be passed the same size.
+	 */
+	void deallocate(void *ptr, size_t size);
+
+	/**
+	 * Give pages which are completely unused back to the system. Memory
+	 * held by caches is still in use from the allocator's point of view.
+	 */
+	void freeUnusedPages();
+
+	/**
+	 * Return the statistics. Allocations served by a Cache are included
+	 * once the cache has exchanged chunks with the allocator or has been
+	 * flushed.
+	 */
+	AllocatorStats getStats() const;
+
+	/** Reset all statistics counters except bytesInUse. */
+	void resetStats();
+
+	/** Return the size class used for the given size, or -1 if it is too big. */
+	static int getSizeClass(size_t size);
+
+	/** Return the (maximum) size of blocks in the given size class. */
+	static size_t getClassSize(int sizeClass);
+
+private:
+	void *allocLocked(int sizeClass);
+	void mergeStats(const AllocatorStats &stats, int bytesInUse);
+
+	MemoryPool *_pools[kNumSizeClasses];
+	Mutex *_mutex;
+	AllocatorStats _stats;
+	uint _cacheCount;
+};
+
+/**
+ * Free chunks of a SizeClassAllocator reserved for one thread.
+ *
+ * A cache is not thread safe; each thread using the allocator should create
+ * its own. Blocks may be deallocated through a different cache (or through
+ * the allocator) than they were allocated from.
+ */
+class SizeClassAllocator::Cache : NonCopyable {
+public:
+	explicit Cache(SizeClassAllocator &allocator);
+
+	/** Return all cached chunks to the allocator. */
+	~Cache();
+
+	void *allocate(size_t size);
+	void deallocate(void *ptr, size_t size);
+
+	/**
+	 * Return all cached chunks and report the statistics to the allocator,
+	 * e.g. at the end of a frame.
+	 */
+	void flush();
+
+private:
+	enum {
+		/** Number of chunks moved between the cache and the allocator at once. */
+		kBatchSize = 16
+	};
+
+	struct FreeList {
+		void *head;
+		uint count;
+	};
+
+	void refill(int sizeClass);
+	void release(int sizeClass, uint count);
+
+	SizeClassAllocator &_allocator;
+	FreeList _free[kNumSizeClasses];
+	AllocatorStats _stats;
+	int _bytesInUse;
+};
+
+/**
+ * A bump allocator for temporary data which is freed all at once, e.g. at
+ * the end of each frame.
+ *
+ * Allocating only advances a pointer in the current memory block, and
+ * reset() makes all blocks available again without returning them to the
+ * system. Hence after the first few frames, no more mallocs happen. The
+ * destructors of objects in the arena are never called, so only put
+ * objects into it which do not need them.
+ *
+ * An arena is not thread safe.
+ */
+class FrameArena : NonCopyable {
+public:
+	enum {
+		/** Alignment of all allocations, enough for SSE types. */
+		kAlignment = 16
+	};
+
+	/**
+	 * Create an arena which gets its memory in blocks of the given size.
+	 * Allocations bigger than a quarter of a block get a block of their own.
+	 */
+	explicit FrameArena(size_t blockSize = 64 * 1024);
+	~FrameArena();
+
+	/** Allocate a block of at least the given size, valid until reset(). */
+	void *allocate(size_t size);
+
+	/**
+	 * Free all allocations at once. Regular blocks are kept for reuse,
+	 * blocks of big allocations are freed.
+	 */
+	void reset();
+
+	/**
+	 * Return the statistics. deallocations counts the allocations freed
+	 * by reset().
+	 */
+	const AllocatorStats &getStats() const { return _stats; }
+
+	/** Return the number of allocations made since the last reset(). */
+	uint32 getFrameAllocations() const { return _frameAllocations; }
+
+	/** Reset all statistics counters except bytesInUse. */
+	void resetStats();
+
+private:
+	void nextBlock(size_t size);
+
+	const size_t _blockSize;
+	Array<byte *> _blocks;
+	Array<byte *> _bigBlocks;
+	uint _currentBlock;
+	byte *_pos;
+	byte *_end;
+	AllocatorStats _stats;
+	uint32 _frameAllocations;
+};
+
+} // End of namespace Common
+
+/**
+ * Placement new operator allocating from a FrameArena, analogous to the one
+ * for MemoryPool.
+ */
+inline void *operator new(size_t nbytes, Common::FrameArena &arena) {
+	return arena.allocate(nbytes);
+}
+
+inline void operator delete(void *, Common::FrameArena &) {
+	// Only called if a constructor throws; the memory is freed on reset()
+}
+
+#endif
@@ -0,0 +1,178 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "common/asyncstream.h"
+#include "common/atomic.h"
+#include "common/threadpool.h"
+#include "common/util.h"
+
+namespace Common {
+
+AsyncReadStream::AsyncReadStream(SeekableReadStream *parentStream, uint32 blockSize, DisposeAfterUse::Flag disposeParentStream)
+	: _parentStream(parentStream), _disposeParentStream(disposeParentStream),
+	  _blockSize(blockSize), _size(parentStream->size()),
+	  _frontStart(parentStream->pos()), _frontSize(0), _frontPos(0), _frontLast(false),
+	  _backStart(0), _backSize(0), _backLast(false), _backErr(false), _filling(false), _filled(false),
+	  _eos(false), _err(false), _stalls(0) {
+	assert(parentStream);
+	assert(blockSize > 0);
+
+	_front = (byte *)malloc(_blockSize);
+	_back = (byte *)malloc(_blockSize);
+	assert(_front && _back);
+
+	_pool = new ThreadPool(1);
+	startFill(_frontStart);
+}
+
+AsyncReadStream::~AsyncReadStream() {
+	// Make sure the background thread is done with the parent stream
+	if (_filling)
+		_pool->waitForJobs();
+	delete _pool;
+
+	free(_front);
+	free(_back);
+
+	if (_disposeParentStream)
+		delete _parentStream;
+}
+
+void AsyncReadStream::fillJob(void *param) {
+	AsyncReadStream *stream = (AsyncReadStream *)param;
+	SeekableReadStream *parent = stream->_parentStream;
+
+	// Avoid seeking when reading sequentially, which may be expensive
+	if (parent->pos() != (int32)stream->_backStart)
+		parent->seek(stream->_backStart);
+
+	stream->_backSize = parent->read(stream->_back, stream->_blockSize);
+	stream->_backErr = parent->err();
+	stream->_backLast = stream->_backErr || parent->eos() || stream->_backSize < stream->_blockSize;
+
+	memoryBarrier();
+	stream->_filled = true;
+}
+
+void AsyncReadStream::startFill(uint32 start) {
+	assert(!_filling);
+	_backStart = start;
+	_filled = false;
+	_filling = true;
+	_pool->addJob(fillJob, this);
+}
+
+void AsyncReadStream::swapBuffers() {
+	assert(_filling);
+	if (!_filled)
+		++_stalls;
+	_pool->waitForJobs();
+	_filling = false;
+
+	SWAP(_front, _back);
+	_frontStart = _backStart;
+	_frontSize = _backSize;
+	_frontPos = 0;
+	_frontLast = _backLast;
+	if (_backErr)
+		_err = true;
+
+	if (!_frontLast)
+		startFill(_frontStart + _frontSize);
+}
+
+uint32 AsyncReadStream::read(void *dataPtr, uint32 dataSize) {
+	byte *dst = (byte *)dataPtr;
+	uint32 done = 0;
+
+	while (done < dataSize) {
+		if (_frontPos == _frontSize) {
+			if (_frontLast || !_filling) {
+				_eos = true;
+				break;
+			}
+			swapBuffers();
+			continue;
+		}
+
+		const uint32 n = MIN(dataSize - done, _frontSize - _frontPos);
+		memcpy(dst + done, _front + _frontPos, n);
+		_frontPos += n;
+		done += n;
+	}
+
+	return done;
+}
+
+bool AsyncReadStream::seek(int32 offset, int whence) {
+	int32 target;
+	switch (whence) {
+	case SEEK_END:
+		target = _size + offset;
+		break;
+	case SEEK_CUR:
+		target = pos() + offset;
+		break;
+	case SEEK_SET:
+	default:
+		target = offset;
+		break;
+	}
+
+	if (target < 0 || target > _size)
+		return false;
+
+	_eos = false;
+
+	// Seeking inside the current block is cheap
+	if ((uint32)target >= _frontStart && (uint32)target <= _frontStart + _frontSize) {
+		_frontPos = target - _frontStart;
+		return true;
+	}
+
+	// So is seeking to the block read ahead, once it is there
+	if (_filling) {
+		_pool->waitForJobs();
+		if ((uint32)target >= _backStart && (uint32)target < _backStart + _backSize) {
+			swapBuffers();
+			_frontPos = target - _frontStart;
+			return true;
+		}
+		_filling = false;
+	}
+
+	// Otherwise, start over at the new position
+	_frontStart = target;
+	_frontSize = 0;
+	_frontPos = 0;
+	_frontLast = false;
+	startFill(target);
+	return true;
+}
+
+SeekableReadStream *wrapAsyncReadStream(SeekableReadStream *parentStream, uint32 blockSize, DisposeAfterUse::Flag disposeParentStream) {
+	if (parentStream)
+		return new AsyncReadStream(parentStream, blockSize, disposeParentStream);
+	return 0;
+}
+
+} // End of namespace Common
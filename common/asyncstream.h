@@ -0,0 +1,131 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef COMMON_ASYNCSTREAM_H
+#define COMMON_ASYNCSTREAM_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+#include "common/stream.h"
+#include "common/types.h"
+
+namespace Common {
+
+class ThreadPool;
+
+/**
+ * A read stream which reads ahead of its user on a background thread.
+ *
+ * The parent stream is read in blocks of a fixed size. While one block is
+ * being consumed, the next one is already read into a second buffer, so
+ * that reading from slow storage (optical drives, network mounts) does not
+ * block the user unless it consumes data faster than the storage delivers
+ * it. Each time the user has to wait for a block, the stall counter is
+ * incremented.
+ *
+ * A seek outside the buffered data restarts reading ahead at the new
+ * position. If the backend does not support threads, blocks are read when
+ * they are needed, as with a plain buffered stream.
+ *
+ * The parent stream must not be used by anyone else while it is wrapped.
+ */
+class AsyncReadStream : public SeekableReadStream, public NonCopyable {
+public:
+	/**
+	 * Wrap the given stream, and start reading its first block.
+	 *
+	 * @param parentStream	the stream to read from
+	 * @param blockSize	the number of bytes read at once
+	 * @param disposeParentStream	whether to delete the parent stream along with this one
+	 */
+	AsyncReadStream(SeekableReadStream *parentStream, uint32 blockSize, DisposeAfterUse::Flag disposeParentStream);
+	virtual ~AsyncReadStream();
+
+	virtual bool err() const { return _err; }
+	virtual void clearErr() { _err = false; _eos = false; }
+	virtual bool eos() const { return _eos; }
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize);
+
+	virtual int32 pos() const { return _frontStart + _frontPos; }
+	virtual int32 size() const { return _size; }
+	virtual bool seek(int32 offset, int whence = SEEK_SET);
+
+	/** Return the block size given on creation. */
+	uint32 getBlockSize() const { return _blockSize; }
+
+	/**
+	 * Return how often reading had to wait for the background thread to
+	 * deliver the next block.
+	 */
+	uint32 getStallCount() const { return _stalls; }
+
+private:
+	static void fillJob(void *param);
+
+	/** Start reading the block at the given position into the back buffer. */
+	void startFill(uint32 start);
+	/** Wait for the back buffer to be filled, and make it the front buffer. */
+	void swapBuffers();
+
+	SeekableReadStream *_parentStream;
+	DisposeAfterUse::Flag _disposeParentStream;
+	ThreadPool *_pool;
+
+	const uint32 _blockSize;
+	const int32 _size;
+
+	/** The block being consumed */
+	byte *_front;
+	uint32 _frontStart;
+	uint32 _frontSize;
+	uint32 _frontPos;
+	bool _frontLast;
+
+	/** The block being filled by the background thread */
+	byte *_back;
+	uint32 _backStart;
+	uint32 _backSize;
+	bool _backLast;
+	bool _backErr;
+	/** Whether a fill of the back buffer was started; only used by the reader */
+	bool _filling;
+	/** Set by the background thread once it has finished filling the back buffer */
+	volatile bool _filled;
+
+	bool _eos;
+	bool _err;
+	uint32 _stalls;
+};
+
+/**
+ * Take an arbitrary SeekableReadStream and wrap it in an AsyncReadStream,
+ * which reads blocks of the given size ahead on a background thread.
+ *
+ * It is safe to call this with a NULL parameter (in this case, NULL is
+ * returned).
+ */
+SeekableReadStream *wrapAsyncReadStream(SeekableReadStream *parentStream, uint32 blockSize, DisposeAfterUse::Flag disposeParentStream);
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,56 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef COMMON_ATOMIC_H
+#define COMMON_ATOMIC_H
+
+#include "common/scummsys.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * Issue a full memory barrier.
+ *
+ * Neither the compiler nor the CPU may move memory accesses across the
+ * barrier. This is the only primitive required by the lock-free structures
+ * in common/ (e.g. SPSCQueue), which otherwise rely on aligned 32-bit loads
+ * and stores being atomic on all supported platforms.
+ */
+inline void memoryBarrier() {
+#if GCC_ATLEAST(4, 1)
+	__sync_synchronize();
+#elif defined(_MSC_VER)
+	// With MSVC, volatile accesses already have acquire/release semantics,
+	// so we only need to keep the compiler from reordering.
+	_ReadWriteBarrier();
+#else
+	#warning Common::memoryBarrier() is not implemented for this compiler
+#endif
+}
+
+} // End of namespace Common
+
+#endif
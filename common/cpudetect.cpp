@@ -0,0 +1,121 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "common/cpudetect.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+#define CPUDETECT_X86_GCC
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define CPUDETECT_X86_MSVC
+#endif
+
+namespace Common {
+
+static bool s_detected = false;
+static uint32 s_features = 0;
+static uint32 s_disabledFeatures = 0;
+
+#if defined(CPUDETECT_X86_GCC) || defined(CPUDETECT_X86_MSVC)
+
+static void cpuid(uint32 leaf, uint32 subleaf, uint32 regs[4]) {
+#ifdef CPUDETECT_X86_GCC
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#else
+	int info[4];
+	__cpuidex(info, leaf, subleaf);
+	for (int i = 0; i < 4; ++i)
+		regs[i] = info[i];
+#endif
+}
+
+static uint32 getXCR0() {
+#ifdef CPUDETECT_X86_GCC
+	uint32 eax, edx;
+	// xgetbv, spelled out for assemblers which do not know the mnemonic
+	__asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a" (eax), "=d" (edx) : "c" (0));
+	return eax;
+#elif defined(_MSC_VER) && _MSC_VER >= 1600
+	return (uint32)_xgetbv(0);
+#else
+	return 0;
+#endif
+}
+
+static uint32 detectFeatures() {
+	uint32 features = 0;
+	uint32 regs[4];
+
+#ifdef CPUDETECT_X86_GCC
+	if (!__get_cpuid_max(0, 0))
+		return 0;
+#endif
+
+	cpuid(0, 0, regs);
+	const uint32 maxLeaf = regs[0];
+
+	cpuid(1, 0, regs);
+	if (regs[3] & (1 << 26))
+		features |= kCpuFeatureSSE2;
+	if (regs[2] & (1 << 9))
+		features |= kCpuFeatureSSSE3;
+	if (regs[2] & (1 << 19))
+		features |= kCpuFeatureSSE41;
+
+	// AVX2 also needs the OS to save the YMM registers (OSXSAVE + XCR0)
+	const bool osxsave = (regs[2] & (1 << 27)) != 0;
+	if (osxsave && maxLeaf >= 7 && (getXCR0() & 0x6) == 0x6) {
+		cpuid(7, 0, regs);
+		if (regs[1] & (1 << 5))
+			features |= kCpuFeatureAVX2;
+	}
+
+	return features;
+}
+
+#else
+
+static uint32 detectFeatures() {
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+	return kCpuFeatureNEON;
+#else
+	return 0;
+#endif
+}
+
+#endif
+
+bool hasCPUFeature(CPUFeature feature) {
+	if (!s_detected) {
+		s_features = detectFeatures();
+		s_detected = true;
+	}
+
+	return (s_features & ~s_disabledFeatures & feature) != 0;
+}
+
+void setDisabledCPUFeatures(uint32 features) {
+	s_disabledFeatures = features;
+}
+
+} // End of namespace Common
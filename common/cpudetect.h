@@ -0,0 +1,87 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef COMMON_CPUDETECT_H
+#define COMMON_CPUDETECT_H
+
+#include "common/scummsys.h"
+
+/**
+ * @name SIMD support macros
+ *
+ * SCUMMVM_SSE2 is defined if SSE2 intrinsics may be used unconditionally
+ * (i.e. the compiler targets SSE2 anyway, as on all x86-64 systems).
+ *
+ * SCUMMVM_AVX2 is defined if the compiler can generate AVX2 code for single
+ * functions, which then have to be marked with SCUMMVM_TARGET_AVX2 and
+ * must only be called after checking hasCPUFeature(kCpuFeatureAVX2).
+ */
+//@{
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCUMMVM_SSE2
+#endif
+
+#if defined(SCUMMVM_SSE2) && (GCC_ATLEAST(4, 9) || defined(__clang__))
+#define SCUMMVM_AVX2
+#define SCUMMVM_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(SCUMMVM_SSE2) && defined(_MSC_VER) && _MSC_VER >= 1800
+#define SCUMMVM_AVX2
+#define SCUMMVM_TARGET_AVX2
+#endif
+
+//@}
+
+namespace Common {
+
+/**
+ * CPU features which have hand-optimized code paths.
+ */
+enum CPUFeature {
+	kCpuFeatureSSE2  = 1 << 0,
+	kCpuFeatureSSSE3 = 1 << 1,
+	kCpuFeatureSSE41 = 1 << 2,
+	kCpuFeatureAVX2  = 1 << 3,
+	kCpuFeatureNEON  = 1 << 4
+};
+
+/**
+ * Check whether the CPU (and the operating system) supports the given
+ * feature, and it has not been disabled via setDisabledCPUFeatures().
+ *
+ * The CPU is only queried the first time this is called.
+ */
+bool hasCPUFeature(CPUFeature feature);
+
+/**
+ * Pretend that the given features (a mask of CPUFeature values) are not
+ * available. Code paths picked after this call then use the next best
+ * implementation, down to the plain C++ one if 0xFFFFFFFF is passed.
+ *
+ * This is mostly useful to compare optimized code against its reference
+ * implementation, in unit tests and benchmarks.
+ */
+void setDisabledCPUFeatures(uint32 features);
+
+} // End of namespace Common
+
+#endif
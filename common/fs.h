@@ -214,6 +214,20 @@ public:
 	 */
 	virtual SeekableReadStream *createReadStream() const;
 
+	/**
+	 * Creates a SeekableReadStream instance corresponding to the file
+	 * referred by this node, like createReadStream(). If the backend
+	 * supports it, big files are mapped into memory, so that
+	 * SeekableReadStream::getView() gives direct access to their data.
+	 *
+	 * @note Only use this for read-only game data on reliable storage. A
+	 *       read error of a mapped file, or the file being truncated while
+	 *       it is mapped, crashes instead of setting the stream error flag.
+	 *
+	 * @return pointer to the stream object, 0 in case of a failure
+	 */
+	SeekableReadStream *createMappedReadStream() const;
+
 	/**
 	 * Creates a WriteStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
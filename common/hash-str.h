@@ -35,21 +35,28 @@ inline uint hashit_lower(const String &str) { return hashit_lower(str.c_str());
 
 // FIXME: The following functors obviously are not consistently named
 
+// All of these also accept "const char *" arguments, so that string keyed
+// HashMaps can be searched without creating a String (see HashMapLookupKey).
+
 struct CaseSensitiveString_EqualTo {
 	bool operator()(const String& x, const String& y) const { return x.equals(y); }
+	bool operator()(const String& x, const char *y) const { return x.equals(y); }
 };
 
 struct CaseSensitiveString_Hash {
 	uint operator()(const String& x) const { return hashit(x.c_str()); }
+	uint operator()(const char *x) const { return hashit(x); }
 };
 
 
 struct IgnoreCase_EqualTo {
 	bool operator()(const String& x, const String& y) const { return x.equalsIgnoreCase(y); }
+	bool operator()(const String& x, const char *y) const { return x.equalsIgnoreCase(y); }
 };
 
 struct IgnoreCase_Hash {
 	uint operator()(const String& x) const { return hashit_lower(x.c_str()); }
+	uint operator()(const char *x) const { return hashit_lower(x); }
 };
 
 
@@ -65,6 +72,9 @@ struct Hash<String> {
 	uint operator()(const String& s) const {
 		return hashit(s.c_str());
 	}
+	uint operator()(const char *s) const {
+		return hashit(s);
+	}
 };
 
 template<>
@@ -74,6 +84,12 @@ struct Hash<const char *> {
 	}
 };
 
+template<>
+struct EqualTo<String> {
+	bool operator()(const String& x, const String& y) const { return x.equals(y); }
+	bool operator()(const String& x, const char *y) const { return x.equals(y); }
+};
+
 // String map -- by default case insensitive
 typedef HashMap<String, String, IgnoreCase_Hash, IgnoreCase_EqualTo> StringMap;
 
@@ -19,9 +19,10 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  *
  */
-
-// The hash map (associative array) implementation in this file is
-// based on the PyDict implementation of CPython.
+// The hash map (associative array) implementation in this file was
+// originally based on the PyDict implementation of CPython. Probing now
+// follows the "Swiss table" design: a separate array of control bytes,
+// scanned a group at a time, tells which slots are worth looking at.
 
 #ifndef COMMON_HASHMAP_H
 #define COMMON_HASHMAP_H
@@ -43,8 +44,13 @@
 #define USE_HASHMAP_MEMORY_POOL
 
 
+#include "common/cpudetect.h"
 #include "common/func.h"
 
+#ifdef SCUMMVM_SSE2
+#include <emmintrin.h>
+#endif
+
 #ifdef DEBUG_HASH_COLLISIONS
 #include "common/debug.h"
 #endif
@@ -65,6 +71,90 @@ template<class T> class IteratorImpl;
 #endif
 
 
+/**
+ * Control byte helpers for HashMap; not meant to be used directly.
+ *
+ * Every slot of a HashMap has a control byte, which is either kEmpty,
+ * kDeleted, or (for used slots) the lower 7 bits of a second hash of the
+ * key. Lookups compare a whole group of control bytes against the second
+ * hash of the key they are looking for, and only compare the keys of the
+ * slots which match. This way, most slots which are in the way are skipped
+ * without touching their nodes at all.
+ */
+struct HashMapControl {
+	enum {
+		kGroupSize = 16,
+		kEmpty = 0x80,
+		kDeleted = 0xFE
+	};
+
+	/** Compute the control byte for a used slot from a hash value. */
+	static byte fragment(uint hash) {
+		// Take the top bits of a multiplicative hash, so that they depend
+		// on all bits of the hash (which are often poorly distributed).
+		return (byte)((hash * 2654435769U) >> 25);
+	}
+
+	/** Returns a mask with bit i set for each group[i] == value. */
+	static uint match(const byte *group, byte value) {
+#ifdef SCUMMVM_SSE2
+		const __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+		return (uint)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)value)));
+#else
+		uint mask = 0;
+		for (int i = 0; i < kGroupSize; ++i)
+			if (group[i] == value)
+				mask |= 1 << i;
+		return mask;
+#endif
+	}
+
+	/** Returns the index of the lowest set bit in a non-zero mask. */
+	static uint lowestBit(uint mask) {
+#if GCC_ATLEAST(3, 4)
+		return __builtin_ctz(mask);
+#else
+		uint bit = 0;
+		while (!(mask & 1)) {
+			mask >>= 1;
+			bit++;
+		}
+		return bit;
+#endif
+	}
+};
+
+
+/**
+ * Placeholder for HashMapLookupKey, for key types without an alternative
+ * lookup type. No value can be converted to it.
+ */
+struct HashMapNoLookupKey {
+private:
+	HashMapNoLookupKey();
+};
+
+/**
+ * Type which may be used to look up keys of type T in a HashMap without
+ * creating a temporary T, e.g. "const char *" for String keys (see
+ * hash-str.h). The HashFunc and EqualFunc of such maps must then accept it
+ * in place of a T, and hash it to the same value. By default, there is no
+ * such type.
+ */
+template<class T>
+struct HashMapLookupKey {
+	typedef HashMapNoLookupKey Type;
+};
+
+class String;
+
+// Declared here rather than in hash-str.h, so that all code agrees on it
+template<>
+struct HashMapLookupKey<String> {
+	typedef const char *Type;
+};
+
+
 /**
  * HashMap<Key,Val> maps objects of type Key to objects of type Val.
  * For each used Key type, we need an "size_type hashit(Key,size_type)" function
@@ -77,6 +167,13 @@ template<class T> class IteratorImpl;
  * referenced, for a new key. If the object is const, then an assertion is
  * triggered instead. Hence if you are not sure whether a key is contained in
  * the map, use contains() first to check for its presence.
+ *
+ * Keys and values live in separately allocated nodes, so references to them
+ * stay valid until the key is erased, no matter what else happens to the map.
+ *
+ * Lookups may also use the HashMapLookupKey type of the map's key type, if
+ * there is one. E.g. string maps can be searched for a "const char *" key
+ * without creating a String.
  */
 template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
 class HashMap {
@@ -86,25 +183,28 @@ public:
 private:
 
 	typedef HashMap<Key, Val, HashFunc, EqualFunc> HM_t;
+	typedef typename HashMapLookupKey<Key>::Type LookupKey;
 
 	struct Node {
 		const Key _key;
 		Val _value;
-		explicit Node(const Key &key) : _key(key), _value() {}
-		Node() : _key(), _value() {}
+		/** Hash of _key, so that it never has to be computed again. */
+		const size_type _hash;
+		Node(const Key &key, size_type hash) : _key(key), _value(), _hash(hash) {}
 	};
 
 	enum {
-		HASHMAP_PERTURB_SHIFT = 5,
-		HASHMAP_MIN_CAPACITY = 16,
+		HASHMAP_GROUP_SIZE = HashMapControl::kGroupSize,
+		HASHMAP_MIN_CAPACITY = HASHMAP_GROUP_SIZE,
 
 		// The quotient of the next two constants controls how much the
 		// internal storage of the hashmap may fill up before being
-		// increased automatically.
+		// increased automatically. Since slots which are in the way
+		// are cheap to skip, this can be quite high.
 		// Note: the quotient of these two must be between and different
 		// from 0 and 1.
-		HASHMAP_LOADFACTOR_NUMERATOR = 2,
-		HASHMAP_LOADFACTOR_DENOMINATOR = 3,
+		HASHMAP_LOADFACTOR_NUMERATOR = 7,
+		HASHMAP_LOADFACTOR_DENOMINATOR = 8,
 
 		HASHMAP_MEMORYPOOL_SIZE = HASHMAP_MIN_CAPACITY * HASHMAP_LOADFACTOR_NUMERATOR / HASHMAP_LOADFACTOR_DENOMINATOR
 	};
@@ -113,10 +213,11 @@ private:
 	ObjectPool<Node, HASHMAP_MEMORYPOOL_SIZE> _nodePool;
 #endif
 
-	Node **_storage;	///< hashtable of size arrsize.
+	Node **_storage;	///< hashtable of size arrsize; 0 for unused slots
+	byte *_ctrl;		///< control bytes, one per slot (see HashMapControl)
 	size_type _mask;		///< Capacity of the HashMap minus one; must be a power of two of minus one
 	size_type _size;
-	size_type _deleted; ///< Number of deleted elements (_dummyNodes)
+	size_type _deleted; ///< Number of deleted elements (kDeleted control bytes)
 
 	HashFunc _hash;
 	EqualFunc _equal;
@@ -124,23 +225,22 @@ private:
 	/** Default value, returned by the const getVal. */
 	const Val _defaultVal;
 
-	/** Dummy node, used as marker for erased objects. */
-	#define HASHMAP_DUMMY_NODE	((Node *)1)
-
 #ifdef DEBUG_HASH_COLLISIONS
+	// _dummyHits counts control byte matches which turned out to be a
+	// different key.
 	mutable int _collisions, _lookups, _dummyHits;
 #endif
 
-	Node *allocNode(const Key &key) {
+	Node *allocNode(const Key &key, size_type hash) {
 #ifdef USE_HASHMAP_MEMORY_POOL
-		return new (_nodePool) Node(key);
+		return new (_nodePool) Node(key, hash);
 #else
-		return new Node(key);
+		return new Node(key, hash);
 #endif
 	}
 
 	void freeNode(Node *node) {
-		if (node && node != HASHMAP_DUMMY_NODE)
+		if (node)
 #ifdef USE_HASHMAP_MEMORY_POOL
 			_nodePool.deleteChunk(node);
 #else
@@ -148,10 +248,26 @@ private:
 #endif
 	}
 
+	void allocStorage(size_type capacity) {
+		_mask = capacity - 1;
+		_storage = new Node *[capacity];
+		assert(_storage != NULL);
+		memset(_storage, 0, capacity * sizeof(Node *));
+		_ctrl = new byte[capacity];
+		assert(_ctrl != NULL);
+		memset(_ctrl, HashMapControl::kEmpty, capacity);
+	}
+
+	void freeStorage() {
+		delete[] _storage;
+		delete[] _ctrl;
+	}
+
 	void assign(const HM_t &map);
-	size_type lookup(const Key &key) const;
+	template<class K> size_type lookup(const K &key) const;
 	size_type lookupAndCreateIfMissing(const Key &key);
-	void expandStorage(size_type newCapacity);
+	void eraseSlot(size_type ctr);
+	void resizeStorage(size_type newCapacity);
 
 #if !defined(__sgi) || defined(__GNUC__)
 	template<class T> friend class IteratorImpl;
@@ -182,7 +298,6 @@ private:
 			assert(_idx <= _hashmap->_mask);
 			Node *node = _hashmap->_storage[_idx];
 			assert(node != 0);
-			assert(node != HASHMAP_DUMMY_NODE);
 			return node;
 		}
 
@@ -201,7 +316,7 @@ private:
 			assert(_hashmap);
 			do {
 				_idx++;
-			} while (_idx <= _hashmap->_mask && (_hashmap->_storage[_idx] == 0 || _hashmap->_storage[_idx] == HASHMAP_DUMMY_NODE));
+			} while (_idx <= _hashmap->_mask && _hashmap->_storage[_idx] == 0);
 			if (_idx > _hashmap->_mask)
 				_idx = (size_type)-1;
 
@@ -229,33 +344,40 @@ public:
 
 		// Remove the previous content and ...
 		clear();
-		delete[] _storage;
+		freeStorage();
 		// ... copy the new stuff.
 		assign(map);
 		return *this;
 	}
 
 	bool contains(const Key &key) const;
+	bool contains(const LookupKey &key) const;
 
 	Val &operator[](const Key &key);
+	Val &operator[](const LookupKey &key);
 	const Val &operator[](const Key &key) const;
+	const Val &operator[](const LookupKey &key) const;
 
 	Val &getVal(const Key &key);
+	Val &getVal(const LookupKey &key);
 	const Val &getVal(const Key &key) const;
+	const Val &getVal(const LookupKey &key) const;
 	const Val &getVal(const Key &key, const Val &defaultVal) const;
+	const Val &getVal(const LookupKey &key, const Val &defaultVal) const;
 	void setVal(const Key &key, const Val &val);
 
 	void clear(bool shrinkArray = 0);
 
 	void erase(iterator entry);
 	void erase(const Key &key);
+	void erase(const LookupKey &key);
 
 	size_type size() const { return _size; }
 
 	iterator	begin() {
 		// Find and return the first non-empty entry
 		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
-			if (_storage[ctr] && _storage[ctr] != HASHMAP_DUMMY_NODE)
+			if (_storage[ctr])
 				return iterator(ctr, this);
 		}
 		return end();
@@ -267,7 +389,7 @@ public:
 	const_iterator	begin() const {
 		// Find and return the first non-empty entry
 		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
-			if (_storage[ctr] && _storage[ctr] != HASHMAP_DUMMY_NODE)
+			if (_storage[ctr])
 				return const_iterator(ctr, this);
 		}
 		return end();
@@ -278,14 +400,28 @@ public:
 
 	iterator	find(const Key &key) {
 		size_type ctr = lookup(key);
-		if (_storage[ctr])
+		if (ctr <= _mask)
+			return iterator(ctr, this);
+		return end();
+	}
+
+	iterator	find(const LookupKey &key) {
+		size_type ctr = lookup(key);
+		if (ctr <= _mask)
 			return iterator(ctr, this);
 		return end();
 	}
 
 	const_iterator	find(const Key &key) const {
 		size_type ctr = lookup(key);
-		if (_storage[ctr])
+		if (ctr <= _mask)
+			return const_iterator(ctr, this);
+		return end();
+	}
+
+	const_iterator	find(const LookupKey &key) const {
+		size_type ctr = lookup(key);
+		if (ctr <= _mask)
 			return const_iterator(ctr, this);
 		return end();
 	}
@@ -313,10 +449,7 @@ HashMap<Key, Val, HashFunc, EqualFunc>::HashMap()
 #else
 	: _defaultVal() {
 #endif
-	_mask = HASHMAP_MIN_CAPACITY - 1;
-	_storage = new Node *[HASHMAP_MIN_CAPACITY];
-	assert(_storage != NULL);
-	memset(_storage, 0, HASHMAP_MIN_CAPACITY * sizeof(Node *));
+	allocStorage(HASHMAP_MIN_CAPACITY);
 
 	_size = 0;
 	_deleted = 0;
@@ -352,7 +485,7 @@ HashMap<Key, Val, HashFunc, EqualFunc>::~HashMap() {
 	for (size_type ctr = 0; ctr <= _mask; ++ctr)
 	  freeNode(_storage[ctr]);
 
-	delete[] _storage;
+	freeStorage();
 #ifdef DEBUG_HASH_COLLISIONS
 	extern void updateHashCollisionStats(int, int, int, int, int);
 	updateHashCollisionStats(_collisions, _dummyHits, _lookups, _mask+1, _size);
@@ -368,20 +501,17 @@ HashMap<Key, Val, HashFunc, EqualFunc>::~HashMap() {
  */
 template<class Key, class Val, class HashFunc, class EqualFunc>
 void HashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
-	_mask = map._mask;
-	_storage = new Node *[_mask+1];
-	assert(_storage != NULL);
-	memset(_storage, 0, (_mask+1) * sizeof(Node *));
+	allocStorage(map._mask + 1);
+	memcpy(_ctrl, map._ctrl, _mask + 1);
 
 	// Simply clone the map given to us, one by one.
 	_size = 0;
 	_deleted = 0;
 	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
-		if (map._storage[ctr] == HASHMAP_DUMMY_NODE) {
-			_storage[ctr] = HASHMAP_DUMMY_NODE;
+		if (_ctrl[ctr] == HashMapControl::kDeleted) {
 			_deleted++;
 		} else if (map._storage[ctr] != NULL) {
-			_storage[ctr] = allocNode(map._storage[ctr]->_key);
+			_storage[ctr] = allocNode(map._storage[ctr]->_key, map._storage[ctr]->_hash);
 			_storage[ctr]->_value = map._storage[ctr]->_value;
 			_size++;
 		}
@@ -398,18 +528,15 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
 		freeNode(_storage[ctr]);
 		_storage[ctr] = NULL;
 	}
+	memset(_ctrl, HashMapControl::kEmpty, _mask + 1);
 
 #ifdef USE_HASHMAP_MEMORY_POOL
 	_nodePool.freeUnusedPages();
 #endif
 
 	if (shrinkArray && _mask >= HASHMAP_MIN_CAPACITY) {
-		delete[] _storage;
-
-		_mask = HASHMAP_MIN_CAPACITY;
-		_storage = new Node *[HASHMAP_MIN_CAPACITY];
-		assert(_storage != NULL);
-		memset(_storage, 0, HASHMAP_MIN_CAPACITY * sizeof(Node *));
+		freeStorage();
+		allocStorage(HASHMAP_MIN_CAPACITY);
 	}
 
 	_size = 0;
@@ -417,39 +544,47 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
 }
 
 template<class Key, class Val, class HashFunc, class EqualFunc>
-void HashMap<Key, Val, HashFunc, EqualFunc>::expandStorage(size_type newCapacity) {
-	assert(newCapacity > _mask+1);
+void HashMap<Key, Val, HashFunc, EqualFunc>::resizeStorage(size_type newCapacity) {
+	assert(newCapacity >= _mask+1);
 
 #ifndef NDEBUG
 	const size_type old_size = _size;
 #endif
 	const size_type old_mask = _mask;
 	Node **old_storage = _storage;
+	byte *old_ctrl = _ctrl;
 
 	// allocate a new array
 	_size = 0;
 	_deleted = 0;
-	_mask = newCapacity - 1;
-	_storage = new Node *[newCapacity];
-	assert(_storage != NULL);
-	memset(_storage, 0, newCapacity * sizeof(Node *));
+	allocStorage(newCapacity);
+
+	const size_type groupMask = (_mask + 1) / HASHMAP_GROUP_SIZE - 1;
 
 	// rehash all the old elements
 	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
-		if (old_storage[ctr] == NULL || old_storage[ctr] == HASHMAP_DUMMY_NODE)
+		if (old_storage[ctr] == NULL)
 			continue;
 
 		// Insert the element from the old table into the new table.
 		// Since we know that no key exists twice in the old table, we
 		// can do this slightly better than by calling lookup, since we
-		// don't have to call _equal().
-		const size_type hash = _hash(old_storage[ctr]->_key);
-		size_type idx = hash & _mask;
-		for (size_type perturb = hash; _storage[idx] != NULL && _storage[idx] != HASHMAP_DUMMY_NODE; perturb >>= HASHMAP_PERTURB_SHIFT) {
-			idx = (5 * idx + perturb + 1) & _mask;
+		// don't have to call _equal(): just take the first free slot.
+		// The node also remembers the hash, so we don't need _hash().
+		const size_type hash = old_storage[ctr]->_hash;
+		size_type group = hash & groupMask;
+		for (size_type step = 1; ; ++step) {
+			const byte *ctrl = _ctrl + group * HASHMAP_GROUP_SIZE;
+			const uint free = HashMapControl::match(ctrl, HashMapControl::kEmpty);
+			if (free) {
+				const size_type idx = group * HASHMAP_GROUP_SIZE + HashMapControl::lowestBit(free);
+				_storage[idx] = old_storage[ctr];
+				_ctrl[idx] = HashMapControl::fragment(hash);
+				break;
+			}
+			group = (group + step) & groupMask;
 		}
 
-		_storage[idx] = old_storage[ctr];
 		_size++;
 	}
 
@@ -458,25 +593,48 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::expandStorage(size_type newCapacity
 	assert(_size == old_size);
 
 	delete[] old_storage;
+	delete[] old_ctrl;
 
 	return;
 }
 
+/**
+ * Find the slot holding the given key.
+ *
+ * Groups of slots are probed in a triangular sequence, which visits every
+ * group since the number of groups is a power of two. A group containing
+ * an empty slot ends the search: had the key been inserted, it would have
+ * been put into that empty slot (or an earlier one).
+ *
+ * @return the index of the slot, or _mask + 1 if the key is not contained
+ */
 template<class Key, class Val, class HashFunc, class EqualFunc>
-typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+template<class K>
+typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, HashFunc, EqualFunc>::lookup(const K &key) const {
 	const size_type hash = _hash(key);
-	size_type ctr = hash & _mask;
-	for (size_type perturb = hash; ; perturb >>= HASHMAP_PERTURB_SHIFT) {
-		if (_storage[ctr] == NULL)
-			break;
-		if (_storage[ctr] == HASHMAP_DUMMY_NODE) {
+	const byte fragment = HashMapControl::fragment(hash);
+	const size_type groupMask = (_mask + 1) / HASHMAP_GROUP_SIZE - 1;
+	size_type group = hash & groupMask;
+	size_type ctr = _mask + 1;
+
+	for (size_type step = 1; ; ++step) {
+		const byte *ctrl = _ctrl + group * HASHMAP_GROUP_SIZE;
+
+		for (uint candidates = HashMapControl::match(ctrl, fragment); candidates; candidates &= candidates - 1) {
+			const size_type idx = group * HASHMAP_GROUP_SIZE + HashMapControl::lowestBit(candidates);
+			if (_storage[idx]->_hash == hash && _equal(_storage[idx]->_key, key)) {
+				ctr = idx;
+				break;
+			}
 #ifdef DEBUG_HASH_COLLISIONS
 			_dummyHits++;
 #endif
-		} else if (_equal(_storage[ctr]->_key, key))
+		}
+
+		if (ctr <= _mask || HashMapControl::match(ctrl, HashMapControl::kEmpty))
 			break;
 
-		ctr = (5 * ctr + perturb + 1) & _mask;
+		group = (group + step) & groupMask;
 
 #ifdef DEBUG_HASH_COLLISIONS
 		_collisions++;
@@ -496,25 +654,40 @@ typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, Has
 template<class Key, class Val, class HashFunc, class EqualFunc>
 typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
 	const size_type hash = _hash(key);
-	size_type ctr = hash & _mask;
+	const byte fragment = HashMapControl::fragment(hash);
+	const size_type groupMask = (_mask + 1) / HASHMAP_GROUP_SIZE - 1;
 	const size_type NONE_FOUND = _mask + 1;
+	size_type group = hash & groupMask;
 	size_type first_free = NONE_FOUND;
-	bool found = false;
-	for (size_type perturb = hash; ; perturb >>= HASHMAP_PERTURB_SHIFT) {
-		if (_storage[ctr] == NULL)
-			break;
-		if (_storage[ctr] == HASHMAP_DUMMY_NODE) {
+
+	for (size_type step = 1; ; ++step) {
+		const byte *ctrl = _ctrl + group * HASHMAP_GROUP_SIZE;
+
+		for (uint candidates = HashMapControl::match(ctrl, fragment); candidates; candidates &= candidates - 1) {
+			const size_type idx = group * HASHMAP_GROUP_SIZE + HashMapControl::lowestBit(candidates);
+			if (_storage[idx]->_hash == hash && _equal(_storage[idx]->_key, key))
+				return idx;
 #ifdef DEBUG_HASH_COLLISIONS
 			_dummyHits++;
 #endif
-			if (first_free != _mask + 1)
-				first_free = ctr;
-		} else if (_equal(_storage[ctr]->_key, key)) {
-			found = true;
+		}
+
+		// Remember where to insert the key: the first deleted slot on
+		// the way, or else the first empty one.
+		if (first_free == NONE_FOUND) {
+			const uint deleted = HashMapControl::match(ctrl, HashMapControl::kDeleted);
+			if (deleted)
+				first_free = group * HASHMAP_GROUP_SIZE + HashMapControl::lowestBit(deleted);
+		}
+
+		const uint empty = HashMapControl::match(ctrl, HashMapControl::kEmpty);
+		if (empty) {
+			if (first_free == NONE_FOUND)
+				first_free = group * HASHMAP_GROUP_SIZE + HashMapControl::lowestBit(empty);
 			break;
 		}
 
-		ctr = (5 * ctr + perturb + 1) & _mask;
+		group = (group + step) & groupMask;
 
 #ifdef DEBUG_HASH_COLLISIONS
 		_collisions++;
@@ -528,26 +701,26 @@ typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, Has
 		(const void *)this, _mask+1, _size);
 #endif
 
-	if (!found && first_free != _mask + 1)
-		ctr = first_free;
-
-	if (!found) {
-		if (_storage[ctr])
-			_deleted--;
-		_storage[ctr] = allocNode(key);
-		assert(_storage[ctr] != NULL);
-		_size++;
-
-		// Keep the load factor below a certain threshold.
-		// Deleted nodes are also counted
-		size_type capacity = _mask + 1;
-		if ((_size + _deleted) * HASHMAP_LOADFACTOR_DENOMINATOR >
-		        capacity * HASHMAP_LOADFACTOR_NUMERATOR) {
+	size_type ctr = first_free;
+	if (_ctrl[ctr] == HashMapControl::kDeleted)
+		_deleted--;
+	_storage[ctr] = allocNode(key, hash);
+	assert(_storage[ctr] != NULL);
+	_ctrl[ctr] = fragment;
+	_size++;
+
+	// Keep the load factor below a certain threshold.
+	// Deleted nodes are also counted
+	size_type capacity = _mask + 1;
+	if ((_size + _deleted) * HASHMAP_LOADFACTOR_DENOMINATOR >
+	        capacity * HASHMAP_LOADFACTOR_NUMERATOR) {
+		// If the map is mostly filled with deleted entries, getting rid
+		// of those is enough.
+		if (_deleted < _size)
 			capacity = capacity < 500 ? (capacity * 4) : (capacity * 2);
-			expandStorage(capacity);
-			ctr = lookup(key);
-			assert(_storage[ctr] != NULL);
-		}
+		resizeStorage(capacity);
+		ctr = lookup(key);
+		assert(ctr <= _mask);
 	}
 
 	return ctr;
@@ -557,7 +730,13 @@ typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, Has
 template<class Key, class Val, class HashFunc, class EqualFunc>
 bool HashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
 	size_type ctr = lookup(key);
-	return (_storage[ctr] != NULL);
+	return (ctr <= _mask);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool HashMap<Key, Val, HashFunc, EqualFunc>::contains(const LookupKey &key) const {
+	size_type ctr = lookup(key);
+	return (ctr <= _mask);
 }
 
 template<class Key, class Val, class HashFunc, class EqualFunc>
@@ -565,11 +744,21 @@ Val &HashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
 	return getVal(key);
 }
 
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &HashMap<Key, Val, HashFunc, EqualFunc>::operator[](const LookupKey &key) {
+	return getVal(key);
+}
+
 template<class Key, class Val, class HashFunc, class EqualFunc>
 const Val &HashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
 	return getVal(key);
 }
 
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &HashMap<Key, Val, HashFunc, EqualFunc>::operator[](const LookupKey &key) const {
+	return getVal(key);
+}
+
 template<class Key, class Val, class HashFunc, class EqualFunc>
 Val &HashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
 	size_type ctr = lookupAndCreateIfMissing(key);
@@ -577,15 +766,39 @@ Val &HashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
 	return _storage[ctr]->_value;
 }
 
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &HashMap<Key, Val, HashFunc, EqualFunc>::getVal(const LookupKey &key) {
+	// Only create a Key if we really have to insert it
+	size_type ctr = lookup(key);
+	if (ctr > _mask)
+		ctr = lookupAndCreateIfMissing(Key(key));
+	assert(_storage[ctr] != NULL);
+	return _storage[ctr]->_value;
+}
+
 template<class Key, class Val, class HashFunc, class EqualFunc>
 const Val &HashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
 	return getVal(key, _defaultVal);
 }
 
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &HashMap<Key, Val, HashFunc, EqualFunc>::getVal(const LookupKey &key) const {
+	return getVal(key, _defaultVal);
+}
+
 template<class Key, class Val, class HashFunc, class EqualFunc>
 const Val &HashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
 	size_type ctr = lookup(key);
-	if (_storage[ctr] != NULL)
+	if (ctr <= _mask)
+		return _storage[ctr]->_value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &HashMap<Key, Val, HashFunc, EqualFunc>::getVal(const LookupKey &key, const Val &defaultVal) const {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
 		return _storage[ctr]->_value;
 	else
 		return defaultVal;
@@ -598,39 +811,54 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &v
 	_storage[ctr]->_value = val;
 }
 
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void HashMap<Key, Val, HashFunc, EqualFunc>::eraseSlot(size_type ctr) {
+	freeNode(_storage[ctr]);
+	_storage[ctr] = NULL;
+	_size--;
+
+	// If the group still has an empty slot, no lookup ever went past it,
+	// so the slot can become empty again. Otherwise, we have to leave a
+	// marker so that lookups keep probing the following groups.
+	const byte *group = _ctrl + (ctr & ~(size_type)(HASHMAP_GROUP_SIZE - 1));
+	if (HashMapControl::match(group, HashMapControl::kEmpty)) {
+		_ctrl[ctr] = HashMapControl::kEmpty;
+	} else {
+		_ctrl[ctr] = HashMapControl::kDeleted;
+		_deleted++;
+	}
+}
+
 template<class Key, class Val, class HashFunc, class EqualFunc>
 void HashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
 	// Check whether we have a valid iterator
 	assert(entry._hashmap == this);
 	const size_type ctr = entry._idx;
 	assert(ctr <= _mask);
-	Node * const node = _storage[ctr];
-	assert(node != NULL);
-	assert(node != HASHMAP_DUMMY_NODE);
+	assert(_storage[ctr] != NULL);
 
-	// If we remove a key, we replace it with a dummy node.
-	freeNode(node);
-	_storage[ctr] = HASHMAP_DUMMY_NODE;
-	_size--;
-	_deleted++;
+	eraseSlot(ctr);
 }
 
 template<class Key, class Val, class HashFunc, class EqualFunc>
 void HashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
 
 	size_type ctr = lookup(key);
-	if (_storage[ctr] == NULL)
+	if (ctr > _mask)
 		return;
 
-	// If we remove a key, we replace it with a dummy node.
-	freeNode(_storage[ctr]);
-	_storage[ctr] = HASHMAP_DUMMY_NODE;
-	_size--;
-	_deleted++;
+	eraseSlot(ctr);
 	return;
 }
 
-#undef HASHMAP_DUMMY_NODE
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void HashMap<Key, Val, HashFunc, EqualFunc>::erase(const LookupKey &key) {
+	size_type ctr = lookup(key);
+	if (ctr > _mask)
+		return;
+
+	eraseSlot(ctr);
+}
 
 } // End of namespace Common
 
@@ -94,6 +94,11 @@ public:
 	 * Return the chunk size used by this memory pool.
 	 */
 	size_t	getChunkSize() const { return _chunkSize; }
+
+	/**
+	 * Return the number of pages currently allocated by this memory pool.
+	 */
+	size_t	getPageCount() const { return _pages.size(); }
 };
 
 /**
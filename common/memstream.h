@@ -70,6 +70,10 @@ public:
 	int32 size() const { return _size; }
 
 	bool seek(int32 offs, int whence = SEEK_SET);
+
+	const byte *getView(uint32 offset, uint32 dataSize) {
+		return (offset <= _size && dataSize <= _size - offset) ? _ptrOrig + offset : 0;
+	}
 };
 
 
@@ -2,7 +2,10 @@ MODULE := common
 
 MODULE_OBJS := \
 	archive.o \
+	arena.o \
+	asyncstream.o \
 	config-manager.o \
+	cpudetect.o \
 	coroutines.o \
 	dcl.o \
 	debug.o \
@@ -31,6 +34,7 @@ MODULE_OBJS := \
 	stream.o \
 	system.o \
 	textconsole.o \
+	threadpool.o \
 	tokenizer.o \
 	translation.o \
 	unarj.o \
@@ -0,0 +1,212 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef COMMON_SPSC_QUEUE_H
+#define COMMON_SPSC_QUEUE_H
+
+#include "common/scummsys.h"
+#include "common/atomic.h"
+#include "common/noncopyable.h"
+#include "common/util.h"
+
+namespace Common {
+
+/**
+ * Fixed size, lock-free queue for exactly one producer and one consumer
+ * thread.
+ *
+ * push() may only be called from the producer thread, pop() only from the
+ * consumer thread. Neither of them ever blocks: push() fails if the queue is
+ * full, pop() fails if it is empty. This makes it suitable for handing data
+ * to and from real-time threads (like the audio mixing callback) which must
+ * not wait on a mutex held by another thread.
+ *
+ * If several threads need to push (or pop), they have to serialize among
+ * themselves, e.g. with a Common::Mutex; the other side stays lock-free.
+ *
+ * @note N must be a power of two.
+ */
+template<class T, uint N>
+class SPSCQueue : NonCopyable {
+public:
+	SPSCQueue() : _head(0), _tail(0) {
+		assert((N & (N - 1)) == 0);
+	}
+
+	/** Returns true if there is currently nothing to pop. */
+	bool empty() const {
+		return _head == _tail;
+	}
+
+	/** Returns true if there is currently no room to push. */
+	bool full() const {
+		return _tail - _head == N;
+	}
+
+	/** Returns the number of items currently in the queue. */
+	uint size() const {
+		return _tail - _head;
+	}
+
+	/** Returns the maximum number of items the queue can hold. */
+	uint capacity() const {
+		return N;
+	}
+
+	/**
+	 * Append an item at the end of the queue. Producer thread only.
+	 *
+	 * @return false if the queue was full and the item was not added
+	 */
+	bool push(const T &item) {
+		const uint32 tail = _tail;
+		if (tail - _head == N)
+			return false;
+
+		_items[tail & (N - 1)] = item;
+		// The item must be completely written before the consumer can see it
+		memoryBarrier();
+		_tail = tail + 1;
+		return true;
+	}
+
+	/**
+	 * Remove the item at the front of the queue. Consumer thread only.
+	 *
+	 * @return false if the queue was empty and item was left untouched
+	 */
+	bool pop(T &item) {
+		const uint32 head = _head;
+		if (head == _tail)
+			return false;
+
+		memoryBarrier();
+		item = _items[head & (N - 1)];
+		// The item must be completely read before the producer may reuse it
+		memoryBarrier();
+		_head = head + 1;
+		return true;
+	}
+
+private:
+	T _items[N];
+
+	/** Index of the next item to pop; only written by the consumer. */
+	volatile uint32 _head;
+	/** Index of the next item to push; only written by the producer. */
+	volatile uint32 _tail;
+};
+
+/**
+ * Lock-free ring buffer of plain data for exactly one producer and one
+ * consumer thread, transferring whole blocks of items at a time.
+ *
+ * This follows the same rules as SPSCQueue: write() may only be called from
+ * the producer thread, read() only from the consumer thread, and neither
+ * ever blocks. Unlike SPSCQueue, the capacity is chosen at run time, and T
+ * must be a type which can be copied with memcpy (e.g. audio samples).
+ */
+template<class T>
+class SPSCRingBuffer : NonCopyable {
+public:
+	/**
+	 * Create a ring buffer holding up to the given number of items.
+	 * @note capacity must be a power of two.
+	 */
+	explicit SPSCRingBuffer(uint capacity) : _capacity(capacity), _head(0), _tail(0) {
+		assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+		_items = new T[capacity];
+	}
+
+	~SPSCRingBuffer() {
+		delete[] _items;
+	}
+
+	/** Returns the number of items which can currently be read. */
+	uint size() const {
+		return _tail - _head;
+	}
+
+	/** Returns the number of items which can currently be written. */
+	uint space() const {
+		return _capacity - (_tail - _head);
+	}
+
+	/** Returns the maximum number of items the buffer can hold. */
+	uint capacity() const {
+		return _capacity;
+	}
+
+	/**
+	 * Append up to count items. Producer thread only.
+	 * @return the number of items actually written
+	 */
+	uint write(const T *items, uint count) {
+		const uint32 tail = _tail;
+		count = MIN<uint>(count, _capacity - (tail - _head));
+		copyIn(tail & (_capacity - 1), items, count);
+		// The items must be completely written before the consumer can see them
+		memoryBarrier();
+		_tail = tail + count;
+		return count;
+	}
+
+	/**
+	 * Remove up to count items from the front. Consumer thread only.
+	 * @return the number of items actually read
+	 */
+	uint read(T *items, uint count) {
+		const uint32 head = _head;
+		count = MIN<uint>(count, _tail - head);
+		memoryBarrier();
+		copyOut(head & (_capacity - 1), items, count);
+		// The items must be completely read before the producer may reuse them
+		memoryBarrier();
+		_head = head + count;
+		return count;
+	}
+
+private:
+	void copyIn(uint pos, const T *items, uint count) {
+		const uint first = MIN(count, _capacity - pos);
+		memcpy(_items + pos, items, first * sizeof(T));
+		memcpy(_items, items + first, (count - first) * sizeof(T));
+	}
+
+	void copyOut(uint pos, T *items, uint count) const {
+		const uint first = MIN(count, _capacity - pos);
+		memcpy(items, _items + pos, first * sizeof(T));
+		memcpy(items + first, _items, (count - first) * sizeof(T));
+	}
+
+	T *_items;
+	const uint _capacity;
+
+	/** Index of the next item to read; only written by the consumer. */
+	volatile uint32 _head;
+	/** Index of the next item to write; only written by the producer. */
+	volatile uint32 _tail;
+};
+
+} // End of namespace Common
+
+#endif
@@ -240,6 +240,12 @@ bool SeekableSubReadStream::seek(int32 offset, int whence) {
 	return ret;
 }
 
+const byte *SeekableSubReadStream::getView(uint32 offset, uint32 dataSize) {
+	if (offset > (uint32)size() || dataSize > (uint32)size() - offset)
+		return 0;
+	return _parentStream->getView(_begin + offset, dataSize);
+}
+
 uint32 SafeSeekableSubReadStream::read(void *dataPtr, uint32 dataSize) {
 	// Make sure the parent stream is at the right position
 	seek(0, SEEK_CUR);
@@ -371,6 +371,23 @@ public:
 	 */
 	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
 
+	/**
+	 * Returns a pointer to the given range of the stream data, if the
+	 * stream has it in memory anyway (e.g. because it reads from a memory
+	 * buffer or a memory mapped file, see FSNode::createMappedReadStream()).
+	 * This allows parsing big resources in place, without copying them.
+	 *
+	 * The data remains valid as long as the stream exists. The stream
+	 * position is not changed.
+	 *
+	 * @param offset	the start of the range, relative to the start of the stream
+	 * @param dataSize	the size of the range in bytes
+	 * @return a pointer to the data, or NULL if the range is not directly
+	 *         accessible (or not completely inside the stream), in which
+	 *         case it has to be read() instead
+	 */
+	virtual const byte *getView(uint32 offset, uint32 dataSize) { return 0; }
+
 	/**
 	 * Reads at most one less than the number of characters specified
 	 * by bufSize from the and stores them in the string buf. Reading
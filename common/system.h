@@ -899,6 +899,15 @@ public:
 	*/
 	virtual uint32 getMillis(bool skipRecord = false) = 0;
 
+	/**
+	 * Get the number of microseconds since an arbitrary point in time, with
+	 * the best resolution available. This is meant for profiling: the value
+	 * wraps around after a bit more than an hour, so only differences are
+	 * meaningful, and it is not recorded by the event recorder.
+	 * The default implementation is based on getMillis().
+	 */
+	virtual uint32 getMicros() { return getMillis(true) * 1000; }
+
 	/** Delay/sleep for the specified amount of milliseconds. */
 	virtual void delayMillis(uint msecs) = 0;
 
@@ -1018,6 +1027,67 @@ public:
 
 
 
+	/**
+	 * @name Thread handling
+	 * Optional support for worker threads, used to move heavy work (like
+	 * decoding audio ahead of time) off the main and audio threads. Nothing
+	 * may depend on threads being available: backends are free to keep the
+	 * default implementations, in which case createThread() always fails and
+	 * callers have to do the work themselves. Common::ThreadPool hides this
+	 * difference and should be used instead of calling these directly.
+	 */
+	//@{
+
+	typedef struct OpaqueThread *ThreadRef;
+	typedef struct OpaqueSemaphore *SemaphoreRef;
+
+	/** Entry point of a thread created by createThread(). */
+	typedef int (*ThreadProc)(void *param);
+
+	/**
+	 * Create and start a new thread.
+	 * @param proc	the function to run in the new thread.
+	 * @param param	the parameter passed to proc.
+	 * @return the new thread, or 0 if threads are not supported or an error
+	 *         occurred.
+	 */
+	virtual ThreadRef createThread(ThreadProc proc, void *param) { return 0; }
+
+	/**
+	 * Wait until the given thread has terminated and release it.
+	 * @param thread	the thread to wait for.
+	 */
+	virtual void joinThread(ThreadRef thread) {}
+
+	/**
+	 * Create a new counting semaphore.
+	 * @param initialValue	the initial value of the semaphore.
+	 * @return the newly created semaphore, or 0 if an error occurred.
+	 */
+	virtual SemaphoreRef createSemaphore(uint initialValue) { return 0; }
+
+	/**
+	 * Wait until the value of the semaphore is positive, then decrement it.
+	 * @param semaphore	the semaphore to wait on.
+	 */
+	virtual void waitSemaphore(SemaphoreRef semaphore) {}
+
+	/**
+	 * Increment the value of the semaphore, waking up one waiting thread.
+	 * @param semaphore	the semaphore to post.
+	 */
+	virtual void postSemaphore(SemaphoreRef semaphore) {}
+
+	/**
+	 * Delete the given semaphore. No thread may be waiting on it.
+	 * @param semaphore	the semaphore to delete.
+	 */
+	virtual void deleteSemaphore(SemaphoreRef semaphore) {}
+
+	//@}
+
+
+
 	/** @name Sound */
 	//@{
 
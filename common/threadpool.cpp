@@ -0,0 +1,135 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "common/threadpool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(uint numThreads)
+	: _pendingJobs(0), _waiting(false), _quit(false), _jobSemaphore(0), _idleSemaphore(0) {
+
+	if (numThreads == 0)
+		return;
+
+	_jobSemaphore = g_system->createSemaphore(0);
+	_idleSemaphore = g_system->createSemaphore(0);
+	if (!_jobSemaphore || !_idleSemaphore)
+		return;
+
+	for (uint i = 0; i < numThreads; ++i) {
+		OSystem::ThreadRef thread = g_system->createThread(workerProc, this);
+		if (!thread)
+			break;
+		_threads.push_back(thread);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		StackLock lock(_mutex);
+		_quit = true;
+		_pendingJobs -= _jobs.size();
+		_jobs.clear();
+	}
+
+	for (uint i = 0; i < _threads.size(); ++i)
+		g_system->postSemaphore(_jobSemaphore);
+	for (uint i = 0; i < _threads.size(); ++i)
+		g_system->joinThread(_threads[i]);
+
+	if (_jobSemaphore)
+		g_system->deleteSemaphore(_jobSemaphore);
+	if (_idleSemaphore)
+		g_system->deleteSemaphore(_idleSemaphore);
+}
+
+void ThreadPool::addJob(JobProc proc, void *param) {
+	if (_threads.empty()) {
+		proc(param);
+		return;
+	}
+
+	Job job;
+	job.proc = proc;
+	job.param = param;
+
+	{
+		StackLock lock(_mutex);
+		_jobs.push(job);
+		++_pendingJobs;
+	}
+	g_system->postSemaphore(_jobSemaphore);
+}
+
+void ThreadPool::waitForJobs() {
+	while (runNextJob())
+		;
+
+	{
+		StackLock lock(_mutex);
+		if (_pendingJobs == 0)
+			return;
+		_waiting = true;
+	}
+	g_system->waitSemaphore(_idleSemaphore);
+}
+
+bool ThreadPool::runNextJob() {
+	Job job;
+	{
+		StackLock lock(_mutex);
+		if (_jobs.empty())
+			return false;
+		job = _jobs.pop();
+	}
+
+	job.proc(job.param);
+	finishJob();
+	return true;
+}
+
+void ThreadPool::finishJob() {
+	StackLock lock(_mutex);
+	assert(_pendingJobs > 0);
+	if (--_pendingJobs == 0 && _waiting) {
+		_waiting = false;
+		g_system->postSemaphore(_idleSemaphore);
+	}
+}
+
+int ThreadPool::workerProc(void *param) {
+	ThreadPool *pool = (ThreadPool *)param;
+
+	for (;;) {
+		g_system->waitSemaphore(pool->_jobSemaphore);
+
+		// Jobs may have been taken by a thread in waitForJobs() meanwhile,
+		// in which case there is nothing to do for this wake up.
+		if (!pool->runNextJob()) {
+			StackLock lock(pool->_mutex);
+			if (pool->_quit)
+				return 0;
+		}
+	}
+}
+
+} // End of namespace Common
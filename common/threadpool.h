@@ -0,0 +1,112 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef COMMON_THREADPOOL_H
+#define COMMON_THREADPOOL_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/mutex.h"
+#include "common/noncopyable.h"
+#include "common/queue.h"
+#include "common/system.h"
+
+namespace Common {
+
+/**
+ * A fixed number of worker threads running jobs from a shared queue.
+ *
+ * Threads are an optional backend feature (see OSystem::createThread()).
+ * If the backend does not provide them, the pool has no workers and
+ * addJob() simply runs each job right away in the calling thread, so code
+ * using a ThreadPool works everywhere, just without the parallelism.
+ *
+ * A job is a plain function pointer plus a parameter. Jobs may run in any
+ * order and concurrently with each other, so they must not share unprotected
+ * state. To split up work and wait for the result, add one job per part and
+ * then call waitForJobs().
+ */
+class ThreadPool : NonCopyable {
+public:
+	typedef void (*JobProc)(void *param);
+
+	/**
+	 * Start the given number of worker threads. Fewer threads (possibly
+	 * none) may be started if the backend runs out of them or does not
+	 * support threads at all.
+	 */
+	explicit ThreadPool(uint numThreads);
+
+	/**
+	 * Stop all workers. Jobs which are already running are finished, jobs
+	 * still waiting in the queue are discarded.
+	 */
+	~ThreadPool();
+
+	/** Returns the number of worker threads; 0 means jobs run synchronously. */
+	uint getThreadCount() const { return _threads.size(); }
+
+	/**
+	 * Queue a job for one of the workers. May be called from any thread,
+	 * including from within a job.
+	 */
+	void addJob(JobProc proc, void *param);
+
+	/**
+	 * Wait until all jobs added so far have finished. The calling thread
+	 * helps out by running queued jobs itself while it waits.
+	 *
+	 * @note Only one thread at a time may wait on the same pool.
+	 */
+	void waitForJobs();
+
+private:
+	struct Job {
+		JobProc proc;
+		void *param;
+	};
+
+	static int workerProc(void *param);
+
+	/** Run the next queued job, if any. Returns false if the queue was empty. */
+	bool runNextJob();
+	void finishJob();
+
+	Array<OSystem::ThreadRef> _threads;
+
+	Mutex _mutex;
+	Queue<Job> _jobs;
+	/** Jobs queued or running; protected by _mutex. */
+	uint _pendingJobs;
+	/** Set while a thread is blocked in waitForJobs(); protected by _mutex. */
+	bool _waiting;
+	bool _quit;
+
+	/** Posted once for each queued job, and once per worker on shutdown. */
+	OSystem::SemaphoreRef _jobSemaphore;
+	/** Posted when the last pending job finishes while someone is waiting. */
+	OSystem::SemaphoreRef _idleSemaphore;
+};
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,117 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+// We use the standard C library for timing and output
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "devtools/benchmark/benchmark.h"
+
+#include "common/system.h"
+#include "common/util.h"
+
+#include "test/system.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef POSIX
+#include <sys/time.h>
+#endif
+
+static const Benchmark s_benchmarks[] = {
+	{ "bink", "<file> [max threads]", runBinkBenchmark },
+#ifdef ENABLE_WINTERMUTE
+	{ "blit", "[seconds]", runBlitBenchmark },
+#endif
+	{ "convert", "[seconds]", runConvertBenchmark },
+	{ "hashmap", "[seconds]", runHashMapBenchmark },
+	{ "rate", "[seconds]", runRateBenchmark },
+	{ "scaler", "[seconds] [max threads]", runScalerBenchmark },
+	{ "video", "<file> [decoder] [nosimd]", runVideoBenchmark }
+};
+
+double getBenchmarkTime() {
+	return (double)clock() / CLOCKS_PER_SEC;
+}
+
+double getBenchmarkWallTime() {
+#ifdef POSIX
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+#else
+	return getBenchmarkTime();
+#endif
+}
+
+void reportResult(const char *benchmark, const char *testCase, double value, const char *unit) {
+	printf("%s %s %.2f %s\n", benchmark, testCase, value, unit);
+	fflush(stdout);
+}
+
+byte *readBenchmarkFile(const char *filename, uint32 &size) {
+	FILE *file = fopen(filename, "rb");
+	if (!file)
+		return 0;
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	byte *data = (byte *)malloc(size);
+	if (data && fread(data, 1, size, file) != size) {
+		free(data);
+		data = 0;
+	}
+
+	fclose(file);
+	return data;
+}
+
+static void printUsage(const char *name) {
+	printf("Usage: %s <benchmark> [args...]\n\nAvailable benchmarks:\n", name);
+	for (int i = 0; i < ARRAYSIZE(s_benchmarks); ++i)
+		printf("  %s %s\n", s_benchmarks[i].name, s_benchmarks[i].usage);
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	for (int i = 0; i < ARRAYSIZE(s_benchmarks); ++i) {
+		if (!strcmp(argv[1], s_benchmarks[i].name)) {
+			// Provide mutexes and threads to the code under test
+			g_system = createTestSystem();
+			const int result = s_benchmarks[i].run(argc - 2, argv + 2);
+			destroyTestSystem(g_system);
+			g_system = 0;
+			return result;
+		}
+	}
+
+	printUsage(argv[0]);
+	return 1;
+}
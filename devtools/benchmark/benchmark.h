@@ -0,0 +1,88 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef DEVTOOLS_BENCHMARK_H
+#define DEVTOOLS_BENCHMARK_H
+
+#include "common/scummsys.h"
+
+/**
+ * A single benchmark, run via "benchmark <name> [args...]".
+ *
+ * @return the exit code of the tool
+ */
+struct Benchmark {
+	const char *name;
+	const char *usage;
+	int (*run)(int argc, const char *const *argv);
+};
+
+/** Processor time in seconds, for measuring intervals. */
+double getBenchmarkTime();
+
+/**
+ * Real time in seconds, for measuring intervals of multi-threaded code
+ * (processor time would add up the time of all threads).
+ */
+double getBenchmarkWallTime();
+
+/**
+ * Report a measurement in a fixed, easily machine-parsable format:
+ *   <benchmark> <case> <value> <unit>
+ */
+void reportResult(const char *benchmark, const char *testCase, double value, const char *unit);
+
+/**
+ * Read a whole file into memory, so that a benchmark doesn't measure disk
+ * access. Returns 0 on failure, otherwise the data, which must be freed
+ * with free().
+ */
+byte *readBenchmarkFile(const char *filename, uint32 &size);
+
+/** Heap usage of the whole tool, see getHeapStats(). */
+struct HeapStats {
+	/** The number of allocations so far. */
+	uint32 allocations;
+	/** The number of bytes allocated right now. */
+	int64 currentBytes;
+	/** The most bytes allocated at once since the last resetHeapPeak(). */
+	int64 peakBytes;
+};
+
+/**
+ * Get the heap usage, which is tracked by wrapping malloc() and friends.
+ * That is only possible with glibc; elsewhere, this returns false.
+ */
+bool getHeapStats(HeapStats &stats);
+
+/** Let the peak heap usage start over from the current usage. */
+void resetHeapPeak();
+
+int runBinkBenchmark(int argc, const char *const *argv);
+int runBlitBenchmark(int argc, const char *const *argv);
+int runConvertBenchmark(int argc, const char *const *argv);
+int runHashMapBenchmark(int argc, const char *const *argv);
+int runRateBenchmark(int argc, const char *const *argv);
+int runScalerBenchmark(int argc, const char *const *argv);
+int runVideoBenchmark(int argc, const char *const *argv);
+
+#endif
@@ -0,0 +1,121 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+// We use the standard C library for output
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "devtools/benchmark/benchmark.h"
+
+#include "common/scummsys.h"
+
+#ifdef USE_BINK
+
+#include "common/memstream.h"
+#include "common/str.h"
+#include "graphics/surface.h"
+#include "video/bink_decoder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+uint32 checksumSurface(const Graphics::Surface &surface, uint32 checksum) {
+	for (int y = 0; y < surface.h; ++y) {
+		const byte *row = (const byte *)surface.getBasePtr(0, y);
+		for (int x = 0; x < surface.w * surface.format.bytesPerPixel; ++x)
+			checksum = checksum * 31 + row[x];
+	}
+
+	return checksum;
+}
+
+} // End of anonymous namespace
+
+int runBinkBenchmark(int argc, const char *const *argv) {
+	if (argc < 1) {
+		fprintf(stderr, "bink: No file given\n");
+		return 1;
+	}
+
+	const int maxThreads = (argc > 1) ? atoi(argv[1]) : 4;
+
+	uint32 size = 0;
+	byte *data = readBenchmarkFile(argv[0], size);
+	if (!data) {
+		fprintf(stderr, "bink: Could not read '%s'\n", argv[0]);
+		return 1;
+	}
+
+	int result = 0;
+	uint32 refChecksum = 0;
+
+	for (int threads = 0; threads <= maxThreads; ++threads) {
+		Video::BinkDecoder decoder;
+		decoder.setThreadCount(threads);
+
+		if (!decoder.loadStream(new Common::MemoryReadStream(data, size))) {
+			fprintf(stderr, "bink: '%s' is not a Bink video\n", argv[0]);
+			result = 1;
+			break;
+		}
+
+		// Only the decoding is timed, not the checksum
+		const uint32 frameCount = decoder.getFrameCount();
+		uint32 checksum = 0;
+		double elapsed = 0.0;
+
+		for (uint32 i = 0; i < frameCount; ++i) {
+			const double start = getBenchmarkWallTime();
+			const Graphics::Surface *frame = decoder.decodeNextFrame();
+			elapsed += getBenchmarkWallTime() - start;
+
+			if (frame)
+				checksum = checksumSurface(*frame, checksum);
+		}
+
+		const Common::String name = Common::String::format("%dthreads", threads);
+		reportResult("bink", name.c_str(), frameCount / elapsed, "frames/s");
+
+		// Decoding with threads may not change the result
+		if (threads == 0) {
+			refChecksum = checksum;
+		} else if (checksum != refChecksum) {
+			fprintf(stderr, "bink %s: output differs from serial decoding\n", name.c_str());
+			result = 1;
+		}
+	}
+
+	free(data);
+	return result;
+}
+
+#else
+
+#include <stdio.h>
+
+int runBinkBenchmark(int argc, const char *const *argv) {
+	fprintf(stderr, "bink: Bink support is not compiled in\n");
+	return 1;
+}
+
+#endif
@@ -0,0 +1,263 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+// We use the standard C library for output
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "devtools/benchmark/benchmark.h"
+
+#include "common/array.h"
+#include "common/cpudetect.h"
+#include "common/str.h"
+#include "common/util.h"
+#include "engines/wintermute/graphics/blit_kernels.h"
+#include "engines/wintermute/graphics/transparent_surface.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+using Wintermute::TransparentSurface;
+
+enum {
+	kScreenWidth = 800,
+	kScreenHeight = 600,
+	kSpriteWidth = 96,
+	kSpriteHeight = 128,
+	kParticleSize = 32
+};
+
+/** A single blit of a scene, with the same arguments as TransparentSurface::blit(). */
+struct SceneBlit {
+	TransparentSurface *sprite;
+	int x, y;
+	int flipping;
+	uint color;
+	Wintermute::TSpriteBlendMode blendMode;
+};
+
+/**
+ * The sprites of a typical scene: a background, characters with soft
+ * (full alpha) and hard (binary alpha) edges, and particles.
+ */
+class Scene {
+public:
+	Scene() : _seed(1) {
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 16, 8, 0, 24);
+
+		_background.create(kScreenWidth, kScreenHeight, format);
+		fill(_background, 0);
+		_background._enableAlphaBlit = false;
+		_background._alphaMode = TransparentSurface::ALPHA_OPAQUE;
+
+		_soft.create(kSpriteWidth, kSpriteHeight, format);
+		fill(_soft, 1);
+		_soft._alphaMode = _soft.detectAlphaMode();
+
+		_hard.create(kSpriteWidth, kSpriteHeight, format);
+		fill(_hard, 2);
+		_hard._alphaMode = _hard.detectAlphaMode();
+
+		_particle.create(kParticleSize, kParticleSize, format);
+		fill(_particle, 1);
+		_particle._alphaMode = _particle.detectAlphaMode();
+	}
+
+	~Scene() {
+		_background.free();
+		_soft.free();
+		_hard.free();
+		_particle.free();
+	}
+
+	/** The sprites added to the scene are drawn in the order they are added. */
+	void addBackground() {
+		add(&_background, 0, 0, TransparentSurface::FLIP_NONE, BS_ARGB(255, 255, 255, 255), Wintermute::BLEND_NORMAL);
+	}
+
+	void addSprites(bool soft, bool tinted, int count) {
+		for (int i = 0; i < count; ++i) {
+			const int x = random() % (kScreenWidth - kSpriteWidth);
+			const int y = random() % (kScreenHeight - kSpriteHeight);
+			const int flipping = (i % 4 == 3) ? TransparentSurface::FLIP_H : TransparentSurface::FLIP_NONE;
+			const uint color = tinted ? BS_ARGB(192, 255, 160, 96) : BS_ARGB(255, 255, 255, 255);
+			add(soft ? &_soft : &_hard, x, y, flipping, color, Wintermute::BLEND_NORMAL);
+		}
+	}
+
+	void addParticles(int count) {
+		for (int i = 0; i < count; ++i) {
+			const int x = random() % (kScreenWidth - kParticleSize);
+			const int y = random() % (kScreenHeight - kParticleSize);
+			add(&_particle, x, y, TransparentSurface::FLIP_NONE, BS_ARGB(160, 255, 200, 120), Wintermute::BLEND_ADDITIVE);
+		}
+	}
+
+	void clear() {
+		_blits.clear();
+	}
+
+	/** Draw the scene, and return the number of pixels drawn. */
+	uint32 draw(Graphics::Surface &target) const {
+		uint32 pixels = 0;
+		for (uint i = 0; i < _blits.size(); ++i) {
+			const SceneBlit &b = _blits[i];
+			pixels += b.sprite->w * b.sprite->h;
+			b.sprite->blit(target, b.x, b.y, b.flipping, nullptr, b.color, -1, -1, b.blendMode);
+		}
+		return pixels;
+	}
+
+private:
+	uint32 random() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 8;
+	}
+
+	/**
+	 * Fill a surface with some gradients. With kind 1, the alpha fades
+	 * out towards the edges; with kind 2, there is a transparent border
+	 * around an opaque center; otherwise everything is opaque.
+	 */
+	static void fill(TransparentSurface &surface, int kind) {
+		for (int y = 0; y < surface.h; ++y) {
+			uint32 *row = (uint32 *)surface.getBasePtr(0, y);
+			for (int x = 0; x < surface.w; ++x) {
+				const int edge = MIN(MIN(x, surface.w - 1 - x), MIN(y, surface.h - 1 - y));
+				uint alpha = 255;
+				if (kind == 1)
+					alpha = MIN(255, edge * 16);
+				else if (kind == 2)
+					alpha = (edge < 8) ? 0 : 255;
+				row[x] = BS_ARGB(alpha, (x * 3) & 0xFF, (y * 5) & 0xFF, (x ^ y) & 0xFF);
+			}
+		}
+	}
+
+	void add(TransparentSurface *sprite, int x, int y, int flipping, uint color, Wintermute::TSpriteBlendMode blendMode) {
+		const SceneBlit b = { sprite, x, y, flipping, color, blendMode };
+		_blits.push_back(b);
+	}
+
+	uint32 _seed;
+	TransparentSurface _background, _soft, _hard, _particle;
+	Common::Array<SceneBlit> _blits;
+};
+
+/** The cases, each drawn by a part of the scene. The last one is a full frame. */
+const char *const s_blitCases[] = {
+	"opaque",
+	"binary",
+	"alpha",
+	"tinted",
+	"additive",
+	"frame"
+};
+
+void setupCase(Scene &scene, int c) {
+	scene.clear();
+	if (c == 0 || c == 5)
+		scene.addBackground();
+	if (c == 1 || c == 5)
+		scene.addSprites(false, false, 12);
+	if (c == 2 || c == 5)
+		scene.addSprites(true, false, 12);
+	if (c == 3 || c == 5)
+		scene.addSprites(true, true, 4);
+	if (c == 4 || c == 5)
+		scene.addParticles(200);
+}
+
+/** Features to disable, to get each of the kernel implementations. */
+const uint32 s_kernelSets[] = {
+	0xFFFFFFFF,
+	Common::kCpuFeatureAVX2,
+	0
+};
+
+} // End of anonymous namespace
+
+int runBlitBenchmark(int argc, const char *const *argv) {
+	const double duration = (argc > 0) ? atof(argv[0]) : 1.0;
+	const Graphics::PixelFormat format(4, 8, 8, 8, 8, 16, 8, 0, 24);
+	const uint32 size = kScreenWidth * kScreenHeight * 4;
+
+	Graphics::Surface target, expected;
+	target.create(kScreenWidth, kScreenHeight, format);
+	expected.create(kScreenWidth, kScreenHeight, format);
+
+	Scene scene;
+	int result = 0;
+
+	for (int c = 0; c < ARRAYSIZE(s_blitCases); ++c) {
+		setupCase(scene, c);
+
+		const char *measured[ARRAYSIZE(s_kernelSets)];
+		uint numMeasured = 0;
+
+		for (int k = 0; k < ARRAYSIZE(s_kernelSets); ++k) {
+			Common::setDisabledCPUFeatures(s_kernelSets[k]);
+
+			// If the CPU lacks a feature, we get the fallback kernels. Do not
+			// measure those twice.
+			const char *kernelName = Wintermute::getBlitKernels().name;
+			bool alreadyMeasured = false;
+			for (uint i = 0; i < numMeasured; ++i)
+				alreadyMeasured |= !strcmp(measured[i], kernelName);
+			if (alreadyMeasured)
+				continue;
+			measured[numMeasured++] = kernelName;
+
+			// The first set is the plain C++ code, which is the reference
+			memset(target.getPixels(), 0x40, size);
+			scene.draw(target);
+			if (k == 0) {
+				memcpy(expected.getPixels(), target.getPixels(), size);
+			} else if (memcmp(expected.getPixels(), target.getPixels(), size)) {
+				fprintf(stderr, "blit: %s/%s differs from the C++ code\n", s_blitCases[c], kernelName);
+				result = 1;
+			}
+
+			double pixels = 0;
+			uint frames = 0;
+			const double start = getBenchmarkTime();
+			double elapsed;
+			do {
+				pixels += scene.draw(target);
+				++frames;
+				elapsed = getBenchmarkTime() - start;
+			} while (elapsed < duration);
+
+			const Common::String caseName = Common::String::format("%s/%s", s_blitCases[c], kernelName);
+			if (c == ARRAYSIZE(s_blitCases) - 1)
+				reportResult("blit", caseName.c_str(), frames / elapsed, "frames/s");
+			else
+				reportResult("blit", caseName.c_str(), pixels / elapsed / 1000000.0, "Mpixels/s");
+		}
+	}
+
+	Common::setDisabledCPUFeatures(0);
+	target.free();
+	expected.free();
+	return result;
+}
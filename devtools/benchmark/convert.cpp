@@ -0,0 +1,138 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+// We use the standard C library for output
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "devtools/benchmark/benchmark.h"
+
+#include "common/cpudetect.h"
+#include "common/str.h"
+#include "common/util.h"
+#include "graphics/conversion.h"
+#include "graphics/pixelformat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+struct ConversionCase {
+	const char *name;
+	Graphics::PixelFormat srcFormat;
+	Graphics::PixelFormat dstFormat;
+};
+
+const Graphics::PixelFormat kFormatCLUT8(1, 0, 0, 0, 0, 0, 0, 0, 0);
+const Graphics::PixelFormat kFormat555(2, 5, 5, 5, 0, 10, 5, 0, 0);
+const Graphics::PixelFormat kFormat565(2, 5, 6, 5, 0, 11, 5, 0, 0);
+const Graphics::PixelFormat kFormatRGB888(3, 8, 8, 8, 0, 16, 8, 0, 0);
+const Graphics::PixelFormat kFormatRGBA8888(4, 8, 8, 8, 8, 24, 16, 8, 0);
+const Graphics::PixelFormat kFormatABGR8888(4, 8, 8, 8, 8, 0, 8, 16, 24);
+
+const ConversionCase s_conversionCases[] = {
+	{ "565-rgba8888", kFormat565, kFormatRGBA8888 },
+	{ "rgba8888-565", kFormatRGBA8888, kFormat565 },
+	{ "555-565", kFormat555, kFormat565 },
+	{ "565-555", kFormat565, kFormat555 },
+	{ "rgba8888-abgr8888", kFormatRGBA8888, kFormatABGR8888 },
+	{ "rgb888-rgba8888", kFormatRGB888, kFormatRGBA8888 },
+	{ "clut8-565", kFormatCLUT8, kFormat565 },
+	{ "clut8-rgba8888", kFormatCLUT8, kFormatRGBA8888 }
+};
+
+// A typical video frame
+const int kWidth = 640;
+const int kHeight = 480;
+
+bool convert(byte *dst, const byte *src, const ConversionCase &cc, const uint32 *map) {
+	const uint srcPitch = kWidth * cc.srcFormat.bytesPerPixel;
+	const uint dstPitch = kWidth * cc.dstFormat.bytesPerPixel;
+
+	if (cc.srcFormat.bytesPerPixel == 1)
+		return Graphics::crossBlitMap(dst, src, dstPitch, srcPitch, kWidth, kHeight, cc.dstFormat.bytesPerPixel, map);
+	else
+		return Graphics::crossBlit(dst, src, dstPitch, srcPitch, kWidth, kHeight, cc.dstFormat, cc.srcFormat);
+}
+
+} // End of anonymous namespace
+
+int runConvertBenchmark(int argc, const char *const *argv) {
+	const double duration = (argc > 0) ? atof(argv[0]) : 0.5;
+
+	const uint32 frameSize = kWidth * kHeight * 4;
+	byte *src = (byte *)malloc(frameSize);
+	byte *dst = (byte *)malloc(frameSize);
+	byte *ref = (byte *)malloc(frameSize);
+
+	uint32 seed = 1;
+	for (uint32 i = 0; i < frameSize; ++i) {
+		seed = seed * 1103515245 + 12345;
+		src[i] = seed >> 24;
+	}
+
+	int result = 0;
+	for (int c = 0; c < ARRAYSIZE(s_conversionCases); ++c) {
+		const ConversionCase &cc = s_conversionCases[c];
+		const uint32 dstSize = kWidth * kHeight * cc.dstFormat.bytesPerPixel;
+
+		uint32 map[256];
+		for (int i = 0; i < 256; ++i)
+			map[i] = cc.dstFormat.RGBToColor(i, 255 - i, i * 7);
+
+		// Paletted sources do not have SIMD code, so only measure them once
+		const bool simd = (cc.srcFormat.bytesPerPixel != 1);
+
+		// The plain C++ conversion is the reference result
+		Common::setDisabledCPUFeatures(0xFFFFFFFF);
+		convert(ref, src, cc, map);
+
+		for (int pass = simd ? 0 : 1; pass < 2; ++pass) {
+			Common::setDisabledCPUFeatures(pass ? 0 : 0xFFFFFFFF);
+			memset(dst, 0, dstSize);
+
+			int frames = 0;
+			const double start = getBenchmarkTime();
+			double elapsed;
+			do {
+				convert(dst, src, cc, map);
+				++frames;
+				elapsed = getBenchmarkTime() - start;
+			} while (elapsed < duration);
+
+			const Common::String name = Common::String::format(pass ? "%s" : "%s/nosimd", cc.name);
+			reportResult("convert", name.c_str(), kWidth * kHeight * frames / elapsed / 1000000.0, "Mpixels/s");
+
+			if (memcmp(dst, ref, dstSize) != 0) {
+				fprintf(stderr, "convert %s: output differs from the plain C++ conversion\n", name.c_str());
+				result = 1;
+			}
+		}
+	}
+
+	free(src);
+	free(dst);
+	free(ref);
+	Common::setDisabledCPUFeatures(0);
+	return result;
+}
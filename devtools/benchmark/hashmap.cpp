@@ -0,0 +1,163 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+// We use the standard C library for output
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "devtools/benchmark/benchmark.h"
+
+#include "common/array.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+#include "common/str.h"
+#include "common/util.h"
+
+#include <stdlib.h>
+
+namespace {
+
+const uint s_mapSizes[] = { 100, 10000, 200000 };
+
+/**
+ * Run one operation over all keys until the given time has passed, and
+ * report the number of operations per second.
+ */
+template<class Op>
+void measure(const char *caseName, uint size, double duration, Op &op) {
+	double ops = 0;
+	const double start = getBenchmarkTime();
+	double elapsed;
+	do {
+		ops += op.run();
+		elapsed = getBenchmarkTime() - start;
+	} while (elapsed < duration);
+
+	const Common::String name = Common::String::format("%s/%u", caseName, size);
+	reportResult("hashmap", name.c_str(), ops / elapsed / 1000000.0, "Mops/s");
+}
+
+template<class Key, class Map>
+struct InsertOp {
+	const Common::Array<Key> &keys;
+	InsertOp(const Common::Array<Key> &k) : keys(k) {}
+
+	uint run() {
+		Map map;
+		for (uint i = 0; i < keys.size(); ++i)
+			map[keys[i]] = i;
+		return keys.size();
+	}
+};
+
+template<class Key, class Map>
+struct LookupOp {
+	const Map &map;
+	const Common::Array<Key> &keys;
+	uint found;
+	LookupOp(const Map &m, const Common::Array<Key> &k) : map(m), keys(k), found(0) {}
+
+	uint run() {
+		for (uint i = 0; i < keys.size(); ++i)
+			found += map.contains(keys[i]);
+		return keys.size();
+	}
+};
+
+template<class Key, class Map>
+struct ChurnOp {
+	Map &map;
+	const Common::Array<Key> &keys;
+	ChurnOp(Map &m, const Common::Array<Key> &k) : map(m), keys(k) {}
+
+	uint run() {
+		for (uint i = 0; i < keys.size(); ++i) {
+			map.erase(keys[i]);
+			map[keys[i]] = i;
+		}
+		return keys.size() * 2;
+	}
+};
+
+template<class Key, class Map>
+void runCases(const char *keyType, const Common::Array<Key> &keys, const Common::Array<Key> &missing, double duration) {
+	const uint size = keys.size();
+	Map map;
+	for (uint i = 0; i < size; ++i)
+		map[keys[i]] = i;
+
+	InsertOp<Key, Map> insert(keys);
+	measure(Common::String::format("insert-%s", keyType).c_str(), size, duration, insert);
+
+	LookupOp<Key, Map> hit(map, keys);
+	measure(Common::String::format("hit-%s", keyType).c_str(), size, duration, hit);
+
+	LookupOp<Key, Map> miss(map, missing);
+	measure(Common::String::format("miss-%s", keyType).c_str(), size, duration, miss);
+
+	ChurnOp<Key, Map> churn(map, keys);
+	measure(Common::String::format("erase-insert-%s", keyType).c_str(), size, duration, churn);
+
+	// Keep the compiler from optimizing the lookups away
+	if (hit.found != (uint)(hit.found + miss.found))
+		return;
+}
+
+} // End of anonymous namespace
+
+int runHashMapBenchmark(int argc, const char *const *argv) {
+	const double duration = (argc > 0) ? atof(argv[0]) : 0.5;
+
+	for (int s = 0; s < ARRAYSIZE(s_mapSizes); ++s) {
+		const uint size = s_mapSizes[s];
+
+		// Scattered integer keys, like resource ids
+		Common::Array<int> intKeys, intMissing;
+		uint32 seed = 1;
+		for (uint i = 0; i < size; ++i) {
+			seed = seed * 1103515245 + 12345;
+			intKeys.push_back((int)(seed & 0x7FFFFFFF) | 1);
+			intMissing.push_back((int)(seed & 0x7FFFFFFF) & ~1);
+		}
+		runCases<int, Common::HashMap<int, uint> >("int", intKeys, intMissing, duration);
+
+		// Case-insensitive file and config key names
+		Common::Array<Common::String> strKeys, strMissing;
+		for (uint i = 0; i < size; ++i) {
+			strKeys.push_back(Common::String::format("resource_%u.dat", i));
+			strMissing.push_back(Common::String::format("RESOURCE_%u.BAK", i));
+		}
+		typedef Common::HashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> StringMap;
+		runCases<Common::String, StringMap>("string", strKeys, strMissing, duration);
+
+		// The same lookups with C strings, which need no temporary String
+		StringMap strMap;
+		Common::Array<const char *> cstrKeys;
+		for (uint i = 0; i < size; ++i) {
+			strMap[strKeys[i]] = i;
+			cstrKeys.push_back(strKeys[i].c_str());
+		}
+		LookupOp<const char *, StringMap> cstrHit(strMap, cstrKeys);
+		measure("hit-cstr", size, duration, cstrHit);
+	}
+
+	return 0;
+}
@@ -0,0 +1,140 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+// We replace the C library's allocation functions
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "devtools/benchmark/benchmark.h"
+
+#ifdef __GLIBC__
+
+#include <errno.h>
+#include <malloc.h>
+#include <stddef.h>
+
+// glibc exports its allocator under these names as well, so we can put
+// counting wrappers in front of it. Memory allocated with new ends up in
+// malloc(), too.
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+namespace {
+
+// Updated from several threads, hence the atomic operations
+uint32 s_allocations = 0;
+int64 s_currentBytes = 0;
+int64 s_peakBytes = 0;
+
+void countAllocation(void *ptr) {
+	if (!ptr)
+		return;
+
+	__sync_fetch_and_add(&s_allocations, 1);
+	const int64 current = __sync_add_and_fetch(&s_currentBytes, (int64)malloc_usable_size(ptr));
+
+	// Losing a peak to a race now and then does not matter
+	if (current > s_peakBytes)
+		s_peakBytes = current;
+}
+
+void countFree(size_t size) {
+	__sync_fetch_and_sub(&s_currentBytes, (int64)size);
+}
+
+} // End of anonymous namespace
+
+extern "C" {
+
+void *malloc(size_t size) {
+	void *ptr = __libc_malloc(size);
+	countAllocation(ptr);
+	return ptr;
+}
+
+void *calloc(size_t count, size_t size) {
+	void *ptr = __libc_calloc(count, size);
+	countAllocation(ptr);
+	return ptr;
+}
+
+void *realloc(void *ptr, size_t size) {
+	const size_t oldSize = ptr ? malloc_usable_size(ptr) : 0;
+	void *newPtr = __libc_realloc(ptr, size);
+
+	// On failure, the old block is still there
+	if (newPtr || !size) {
+		countFree(oldSize);
+		countAllocation(newPtr);
+	}
+
+	return newPtr;
+}
+
+void *memalign(size_t alignment, size_t size) {
+	void *ptr = __libc_memalign(alignment, size);
+	countAllocation(ptr);
+	return ptr;
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+	*ptr = __libc_memalign(alignment, size);
+	countAllocation(*ptr);
+	return *ptr ? 0 : ENOMEM;
+}
+
+void free(void *ptr) {
+	if (ptr)
+		countFree(malloc_usable_size(ptr));
+	__libc_free(ptr);
+}
+
+} // End of extern "C"
+
+bool getHeapStats(HeapStats &stats) {
+	stats.allocations = s_allocations;
+	stats.currentBytes = s_currentBytes;
+	stats.peakBytes = s_peakBytes;
+	return true;
+}
+
+void resetHeapPeak() {
+	s_peakBytes = s_currentBytes;
+}
+
+#else
+
+bool getHeapStats(HeapStats &stats) {
+	stats.allocations = 0;
+	stats.currentBytes = 0;
+	stats.peakBytes = 0;
+	return false;
+}
+
+void resetHeapPeak() {
+}
+
+#endif
@@ -0,0 +1,41 @@
+MODULE := devtools/benchmark
+
+MODULE_OBJS := \
+	benchmark.o \
+	bink.o \
+	convert.o \
+	hashmap.o \
+	heap.o \
+	rate.o \
+	scaler.o \
+	video.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := benchmark
+
+# The benchmarks exercise the real engine-independent code
+TOOL_DEPS := \
+	test/system.o \
+	video/libvideo.a \
+	audio/libaudio.a \
+	graphics/libgraphics.a \
+	common/libcommon.a
+
+# The Wintermute blitter is benchmarked straight from the engine sources
+ifdef ENABLE_WINTERMUTE
+MODULE_OBJS += \
+	blit.o
+TOOL_DEPS := \
+	engines/wintermute/graphics/blit_kernels.o \
+	engines/wintermute/graphics/transform_struct.o \
+	engines/wintermute/graphics/transform_tools.o \
+	engines/wintermute/graphics/transparent_surface.o \
+	$(TOOL_DEPS)
+endif
+
+# The video decoders pull in the audio decoders, which need the same
+# libraries as ScummVM itself
+TOOL_LIBS := $(LIBS)
+
+# Include common rules
+include $(srcdir)/rules.mk
@@ -0,0 +1,155 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+// We use the standard C library for output
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "devtools/benchmark/benchmark.h"
+
+#include "audio/audiostream.h"
+#include "audio/rate.h"
+#include "audio/rate_kernels.h"
+#include "common/cpudetect.h"
+#include "common/str.h"
+#include "common/util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+/**
+ * Endless stream of noise, so that we only measure the rate conversion.
+ */
+class NoiseStream : public Audio::AudioStream {
+public:
+	NoiseStream(int rate, bool stereo) : _rate(rate), _stereo(stereo), _pos(0) {
+		uint32 seed = 1;
+		for (int i = 0; i < kNoiseSamples; ++i) {
+			seed = seed * 1103515245 + 12345;
+			_noise[i] = (int16)(seed >> 16);
+		}
+	}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		for (int done = 0; done < numSamples; ) {
+			const int len = MIN(numSamples - done, kNoiseSamples - _pos);
+			memcpy(buffer + done, _noise + _pos, len * sizeof(int16));
+			done += len;
+			_pos = (_pos + len) % kNoiseSamples;
+		}
+		return numSamples;
+	}
+
+	bool isStereo() const { return _stereo; }
+	int getRate() const { return _rate; }
+	bool endOfData() const { return false; }
+
+private:
+	enum {
+		kNoiseSamples = 4096
+	};
+
+	const int _rate;
+	const bool _stereo;
+	int16 _noise[kNoiseSamples];
+	int _pos;
+};
+
+struct RateCase {
+	const char *name;
+	int inRate;
+	int outRate;
+	bool stereo;
+	bool reverseStereo;
+	Audio::RateConverterQuality quality;
+};
+
+const RateCase s_rateCases[] = {
+	{ "copy-mono",            22050, 22050, false, false, Audio::kRateConverterQualityFast },
+	{ "copy-stereo",          44100, 44100, true,  false, Audio::kRateConverterQualityFast },
+	{ "copy-stereo-reverse",  44100, 44100, true,  true,  Audio::kRateConverterQualityFast },
+	{ "simple-mono",          44100, 22050, false, false, Audio::kRateConverterQualityFast },
+	{ "simple-stereo",        44100, 22050, true,  false, Audio::kRateConverterQualityFast },
+	{ "linear-mono",          11025, 44100, false, false, Audio::kRateConverterQualityFast },
+	{ "linear-stereo",        22050, 48000, true,  false, Audio::kRateConverterQualityFast },
+	{ "sinc16-mono",          11025, 44100, false, false, Audio::kRateConverterQualityGood },
+	{ "sinc16-stereo",        22050, 48000, true,  false, Audio::kRateConverterQualityGood },
+	{ "sinc32-mono",          11025, 44100, false, false, Audio::kRateConverterQualityBest },
+	{ "sinc32-stereo",        22050, 48000, true,  false, Audio::kRateConverterQualityBest }
+};
+
+/** Features to disable, to get each of the kernel implementations. */
+const uint32 s_kernelSets[] = {
+	0,
+	Common::kCpuFeatureAVX2,
+	0xFFFFFFFF
+};
+
+} // End of anonymous namespace
+
+int runRateBenchmark(int argc, const char *const *argv) {
+	const double duration = (argc > 0) ? atof(argv[0]) : 1.0;
+	const uint kFrames = 2048;
+	int16 *output = new int16[kFrames * 2];
+
+	const char *measured[ARRAYSIZE(s_kernelSets)];
+	uint numMeasured = 0;
+
+	for (int k = 0; k < ARRAYSIZE(s_kernelSets); ++k) {
+		Common::setDisabledCPUFeatures(s_kernelSets[k]);
+
+		// If the CPU lacks a feature, we get the fallback kernels. Do not
+		// measure those twice.
+		const char *kernelName = Audio::getRateKernels().name;
+		bool alreadyMeasured = false;
+		for (uint i = 0; i < numMeasured; ++i)
+			alreadyMeasured |= !strcmp(measured[i], kernelName);
+		if (alreadyMeasured)
+			continue;
+		measured[numMeasured++] = kernelName;
+
+		for (int c = 0; c < ARRAYSIZE(s_rateCases); ++c) {
+			const RateCase &rc = s_rateCases[c];
+			NoiseStream input(rc.inRate, rc.stereo);
+			Audio::RateConverter *converter = Audio::makeRateConverter(rc.inRate, rc.outRate, rc.stereo, rc.reverseStereo, rc.quality);
+
+			double frames = 0;
+			const double start = getBenchmarkTime();
+			double elapsed;
+			do {
+				memset(output, 0, kFrames * 2 * sizeof(int16));
+				frames += converter->flow(input, output, kFrames, 200, 180);
+				elapsed = getBenchmarkTime() - start;
+			} while (elapsed < duration);
+
+			delete converter;
+
+			const Common::String caseName = Common::String::format("%s/%s", rc.name, kernelName);
+			reportResult("rate", caseName.c_str(), frames / elapsed / 1000000.0, "Mframes/s");
+		}
+	}
+
+	Common::setDisabledCPUFeatures(0);
+	delete[] output;
+	return 0;
+}
@@ -0,0 +1,137 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+// We use the standard C library for output
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "devtools/benchmark/benchmark.h"
+
+#include "common/cpudetect.h"
+#include "common/str.h"
+#include "common/util.h"
+#include "graphics/scaler.h"
+#include "graphics/scaler/parallel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+struct ScalerInfo {
+	const char *name;
+	ScalerProc *proc;
+	int factor;
+	/** Whether the scaler has SIMD code, which is also measured without. */
+	bool simd;
+};
+
+const ScalerInfo s_scalers[] = {
+	{ "normal1x", Normal1x, 1, false },
+#ifdef USE_SCALERS
+	{ "2xsai", _2xSaI, 2, false },
+	{ "advmame3x", AdvMame3x, 3, false },
+	{ "dotmatrix", DotMatrix, 2, false },
+#ifdef USE_HQ_SCALERS
+	{ "hq2x", HQ2x, 2, true },
+	{ "hq3x", HQ3x, 3, true },
+#endif
+#endif
+};
+
+// A typical high resolution game screen
+const int kWidth = 640;
+const int kHeight = 480;
+
+} // End of anonymous namespace
+
+int runScalerBenchmark(int argc, const char *const *argv) {
+	const double duration = (argc > 0) ? atof(argv[0]) : 0.5;
+	const int maxThreads = (argc > 1) ? atoi(argv[1]) : 4;
+
+	InitScalers(565);
+
+	// The scalers read one pixel around the rectangle, so add a border
+	const uint32 srcPitch = (kWidth + 2) * 2;
+	byte *src = (byte *)malloc(srcPitch * (kHeight + 2));
+	const uint32 dstPitch = kWidth * 3 * 2;
+	byte *dst = (byte *)malloc(dstPitch * kHeight * 3);
+	byte *ref = (byte *)malloc(dstPitch * kHeight * 3);
+
+	// Areas of flat color with some noise, so the scalers find both edges
+	// and smooth parts, like in real game graphics
+	uint32 seed = 1;
+	for (int y = 0; y < kHeight + 2; ++y) {
+		uint16 *row = (uint16 *)(src + y * srcPitch);
+		for (int x = 0; x < kWidth + 2; ++x) {
+			seed = seed * 1103515245 + 12345;
+			row[x] = ((x / 16 + y / 16) & 1) ? 0x07E0 : 0x001F;
+			if ((seed >> 16) % 10 == 0)
+				row[x] = (uint16)(seed >> 8);
+		}
+	}
+
+	int result = 0;
+	for (int s = 0; s < ARRAYSIZE(s_scalers); ++s) {
+		const uint32 dstSize = dstPitch * kHeight * s_scalers[s].factor;
+		memset(ref, 0, dstSize);
+		memset(dst, 0, dstSize);
+		s_scalers[s].proc(src + srcPitch + 2, srcPitch, ref, dstPitch, kWidth, kHeight);
+
+		// The first run measures the plain C++ code, if there is any other
+		for (int threads = s_scalers[s].simd ? -1 : 0; threads <= maxThreads; ++threads) {
+			Graphics::ParallelScaler scaler(MAX(threads, 0));
+			Common::setDisabledCPUFeatures(threads < 0 ? 0xFFFFFFFF : 0);
+
+			int frames = 0;
+			const double start = getBenchmarkWallTime();
+			double elapsed;
+			do {
+				scaler.scale(s_scalers[s].proc, s_scalers[s].factor, src + srcPitch + 2, srcPitch,
+						dst, dstPitch, kWidth, kHeight);
+				++frames;
+				elapsed = getBenchmarkWallTime() - start;
+			} while (elapsed < duration);
+
+			Common::String name;
+			if (threads < 0)
+				name = Common::String::format("%s/nosimd", s_scalers[s].name);
+			else
+				name = Common::String::format("%s/%dthreads", s_scalers[s].name, scaler.getThreadCount());
+			reportResult("scaler", name.c_str(), elapsed * 1000.0 / frames, "ms/frame");
+
+			// Neither SIMD nor scaling in bands may change the result
+			if (memcmp(dst, ref, dstSize) != 0) {
+				fprintf(stderr, "scaler %s: output differs from serial scaling\n", name.c_str());
+				result = 1;
+			}
+		}
+	}
+
+	free(src);
+	free(dst);
+	free(ref);
+	Common::setDisabledCPUFeatures(0);
+	DestroyScalers();
+	return result;
+}
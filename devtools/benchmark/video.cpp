@@ -0,0 +1,222 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+// We use the standard C library for output
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "devtools/benchmark/benchmark.h"
+
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/cpudetect.h"
+#include "common/memstream.h"
+#include "common/str.h"
+#include "common/tokenizer.h"
+#include "video/avi_decoder.h"
+#include "video/bink_decoder.h"
+#include "video/coktel_decoder.h"
+#include "video/dxa_decoder.h"
+#include "video/flic_decoder.h"
+#include "video/psx_decoder.h"
+#include "video/qt_decoder.h"
+#include "video/smk_decoder.h"
+#include "video/theora_decoder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+Video::VideoDecoder *createAVIDecoder() { return new Video::AVIDecoder(); }
+#ifdef USE_BINK
+Video::VideoDecoder *createBinkDecoder() { return new Video::BinkDecoder(); }
+#endif
+Video::VideoDecoder *createDXADecoder() { return new Video::DXADecoder(); }
+Video::VideoDecoder *createFlicDecoder() { return new Video::FlicDecoder(); }
+Video::VideoDecoder *createPSXDecoder() { return new Video::PSXStreamDecoder(Video::PSXStreamDecoder::kCD2x); }
+Video::VideoDecoder *createQuickTimeDecoder() { return new Video::QuickTimeDecoder(); }
+Video::VideoDecoder *createSmackerDecoder() { return new Video::SmackerDecoder(); }
+#ifdef USE_THEORADEC
+Video::VideoDecoder *createTheoraDecoder() { return new Video::TheoraDecoder(); }
+#endif
+#if defined(ENABLE_GOB) || defined(ENABLE_SCI32) || defined(DYNAMIC_MODULES)
+Video::VideoDecoder *createVMDDecoder() { return new Video::AdvancedVMDDecoder(); }
+#endif
+
+struct DecoderInfo {
+	const char *name;
+	/** File name extensions, separated by spaces. */
+	const char *extensions;
+	Video::VideoDecoder *(*create)();
+};
+
+// The codecs in video/codecs are used by the AVI and QuickTime decoders
+const DecoderInfo s_decoders[] = {
+	{ "avi", "avi", createAVIDecoder },
+#ifdef USE_BINK
+	{ "bink", "bik", createBinkDecoder },
+#endif
+	{ "dxa", "dxa", createDXADecoder },
+	{ "flic", "flc fli", createFlicDecoder },
+	{ "psx", "str", createPSXDecoder },
+	{ "qt", "mov qt", createQuickTimeDecoder },
+	{ "smk", "smk", createSmackerDecoder },
+#ifdef USE_THEORADEC
+	{ "theora", "ogg ogv", createTheoraDecoder },
+#endif
+#if defined(ENABLE_GOB) || defined(ENABLE_SCI32) || defined(DYNAMIC_MODULES)
+	{ "vmd", "vmd", createVMDDecoder },
+#endif
+};
+
+const DecoderInfo *findDecoderByName(const char *name) {
+	for (int i = 0; i < ARRAYSIZE(s_decoders); ++i)
+		if (!scumm_stricmp(s_decoders[i].name, name))
+			return &s_decoders[i];
+
+	return 0;
+}
+
+const DecoderInfo *findDecoderByExtension(const char *filename) {
+	const char *dot = strrchr(filename, '.');
+	if (!dot)
+		return 0;
+
+	for (int i = 0; i < ARRAYSIZE(s_decoders); ++i) {
+		Common::StringTokenizer tokenizer(s_decoders[i].extensions, " ");
+		while (!tokenizer.empty())
+			if (!scumm_stricmp(tokenizer.nextToken().c_str(), dot + 1))
+				return &s_decoders[i];
+	}
+
+	return 0;
+}
+
+void printDecoders() {
+	fprintf(stderr, "Available decoders:");
+	for (int i = 0; i < ARRAYSIZE(s_decoders); ++i)
+		fprintf(stderr, " %s", s_decoders[i].name);
+	fprintf(stderr, "\n");
+}
+
+} // End of anonymous namespace
+
+int runVideoBenchmark(int argc, const char *const *argv) {
+	if (argc < 1) {
+		fprintf(stderr, "video: No file given\n");
+		return 1;
+	}
+
+	const char *filename = argv[0];
+	const DecoderInfo *info = 0;
+	bool noSIMD = false;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "nosimd")) {
+			noSIMD = true;
+		} else if (!(info = findDecoderByName(argv[i]))) {
+			fprintf(stderr, "video: Unknown decoder '%s'\n", argv[i]);
+			printDecoders();
+			return 1;
+		}
+	}
+
+	if (!info && !(info = findDecoderByExtension(filename))) {
+		fprintf(stderr, "video: Cannot tell the decoder for '%s' from its extension\n", filename);
+		printDecoders();
+		return 1;
+	}
+
+	uint32 size = 0;
+	byte *data = readBenchmarkFile(filename, size);
+	if (!data) {
+		fprintf(stderr, "video: Could not read '%s'\n", filename);
+		return 1;
+	}
+
+	Common::setDisabledCPUFeatures(noSIMD ? 0xFFFFFFFF : 0);
+
+	HeapStats baseline, before, after;
+	const bool haveHeapStats = getHeapStats(baseline);
+	if (!haveHeapStats)
+		fprintf(stderr, "video: Heap statistics are not available on this system\n");
+	resetHeapPeak();
+
+	Video::VideoDecoder *decoder = info->create();
+
+	double start = getBenchmarkWallTime();
+	if (!decoder->loadStream(new Common::MemoryReadStream(data, size))) {
+		fprintf(stderr, "video: '%s' could not be loaded by the %s decoder\n", filename, info->name);
+		delete decoder;
+		free(data);
+		return 1;
+	}
+	const double loadTime = getBenchmarkWallTime() - start;
+
+	// Decode everything without ever showing a frame. Only the decoding is
+	// measured, bookkeeping allocations don't count.
+	Common::Array<double> frameTimes;
+	frameTimes.reserve(decoder->getFrameCount());
+	uint32 allocations = 0;
+
+	while (!decoder->endOfVideo()) {
+		getHeapStats(before);
+		start = getBenchmarkWallTime();
+		decoder->decodeNextFrame();
+		const double frameTime = getBenchmarkWallTime() - start;
+		getHeapStats(after);
+
+		allocations += after.allocations - before.allocations;
+		frameTimes.push_back(frameTime);
+	}
+
+	getHeapStats(after);
+	const Common::String base = Common::String::format("%s%s", info->name, noSIMD ? "/nosimd" : "");
+
+	if (frameTimes.empty()) {
+		fprintf(stderr, "video: '%s' has no frames\n", filename);
+	} else {
+		double total = 0.0;
+		for (uint i = 0; i < frameTimes.size(); ++i)
+			total += frameTimes[i];
+
+		Common::sort(frameTimes.begin(), frameTimes.end());
+
+		reportResult("video", (base + "/load").c_str(), loadTime * 1000.0, "ms");
+		reportResult("video", (base + "/frames").c_str(), frameTimes.size(), "frames");
+		reportResult("video", (base + "/fps").c_str(), frameTimes.size() / total, "frames/s");
+		reportResult("video", (base + "/frame-avg").c_str(), total * 1000.0 / frameTimes.size(), "ms");
+		reportResult("video", (base + "/frame-median").c_str(), frameTimes[frameTimes.size() / 2] * 1000.0, "ms");
+		reportResult("video", (base + "/frame-max").c_str(), frameTimes.back() * 1000.0, "ms");
+
+		if (haveHeapStats) {
+			reportResult("video", (base + "/allocs-per-frame").c_str(), (double)allocations / frameTimes.size(), "allocs");
+			reportResult("video", (base + "/peak-heap").c_str(), (after.peakBytes - baseline.currentBytes) / 1024.0, "KB");
+		}
+	}
+
+	delete decoder;
+	free(data);
+	Common::setDisabledCPUFeatures(0);
+	return 0;
+}
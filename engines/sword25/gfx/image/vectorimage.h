@@ -38,6 +38,7 @@
 
 #include "sword25/kernel/common.h"
 #include "sword25/gfx/image/image.h"
+#include "common/mutex.h"
 #include "common/rect.h"
 
 #include "art.h"
@@ -226,6 +227,10 @@ private:
 	Common::Rect                         _boundingBox;
 
 	byte *_pixelData;
+	/** Size _pixelData was rendered at, so that it is only rendered again when the size changes. */
+	int _pixelDataWidth, _pixelDataHeight;
+	/** Blits may come from several render threads at once, see RenderObjectManager. */
+	Common::Mutex _blitMutex;
 
 	Common::String _fname;
 };
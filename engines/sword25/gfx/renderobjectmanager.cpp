@@ -31,7 +31,9 @@
 
 #include "sword25/gfx/renderobjectmanager.h"
 
+#include "sword25/sword25.h"	// for kDebugRender
 #include "sword25/kernel/kernel.h"
+#include "sword25/kernel/resmanager.h"
 #include "sword25/kernel/inputpersistenceblock.h"
 #include "sword25/kernel/outputpersistenceblock.h"
 #include "sword25/gfx/graphicengine.h"
@@ -41,7 +43,10 @@
 #include "sword25/gfx/timedrenderobject.h"
 #include "sword25/gfx/rootrenderobject.h"
 
+#include "common/config-manager.h"
+#include "common/debug.h"
 #include "common/system.h"
+#include "common/threadpool.h"
 
 namespace Sword25 {
 
@@ -58,12 +63,18 @@ bool RenderObjectQueue::exists(const RenderObjectQueueItem &renderObjectQueueIte
 }
 
 RenderObjectManager::RenderObjectManager(int width, int height, int framebufferCount) :
-	_frameStarted(false) {
+	_frameStarted(false), _threadPool(0), _frameTimesCount(0) {
 	// Wurzel des BS_RenderObject-Baumes erzeugen.
 	_rootPtr = (new RootRenderObject(this, width, height))->getHandle();
 	_uta = new MicroTileArray(width, height);
 	_currQueue = new RenderObjectQueue();
 	_prevQueue = new RenderObjectQueue();
+
+	if (ConfMan.hasKey("render_threads") && ConfMan.getInt("render_threads") > 0)
+		_threadPool = new Common::ThreadPool(ConfMan.getInt("render_threads"));
+
+	memset(&_frameTimes, 0, sizeof(_frameTimes));
+	memset(&_frameTimesSum, 0, sizeof(_frameTimesSum));
 }
 
 RenderObjectManager::~RenderObjectManager() {
@@ -72,9 +83,12 @@ RenderObjectManager::~RenderObjectManager() {
 	delete _uta;
 	delete _currQueue;
 	delete _prevQueue;
+	delete _threadPool;
 }
 
 void RenderObjectManager::startFrame() {
+	const uint32 start = g_system->getMicros();
+
 	_frameStarted = true;
 
 	// Verstrichene Zeit bestimmen
@@ -84,9 +98,14 @@ void RenderObjectManager::startFrame() {
 	RenderObjectList::iterator iter = _timedRenderObjects.begin();
 	for (; iter != _timedRenderObjects.end(); ++iter)
 		(*iter)->frameNotification(timeElapsed);
+
+	_frameTimes.notify = g_system->getMicros() - start;
 }
 
 bool RenderObjectManager::render() {
+	uint32 start = g_system->getMicros();
+	uint32 end;
+
 	// Den Objekt-Status des Wurzelobjektes aktualisieren. Dadurch werden rekursiv alle Baumelemente aktualisiert.
 	// Beim aktualisieren des Objekt-Status werden auch die Update-Rects gefunden, so dass feststeht, was neu gezeichnet
 	// werden muss.
@@ -95,6 +114,10 @@ bool RenderObjectManager::render() {
 
 	_frameStarted = false;
 
+	end = g_system->getMicros();
+	_frameTimes.update = end - start;
+	start = end;
+
 	// Die Render-Methode der Wurzel aufrufen. Dadurch wird das rekursive Rendern der Baumelemente angestoen.
 
 	_currQueue->clear();
@@ -131,7 +154,21 @@ bool RenderObjectManager::render() {
 		updateRectsMinZ.push_back(minZ);
 	}
 
-	if (_rootPtr->render(updateRects, updateRectsMinZ)) {
+	end = g_system->getMicros();
+	_frameTimes.dirtyRects = end - start;
+	start = end;
+
+	bool result;
+	if (_threadPool && _threadPool->getThreadCount() > 0 && updateRects->size() > 1)
+		result = renderRegions(updateRects, updateRectsMinZ);
+	else
+		result = _rootPtr->render(updateRects, updateRectsMinZ);
+
+	end = g_system->getMicros();
+	_frameTimes.draw = end - start;
+	start = end;
+
+	if (result) {
 		// Copy updated rectangles to the video screen
 		Graphics::Surface *backSurface = Kernel::getInstance()->getGfx()->getSurface();
 		for (RectangleList::iterator rectIt = updateRects->begin(); rectIt != updateRects->end(); ++rectIt) {
@@ -147,9 +184,87 @@ bool RenderObjectManager::render() {
 
 	SWAP(_currQueue, _prevQueue);
 
+	_frameTimes.copy = g_system->getMicros() - start;
+	logFrameTimes();
+
 	return true;
 }
 
+bool RenderObjectManager::renderRegions(RectangleList *updateRects, const Common::Array<int> &updateRectsMinZ) {
+	// The update rectangles come from different micro tiles and therefore never
+	// overlap. Each object only draws into the rectangles it is given, so the
+	// regions can be drawn concurrently and the result is the same as when
+	// drawing all rectangles at once.
+	const uint regionCount = MIN<uint>(_threadPool->getThreadCount() + 1, updateRects->size());
+	_regions.resize(regionCount);
+
+	for (uint i = 0; i < regionCount; ++i) {
+		_regions[i]._manager = this;
+		_regions[i]._rects.clear();
+		_regions[i]._rectsMinZ.clear();
+	}
+
+	uint32 totalArea = 0;
+	for (RectangleList::iterator rectIt = updateRects->begin(); rectIt != updateRects->end(); ++rectIt)
+		totalArea += (*rectIt).width() * (*rectIt).height();
+
+	// Neighbouring rectangles are kept together, as they are likely to be
+	// covered by the same objects
+	uint32 area = 0;
+	int index = 0;
+	for (RectangleList::iterator rectIt = updateRects->begin(); rectIt != updateRects->end(); ++rectIt, ++index) {
+		RenderRegion &region = _regions[MIN<uint>((uint64)area * regionCount / totalArea, regionCount - 1)];
+		region._rects.push_back(*rectIt);
+		region._rectsMinZ.push_back(updateRectsMinZ[index]);
+		area += (*rectIt).width() * (*rectIt).height();
+	}
+
+	// Resources loaded while drawing must not push out the ones the other
+	// regions are drawing with
+	ResourceManager *resourceManager = Kernel::getInstance()->getResourceManager();
+	resourceManager->setDeferDeletion(true);
+
+	for (uint i = 0; i < regionCount; ++i) {
+		if (!_regions[i]._rects.empty())
+			_threadPool->addJob(renderRegion, &_regions[i]);
+	}
+	_threadPool->waitForJobs();
+
+	resourceManager->setDeferDeletion(false);
+
+	bool result = true;
+	for (uint i = 0; i < regionCount; ++i) {
+		if (!_regions[i]._rects.empty())
+			result &= _regions[i]._result;
+	}
+
+	return result;
+}
+
+void RenderObjectManager::renderRegion(void *param) {
+	RenderRegion *region = (RenderRegion *)param;
+	region->_result = region->_manager->_rootPtr->render(&region->_rects, region->_rectsMinZ);
+}
+
+void RenderObjectManager::logFrameTimes() {
+	_frameTimesSum.notify += _frameTimes.notify;
+	_frameTimesSum.update += _frameTimes.update;
+	_frameTimesSum.dirtyRects += _frameTimes.dirtyRects;
+	_frameTimesSum.draw += _frameTimes.draw;
+	_frameTimesSum.copy += _frameTimes.copy;
+
+	if (++_frameTimesCount < kFrameTimeSampleCount)
+		return;
+
+	debugC(1, kDebugRender, "Average frame times: notify %u us, update %u us, dirty rects %u us, draw %u us (%u threads), copy %u us",
+	       _frameTimesSum.notify / _frameTimesCount, _frameTimesSum.update / _frameTimesCount,
+	       _frameTimesSum.dirtyRects / _frameTimesCount, _frameTimesSum.draw / _frameTimesCount,
+	       _threadPool ? _threadPool->getThreadCount() + 1 : 1, _frameTimesSum.copy / _frameTimesCount);
+
+	memset(&_frameTimesSum, 0, sizeof(_frameTimesSum));
+	_frameTimesCount = 0;
+}
+
 void RenderObjectManager::attatchTimedRenderObject(RenderObjectPtr<TimedRenderObject> renderObjectPtr) {
 	_timedRenderObjects.push_back(renderObjectPtr);
 }
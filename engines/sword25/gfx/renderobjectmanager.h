@@ -49,6 +49,10 @@
 
 #include "sword25/gfx/microtiles.h"
 
+namespace Common {
+class ThreadPool;
+}
+
 namespace Sword25 {
 
 class Kernel;
@@ -123,10 +127,50 @@ public:
 	*/
 	void detatchTimedRenderObject(RenderObjectPtr<TimedRenderObject> pRenderObject);
 
+	/**
+	 * Time spent in each phase of a frame, in microseconds.
+	 */
+	struct FrameTimes {
+		uint32 notify;     ///< informing the timed render objects in startFrame()
+		uint32 update;     ///< updating the object states
+		uint32 dirtyRects; ///< finding the rectangles to redraw
+		uint32 draw;       ///< drawing the objects into the back buffer
+		uint32 copy;       ///< copying the redrawn rectangles to the screen
+	};
+
+	/**
+	 * Returns the phase times of the last frame rendered.
+	 */
+	const FrameTimes &getLastFrameTimes() const {
+		return _frameTimes;
+	}
+
 	virtual bool persist(OutputPersistenceBlock &writer);
 	virtual bool unpersist(InputPersistenceBlock &reader);
 
 private:
+	/** Number of frames the phase times logged on the render debug channel are averaged over */
+	enum { kFrameTimeSampleCount = 100 };
+
+	/**
+	 * Part of the update rectangles, drawn by one render job.
+	 */
+	struct RenderRegion {
+		RenderObjectManager *_manager;
+		RectangleList _rects;
+		Common::Array<int> _rectsMinZ;
+		bool _result;
+	};
+
+	/**
+	 * Draws the update rectangles by splitting them into regions of
+	 * about the same area, which are drawn in parallel.
+	 */
+	bool renderRegions(RectangleList *updateRects, const Common::Array<int> &updateRectsMinZ);
+	static void renderRegion(void *param);
+
+	void logFrameTimes();
+
 	bool _frameStarted;
 	typedef Common::Array<RenderObjectPtr<TimedRenderObject> > RenderObjectList;
 	RenderObjectList _timedRenderObjects;
@@ -134,6 +178,13 @@ private:
 	MicroTileArray *_uta;
 	RenderObjectQueue *_currQueue, *_prevQueue;
 
+	Common::ThreadPool *_threadPool;
+	Common::Array<RenderRegion> _regions;
+
+	FrameTimes _frameTimes;
+	FrameTimes _frameTimesSum;
+	uint _frameTimesCount;
+
 	// RenderObject-Tree Variablen
 	// ---------------------------
 	// Der Baum legt die hierachische Ordnung der BS_RenderObjects fest.
@@ -129,6 +129,14 @@ void ResourceManager::deleteResourcesIfNecessary() {
 	} while (iter != _resources.begin() && _resources.size() >= SWORD25_RESOURCECACHE_MIN);
 }
 
+void ResourceManager::setDeferDeletion(bool defer) {
+	Common::StackLock lock(_mutex);
+
+	_deferDeletion = defer;
+	if (!defer)
+		deleteResourcesIfNecessary();
+}
+
 /**
  * Releases all resources that are not locked.
  */
@@ -164,6 +172,8 @@ void ResourceManager::emptyThumbnailCache() {
  * @param FileName      Filename of resource
  */
 Resource *ResourceManager::requestResource(const Common::String &fileName) {
+	Common::StackLock lock(_mutex);
+
 	// Get the absolute path to the file
 	Common::String uniqueFileName = getUniqueFileName(fileName);
 	if (uniqueFileName.empty())
@@ -244,7 +254,8 @@ Resource *ResourceManager::loadResource(const Common::String &fileName) {
 	for (uint i = 0; i < _resourceServices.size(); ++i) {
 		if (_resourceServices[i]->canLoadResource(fileName)) {
 			// If more memory is desired, memory must be released
-			deleteResourcesIfNecessary();
+			if (!_deferDeletion)
+				deleteResourcesIfNecessary();
 
 			// Load the resource
 			Resource *pResource = _resourceServices[i]->loadResource(fileName);
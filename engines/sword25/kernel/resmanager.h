@@ -35,6 +35,7 @@
 #include "common/list.h"
 #include "common/hashmap.h"
 #include "common/hash-str.h"
+#include "common/mutex.h"
 
 #include "sword25/kernel/common.h"
 
@@ -88,13 +89,30 @@ public:
 	 */
 	void dumpLockedResources();
 
+	/**
+	 * Returns the mutex serializing requestResource() and Resource::release().
+	 * Both are called from the render threads, see RenderObjectManager.
+	 */
+	Common::Mutex &getMutex() {
+		return _mutex;
+	}
+
+	/**
+	 * Stops deleting resources to make room for new ones, or resumes it.
+	 * The render threads use resources without holding the mutex, so the
+	 * cache must not be trimmed while they are drawing. Resuming deletes
+	 * the resources which are not needed anymore right away.
+	 */
+	void setDeferDeletion(bool defer);
+
 private:
 	/**
 	 * Creates a new resource manager
 	 * Only the BS_Kernel class can generate copies this class. Thus, the constructor is private
 	 */
 	ResourceManager(Kernel *pKernel) :
-		_kernelPtr(pKernel)
+		_kernelPtr(pKernel),
+		_deferDeletion(false)
 	{}
 	virtual ~ResourceManager();
 
@@ -139,6 +157,8 @@ private:
 	Common::List<Resource *> _resources;
 	typedef Common::HashMap<Common::String, Resource *> ResMap;
 	ResMap _resourceHashMap;
+	Common::Mutex _mutex;
+	bool _deferDeletion;
 };
 
 } // End of namespace Sword25
@@ -45,6 +45,8 @@ Resource::Resource(const Common::String &fileName, RESOURCE_TYPES type) :
 }
 
 void Resource::release() {
+	Common::StackLock lock(Kernel::getInstance()->getResourceManager()->getMutex());
+
 	if (_refCount) {
 		--_refCount;
 	} else
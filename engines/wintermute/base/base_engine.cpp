@@ -31,7 +31,9 @@
 #include "engines/wintermute/base/base_engine.h"
 #include "engines/wintermute/wintermute.h"
 #include "engines/wintermute/system/sys_class_registry.h"
+#include "common/config-manager.h"
 #include "common/system.h"
+#include "common/threadpool.h"
 namespace Common {
 DECLARE_SINGLETON(Wintermute::BaseEngine);
 }
@@ -43,6 +45,7 @@ BaseEngine::BaseEngine() {
 	_gameRef = nullptr;
 	_classReg = nullptr;
 	_rnd = nullptr;
+	_threadPool = nullptr;
 	_gameId = "";
 	_language = Common::UNK_LANG;
 }
@@ -53,12 +56,16 @@ void BaseEngine::init() {
 	_rnd = new Common::RandomSource("Wintermute");
 	_classReg = new SystemClassRegistry();
 	_classReg->registerClasses();
+	if (ConfMan.hasKey("particle_threads") && ConfMan.getInt("particle_threads") > 0) {
+		_threadPool = new Common::ThreadPool(ConfMan.getInt("particle_threads"));
+	}
 }
 
 BaseEngine::~BaseEngine() {
 	delete _fileManager;
 	delete _rnd;
 	delete _classReg;
+	delete _threadPool;
 }
 
 void BaseEngine::createInstance(const Common::String &targetName, const Common::String &gameId, Common::Language lang) {
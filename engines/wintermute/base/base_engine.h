@@ -34,6 +34,10 @@
 #include "common/random.h"
 #include "common/language.h"
 
+namespace Common {
+class ThreadPool;
+}
+
 namespace Wintermute {
 
 class BaseFileManager;
@@ -53,6 +57,7 @@ class BaseEngine : public Common::Singleton<Wintermute::BaseEngine> {
 	Common::RandomSource *_rnd;
 	SystemClassRegistry *_classReg;
 	Common::Language _language;
+	Common::ThreadPool *_threadPool;
 public:
 	BaseEngine();
 	~BaseEngine();
@@ -65,6 +70,8 @@ public:
 	SystemClassRegistry *getClassRegistry() { return _classReg; }
 	BaseGame *getGameRef() { return _gameRef; }
 	BaseFileManager *getFileManager() { return _fileManager; }
+	/** Worker threads for the particle simulation, or nullptr if it runs serially. */
+	Common::ThreadPool *getThreadPool() { return _threadPool; }
 	BaseSoundMgr *getSoundMgr();
 	static BaseRenderer *getRenderer();
 	static const Timer *getTimer();
@@ -34,6 +34,7 @@
 #include "engines/wintermute/math/math_util.h"
 #include "engines/wintermute/base/base_game.h"
 #include "engines/wintermute/base/base_sprite.h"
+#include "engines/wintermute/wintermute.h"
 #include "common/system.h"
 #include "engines/wintermute/graphics/transparent_surface.h"
 #include "common/queue.h"
@@ -57,6 +58,9 @@ BaseRenderOSystem::BaseRenderOSystem(BaseGame *inGame) : BaseRenderer(inGame) {
 	_batchNum = 0;
 	_skipThisFrame = false;
 	_previousTicket = nullptr;
+	_ticketCount = 0;
+	_repeatingDraw = false;
+	_ticketHits = _ticketMisses = _redrawArea = 0;
 
 	_borderLeft = _borderRight = _borderTop = _borderBottom = 0;
 	_ratioX = _ratioY = 1.0f;
@@ -75,7 +79,7 @@ BaseRenderOSystem::~BaseRenderOSystem() {
 	while (it != _renderQueue.end()) {
 		RenderTicket *ticket = *it;
 		it = _renderQueue.erase(it);
-		delete ticket;
+		deleteTicket(ticket);
 	}
 
 	delete _dirtyRect;
@@ -84,7 +88,6 @@ BaseRenderOSystem::~BaseRenderOSystem() {
 	delete _renderSurface;
 	_blankSurface->free();
 	delete _blankSurface;
-	TransparentSurface::destroyLookup();
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -156,7 +159,7 @@ bool BaseRenderOSystem::indicatorFlip() {
 }
 
 bool BaseRenderOSystem::flip() {
-	if (_renderQueue.size() > DIRTY_RECT_LIMIT) {
+	if (_ticketCount > DIRTY_RECT_LIMIT) {
 		_tempDisableDirtyRects++;
 	}
 	if (_skipThisFrame) {
@@ -167,6 +170,8 @@ bool BaseRenderOSystem::flip() {
 		_needsFlip = false;
 		_drawNum = 1;
 		addDirtyRect(_renderRect);
+		_ticketHits = _ticketMisses = _redrawArea = 0;
+		_transformCache.resetStats();
 		return true;
 	}
 	if (!_tempDisableDirtyRects && !_disableDirtyRects) {
@@ -178,7 +183,7 @@ bool BaseRenderOSystem::flip() {
 			if ((*it)->_wantsDraw == false) {
 				RenderTicket *ticket = *it;
 				it = _renderQueue.erase(it);
-				delete ticket;
+				deleteTicket(ticket);
 			} else {
 				(*it)->_wantsDraw = false;
 				++it;
@@ -188,6 +193,7 @@ bool BaseRenderOSystem::flip() {
 	if (_needsFlip || _disableDirtyRects || _tempDisableDirtyRects) {
 		if (_disableDirtyRects || _tempDisableDirtyRects) {
 			g_system->copyRectToScreen((byte *)_renderSurface->getPixels(), _renderSurface->pitch, 0, 0, _renderSurface->w, _renderSurface->h);
+			_redrawArea = _renderSurface->w * _renderSurface->h;
 		}
 		//  g_system->copyRectToScreen((byte *)_renderSurface->getPixels(), _renderSurface->pitch, _dirtyRect->left, _dirtyRect->top, _dirtyRect->width(), _dirtyRect->height());
 		delete _dirtyRect;
@@ -213,6 +219,11 @@ bool BaseRenderOSystem::flip() {
 		}
 	}
 
+	debugC(kWintermuteDebugRender, "BaseRenderOSystem::flip - %d tickets, %d reused, %d created, %d pixels redrawn", _ticketCount, _ticketHits, _ticketMisses, _redrawArea);
+	debugC(kWintermuteDebugRender, "BaseRenderOSystem::flip - %d transformed sprites from the cache, %d resampled, %d bytes cached", _transformCache.getHits(), _transformCache.getMisses(), _transformCache.getMemoryUsage());
+	_ticketHits = _ticketMisses = _redrawArea = 0;
+	_transformCache.resetStats();
+
 	return STATUS_OK;
 }
 
@@ -287,8 +298,11 @@ Graphics::PixelFormat BaseRenderOSystem::getPixelFormat() const {
 void BaseRenderOSystem::drawSurface(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, TransformStruct &transform) { 
 
 	if (_tempDisableDirtyRects || _disableDirtyRects) {
-		RenderTicket *ticket = new RenderTicket(owner, surf, srcRect, dstRect, transform);
-		ticket->_transform._rgbaMod = _colorMod;
+		// Set the color-mod before the ticket gets indexed
+		TransformStruct modTransform = transform;
+		modTransform._rgbaMod = _colorMod;
+		RenderTicket *ticket = createTicket(owner, surf, srcRect, dstRect, modTransform);
+		_ticketMisses++;
 		ticket->_wantsDraw = true;
 		_renderQueue.push_back(ticket);
 		_previousTicket = ticket;
@@ -313,30 +327,24 @@ void BaseRenderOSystem::drawSurface(BaseSurfaceOSystem *owner, const Graphics::S
 		if (_spriteBatch) {
 			_batchNum++;
 		}
-		RenderQueueIterator it;
-		// Avoid calling end() and operator* every time, when potentially going through
-		// LOTS of tickets.
-		RenderQueueIterator endIterator = _renderQueue.end();
-		RenderTicket *compareTicket = nullptr;
-		for (it = _lastAddedTicket; it != endIterator; ++it) {
-			compareTicket = *it;
-			if (*(compareTicket) == compare && compareTicket->_isValid) {
-				compareTicket->_transform._rgbaMod = transform._rgbaMod; 
-				if (_disableDirtyRects) {
-					drawFromSurface(compareTicket);
-				} else {
-					drawFromTicket(compareTicket);
-					_previousTicket = compareTicket;
-				}
-				if (_renderQueue.size() > DIRTY_RECT_LIMIT) {
-					drawTickets();
-					_tempDisableDirtyRects = 3;
-				}
-				return;
+		RenderTicket *compareTicket = findTicket(compare);
+		if (compareTicket) {
+			_ticketHits++;
+			if (_disableDirtyRects) {
+				drawFromSurface(compareTicket);
+			} else {
+				drawFromTicket(compareTicket);
+				_previousTicket = compareTicket;
 			}
+			if (_ticketCount > DIRTY_RECT_LIMIT) {
+				drawTickets();
+				_tempDisableDirtyRects = 3;
+			}
+			return;
 		}
 	}
-	RenderTicket *ticket = new RenderTicket(owner, surf, srcRect, dstRect, transform);
+	RenderTicket *ticket = createTicket(owner, surf, srcRect, dstRect, transform);
+	_ticketMisses++;
 	if (!_disableDirtyRects) {
 		drawFromTicket(ticket);
 		_previousTicket = ticket;
@@ -373,6 +381,7 @@ void BaseRenderOSystem::repeatLastDraw(int offsetX, int offsetY, int numTimesX,
 
 		TransformStruct temp = TransformStruct(kDefaultZoomX, kDefaultZoomY, kDefaultAngle, kDefaultHotspotX, kDefaultHotspotY, BLEND_NORMAL, kDefaultRgbaMod, false, false, kDefaultOffsetX, kDefaultOffsetY);
 
+		_repeatingDraw = true;
 		for (int i = 0; i < numTimesY; i++) {
 			if (i == 0) {
 				dstRect.translate(offsetX, 0);
@@ -385,11 +394,61 @@ void BaseRenderOSystem::repeatLastDraw(int offsetX, int offsetY, int numTimesX,
 			dstRect.right = initRight;
 			dstRect.translate(0, offsetY);
 		}
+		_repeatingDraw = false;
 	} else {
 		error("Repeat-draw failed (did you forget to draw something before this?)");
 	}
 }
 
+RenderTicket *BaseRenderOSystem::createTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, TransformStruct &transform) {
+	// The surface of a ticket is already transformed, and changes without the owner being invalidated
+	TransformCache *transformCache = _repeatingDraw ? nullptr : &_transformCache;
+	RenderTicket *ticket = new (_ticketPool) RenderTicket(owner, surf, srcRect, dstRect, transform, &_ticketSurfacePool, transformCache);
+	_ticketIndex[ticket->getHash()].push_back(ticket);
+	_ticketCount++;
+	return ticket;
+}
+
+void BaseRenderOSystem::deleteTicket(RenderTicket *ticket) {
+	TicketIndex::iterator bucket = _ticketIndex.find(ticket->getHash());
+	assert(bucket != _ticketIndex.end());
+	Common::Array<RenderTicket *> &tickets = bucket->_value;
+	for (uint i = 0; i < tickets.size(); i++) {
+		if (tickets[i] == ticket) {
+			tickets.remove_at(i);
+			break;
+		}
+	}
+	if (tickets.empty()) {
+		_ticketIndex.erase(bucket);
+	}
+	_ticketCount--;
+	_ticketPool.deleteChunk(ticket);
+}
+
+RenderTicket *BaseRenderOSystem::findTicket(const RenderTicket &compare) const {
+	if (_lastAddedTicket == _renderQueue.end()) {
+		return nullptr;
+	}
+	TicketIndex::const_iterator bucket = _ticketIndex.find(compare.getHash());
+	if (bucket == _ticketIndex.end()) {
+		return nullptr;
+	}
+	// The render queue is always ordered by drawNum, so instead of walking the queue
+	// from _lastAddedTicket, look for the lowest drawNum that isn't before it.
+	const uint32 startNum = (*_lastAddedTicket)->_drawNum;
+	const Common::Array<RenderTicket *> &tickets = bucket->_value;
+	RenderTicket *found = nullptr;
+	for (uint i = 0; i < tickets.size(); i++) {
+		RenderTicket *ticket = tickets[i];
+		if (ticket->_drawNum >= startNum && (!found || ticket->_drawNum < found->_drawNum) &&
+		        ticket->_isValid && *ticket == compare) {
+			found = ticket;
+		}
+	}
+	return found;
+}
+
 void BaseRenderOSystem::invalidateTicket(RenderTicket *renderTicket) {
 	addDirtyRect(renderTicket->_dstRect);
 	renderTicket->_isValid = false;
@@ -403,6 +462,7 @@ void BaseRenderOSystem::invalidateTicketsFromSurface(BaseSurfaceOSystem *surf) {
 			invalidateTicket(*it);
 		}
 	}
+	_transformCache.invalidate(surf);
 }
 
 void BaseRenderOSystem::drawFromTicket(RenderTicket *renderTicket) {
@@ -484,7 +544,7 @@ void BaseRenderOSystem::drawTickets() {
 			RenderTicket *ticket = *it;
 			addDirtyRect((*it)->_dstRect);
 			it = _renderQueue.erase(it);
-			delete ticket;
+			deleteTicket(ticket);
 			decrement++;
 		} else {
 			(*it)->_drawNum -= decrement;
@@ -506,6 +566,7 @@ void BaseRenderOSystem::drawTickets() {
 
 	// Apply the clear-color to the dirty rect.
 	_renderSurface->fillRect(*_dirtyRect, _clearColor);
+	_redrawArea += _dirtyRect->width() * _dirtyRect->height();
 	_drawNum = 1;
 	for (it = _renderQueue.begin(); it != _renderQueue.end(); ++it) {
 		RenderTicket *ticket = *it;
@@ -543,7 +604,7 @@ void BaseRenderOSystem::drawTickets() {
 			RenderTicket *ticket = *it;
 			addDirtyRect((*it)->_dstRect);
 			it = _renderQueue.erase(it);
-			delete ticket;
+			deleteTicket(ticket);
 			decrement++;
 		} else {
 			(*it)->_drawNum -= decrement;
@@ -672,8 +733,10 @@ void BaseRenderOSystem::endSaveLoad() {
 	while (it != _renderQueue.end()) {
 		RenderTicket *ticket = *it;
 		it = _renderQueue.erase(it);
-		delete ticket;
+		deleteTicket(ticket);
 	}
+	_ticketSurfacePool.clear();
+	_transformCache.clear();
 	_lastAddedTicket = _renderQueue.begin();
 	_previousTicket = nullptr;
 	// HACK: After a save the buffer will be drawn before the scripts get to update it,
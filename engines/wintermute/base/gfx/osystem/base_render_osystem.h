@@ -32,12 +32,16 @@
 #include "engines/wintermute/base/gfx/base_renderer.h"
 #include "common/rect.h"
 #include "graphics/surface.h"
+#include "graphics/surface_pool.h"
 #include "common/list.h"
+#include "common/hashmap.h"
+#include "common/memorypool.h"
 #include "engines/wintermute/graphics/transform_struct.h"
+#include "engines/wintermute/base/gfx/osystem/render_ticket.h"
+#include "engines/wintermute/base/gfx/osystem/transform_cache.h"
 
 namespace Wintermute {
 class BaseSurfaceOSystem;
-class RenderTicket;
 /**
  * A 2D-renderer implementation for WME.
  * This renderer makes use of a "ticket"-system, where all draw-calls
@@ -120,11 +124,38 @@ private:
 	void drawFromSurface(RenderTicket *ticket);
 	// Dirty-rects:
 	void drawFromSurface(RenderTicket *ticket, Common::Rect *dstRect, Common::Rect *clipRect);
+	/**
+	 * Allocate a ticket from the pool, and add it to the ticket index.
+	 */
+	RenderTicket *createTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, TransformStruct &transform);
+	/**
+	 * Remove a ticket from the ticket index, and hand it back to the pool.
+	 * The caller is responsible for removing it from the render queue.
+	 */
+	void deleteTicket(RenderTicket *ticket);
+	/**
+	 * Find the first valid ticket equal to compare, at or after _lastAddedTicket
+	 * in the render queue.
+	 * @return the ticket, or nullptr if there is none
+	 */
+	RenderTicket *findTicket(const RenderTicket &compare) const;
 	typedef Common::List<RenderTicket *>::iterator RenderQueueIterator;
+	typedef Common::HashMap<uint32, Common::Array<RenderTicket *> > TicketIndex;
 	Common::Rect *_dirtyRect;
 	Common::List<RenderTicket *> _renderQueue;
 	RenderQueueIterator _lastAddedTicket;
 	RenderTicket *_previousTicket;
+	TicketIndex _ticketIndex; ///< All tickets in the render queue, by their hash
+	uint32 _ticketCount; ///< The size of the render queue, without walking the list
+	Common::ObjectPool<RenderTicket> _ticketPool;
+	Graphics::SurfacePool _ticketSurfacePool; ///< Holds the copies of the surface data made by tickets
+	TransformCache _transformCache; ///< Scaled and rotated sprites, shared by the tickets
+	bool _repeatingDraw; ///< Set while repeatLastDraw() draws from the surface of a ticket
+
+	// Statistics of the current frame, see the "render" debug channel
+	uint32 _ticketHits;
+	uint32 _ticketMisses;
+	uint32 _redrawArea;
 
 	bool _needsFlip;
 	uint32 _drawNum; ///< The global number of the current draw-operation.
@@ -28,42 +28,68 @@
 
 
 #include "engines/wintermute/base/gfx/osystem/render_ticket.h"
+#include "engines/wintermute/base/gfx/osystem/transform_cache.h"
 #include "engines/wintermute/graphics/transform_tools.h"
+#include "graphics/surface_pool.h"
 #include "common/textconsole.h"
 
 namespace Wintermute {
 
-RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, TransformStruct transform) :
+RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, TransformStruct transform, Graphics::SurfacePool *surfacePool, TransformCache *transformCache) :
 	_owner(owner),
+	_surfacePool(surfacePool),
 	_srcRect(*srcRect),
 	_dstRect(*dstRect),
 	_drawNum(0),
 	_isValid(true),
 	_wantsDraw(true),
-	_transform(transform) {
+	_transform(transform),
+	_alphaMode(TransparentSurface::ALPHA_FULL) {
 	_batchNum = 0;
 	if (surf) {
-		_surface = new Graphics::Surface();
-		_surface->create((uint16)srcRect->width(), (uint16)srcRect->height(), surf->format);
+		const bool rotate = _transform._angle != kDefaultAngle;
+		const bool scale = !rotate && (dstRect->width() != srcRect->width() || dstRect->height() != srcRect->height());
+		// Owner-less tickets can't be invalidated, so they aren't cached
+		if (!owner) {
+			transformCache = nullptr;
+		}
+
+		const Graphics::Surface *cached = nullptr;
+		if (transformCache && (rotate || scale)) {
+			cached = transformCache->find(owner, *srcRect, *dstRect, transform, _alphaMode);
+		}
+		if (cached) {
+			// Copying is far cheaper than resampling the sprite again
+			_surface = acquireSurface(cached->w, cached->h, cached->format);
+			for (int i = 0; i < _surface->h; i++) {
+				memcpy(_surface->getBasePtr(0, i), cached->getBasePtr(0, i), _surface->w * _surface->format.bytesPerPixel);
+			}
+			return;
+		}
+
+		_surface = acquireSurface((uint16)srcRect->width(), (uint16)srcRect->height(), surf->format);
 		assert(_surface->format.bytesPerPixel == 4);
 		// Get a clipped copy of the surface
 		for (int i = 0; i < _surface->h; i++) {
 			memcpy(_surface->getBasePtr(0, i), surf->getBasePtr(srcRect->left, srcRect->top + i), srcRect->width() * _surface->format.bytesPerPixel);
 		}
 		// Then scale it if necessary
-		if (_transform._angle != kDefaultAngle) {
+		if (rotate) {
 			TransparentSurface src(*_surface, false);
 			Graphics::Surface *temp = src.rotoscale(transform);
-			_surface->free();
-			delete _surface;
+			freeSurface();
 			_surface = temp;
-		} else if (dstRect->width() != srcRect->width() || dstRect->height() != srcRect->height()) { 
+		} else if (scale) {
 			TransparentSurface src(*_surface, false);
 			Graphics::Surface *temp = src.scale(dstRect->width(), dstRect->height());
-			_surface->free();
-			delete _surface;
+			freeSurface();
 			_surface = temp;
 		}
+		// Find out once how the ticket has to be blended, not every time it's drawn
+		_alphaMode = TransparentSurface(*_surface, false).detectAlphaMode();
+		if (transformCache && (rotate || scale)) {
+			transformCache->insert(owner, *srcRect, *dstRect, transform, *_surface, _alphaMode);
+		}
 	} else {
 		_surface = nullptr;
 		
@@ -78,10 +104,29 @@ RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *s
 }
 
 RenderTicket::~RenderTicket() {
-	if (_surface) {
+	freeSurface();
+}
+
+Graphics::Surface *RenderTicket::acquireSurface(uint16 width, uint16 height, const Graphics::PixelFormat &format) const {
+	if (_surfacePool) {
+		return _surfacePool->acquire(width, height, format);
+	}
+	Graphics::Surface *surface = new Graphics::Surface();
+	surface->create(width, height, format);
+	return surface;
+}
+
+void RenderTicket::freeSurface() {
+	if (!_surface) {
+		return;
+	}
+	if (_surfacePool) {
+		_surfacePool->release(_surface);
+	} else {
 		_surface->free();
 		delete _surface;
 	}
+	_surface = nullptr;
 }
 
 bool RenderTicket::operator==(const RenderTicket &t) const {
@@ -96,6 +141,21 @@ bool RenderTicket::operator==(const RenderTicket &t) const {
 	return true;
 }
 
+uint32 RenderTicket::getHash() const {
+	uint32 hash = (uint32)(size_t)_owner;
+	hash = hash * 31 + _batchNum;
+	hash = hash * 31 + ((_dstRect.left & 0xFFFF) | (_dstRect.top << 16));
+	hash = hash * 31 + ((_dstRect.right & 0xFFFF) | (_dstRect.bottom << 16));
+	hash = hash * 31 + ((_srcRect.left & 0xFFFF) | (_srcRect.top << 16));
+	hash = hash * 31 + ((_srcRect.right & 0xFFFF) | (_srcRect.bottom << 16));
+	hash = hash * 31 + _transform._angle;
+	hash = hash * 31 + (_transform._zoom.x ^ (_transform._zoom.y << 16));
+	hash = hash * 31 + (_transform._offset.x ^ (_transform._offset.y << 16));
+	hash = hash * 31 + (_transform._flip | (_transform._alphaDisable << 8) | (_transform._blendMode << 9));
+	hash = hash * 31 + _transform._rgbaMod;
+	return hash;
+}
+
 // Replacement for SDL2's SDL_RenderCopy
 void RenderTicket::drawToSurface(Graphics::Surface *_targetSurface) const {
 	TransparentSurface src(*getSurface(), false);
@@ -105,7 +165,8 @@ void RenderTicket::drawToSurface(Graphics::Surface *_targetSurface) const {
 	clipRect.setHeight(getSurface()->h);
 
 	src._enableAlphaBlit = !_transform._alphaDisable;
-	src.blit(*_targetSurface, _dstRect.left, _dstRect.top, _transform._flip, &clipRect, _transform._rgbaMod, clipRect.width(), clipRect.height());
+	src._alphaMode = _alphaMode;
+	src.blit(*_targetSurface, _dstRect.left, _dstRect.top, _transform._flip, &clipRect, _transform._rgbaMod, clipRect.width(), clipRect.height(), _transform._blendMode);
 }
 
 void RenderTicket::drawToSurface(Graphics::Surface *_targetSurface, Common::Rect *dstRect, Common::Rect *clipRect) const {
@@ -119,7 +180,8 @@ void RenderTicket::drawToSurface(Graphics::Surface *_targetSurface, Common::Rect
 	}
 
 	src._enableAlphaBlit = !_transform._alphaDisable; 
-	src.blit(*_targetSurface, dstRect->left, dstRect->top, _transform._flip, clipRect, _transform._rgbaMod, clipRect->width(), clipRect->height());
+	src._alphaMode = _alphaMode;
+	src.blit(*_targetSurface, dstRect->left, dstRect->top, _transform._flip, clipRect, _transform._rgbaMod, clipRect->width(), clipRect->height(), _transform._blendMode);
 	if (doDelete) {
 		delete clipRect;
 	}
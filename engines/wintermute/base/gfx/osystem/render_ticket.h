@@ -33,9 +33,14 @@
 #include "graphics/surface.h"
 #include "common/rect.h"
 
+namespace Graphics {
+class SurfacePool;
+}
+
 namespace Wintermute {
 
 class BaseSurfaceOSystem;
+class TransformCache;
 /**
  * A single RenderTicket.
  * A render ticket is a collection of the data and draw specifications made
@@ -51,8 +56,14 @@ class BaseSurfaceOSystem;
  */
 class RenderTicket {
 public:
-	RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRest, TransformStruct transform); 
-	RenderTicket() : _isValid(true), _wantsDraw(false), _drawNum(0), _transform(TransformStruct()) {}
+	/**
+	 * Create a ticket, copying the needed part of surf. If surfacePool is given,
+	 * the copy is taken from it, and handed back to it once the ticket is destroyed.
+	 * If transformCache is given, scaled and rotated copies are looked up there
+	 * first, and added to it otherwise.
+	 */
+	RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRest, TransformStruct transform, Graphics::SurfacePool *surfacePool = nullptr, TransformCache *transformCache = nullptr);
+	RenderTicket() : _isValid(true), _wantsDraw(false), _drawNum(0), _transform(TransformStruct()), _surface(nullptr), _surfacePool(nullptr), _alphaMode(TransparentSurface::ALPHA_FULL) {}
 	~RenderTicket();
 	const Graphics::Surface *getSurface() const { return _surface; }
 	// Non-dirty-rects:
@@ -71,9 +82,19 @@ public:
 	
 	BaseSurfaceOSystem *_owner;
 	bool operator==(const RenderTicket &a) const;
+	/**
+	 * Hash over everything operator== compares, equal tickets
+	 * always have the same hash.
+	 */
+	uint32 getHash() const;
 	const Common::Rect *getSrcRect() const { return &_srcRect; }
 private:
+	Graphics::Surface *acquireSurface(uint16 width, uint16 height, const Graphics::PixelFormat &format) const;
+	void freeSurface();
+
 	Graphics::Surface *_surface;
+	Graphics::SurfacePool *_surfacePool;
+	TransparentSurface::AlphaType _alphaMode;
 	Common::Rect _srcRect;
 };
 
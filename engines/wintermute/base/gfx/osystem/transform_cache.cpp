@@ -0,0 +1,137 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "engines/wintermute/base/gfx/osystem/transform_cache.h"
+
+namespace Wintermute {
+
+TransformCache::Key::Key(const BaseSurfaceOSystem *owner, const Common::Rect &srcRect, const Common::Rect &dstRect, const TransformStruct &transform) :
+	_owner(owner), _srcRect(srcRect), _width(0), _height(0), _angle(kDefaultAngle) {
+	// Only keep what the result depends on, so that e.g. the same scaled
+	// sprite with different color modulation is shared.
+	if (transform._angle != kDefaultAngle) {
+		_angle = transform._angle;
+		_zoom = transform._zoom;
+		_hotspot = transform._hotspot;
+	} else {
+		_width = dstRect.width();
+		_height = dstRect.height();
+	}
+}
+
+bool TransformCache::Key::operator==(const Key &key) const {
+	return _owner == key._owner &&
+	       _srcRect == key._srcRect &&
+	       _width == key._width &&
+	       _height == key._height &&
+	       _angle == key._angle &&
+	       _zoom == key._zoom &&
+	       _hotspot == key._hotspot;
+}
+
+uint TransformCache::KeyHash::operator()(const Key &key) const {
+	uint hash = (uint)(size_t)key._owner;
+	hash = hash * 31 + ((key._srcRect.left & 0xFFFF) | (key._srcRect.top << 16));
+	hash = hash * 31 + ((key._srcRect.right & 0xFFFF) | (key._srcRect.bottom << 16));
+	hash = hash * 31 + ((key._width & 0xFFFF) | (key._height << 16));
+	hash = hash * 31 + key._angle;
+	hash = hash * 31 + (key._zoom.x ^ (key._zoom.y << 16));
+	hash = hash * 31 + (key._hotspot.x ^ (key._hotspot.y << 16));
+	return hash;
+}
+
+TransformCache::TransformCache(uint32 budget) : _budget(budget), _memoryUsage(0), _hits(0), _misses(0) {
+}
+
+TransformCache::~TransformCache() {
+	clear();
+}
+
+const Graphics::Surface *TransformCache::find(const BaseSurfaceOSystem *owner, const Common::Rect &srcRect, const Common::Rect &dstRect, const TransformStruct &transform, TransparentSurface::AlphaType &alphaMode) {
+	EntryMap::iterator found = _map.find(Key(owner, srcRect, dstRect, transform));
+	if (found == _map.end()) {
+		_misses++;
+		return nullptr;
+	}
+	_hits++;
+
+	// Move the entry to the front, so that it is dropped last
+	EntryList::iterator entry = found->_value;
+	if (entry != _entries.begin()) {
+		_entries.push_front(*entry);
+		_entries.erase(entry);
+		found->_value = _entries.begin();
+	}
+	alphaMode = _entries.front()._alphaMode;
+	return &_entries.front()._sprite;
+}
+
+void TransformCache::insert(const BaseSurfaceOSystem *owner, const Common::Rect &srcRect, const Common::Rect &dstRect, const TransformStruct &transform, const Graphics::Surface &sprite, TransparentSurface::AlphaType alphaMode) {
+	const uint32 size = sprite.w * sprite.h * sprite.format.bytesPerPixel;
+	if (size > _budget) {
+		return;
+	}
+
+	const Key key(owner, srcRect, dstRect, transform);
+	EntryMap::iterator found = _map.find(key);
+	if (found != _map.end()) {
+		erase(found->_value);
+	}
+
+	while (_memoryUsage + size > _budget) {
+		erase(--_entries.end());
+	}
+
+	_entries.push_front(Entry(key));
+	Entry &entry = _entries.front();
+	entry._sprite.copyFrom(sprite);
+	entry._alphaMode = alphaMode;
+	_map[key] = _entries.begin();
+	_memoryUsage += size;
+}
+
+void TransformCache::invalidate(const BaseSurfaceOSystem *owner) {
+	EntryList::iterator entry = _entries.begin();
+	while (entry != _entries.end()) {
+		EntryList::iterator next = entry;
+		++next;
+		if (entry->_key._owner == owner) {
+			erase(entry);
+		}
+		entry = next;
+	}
+}
+
+void TransformCache::clear() {
+	while (!_entries.empty()) {
+		erase(_entries.begin());
+	}
+}
+
+void TransformCache::erase(EntryList::iterator entry) {
+	_memoryUsage -= entry->_sprite.pitch * entry->_sprite.h;
+	_map.erase(entry->_key);
+	entry->_sprite.free();
+	_entries.erase(entry);
+}
+
+} // End of namespace Wintermute
@@ -0,0 +1,123 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef WINTERMUTE_TRANSFORM_CACHE_H
+#define WINTERMUTE_TRANSFORM_CACHE_H
+
+#include "engines/wintermute/graphics/transform_struct.h"
+#include "engines/wintermute/graphics/transparent_surface.h"
+#include "graphics/surface.h"
+#include "common/hashmap.h"
+#include "common/list.h"
+#include "common/rect.h"
+
+namespace Wintermute {
+
+class BaseSurfaceOSystem;
+
+/**
+ * Least recently used cache of scaled and rotated sprites.
+ *
+ * Actors are scaled by the depth of the scene, so they keep the same zoom
+ * while they walk around, but every step makes a new render ticket. The
+ * tickets look up the transformed sprite here before resampling it again.
+ * Once the cached sprites take more memory than the budget, the ones used
+ * least recently are dropped.
+ */
+class TransformCache {
+public:
+	enum {
+		kDefaultBudget = 16 * 1024 * 1024 ///< Default memory budget, in bytes
+	};
+
+	TransformCache(uint32 budget = kDefaultBudget);
+	~TransformCache();
+
+	/**
+	 * Find the sprite made by transforming srcRect of the surface of owner
+	 * with transform, or scaling it to the size of dstRect if there is no
+	 * rotation. Returns nullptr if it isn't cached.
+	 */
+	const Graphics::Surface *find(const BaseSurfaceOSystem *owner, const Common::Rect &srcRect, const Common::Rect &dstRect, const TransformStruct &transform, TransparentSurface::AlphaType &alphaMode);
+
+	/**
+	 * Add a copy of a transformed sprite, with the same arguments as find().
+	 * Sprites larger than the whole budget are not cached.
+	 */
+	void insert(const BaseSurfaceOSystem *owner, const Common::Rect &srcRect, const Common::Rect &dstRect, const TransformStruct &transform, const Graphics::Surface &sprite, TransparentSurface::AlphaType alphaMode);
+
+	/** Drop all sprites made from owner, since its surface changed. */
+	void invalidate(const BaseSurfaceOSystem *owner);
+
+	/** Drop all sprites. */
+	void clear();
+
+	uint32 getMemoryUsage() const { return _memoryUsage; }
+
+	// Statistics since the last call of resetStats(), see the "render" debug channel
+	uint32 getHits() const { return _hits; }
+	uint32 getMisses() const { return _misses; }
+	void resetStats() { _hits = _misses = 0; }
+
+private:
+	/** What the transformed sprite depends on. */
+	struct Key {
+		const BaseSurfaceOSystem *_owner;
+		Common::Rect _srcRect;
+		int16 _width;
+		int16 _height;
+		uint32 _angle;
+		Point32 _zoom;
+		Point32 _hotspot;
+
+		Key(const BaseSurfaceOSystem *owner, const Common::Rect &srcRect, const Common::Rect &dstRect, const TransformStruct &transform);
+		bool operator==(const Key &key) const;
+	};
+
+	struct KeyHash {
+		uint operator()(const Key &key) const;
+	};
+
+	struct Entry {
+		Key _key;
+		Graphics::Surface _sprite;
+		TransparentSurface::AlphaType _alphaMode;
+
+		Entry(const Key &key) : _key(key), _alphaMode(TransparentSurface::ALPHA_FULL) {}
+	};
+
+	typedef Common::List<Entry> EntryList;
+	typedef Common::HashMap<Key, EntryList::iterator, KeyHash> EntryMap;
+
+	void erase(EntryList::iterator entry);
+
+	EntryList _entries; ///< Most recently used first
+	EntryMap _map;
+	uint32 _budget;
+	uint32 _memoryUsage;
+	uint32 _hits;
+	uint32 _misses;
+};
+
+} // End of namespace Wintermute
+
+#endif
@@ -41,13 +41,14 @@
 #include "engines/wintermute/platform_osystem.h"
 #include "common/str.h"
 #include "common/math.h"
+#include "common/threadpool.h"
 
 namespace Wintermute {
 
 IMPLEMENT_PERSISTENT(PartEmitter, false)
 
 //////////////////////////////////////////////////////////////////////////
-PartEmitter::PartEmitter(BaseGame *inGame, BaseScriptHolder *owner) : BaseObject(inGame) {
+PartEmitter::PartEmitter(BaseGame *inGame, BaseScriptHolder *owner) : BaseObject(inGame), _particles(inGame) {
 	_width = _height = 0;
 
 	BasePlatform::setRectEmpty(&_border);
@@ -96,9 +97,6 @@ PartEmitter::PartEmitter(BaseGame *inGame, BaseScriptHolder *owner) : BaseObject
 
 //////////////////////////////////////////////////////////////////////////
 PartEmitter::~PartEmitter(void) {
-	for (uint32 i = 0; i < _particles.size(); i++) {
-		delete _particles[i];
-	}
 	_particles.clear();
 
 	for (uint32 i = 0; i < _forces.size(); i++) {
@@ -158,10 +156,7 @@ bool PartEmitter::removeSprite(const char *filename) {
 }
 
 //////////////////////////////////////////////////////////////////////////
-bool PartEmitter::initParticle(PartParticle *particle, uint32 currentTime, uint32 timerDelta) {
-	if (!particle) {
-		return STATUS_FAILED;
-	}
+bool PartEmitter::initParticle(uint32 index, uint32 currentTime, uint32 timerDelta) {
 	if (_sprites.size() == 0) {
 		return STATUS_FAILED;
 	}
@@ -204,11 +199,12 @@ bool PartEmitter::initParticle(PartParticle *particle, uint32 currentTime, uint3
 		int thicknessTop    = (int)(_borderThicknessTop    - (float)_borderThicknessTop    * posZ / 100.0f);
 		int thicknessBottom = (int)(_borderThicknessBottom - (float)_borderThicknessBottom * posZ / 100.0f);
 
-		particle->_border = _border;
-		particle->_border.left += thicknessLeft;
-		particle->_border.right -= thicknessRight;
-		particle->_border.top += thicknessTop;
-		particle->_border.bottom -= thicknessBottom;
+		Rect32 &border = _particles._border[index];
+		border = _border;
+		border.left += thicknessLeft;
+		border.right -= thicknessRight;
+		border.top += thicknessTop;
+		border.bottom -= thicknessBottom;
 	}
 
 	Vector2 vecPos((float)posX, (float)posY);
@@ -219,29 +215,31 @@ bool PartEmitter::initParticle(PartParticle *particle, uint32 currentTime, uint3
 	matRot.transformVector2(vecVel);
 
 	if (_alphaTimeBased) {
-		particle->_alpha1 = _alpha1;
-		particle->_alpha2 = _alpha2;
+		_particles._alpha1[index] = _alpha1;
+		_particles._alpha2[index] = _alpha2;
 	} else {
 		int alpha = BaseUtils::randomInt(_alpha1, _alpha2);
-		particle->_alpha1 = alpha;
-		particle->_alpha2 = alpha;
-	}
-
-	particle->_creationTime = currentTime;
-	particle->_pos = vecPos;
-	particle->_posZ = posZ;
-	particle->_velocity = vecVel;
-	particle->_scale = scale;
-	particle->_lifeTime = lifeTime;
-	particle->_rotation = rotation;
-	particle->_angVelocity = angVelocity;
-	particle->_growthRate = growthRate;
-	particle->_exponentialGrowth = _exponentialGrowth;
-	particle->_isDead = DID_FAIL(particle->setSprite(_sprites[spriteIndex]));
-	particle->fadeIn(currentTime, _fadeInTime);
-
-
-	if (particle->_isDead) {
+		_particles._alpha1[index] = alpha;
+		_particles._alpha2[index] = alpha;
+	}
+
+	_particles._creationTime[index] = currentTime;
+	_particles._posX[index] = vecPos.x;
+	_particles._posY[index] = vecPos.y;
+	_particles._posZ[index] = posZ;
+	_particles._velocityX[index] = vecVel.x;
+	_particles._velocityY[index] = vecVel.y;
+	_particles._scale[index] = scale;
+	_particles._lifeTime[index] = lifeTime;
+	_particles._rotation[index] = rotation;
+	_particles._angVelocity[index] = angVelocity;
+	_particles._growthRate[index] = growthRate;
+	_particles._exponentialGrowth[index] = _exponentialGrowth;
+	_particles._isDead[index] = DID_FAIL(_particles.setSprite(index, _sprites[spriteIndex]));
+	_particles.fadeIn(index, currentTime, _fadeInTime);
+
+
+	if (_particles._isDead[index]) {
 		return STATUS_FAILED;
 	} else {
 		return STATUS_OK;
@@ -259,15 +257,8 @@ bool PartEmitter::update() {
 
 //////////////////////////////////////////////////////////////////////////
 bool PartEmitter::updateInternal(uint32 currentTime, uint32 timerDelta) {
-	int numLive = 0;
-
-	for (uint32 i = 0; i < _particles.size(); i++) {
-		_particles[i]->update(this, currentTime, timerDelta);
-
-		if (!_particles[i]->_isDead) {
-			numLive++;
-		}
-	}
+	updateParticles(currentTime, timerDelta);
+	int numLive = _particles.countLive();
 
 
 	// we're understaffed
@@ -282,23 +273,25 @@ bool PartEmitter::updateInternal(uint32 currentTime, uint32 timerDelta) {
 			}
 
 			int toGen = MIN(_genAmount, _maxParticles - numLive);
+			// The particles before the last one reused are all alive
+			uint32 searchStart = 0;
 			while (toGen > 0) {
 				int firstDeadIndex = -1;
-				for (uint32 i = 0; i < _particles.size(); i++) {
-					if (_particles[i]->_isDead) {
+				for (uint32 i = searchStart; i < _particles.size(); i++) {
+					if (_particles._isDead[i]) {
 						firstDeadIndex = i;
 						break;
 					}
 				}
 
-				PartParticle *particle;
+				uint32 index;
 				if (firstDeadIndex >= 0) {
-					particle = _particles[firstDeadIndex];
+					index = firstDeadIndex;
 				} else {
-					particle = new PartParticle(_gameRef);
-					_particles.add(particle);
+					index = _particles.add();
 				}
-				initParticle(particle, currentTime, timerDelta);
+				initParticle(index, currentTime, timerDelta);
+				searchStart = index;
 				needsSort = true;
 
 				toGen--;
@@ -326,13 +319,16 @@ bool PartEmitter::display(BaseRegion *region) {
 	}
 
 	for (uint32 i = 0; i < _particles.size(); i++) {
+		if (_particles._isDead[i]) {
+			continue;
+		}
 		if (region != nullptr && _useRegion) {
-			if (!region->pointInRegion((int)_particles[i]->_pos.x, (int)_particles[i]->_pos.y)) {
+			if (!region->pointInRegion((int)_particles._posX[i], (int)_particles._posY[i])) {
 				continue;
 			}
 		}
 
-		_particles[i]->display(this);
+		_particles.display(i, this);
 	}
 
 	if (_sprites.size() <= 1) {
@@ -342,10 +338,41 @@ bool PartEmitter::display(BaseRegion *region) {
 	return STATUS_OK;
 }
 
+//////////////////////////////////////////////////////////////////////////
+void PartEmitter::updateParticles(uint32 currentTime, uint32 timerDelta) {
+	Common::ThreadPool *pool = BaseEngine::instance().getThreadPool();
+	const uint32 numParticles = _particles.size();
+	if (!pool || numParticles < 2 * kParticleChunkSize) {
+		_particles.update(this, 0, numParticles, currentTime, timerDelta);
+		return;
+	}
+
+	// Each job updates a range of particles of its own, and only reads the
+	// emitter, so the result is the same as when updating them serially.
+	const uint32 numChunks = (numParticles + kParticleChunkSize - 1) / kParticleChunkSize;
+	_updateChunks.resize(numChunks);
+	for (uint32 i = 0; i < numChunks; i++) {
+		UpdateChunk &chunk = _updateChunks[i];
+		chunk._emitter = this;
+		chunk._first = i * kParticleChunkSize;
+		chunk._last = MIN<uint32>(chunk._first + kParticleChunkSize, numParticles);
+		chunk._currentTime = currentTime;
+		chunk._timerDelta = timerDelta;
+		pool->addJob(updateChunk, &chunk);
+	}
+	pool->waitForJobs();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void PartEmitter::updateChunk(void *param) {
+	const UpdateChunk *chunk = (const UpdateChunk *)param;
+	chunk->_emitter->_particles.update(chunk->_emitter, chunk->_first, chunk->_last, chunk->_currentTime, chunk->_timerDelta);
+}
+
 //////////////////////////////////////////////////////////////////////////
 bool PartEmitter::start() {
 	for (uint32 i = 0; i < _particles.size(); i++) {
-		_particles[i]->_isDead = true;
+		_particles._isDead[i] = true;
 	}
 	_running = true;
 	_batchesGenerated = 0;
@@ -369,21 +396,10 @@ bool PartEmitter::start() {
 //////////////////////////////////////////////////////////////////////////
 bool PartEmitter::sortParticlesByZ() {
 	// sort particles by _posY
-	Common::sort(_particles.begin(), _particles.end(), PartEmitter::compareZ);
+	_particles.sortByZ();
 	return STATUS_OK;
 }
 
-//////////////////////////////////////////////////////////////////////////
-bool PartEmitter::compareZ(const PartParticle *p1, const PartParticle *p2) {
-	if (p1->_posZ < p2->_posZ) {
-		return true;
-	} else if (p1->_posZ > p2->_posZ) {
-		return false;
-	} else {
-		return false;
-	}
-}
-
 //////////////////////////////////////////////////////////////////////////
 bool PartEmitter::setBorder(int x, int y, int width, int height) {
 	BasePlatform::setRect(&_border, x, y, x + width, y + height);
@@ -523,9 +539,6 @@ bool PartEmitter::scCallMethod(ScScript *script, ScStack *stack, ScStack *thisSt
 	else if (strcmp(name, "Stop") == 0) {
 		stack->correctParams(0);
 
-		for (uint32 i = 0; i < _particles.size(); i++) {
-			delete _particles[i];
-		}
 		_particles.clear();
 
 		_running = false;
@@ -785,13 +798,7 @@ ScValue *PartEmitter::scGetProperty(const Common::String &name) {
 	// NumLiveParticles (RO)
 	//////////////////////////////////////////////////////////////////////////
 	else if (name == "NumLiveParticles") {
-		int numAlive = 0;
-		for (uint32 i = 0; i < _particles.size(); i++) {
-			if (_particles[i] && !_particles[i]->_isDead) {
-				numAlive++;
-			}
-		}
-		_scValue->setInt(numAlive);
+		_scValue->setInt(_particles.countLive());
 		return _scValue;
 	}
 
@@ -1238,14 +1245,14 @@ bool PartEmitter::persist(BasePersistenceManager *persistMgr) {
 		numParticles = _particles.size();
 		persistMgr->transfer(TMEMBER(numParticles));
 		for (uint32 i = 0; i < _particles.size(); i++) {
-			_particles[i]->persist(persistMgr);
+			_particles.persist(i, persistMgr);
 		}
 	} else {
 		persistMgr->transfer(TMEMBER(numParticles));
+		// Emitters being loaded are created without a game
+		_particles._gameRef = _gameRef;
 		for (uint32 i = 0; i < numParticles; i++) {
-			PartParticle *particle = new PartParticle(_gameRef);
-			particle->persist(persistMgr);
-			_particles.add(particle);
+			_particles.persist(_particles.add(), persistMgr);
 		}
 	}
 
@@ -32,10 +32,10 @@
 
 #include "engines/wintermute/base/base_object.h"
 #include "engines/wintermute/base/particles/part_force.h"
+#include "engines/wintermute/base/particles/part_particle.h"
 
 namespace Wintermute {
 class BaseRegion;
-class PartParticle;
 class PartEmitter : public BaseObject {
 public:
 	DECLARE_PERSISTENT(PartEmitter, BaseObject)
@@ -126,13 +126,29 @@ private:
 	char *_emitEvent;
 	BaseScriptHolder *_owner;
 
+	enum {
+		/** Number of particles updated by one job, if there are worker threads. */
+		kParticleChunkSize = 512
+	};
+
+	struct UpdateChunk {
+		PartEmitter *_emitter;
+		uint32 _first;
+		uint32 _last;
+		uint32 _currentTime;
+		uint32 _timerDelta;
+	};
+
 	PartForce *addForceByName(const Common::String &name);
-	bool static compareZ(const PartParticle *p1, const PartParticle *p2);
-	bool initParticle(PartParticle *particle, uint32 currentTime, uint32 timerDelta);
+	bool initParticle(uint32 index, uint32 currentTime, uint32 timerDelta);
 	bool updateInternal(uint32 currentTime, uint32 timerDelta);
+	/** Update all particles, on the worker threads of the engine if there are any. */
+	void updateParticles(uint32 currentTime, uint32 timerDelta);
+	static void updateChunk(void *param);
 	uint32 _lastGenTime;
-	BaseArray<PartParticle *> _particles;
+	PartParticles _particles;
 	BaseArray<char *> _sprites;
+	Common::Array<UpdateChunk> _updateChunks;
 };
 
 } // End of namespace Wintermute
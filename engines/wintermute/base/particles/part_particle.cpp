@@ -29,63 +29,176 @@
 #include "engines/wintermute/base/particles/part_particle.h"
 #include "engines/wintermute/base/particles/part_emitter.h"
 #include "engines/wintermute/base/base_sprite.h"
+#include "engines/wintermute/math/vector2.h"
 #include "engines/wintermute/utils/utils.h"
 #include "engines/wintermute/platform_osystem.h"
+#include "common/algorithm.h"
 #include "common/str.h"
 
 namespace Wintermute {
 
 //////////////////////////////////////////////////////////////////////////
-PartParticle::PartParticle(BaseGame *inGame) : BaseClass(inGame) {
-	_pos = Vector2(0.0f, 0.0f);
-	_posZ = 0.0f;
-	_velocity = Vector2(0.0f, 0.0f);
-	_scale = 100.0f;
-	_sprite = nullptr;
-	_creationTime = 0;
-	_lifeTime = 0;
-	_isDead = true;
-	BasePlatform::setRectEmpty(&_border);
-
-	_state = PARTICLE_NORMAL;
-	_fadeStart = 0;
-	_fadeTime = 0;
-	_currentAlpha = 255;
-
-	_alpha1 = _alpha2 = 255;
-
-	_rotation = 0.0f;
-	_angVelocity = 0.0f;
-
-	_growthRate = 0.0f;
-	_exponentialGrowth = false;
+PartParticles::PartParticles(BaseGame *inGame) : BaseClass(inGame) {
 }
 
 
 //////////////////////////////////////////////////////////////////////////
-PartParticle::~PartParticle(void) {
-	delete _sprite;
-	_sprite = nullptr;
+PartParticles::~PartParticles(void) {
+	clear();
 }
 
 //////////////////////////////////////////////////////////////////////////
-bool PartParticle::setSprite(const Common::String &filename) {
-	if (_sprite && _sprite->getFilename() && scumm_stricmp(filename.c_str(), _sprite->getFilename()) == 0) {
-		_sprite->reset();
+uint32 PartParticles::add() {
+	Rect32 border;
+	BasePlatform::setRectEmpty(&border);
+
+	_growthRate.push_back(0.0f);
+	_exponentialGrowth.push_back(false);
+	_rotation.push_back(0.0f);
+	_angVelocity.push_back(0.0f);
+	_alpha1.push_back(255);
+	_alpha2.push_back(255);
+	_border.push_back(border);
+	_posX.push_back(0.0f);
+	_posY.push_back(0.0f);
+	_posZ.push_back(0.0f);
+	_velocityX.push_back(0.0f);
+	_velocityY.push_back(0.0f);
+	_scale.push_back(100.0f);
+	_sprite.push_back(nullptr);
+	_creationTime.push_back(0);
+	_lifeTime.push_back(0);
+	_isDead.push_back(true);
+	_state.push_back(PARTICLE_NORMAL);
+	_fadeStart.push_back(0);
+	_fadeTime.push_back(0);
+	_currentAlpha.push_back(255);
+	_fadeStartAlpha.push_back(255);
+	_moving.push_back(false);
+
+	return size() - 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void PartParticles::clear() {
+	for (uint32 i = 0; i < _sprite.size(); i++) {
+		delete _sprite[i];
+	}
+
+	_growthRate.clear();
+	_exponentialGrowth.clear();
+	_rotation.clear();
+	_angVelocity.clear();
+	_alpha1.clear();
+	_alpha2.clear();
+	_border.clear();
+	_posX.clear();
+	_posY.clear();
+	_posZ.clear();
+	_velocityX.clear();
+	_velocityY.clear();
+	_scale.clear();
+	_sprite.clear();
+	_creationTime.clear();
+	_lifeTime.clear();
+	_isDead.clear();
+	_state.clear();
+	_fadeStart.clear();
+	_fadeTime.clear();
+	_currentAlpha.clear();
+	_fadeStartAlpha.clear();
+	_moving.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint32 PartParticles::countLive() const {
+	uint32 numLive = 0;
+	for (uint32 i = 0; i < _isDead.size(); i++) {
+		if (!_isDead[i]) {
+			numLive++;
+		}
+	}
+	return numLive;
+}
+
+//////////////////////////////////////////////////////////////////////////
+namespace {
+
+struct CompareZ {
+	const Common::Array<float> &_posZ;
+
+	CompareZ(const Common::Array<float> &posZ) : _posZ(posZ) {}
+
+	bool operator()(uint32 a, uint32 b) const {
+		return _posZ[a] < _posZ[b];
+	}
+};
+
+} // End of anonymous namespace
+
+template<class T>
+void PartParticles::reorder(Common::Array<T> &array, const Common::Array<uint32> &order) {
+	Common::Array<T> sorted;
+	sorted.reserve(order.size());
+	for (uint32 i = 0; i < order.size(); i++) {
+		sorted.push_back(array[order[i]]);
+	}
+	array = sorted;
+}
+
+void PartParticles::sortByZ() {
+	// Sort the indices, then move every property into that order
+	Common::Array<uint32> order;
+	order.reserve(size());
+	for (uint32 i = 0; i < size(); i++) {
+		order.push_back(i);
+	}
+	Common::sort(order.begin(), order.end(), CompareZ(_posZ));
+
+	reorder(_growthRate, order);
+	reorder(_exponentialGrowth, order);
+	reorder(_rotation, order);
+	reorder(_angVelocity, order);
+	reorder(_alpha1, order);
+	reorder(_alpha2, order);
+	reorder(_border, order);
+	reorder(_posX, order);
+	reorder(_posY, order);
+	reorder(_posZ, order);
+	reorder(_velocityX, order);
+	reorder(_velocityY, order);
+	reorder(_scale, order);
+	reorder(_sprite, order);
+	reorder(_creationTime, order);
+	reorder(_lifeTime, order);
+	reorder(_isDead, order);
+	reorder(_state, order);
+	reorder(_fadeStart, order);
+	reorder(_fadeTime, order);
+	reorder(_currentAlpha, order);
+	reorder(_fadeStartAlpha, order);
+	reorder(_moving, order);
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool PartParticles::setSprite(uint32 index, const Common::String &filename) {
+	BaseSprite *&sprite = _sprite[index];
+	if (sprite && sprite->getFilename() && scumm_stricmp(filename.c_str(), sprite->getFilename()) == 0) {
+		sprite->reset();
 		return STATUS_OK;
 	}
 
-	delete _sprite;
-	_sprite = nullptr;
+	delete sprite;
+	sprite = nullptr;
 
 	SystemClassRegistry::getInstance()->_disabled = true;
-	_sprite = new BaseSprite(_gameRef, (BaseObject*)_gameRef);
-	if (_sprite && DID_SUCCEED(_sprite->loadFile(filename))) {
+	sprite = new BaseSprite(_gameRef, (BaseObject*)_gameRef);
+	if (sprite && DID_SUCCEED(sprite->loadFile(filename))) {
 		SystemClassRegistry::getInstance()->_disabled = false;
 		return STATUS_OK;
 	} else {
-		delete _sprite;
-		_sprite = nullptr;
+		delete sprite;
+		sprite = nullptr;
 		SystemClassRegistry::getInstance()->_disabled = false;
 		return STATUS_FAILED;
 	}
@@ -93,171 +206,207 @@ bool PartParticle::setSprite(const Common::String &filename) {
 }
 
 //////////////////////////////////////////////////////////////////////////
-bool PartParticle::update(PartEmitter *emitter, uint32 currentTime, uint32 timerDelta) {
-	if (_state == PARTICLE_FADEIN) {
-		if (currentTime - _fadeStart >= (uint32)_fadeTime) {
-			_state = PARTICLE_NORMAL;
-			_currentAlpha = _alpha1;
-		} else {
-			_currentAlpha = (int)(((float)currentTime - (float)_fadeStart) / (float)_fadeTime * _alpha1);
+void PartParticles::update(const PartEmitter *emitter, uint32 first, uint32 last, uint32 currentTime, uint32 timerDelta) {
+	// First the fading and the end of life, which decide which particles move
+	for (uint32 i = first; i < last; i++) {
+		_moving[i] = false;
+
+		// Dead particles are reinitialized completely before they are used again
+		if (_isDead[i]) {
+			continue;
 		}
 
-		return STATUS_OK;
-	} else if (_state == PARTICLE_FADEOUT) {
-		if (currentTime - _fadeStart >= (uint32)_fadeTime) {
-			_isDead = true;
-			return STATUS_OK;
-		} else {
-			_currentAlpha = _fadeStartAlpha - (int)(((float)currentTime - (float)_fadeStart) / (float)_fadeTime * _fadeStartAlpha);
+		if (_state[i] == PARTICLE_FADEIN) {
+			if (currentTime - _fadeStart[i] >= (uint32)_fadeTime[i]) {
+				_state[i] = PARTICLE_NORMAL;
+				_currentAlpha[i] = _alpha1[i];
+			} else {
+				_currentAlpha[i] = (int)(((float)currentTime - (float)_fadeStart[i]) / (float)_fadeTime[i] * _alpha1[i]);
+			}
+			continue;
+		} else if (_state[i] == PARTICLE_FADEOUT) {
+			if (currentTime - _fadeStart[i] >= (uint32)_fadeTime[i]) {
+				_isDead[i] = true;
+			} else {
+				_currentAlpha[i] = _fadeStartAlpha[i] - (int)(((float)currentTime - (float)_fadeStart[i]) / (float)_fadeTime[i] * _fadeStartAlpha[i]);
+			}
+			continue;
 		}
 
-		return STATUS_OK;
-	} else {
 		// time is up
-		if (_lifeTime > 0) {
-			if (currentTime - _creationTime >= (uint32)_lifeTime) {
+		if (_lifeTime[i] > 0) {
+			if (currentTime - _creationTime[i] >= (uint32)_lifeTime[i]) {
 				if (emitter->_fadeOutTime > 0) {
-					fadeOut(currentTime, emitter->_fadeOutTime);
+					fadeOut(i, currentTime, emitter->_fadeOutTime);
 				} else {
-					_isDead = true;
+					_isDead[i] = true;
 				}
 			}
 		}
 
 		// particle hit the border
-		if (!_isDead && !BasePlatform::isRectEmpty(&_border)) {
+		if (!_isDead[i] && !BasePlatform::isRectEmpty(&_border[i])) {
 			Point32 p;
-			p.x = (int32)_pos.x;
-			p.y = (int32)_pos.y;
-			if (!BasePlatform::ptInRect(&_border, p)) {
-				fadeOut(currentTime, emitter->_fadeOutTime);
+			p.x = (int32)_posX[i];
+			p.y = (int32)_posY[i];
+			if (!BasePlatform::ptInRect(&_border[i], p)) {
+				fadeOut(i, currentTime, emitter->_fadeOutTime);
 			}
 		}
-		if (_state != PARTICLE_NORMAL) {
-			return STATUS_OK;
+		if (_state[i] != PARTICLE_NORMAL) {
+			continue;
 		}
 
 		// update alpha
-		if (_lifeTime > 0) {
-			int age = (int)(currentTime - _creationTime);
-			int alphaDelta = (int)(_alpha2 - _alpha1);
+		if (_lifeTime[i] > 0) {
+			int age = (int)(currentTime - _creationTime[i]);
+			int alphaDelta = (int)(_alpha2[i] - _alpha1[i]);
 
-			_currentAlpha = _alpha1 + (int)(((float)alphaDelta / (float)_lifeTime * (float)age));
+			_currentAlpha[i] = _alpha1[i] + (int)(((float)alphaDelta / (float)_lifeTime[i] * (float)age));
 		}
 
-		// update position
-		float elapsedTime = (float)timerDelta / 1000.f;
+		_moving[i] = true;
+	}
 
-		for (uint32 i = 0; i < emitter->_forces.size(); i++) {
-			PartForce *force = emitter->_forces[i];
-			switch (force->_type) {
-			case PartForce::FORCE_GLOBAL:
-				_velocity += force->_direction * elapsedTime;
-				break;
+	// update position
+	float elapsedTime = (float)timerDelta / 1000.f;
+
+	for (uint32 f = 0; f < emitter->_forces.size(); f++) {
+		const PartForce *force = emitter->_forces[f];
+		switch (force->_type) {
+		case PartForce::FORCE_GLOBAL: {
+			const Vector2 delta = force->_direction * elapsedTime;
+			for (uint32 i = first; i < last; i++) {
+				if (_moving[i]) {
+					_velocityX[i] += delta.x;
+					_velocityY[i] += delta.y;
+				}
+			}
+		}
+		break;
 
-			case PartForce::FORCE_POINT: {
-				Vector2 vecDist = force->_pos - _pos;
-				float dist = fabs(vecDist.length());
+		case PartForce::FORCE_POINT:
+			for (uint32 i = first; i < last; i++) {
+				if (_moving[i]) {
+					Vector2 vecDist = force->_pos - Vector2(_posX[i], _posY[i]);
+					float dist = fabs(vecDist.length());
 
-				dist = 100.0f / dist;
+					dist = 100.0f / dist;
 
-				_velocity += force->_direction * dist * elapsedTime;
+					const Vector2 delta = force->_direction * dist * elapsedTime;
+					_velocityX[i] += delta.x;
+					_velocityY[i] += delta.y;
+				}
 			}
 			break;
-			}
 		}
-		_pos += _velocity * elapsedTime;
+	}
+
+	for (uint32 i = first; i < last; i++) {
+		if (!_moving[i]) {
+			continue;
+		}
+
+		_posX[i] += _velocityX[i] * elapsedTime;
+		_posY[i] += _velocityY[i] * elapsedTime;
 
 		// update rotation
-		_rotation += _angVelocity * elapsedTime;
-		_rotation = BaseUtils::normalizeAngle(_rotation);
+		_rotation[i] += _angVelocity[i] * elapsedTime;
+		_rotation[i] = BaseUtils::normalizeAngle(_rotation[i]);
 
 		// update scale
-		if (_exponentialGrowth) {
-			_scale += _scale / 100.0f * _growthRate * elapsedTime;
+		if (_exponentialGrowth[i]) {
+			_scale[i] += _scale[i] / 100.0f * _growthRate[i] * elapsedTime;
 		} else {
-			_scale += _growthRate * elapsedTime;
+			_scale[i] += _growthRate[i] * elapsedTime;
 		}
 
-		if (_scale <= 0.0f) {
-			_isDead = true;
+		if (_scale[i] <= 0.0f) {
+			_isDead[i] = true;
 		}
-
-
-		return STATUS_OK;
 	}
 }
 
 //////////////////////////////////////////////////////////////////////////
-bool PartParticle::display(PartEmitter *emitter) {
-	if (!_sprite) {
+bool PartParticles::display(uint32 index, PartEmitter *emitter) {
+	BaseSprite *sprite = _sprite[index];
+	if (!sprite) {
 		return STATUS_FAILED;
 	}
-	if (_isDead) {
+	if (_isDead[index]) {
 		return STATUS_OK;
 	}
 
-	_sprite->getCurrentFrame();
-	return _sprite->display((int)_pos.x, (int)_pos.y,
-	                        nullptr,
-	                        _scale, _scale,
-	                        BYTETORGBA(255, 255, 255, _currentAlpha),
-	                        _rotation,
-	                        emitter->_blendMode);
+	sprite->getCurrentFrame();
+	return sprite->display((int)_posX[index], (int)_posY[index],
+	                       nullptr,
+	                       _scale[index], _scale[index],
+	                       BYTETORGBA(255, 255, 255, _currentAlpha[index]),
+	                       _rotation[index],
+	                       emitter->_blendMode);
 }
 
 
 //////////////////////////////////////////////////////////////////////////
-bool PartParticle::fadeIn(uint32 currentTime, int fadeTime) {
-	_currentAlpha = 0;
-	_fadeStart = currentTime;
-	_fadeTime = fadeTime;
-	_state = PARTICLE_FADEIN;
+bool PartParticles::fadeIn(uint32 index, uint32 currentTime, int fadeTime) {
+	_currentAlpha[index] = 0;
+	_fadeStart[index] = currentTime;
+	_fadeTime[index] = fadeTime;
+	_state[index] = PARTICLE_FADEIN;
 
 	return STATUS_OK;
 }
 
 //////////////////////////////////////////////////////////////////////////
-bool PartParticle::fadeOut(uint32 currentTime, int fadeTime) {
+bool PartParticles::fadeOut(uint32 index, uint32 currentTime, int fadeTime) {
 	//_currentAlpha = 255;
-	_fadeStartAlpha = _currentAlpha;
-	_fadeStart = currentTime;
-	_fadeTime = fadeTime;
-	_state = PARTICLE_FADEOUT;
+	_fadeStartAlpha[index] = _currentAlpha[index];
+	_fadeStart[index] = currentTime;
+	_fadeTime[index] = fadeTime;
+	_state[index] = PARTICLE_FADEOUT;
 
 	return STATUS_OK;
 }
 
 //////////////////////////////////////////////////////////////////////////
-bool PartParticle::persist(BasePersistenceManager *persistMgr) {
-	persistMgr->transfer(TMEMBER(_alpha1));
-	persistMgr->transfer(TMEMBER(_alpha2));
-	persistMgr->transfer(TMEMBER(_border));
-	persistMgr->transfer(TMEMBER(_pos));
-	persistMgr->transferFloat(TMEMBER(_posZ));
-	persistMgr->transfer(TMEMBER(_velocity));
-	persistMgr->transferFloat(TMEMBER(_scale));
-	persistMgr->transfer(TMEMBER(_creationTime));
-	persistMgr->transfer(TMEMBER(_lifeTime));
-	persistMgr->transfer(TMEMBER(_isDead));
-	persistMgr->transfer(TMEMBER_INT(_state));
-	persistMgr->transfer(TMEMBER(_fadeStart));
-	persistMgr->transfer(TMEMBER(_fadeTime));
-	persistMgr->transfer(TMEMBER(_currentAlpha));
-	persistMgr->transferFloat(TMEMBER(_angVelocity));
-	persistMgr->transferFloat(TMEMBER(_rotation));
-	persistMgr->transferFloat(TMEMBER(_growthRate));
-	persistMgr->transfer(TMEMBER(_exponentialGrowth));
-	persistMgr->transfer(TMEMBER(_fadeStartAlpha));
+bool PartParticles::persist(uint32 index, BasePersistenceManager *persistMgr) {
+	// Same layout as when each particle was an object of its own
+	Vector2 pos(_posX[index], _posY[index]);
+	Vector2 velocity(_velocityX[index], _velocityY[index]);
+
+	persistMgr->transfer("_alpha1", &_alpha1[index]);
+	persistMgr->transfer("_alpha2", &_alpha2[index]);
+	persistMgr->transfer("_border", &_border[index]);
+	persistMgr->transfer(TMEMBER(pos));
+	persistMgr->transferFloat("_posZ", &_posZ[index]);
+	persistMgr->transfer(TMEMBER(velocity));
+	persistMgr->transferFloat("_scale", &_scale[index]);
+	persistMgr->transfer("_creationTime", &_creationTime[index]);
+	persistMgr->transfer("_lifeTime", &_lifeTime[index]);
+	persistMgr->transfer("_isDead", &_isDead[index]);
+	persistMgr->transfer("_state", (int32 *)&_state[index]);
+	persistMgr->transfer("_fadeStart", &_fadeStart[index]);
+	persistMgr->transfer("_fadeTime", &_fadeTime[index]);
+	persistMgr->transfer("_currentAlpha", &_currentAlpha[index]);
+	persistMgr->transferFloat("_angVelocity", &_angVelocity[index]);
+	persistMgr->transferFloat("_rotation", &_rotation[index]);
+	persistMgr->transferFloat("_growthRate", &_growthRate[index]);
+	persistMgr->transfer("_exponentialGrowth", &_exponentialGrowth[index]);
+	persistMgr->transfer("_fadeStartAlpha", &_fadeStartAlpha[index]);
+
+	_posX[index] = pos.x;
+	_posY[index] = pos.y;
+	_velocityX[index] = velocity.x;
+	_velocityY[index] = velocity.y;
 
 	if (persistMgr->getIsSaving()) {
-		const char *filename = _sprite->getFilename();
+		const char *filename = _sprite[index]->getFilename();
 		persistMgr->transfer(TMEMBER(filename));
 	} else {
 		char *filename;
 		persistMgr->transfer(TMEMBER(filename));
 		SystemClassRegistry::getInstance()->_disabled = true;
-		setSprite(filename);
+		setSprite(index, filename);
 		SystemClassRegistry::getInstance()->_disabled = false;
 		delete[] filename;
 		filename = nullptr;
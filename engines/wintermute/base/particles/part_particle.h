@@ -32,7 +32,7 @@
 
 #include "engines/wintermute/base/base.h"
 #include "engines/wintermute/math/rect32.h"
-#include "engines/wintermute/math/vector2.h"
+#include "common/array.h"
 
 namespace Wintermute {
 
@@ -40,49 +40,77 @@ class PartEmitter;
 class BaseSprite;
 class BasePersistenceManager;
 
-class PartParticle : public BaseClass {
+/**
+ * The particles of one emitter.
+ *
+ * The particles are stored as a structure of arrays: each property has an
+ * array of its own, indexed by the number of the particle. update() runs
+ * over a range of particles one property at a time, which keeps the data it
+ * touches compact, and lets separate ranges be updated in parallel.
+ */
+class PartParticles : public BaseClass {
 public:
 	enum TParticleState {
 	    PARTICLE_NORMAL, PARTICLE_FADEIN, PARTICLE_FADEOUT
 	};
 
-	PartParticle(BaseGame *inGame);
-	virtual ~PartParticle(void);
-
-	float _growthRate;
-	bool _exponentialGrowth;
-
-	float _rotation;
-	float _angVelocity;
-
-	int32 _alpha1;
-	int32 _alpha2;
-
-	Rect32 _border;
-	Vector2 _pos;
-	float _posZ;
-	Vector2 _velocity;
-	float _scale;
-	BaseSprite *_sprite;
-	uint32 _creationTime;
-	int32 _lifeTime;
-	bool _isDead;
-	TParticleState _state;
-
-	bool update(PartEmitter *emitter, uint32 currentTime, uint32 timerDelta);
-	bool display(PartEmitter *emitter);
-
-	bool setSprite(const Common::String &filename);
-
-	bool fadeIn(uint32 currentTime, int fadeTime);
-	bool fadeOut(uint32 currentTime, int fadeTime);
-
-	bool persist(BasePersistenceManager *PersistMgr);
+	PartParticles(BaseGame *inGame = nullptr);
+	virtual ~PartParticles(void);
+
+	uint32 size() const { return _isDead.size(); }
+	/** Add a dead particle, and return its index. */
+	uint32 add();
+	void clear();
+	uint32 countLive() const;
+	/** Sort the particles by their Z position, front most last. */
+	void sortByZ();
+
+	Common::Array<float> _growthRate;
+	Common::Array<bool> _exponentialGrowth;
+
+	Common::Array<float> _rotation;
+	Common::Array<float> _angVelocity;
+
+	Common::Array<int32> _alpha1;
+	Common::Array<int32> _alpha2;
+
+	Common::Array<Rect32> _border;
+	Common::Array<float> _posX;
+	Common::Array<float> _posY;
+	Common::Array<float> _posZ;
+	Common::Array<float> _velocityX;
+	Common::Array<float> _velocityY;
+	Common::Array<float> _scale;
+	Common::Array<BaseSprite *> _sprite;
+	Common::Array<uint32> _creationTime;
+	Common::Array<int32> _lifeTime;
+	Common::Array<bool> _isDead;
+	Common::Array<TParticleState> _state;
+
+	/**
+	 * Update the particles from first up to (excluding) last. Only touches
+	 * these particles, and only reads the emitter.
+	 */
+	void update(const PartEmitter *emitter, uint32 first, uint32 last, uint32 currentTime, uint32 timerDelta);
+	bool display(uint32 index, PartEmitter *emitter);
+
+	bool setSprite(uint32 index, const Common::String &filename);
+
+	bool fadeIn(uint32 index, uint32 currentTime, int fadeTime);
+	bool fadeOut(uint32 index, uint32 currentTime, int fadeTime);
+
+	/** Save or load a single particle. */
+	bool persist(uint32 index, BasePersistenceManager *PersistMgr);
 private:
-	uint32 _fadeStart;
-	int32 _fadeTime;
-	int32 _currentAlpha;
-	int32 _fadeStartAlpha;
+	template<class T>
+	static void reorder(Common::Array<T> &array, const Common::Array<uint32> &order);
+
+	Common::Array<uint32> _fadeStart;
+	Common::Array<int32> _fadeTime;
+	Common::Array<int32> _currentAlpha;
+	Common::Array<int32> _fadeStartAlpha;
+	/** Set by update() for the particles which move in this step. */
+	Common::Array<bool> _moving;
 };
 
 } // End of namespace Wintermute
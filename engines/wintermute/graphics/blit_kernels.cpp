@@ -0,0 +1,523 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "engines/wintermute/graphics/blit_kernels.h"
+#include "common/cpudetect.h"
+#include "common/util.h"
+
+#ifdef SCUMMVM_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SCUMMVM_AVX2
+#include <immintrin.h>
+#endif
+
+namespace Wintermute {
+
+#pragma mark -
+#pragma mark --- SIMD helpers ---
+#pragma mark -
+
+#ifdef SCUMMVM_SSE2
+
+static inline __m128i selectSSE2(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/** Copy the alpha of each pixel unpacked to 16 bit lanes to the lanes of its other components. */
+static inline __m128i spreadAlphaSSE2(__m128i pixels) {
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+#endif
+
+#ifdef SCUMMVM_AVX2
+
+SCUMMVM_TARGET_AVX2
+static inline __m256i selectAVX2(__m256i mask, __m256i a, __m256i b) {
+	return _mm256_or_si256(_mm256_and_si256(mask, a), _mm256_andnot_si256(mask, b));
+}
+
+SCUMMVM_TARGET_AVX2
+static inline __m256i spreadAlphaAVX2(__m256i pixels) {
+	return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+#endif
+
+#pragma mark -
+#pragma mark --- Blend operations ---
+#pragma mark -
+
+/**
+ * Each kind of blit combines a source pixel with a destination pixel in
+ * its own way. blend() does that in plain C++, and is the reference for
+ * blendSSE2() and blendAVX2(), which do the same for four or eight pixels.
+ *
+ * Color modulations are done by multiplying with a factor and shifting
+ * right by 8 bits; a factor of 256 stands for a color component of 255,
+ * which leaves the value alone.
+ */
+
+static inline int modulationFactor(int component) {
+	return component == 255 ? 256 : component;
+}
+
+struct OpaqueOp {
+	OpaqueOp(uint32 color) {}
+
+	inline uint32 blend(uint32 src, uint32 dst) const {
+		return src | 0xFF000000;
+	}
+
+#ifdef SCUMMVM_SSE2
+	inline __m128i blendSSE2(__m128i src, __m128i dst) const {
+		return _mm_or_si128(src, _mm_set1_epi32((int)0xFF000000));
+	}
+#endif
+
+#ifdef SCUMMVM_AVX2
+	SCUMMVM_TARGET_AVX2
+	inline __m256i blendAVX2(__m256i src, __m256i dst) const {
+		return _mm256_or_si256(src, _mm256_set1_epi32((int)0xFF000000));
+	}
+#endif
+};
+
+struct BinaryOp {
+	BinaryOp(uint32 color) {}
+
+	inline uint32 blend(uint32 src, uint32 dst) const {
+		return (src >> 24) ? src : dst;
+	}
+
+#ifdef SCUMMVM_SSE2
+	inline __m128i blendSSE2(__m128i src, __m128i dst) const {
+		return selectSSE2(_mm_cmpeq_epi32(_mm_srli_epi32(src, 24), _mm_setzero_si128()), dst, src);
+	}
+#endif
+
+#ifdef SCUMMVM_AVX2
+	SCUMMVM_TARGET_AVX2
+	inline __m256i blendAVX2(__m256i src, __m256i dst) const {
+		return selectAVX2(_mm256_cmpeq_epi32(_mm256_srli_epi32(src, 24), _mm256_setzero_si256()), dst, src);
+	}
+#endif
+};
+
+struct AlphaOp {
+	AlphaOp(uint32 color) {}
+
+	inline uint32 blend(uint32 src, uint32 dst) const {
+		const uint32 a = src >> 24;
+		if (a == 0)
+			return dst;
+		if (a == 255)
+			return src;
+
+		uint32 result = 0xFF000000;
+		for (int shift = 0; shift < 24; shift += 8) {
+			const uint32 s = (src >> shift) & 0xFF;
+			const uint32 o = (dst >> shift) & 0xFF;
+			result |= (((o * (255 - a)) >> 8) + ((s * a) >> 8)) << shift;
+		}
+		return result;
+	}
+
+#ifdef SCUMMVM_SSE2
+	static inline __m128i blendHalfSSE2(__m128i src, __m128i dst) {
+		const __m128i alpha = spreadAlphaSSE2(src);
+		const __m128i invAlpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+		return _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(dst, invAlpha), 8), _mm_srli_epi16(_mm_mullo_epi16(src, alpha), 8));
+	}
+
+	inline __m128i blendSSE2(__m128i src, __m128i dst) const {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alpha = _mm_srli_epi32(src, 24);
+		const __m128i blended = _mm_or_si128(_mm_packus_epi16(
+			blendHalfSSE2(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero)),
+			blendHalfSSE2(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero))), _mm_set1_epi32((int)0xFF000000));
+		const __m128i result = selectSSE2(_mm_cmpeq_epi32(alpha, _mm_set1_epi32(255)), src, blended);
+		return selectSSE2(_mm_cmpeq_epi32(alpha, zero), dst, result);
+	}
+#endif
+
+#ifdef SCUMMVM_AVX2
+	SCUMMVM_TARGET_AVX2
+	static inline __m256i blendHalfAVX2(__m256i src, __m256i dst) {
+		const __m256i alpha = spreadAlphaAVX2(src);
+		const __m256i invAlpha = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+		return _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(dst, invAlpha), 8), _mm256_srli_epi16(_mm256_mullo_epi16(src, alpha), 8));
+	}
+
+	SCUMMVM_TARGET_AVX2
+	inline __m256i blendAVX2(__m256i src, __m256i dst) const {
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i alpha = _mm256_srli_epi32(src, 24);
+		const __m256i blended = _mm256_or_si256(_mm256_packus_epi16(
+			blendHalfAVX2(_mm256_unpacklo_epi8(src, zero), _mm256_unpacklo_epi8(dst, zero)),
+			blendHalfAVX2(_mm256_unpackhi_epi8(src, zero), _mm256_unpackhi_epi8(dst, zero))), _mm256_set1_epi32((int)0xFF000000));
+		const __m256i result = selectAVX2(_mm256_cmpeq_epi32(alpha, _mm256_set1_epi32(255)), src, blended);
+		return selectAVX2(_mm256_cmpeq_epi32(alpha, zero), dst, result);
+	}
+#endif
+};
+
+struct TintOp {
+	int _ca, _cr, _cg, _cb;
+	int _alphaFactor, _rFactor, _gFactor, _bFactor;
+
+	TintOp(uint32 color) {
+		_ca = (color >> 24) & 0xFF;
+		_cr = (color >> 16) & 0xFF;
+		_cg = (color >> 8) & 0xFF;
+		_cb = color & 0xFF;
+
+		// Compensate for transparency. Since we're coming
+		// down to 255 alpha, we just compensate for the colors here
+		if (_ca != 255) {
+			_cr = _cr * _ca >> 8;
+			_cg = _cg * _ca >> 8;
+			_cb = _cb * _ca >> 8;
+		}
+
+		_alphaFactor = modulationFactor(_ca);
+		_rFactor = modulationFactor(_cr);
+		_gFactor = modulationFactor(_cg);
+		_bFactor = modulationFactor(_cb);
+	}
+
+	static inline int blendComponent(int s, int o, int a, int c) {
+		if (c == 0)
+			return 0;
+		else if (c != 255)
+			return o + (((s - o) * a * c) >> 16);
+		else
+			return o + (((s - o) * a) >> 8);
+	}
+
+	inline uint32 blend(uint32 src, uint32 dst) const {
+		int b = src & 0xFF;
+		int g = (src >> 8) & 0xFF;
+		int r = (src >> 16) & 0xFF;
+		int a = (src >> 24) & 0xFF;
+
+		if (_ca != 255)
+			a = a * _ca >> 8;
+
+		if (a == 0)
+			return dst;
+
+		if (a == 255) {
+			if (_cb != 255)
+				b = (b * _cb) >> 8;
+			if (_cg != 255)
+				g = (g * _cg) >> 8;
+			if (_cr != 255)
+				r = (r * _cr) >> 8;
+		} else {
+			b = blendComponent(b, dst & 0xFF, a, _cb);
+			g = blendComponent(g, (dst >> 8) & 0xFF, a, _cg);
+			r = blendComponent(r, (dst >> 16) & 0xFF, a, _cr);
+		}
+		return 0xFF000000 | (r << 16) | (g << 8) | b;
+	}
+
+#ifdef SCUMMVM_SSE2
+	static inline __m128i blendHalfSSE2(__m128i src, __m128i dst, __m128i factors, __m128i alphaFactor, __m128i &alpha) {
+		const __m128i zero = _mm_setzero_si128();
+		alpha = _mm_srli_epi16(_mm_mullo_epi16(spreadAlphaSSE2(src), alphaFactor), 8);
+
+		// Fully opaque pixels are only modulated
+		const __m128i opaque = _mm_srli_epi16(_mm_mullo_epi16(src, factors), 8);
+
+		// The others become dst + floor((src - dst) * alpha * factor / 65536).
+		// The weight needs all 16 bits, so multiply the magnitude of the
+		// difference and round up the magnitude of negative results.
+		const __m128i diff = _mm_sub_epi16(src, dst);
+		const __m128i negative = _mm_cmpgt_epi16(zero, diff);
+		const __m128i magnitude = _mm_max_epi16(diff, _mm_sub_epi16(zero, diff));
+		const __m128i weight = _mm_mullo_epi16(alpha, factors);
+		const __m128i high = _mm_mulhi_epu16(magnitude, weight);
+		const __m128i roundUp = _mm_andnot_si128(_mm_cmpeq_epi16(_mm_mullo_epi16(magnitude, weight), zero), _mm_set1_epi16(1));
+		const __m128i delta = selectSSE2(negative, _mm_sub_epi16(zero, _mm_add_epi16(high, roundUp)), high);
+		// Components modulated with 0 end up black
+		const __m128i blended = _mm_andnot_si128(_mm_cmpeq_epi16(factors, zero), _mm_add_epi16(dst, delta));
+
+		return selectSSE2(_mm_cmpeq_epi16(alpha, _mm_set1_epi16(255)), opaque, blended);
+	}
+
+	inline __m128i blendSSE2(__m128i src, __m128i dst) const {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i factors = _mm_set_epi16(0, _rFactor, _gFactor, _bFactor, 0, _rFactor, _gFactor, _bFactor);
+		const __m128i alphaFactor = _mm_set1_epi16(_alphaFactor);
+		__m128i alphaLow, alphaHigh;
+		const __m128i low = blendHalfSSE2(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero), factors, alphaFactor, alphaLow);
+		const __m128i high = blendHalfSSE2(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero), factors, alphaFactor, alphaHigh);
+		const __m128i result = _mm_or_si128(_mm_packus_epi16(low, high), _mm_set1_epi32((int)0xFF000000));
+		// The modulated alpha is in every byte of a pixel
+		const __m128i alpha = _mm_packus_epi16(alphaLow, alphaHigh);
+		return selectSSE2(_mm_cmpeq_epi8(alpha, zero), dst, result);
+	}
+#endif
+
+#ifdef SCUMMVM_AVX2
+	SCUMMVM_TARGET_AVX2
+	static inline __m256i blendHalfAVX2(__m256i src, __m256i dst, __m256i factors, __m256i alphaFactor, __m256i &alpha) {
+		const __m256i zero = _mm256_setzero_si256();
+		alpha = _mm256_srli_epi16(_mm256_mullo_epi16(spreadAlphaAVX2(src), alphaFactor), 8);
+
+		const __m256i opaque = _mm256_srli_epi16(_mm256_mullo_epi16(src, factors), 8);
+
+		const __m256i diff = _mm256_sub_epi16(src, dst);
+		const __m256i negative = _mm256_cmpgt_epi16(zero, diff);
+		const __m256i magnitude = _mm256_abs_epi16(diff);
+		const __m256i weight = _mm256_mullo_epi16(alpha, factors);
+		const __m256i high = _mm256_mulhi_epu16(magnitude, weight);
+		const __m256i roundUp = _mm256_andnot_si256(_mm256_cmpeq_epi16(_mm256_mullo_epi16(magnitude, weight), zero), _mm256_set1_epi16(1));
+		const __m256i delta = selectAVX2(negative, _mm256_sub_epi16(zero, _mm256_add_epi16(high, roundUp)), high);
+		const __m256i blended = _mm256_andnot_si256(_mm256_cmpeq_epi16(factors, zero), _mm256_add_epi16(dst, delta));
+
+		return selectAVX2(_mm256_cmpeq_epi16(alpha, _mm256_set1_epi16(255)), opaque, blended);
+	}
+
+	SCUMMVM_TARGET_AVX2
+	inline __m256i blendAVX2(__m256i src, __m256i dst) const {
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i factors = _mm256_broadcastsi128_si256(_mm_set_epi16(0, _rFactor, _gFactor, _bFactor, 0, _rFactor, _gFactor, _bFactor));
+		const __m256i alphaFactor = _mm256_set1_epi16(_alphaFactor);
+		__m256i alphaLow, alphaHigh;
+		const __m256i low = blendHalfAVX2(_mm256_unpacklo_epi8(src, zero), _mm256_unpacklo_epi8(dst, zero), factors, alphaFactor, alphaLow);
+		const __m256i high = blendHalfAVX2(_mm256_unpackhi_epi8(src, zero), _mm256_unpackhi_epi8(dst, zero), factors, alphaFactor, alphaHigh);
+		const __m256i result = _mm256_or_si256(_mm256_packus_epi16(low, high), _mm256_set1_epi32((int)0xFF000000));
+		const __m256i alpha = _mm256_packus_epi16(alphaLow, alphaHigh);
+		return selectAVX2(_mm256_cmpeq_epi8(alpha, zero), dst, result);
+	}
+#endif
+};
+
+struct AdditiveOp {
+	int _alphaFactor, _rFactor, _gFactor, _bFactor;
+
+	AdditiveOp(uint32 color) {
+		_alphaFactor = modulationFactor((color >> 24) & 0xFF);
+		_rFactor = modulationFactor((color >> 16) & 0xFF);
+		_gFactor = modulationFactor((color >> 8) & 0xFF);
+		_bFactor = modulationFactor(color & 0xFF);
+	}
+
+	static inline uint32 addComponent(uint32 s, uint32 o, uint32 a, uint32 factor) {
+		return MIN<uint32>(o + ((((s * factor) >> 8) * a) >> 8), 255);
+	}
+
+	inline uint32 blend(uint32 src, uint32 dst) const {
+		const uint32 a = ((src >> 24) * _alphaFactor) >> 8;
+		const uint32 b = addComponent(src & 0xFF, dst & 0xFF, a, _bFactor);
+		const uint32 g = addComponent((src >> 8) & 0xFF, (dst >> 8) & 0xFF, a, _gFactor);
+		const uint32 r = addComponent((src >> 16) & 0xFF, (dst >> 16) & 0xFF, a, _rFactor);
+		return (dst & 0xFF000000) | (r << 16) | (g << 8) | b;
+	}
+
+#ifdef SCUMMVM_SSE2
+	static inline __m128i addHalfSSE2(__m128i src, __m128i factors, __m128i alphaFactor) {
+		const __m128i alpha = _mm_srli_epi16(_mm_mullo_epi16(spreadAlphaSSE2(src), alphaFactor), 8);
+		const __m128i color = _mm_srli_epi16(_mm_mullo_epi16(src, factors), 8);
+		return _mm_srli_epi16(_mm_mullo_epi16(color, alpha), 8);
+	}
+
+	inline __m128i blendSSE2(__m128i src, __m128i dst) const {
+		const __m128i zero = _mm_setzero_si128();
+		// The alpha factor of 0 keeps the destination alpha
+		const __m128i factors = _mm_set_epi16(0, _rFactor, _gFactor, _bFactor, 0, _rFactor, _gFactor, _bFactor);
+		const __m128i alphaFactor = _mm_set1_epi16(_alphaFactor);
+		const __m128i add = _mm_packus_epi16(addHalfSSE2(_mm_unpacklo_epi8(src, zero), factors, alphaFactor),
+		                                     addHalfSSE2(_mm_unpackhi_epi8(src, zero), factors, alphaFactor));
+		return _mm_adds_epu8(dst, add);
+	}
+#endif
+
+#ifdef SCUMMVM_AVX2
+	SCUMMVM_TARGET_AVX2
+	static inline __m256i addHalfAVX2(__m256i src, __m256i factors, __m256i alphaFactor) {
+		const __m256i alpha = _mm256_srli_epi16(_mm256_mullo_epi16(spreadAlphaAVX2(src), alphaFactor), 8);
+		const __m256i color = _mm256_srli_epi16(_mm256_mullo_epi16(src, factors), 8);
+		return _mm256_srli_epi16(_mm256_mullo_epi16(color, alpha), 8);
+	}
+
+	SCUMMVM_TARGET_AVX2
+	inline __m256i blendAVX2(__m256i src, __m256i dst) const {
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i factors = _mm256_broadcastsi128_si256(_mm_set_epi16(0, _rFactor, _gFactor, _bFactor, 0, _rFactor, _gFactor, _bFactor));
+		const __m256i alphaFactor = _mm256_set1_epi16(_alphaFactor);
+		const __m256i add = _mm256_packus_epi16(addHalfAVX2(_mm256_unpacklo_epi8(src, zero), factors, alphaFactor),
+		                                        addHalfAVX2(_mm256_unpackhi_epi8(src, zero), factors, alphaFactor));
+		return _mm256_adds_epu8(dst, add);
+	}
+#endif
+};
+
+#pragma mark -
+#pragma mark --- Plain C++ kernels ---
+#pragma mark -
+
+template<class Op>
+static void blitScalar(byte *dst, const byte *src, int width, int height, int dstPitch, int srcPitch, bool flipH, uint32 color) {
+	const Op op(color);
+	const int step = flipH ? -1 : 1;
+
+	for (int y = 0; y < height; y++) {
+		uint32 *out = (uint32 *)dst;
+		const uint32 *in = (const uint32 *)src;
+		for (int x = 0; x < width; x++, in += step)
+			out[x] = op.blend(*in, out[x]);
+		dst += dstPitch;
+		src += srcPitch;
+	}
+}
+
+static const BlitKernels s_scalarKernels = {
+	"C++",
+	blitScalar<OpaqueOp>,
+	blitScalar<BinaryOp>,
+	blitScalar<AlphaOp>,
+	blitScalar<TintOp>,
+	blitScalar<AdditiveOp>
+};
+
+#ifdef SCUMMVM_SSE2
+
+#pragma mark -
+#pragma mark --- SSE2 kernels ---
+#pragma mark -
+
+template<class Op, bool flipH>
+static void blitRowsSSE2(byte *dst, const byte *src, int width, int height, int dstPitch, int srcPitch, const Op &op) {
+	for (int y = 0; y < height; y++) {
+		uint32 *out = (uint32 *)dst;
+		const uint32 *in = (const uint32 *)src;
+		int x = 0;
+		for (; x + 4 <= width; x += 4) {
+			__m128i pixels;
+			if (flipH)
+				pixels = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(in - x - 3)), _MM_SHUFFLE(0, 1, 2, 3));
+			else
+				pixels = _mm_loadu_si128((const __m128i *)(in + x));
+			__m128i *outPixels = (__m128i *)(out + x);
+			_mm_storeu_si128(outPixels, op.blendSSE2(pixels, _mm_loadu_si128(outPixels)));
+		}
+		for (; x < width; x++)
+			out[x] = op.blend(flipH ? in[-x] : in[x], out[x]);
+		dst += dstPitch;
+		src += srcPitch;
+	}
+}
+
+template<class Op>
+static void blitSSE2(byte *dst, const byte *src, int width, int height, int dstPitch, int srcPitch, bool flipH, uint32 color) {
+	const Op op(color);
+	if (flipH)
+		blitRowsSSE2<Op, true>(dst, src, width, height, dstPitch, srcPitch, op);
+	else
+		blitRowsSSE2<Op, false>(dst, src, width, height, dstPitch, srcPitch, op);
+}
+
+static const BlitKernels s_sse2Kernels = {
+	"SSE2",
+	blitSSE2<OpaqueOp>,
+	blitSSE2<BinaryOp>,
+	blitSSE2<AlphaOp>,
+	blitSSE2<TintOp>,
+	blitSSE2<AdditiveOp>
+};
+
+#endif
+
+#ifdef SCUMMVM_AVX2
+
+#pragma mark -
+#pragma mark --- AVX2 kernels ---
+#pragma mark -
+
+template<class Op, bool flipH>
+SCUMMVM_TARGET_AVX2
+static void blitRowsAVX2(byte *dst, const byte *src, int width, int height, int dstPitch, int srcPitch, const Op &op) {
+	const __m256i reverse = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	for (int y = 0; y < height; y++) {
+		uint32 *out = (uint32 *)dst;
+		const uint32 *in = (const uint32 *)src;
+		int x = 0;
+		for (; x + 8 <= width; x += 8) {
+			__m256i pixels;
+			if (flipH)
+				pixels = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)(in - x - 7)), reverse);
+			else
+				pixels = _mm256_loadu_si256((const __m256i *)(in + x));
+			__m256i *outPixels = (__m256i *)(out + x);
+			_mm256_storeu_si256(outPixels, op.blendAVX2(pixels, _mm256_loadu_si256(outPixels)));
+		}
+		for (; x < width; x++)
+			out[x] = op.blend(flipH ? in[-x] : in[x], out[x]);
+		dst += dstPitch;
+		src += srcPitch;
+	}
+}
+
+template<class Op>
+static void blitAVX2(byte *dst, const byte *src, int width, int height, int dstPitch, int srcPitch, bool flipH, uint32 color) {
+	const Op op(color);
+	if (flipH)
+		blitRowsAVX2<Op, true>(dst, src, width, height, dstPitch, srcPitch, op);
+	else
+		blitRowsAVX2<Op, false>(dst, src, width, height, dstPitch, srcPitch, op);
+}
+
+static const BlitKernels s_avx2Kernels = {
+	"AVX2",
+	blitAVX2<OpaqueOp>,
+	blitAVX2<BinaryOp>,
+	blitAVX2<AlphaOp>,
+	blitAVX2<TintOp>,
+	blitAVX2<AdditiveOp>
+};
+
+#endif
+
+#pragma mark -
+
+const BlitKernels &getBlitKernels() {
+#ifdef SCUMMVM_AVX2
+	if (Common::hasCPUFeature(Common::kCpuFeatureAVX2))
+		return s_avx2Kernels;
+#endif
+#ifdef SCUMMVM_SSE2
+	if (Common::hasCPUFeature(Common::kCpuFeatureSSE2))
+		return s_sse2Kernels;
+#endif
+	return s_scalarKernels;
+}
+
+const BlitKernels &getScalarBlitKernels() {
+	return s_scalarKernels;
+}
+
+} // End of namespace Wintermute
@@ -0,0 +1,84 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef WINTERMUTE_BLIT_KERNELS_H
+#define WINTERMUTE_BLIT_KERNELS_H
+
+#include "common/scummsys.h"
+
+namespace Wintermute {
+
+/**
+ * The inner loop of TransparentSurface::blit() for one kind of blit.
+ *
+ * Both surfaces are 32 bpp with alpha in the highest byte of each pixel.
+ * Pixels are read starting at src, from right to left if flipH is set;
+ * srcPitch is negative for vertically flipped blits. color is the ARGB
+ * color modulation, only used by the tinted and additive kernels.
+ */
+typedef void (*BlitKernel)(byte *dst, const byte *src, int width, int height, int dstPitch, int srcPitch, bool flipH, uint32 color);
+
+/**
+ * The blit kernels. Each set produces exactly the same output; they only
+ * differ in the instruction set used.
+ */
+struct BlitKernels {
+	/** Name of the implementation, for debug output and benchmarks. */
+	const char *name;
+
+	/** Copy the source, making every pixel opaque. */
+	BlitKernel opaque;
+
+	/**
+	 * Copy the source pixels which are not fully transparent. Only valid
+	 * for sources which have nothing but fully transparent and fully
+	 * opaque pixels.
+	 */
+	BlitKernel binary;
+
+	/** Alpha blend the source onto the destination. */
+	BlitKernel alpha;
+
+	/** Alpha blend the source, modulated with color, onto the destination. */
+	BlitKernel tinted;
+
+	/**
+	 * Add the source, modulated with color and weighted by its alpha, to
+	 * the destination, with saturation. The destination alpha is kept.
+	 */
+	BlitKernel additive;
+};
+
+/**
+ * Return the fastest kernels the CPU supports, taking features disabled
+ * with Common::setDisabledCPUFeatures() into account.
+ */
+const BlitKernels &getBlitKernels();
+
+/**
+ * Return the plain C++ reference kernels.
+ */
+const BlitKernels &getScalarBlitKernels();
+
+} // End of namespace Wintermute
+
+#endif
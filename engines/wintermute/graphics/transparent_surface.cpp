@@ -27,6 +27,7 @@
 #include "common/textconsole.h"
 #include "graphics/primitives.h"
 #include "engines/wintermute/graphics/transparent_surface.h"
+#include "engines/wintermute/graphics/blit_kernels.h"
 #include "engines/wintermute/graphics/transform_tools.h"
 
 namespace Wintermute {
@@ -140,16 +141,9 @@ void TransparentSurface::copyPixelNearestNeighbor(float projX, float projY, int
 }
 #endif
 
-byte *TransparentSurface::_lookup = nullptr;
+TransparentSurface::TransparentSurface() : Surface(), _enableAlphaBlit(true), _alphaMode(ALPHA_FULL) {}
 
-void TransparentSurface::destroyLookup() {
-	delete[] _lookup;
-	_lookup = nullptr;
-}
-
-TransparentSurface::TransparentSurface() : Surface(), _enableAlphaBlit(true) {}
-
-TransparentSurface::TransparentSurface(const Surface &surf, bool copyData) : Surface(), _enableAlphaBlit(true) {
+TransparentSurface::TransparentSurface(const Surface &surf, bool copyData) : Surface(), _enableAlphaBlit(true), _alphaMode(ALPHA_FULL) {
 	if (copyData) {
 		copyFrom(surf);
 	} else {
@@ -164,119 +158,25 @@ TransparentSurface::TransparentSurface(const Surface &surf, bool copyData) : Sur
 	}
 }
 
-void doBlitOpaque(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep) {
-	byte *in, *out;
-
-#ifdef SCUMM_LITTLE_ENDIAN
-	const int aIndex = 3;
-#else
-	const int aIndex = 0;
-#endif
-
-	for (uint32 i = 0; i < height; i++) {
-		out = outo;
-		in = ino;
-		memcpy(out, in, width * 4);
-		for (uint32 j = 0; j < width; j++) {
-			out[aIndex] = 0xFF;
-			out += 4;
-		}
-		outo += pitch;
-		ino += inoStep;
-	}
-}
-
-void TransparentSurface::generateLookup() {
-	_lookup = new byte[256 * 256];
-	for (int i = 0; i < 256; i++) {
-		for (int j = 0; j < 256; j++) {
-			_lookup[(i << 8) + j] = (i * j) >> 8;
-		}
-	}
-}
-
-void TransparentSurface::doBlitAlpha(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep) {
-	byte *in, *out;
-
-	if (!_lookup) {
-		generateLookup();
-	}
-
-#ifdef SCUMM_LITTLE_ENDIAN
-	const int aIndex = 3;
-	const int bIndex = 0;
-	const int gIndex = 1;
-	const int rIndex = 2;
-#else
-	const int aIndex = 0;
-	const int bIndex = 3;
-	const int gIndex = 2;
-	const int rIndex = 1;
-#endif
-
-	const int bShift = 0;//img->format.bShift;
-	const int gShift = 8;//img->format.gShift;
-	const int rShift = 16;//img->format.rShift;
-	const int aShift = 24;//img->format.aShift;
-
-	const int bShiftTarget = 0;//target.format.bShift;
-	const int gShiftTarget = 8;//target.format.gShift;
-	const int rShiftTarget = 16;//target.format.rShift;
-
-	for (uint32 i = 0; i < height; i++) {
-		out = outo;
-		in = ino;
-		for (uint32 j = 0; j < width; j++) {
-			uint32 pix = *(uint32 *)in;
-			uint32 oPix = *(uint32 *) out;
-			int b = (pix >> bShift) & 0xff;
-			int g = (pix >> gShift) & 0xff;
-			int r = (pix >> rShift) & 0xff;
-			int a = (pix >> aShift) & 0xff;
-			int outb, outg, outr, outa;
-			in += inStep;
-
-			switch (a) {
-				case 0: // Full transparency
-					out += 4;
-					break;
-				case 255: // Full opacity
-					outb = b;
-					outg = g;
-					outr = r;
-					outa = a;
-
-					out[aIndex] = outa;
-					out[bIndex] = outb;
-					out[gIndex] = outg;
-					out[rIndex] = outr;
-					out += 4;
-					break;
-
-				default: // alpha blending
-					outa = 255;
-
-					outb = _lookup[(((oPix >> bShiftTarget) & 0xff)) + ((255 - a) << 8)];
-					outg = _lookup[(((oPix >> gShiftTarget) & 0xff)) + ((255 - a) << 8)];
-					outr = _lookup[(((oPix >> rShiftTarget) & 0xff)) + ((255 - a) << 8)];
-					outb += _lookup[b + (a << 8)];
-					outg += _lookup[g + (a << 8)];
-					outr += _lookup[r + (a << 8)];
-
-					out[aIndex] = outa;
-					out[bIndex] = outb;
-					out[gIndex] = outg;
-					out[rIndex] = outr;
-					out += 4;
-			}
+TransparentSurface::AlphaType TransparentSurface::detectAlphaMode() const {
+	if (format.bytesPerPixel != 4)
+		return ALPHA_FULL;
+
+	AlphaType type = ALPHA_OPAQUE;
+	for (int y = 0; y < h; y++) {
+		const uint32 *pix = (const uint32 *)getBasePtr(0, y);
+		for (int x = 0; x < w; x++) {
+			const uint32 a = pix[x] >> 24;
+			if (a == 0)
+				type = ALPHA_BINARY;
+			else if (a != 255)
+				return ALPHA_FULL;
 		}
-		outo += pitch;
-		ino += inoStep;
 	}
+	return type;
 }
 
-
-Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int posY, int flipping, Common::Rect *pPartRect, uint color, int width, int height) {
+Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int posY, int flipping, Common::Rect *pPartRect, uint color, int width, int height, TSpriteBlendMode blendMode) {
 	int ca = (color >> 24) & 0xff;
 
 	Common::Rect retSize;
@@ -288,18 +188,6 @@ Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int p
 	if (ca == 0)
 		return retSize;
 
-	int cr = (color >> 16) & 0xff;
-	int cg = (color >> 8) & 0xff;
-	int cb = (color >> 0) & 0xff;
-
-	// Compensate for transparency. Since we're coming
-	// down to 255 alpha, we just compensate for the colors here
-	if (ca != 255) {
-		cr = cr * ca >> 8;
-		cg = cg * ca >> 8;
-		cb = cb * ca >> 8;
-	}
-
 	// Create an encapsulating surface for the data
 	TransparentSurface srcImage(*this, false);
 	// TODO: Is the data really in the screen format?
@@ -376,113 +264,22 @@ Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int p
 
 		byte *ino = (byte *)img->getBasePtr(xp, yp);
 		byte *outo = (byte *)target.getBasePtr(posX, posY);
-		byte *in, *out;
 
-#ifdef SCUMM_LITTLE_ENDIAN
-		const int aIndex = 3;
-		const int bIndex = 0;
-		const int gIndex = 1;
-		const int rIndex = 2;
-#else
-		const int aIndex = 0;
-		const int bIndex = 3;
-		const int gIndex = 2;
-		const int rIndex = 1;
-#endif
-		const int bShift = 0;//img->format.bShift;
-		const int gShift = 8;//img->format.gShift;
-		const int rShift = 16;//img->format.rShift;
-		const int aShift = 24;//img->format.aShift;
-
-		const int bShiftTarget = 0;//target.format.bShift;
-		const int gShiftTarget = 8;//target.format.gShift;
-		const int rShiftTarget = 16;//target.format.rShift;
-
-		if (ca == 255 && cb == 255 && cg == 255 && cr == 255) {
-			if (_enableAlphaBlit) {
-				doBlitAlpha(ino, outo, img->w, img->h, target.pitch, inStep, inoStep);
-			} else {
-				doBlitOpaque(ino, outo, img->w, img->h, target.pitch, inStep, inoStep);
-			}
+		// Pick the kernel once, instead of checking the modes for every pixel
+		const BlitKernels &kernels = getBlitKernels();
+		BlitKernel kernel;
+		if (blendMode == BLEND_ADDITIVE) {
+			kernel = kernels.additive;
+		} else if (color != (uint)BS_ARGB(255, 255, 255, 255)) {
+			kernel = kernels.tinted;
+		} else if (!_enableAlphaBlit || _alphaMode == ALPHA_OPAQUE) {
+			kernel = kernels.opaque;
+		} else if (_alphaMode == ALPHA_BINARY) {
+			kernel = kernels.binary;
 		} else {
-			for (int i = 0; i < img->h; i++) {
-				out = outo;
-				in = ino;
-				for (int j = 0; j < img->w; j++) {
-					uint32 pix = *(uint32 *)in;
-					uint32 o_pix = *(uint32 *) out;
-					int b = (pix >> bShift) & 0xff;
-					int g = (pix >> gShift) & 0xff;
-					int r = (pix >> rShift) & 0xff;
-					int a = (pix >> aShift) & 0xff;
-					int outb, outg, outr, outa;
-					in += inStep;
-
-					if (ca != 255) {
-						a = a * ca >> 8;
-					}
-
-					switch (a) {
-					case 0: // Full transparency
-						out += 4;
-						break;
-					case 255: // Full opacity
-						if (cb != 255)
-							outb = (b * cb) >> 8;
-						else
-							outb = b;
-
-						if (cg != 255)
-							outg = (g * cg) >> 8;
-						else
-							outg = g;
-
-						if (cr != 255)
-							outr = (r * cr) >> 8;
-						else
-							outr = r;
-						outa = a;
-						out[aIndex] = outa;
-						out[bIndex] = outb;
-						out[gIndex] = outg;
-						out[rIndex] = outr;
-						out += 4;
-						break;
-
-					default: // alpha blending
-						outa = 255;
-						outb = (o_pix >> bShiftTarget) & 0xff;
-						outg = (o_pix >> gShiftTarget) & 0xff;
-						outr = (o_pix >> rShiftTarget) & 0xff;
-						if (cb == 0)
-							outb = 0;
-						else if (cb != 255)
-							outb += ((b - outb) * a * cb) >> 16;
-						else
-							outb += ((b - outb) * a) >> 8;
-						if (cg == 0)
-							outg = 0;
-						else if (cg != 255)
-							outg += ((g - outg) * a * cg) >> 16;
-						else
-							outg += ((g - outg) * a) >> 8;
-						if (cr == 0)
-							outr = 0;
-						else if (cr != 255)
-							outr += ((r - outr) * a * cr) >> 16;
-						else
-							outr += ((r - outr) * a) >> 8;
-						out[aIndex] = outa;
-						out[bIndex] = outb;
-						out[gIndex] = outg;
-						out[rIndex] = outr;
-						out += 4;
-					}
-				}
-				outo += target.pitch;
-				ino += inoStep;
-			}
+			kernel = kernels.alpha;
 		}
+		kernel(outo, ino, img->w, img->h, target.pitch, inoStep, inStep < 0, color);
 	}
 
 	retSize.setWidth(img->w);
@@ -75,8 +75,31 @@ struct TransparentSurface : public Graphics::Surface {
 		FLIP_VH = FLIP_H | FLIP_V
 	};
 
+	/**
+	 @brief The kinds of alpha values a surface can have.
+	 */
+	enum AlphaType {
+		/// Every pixel is fully opaque.
+		ALPHA_OPAQUE = 0,
+		/// Every pixel is either fully transparent or fully opaque.
+		ALPHA_BINARY = 1,
+		/// Any alpha value may occur.
+		ALPHA_FULL = 2
+	};
+
 	bool _enableAlphaBlit;
 
+	/**
+	 The alpha values of the surface, which lets blit() skip the blending
+	 where it isn't needed. Defaults to ALPHA_FULL, which is always correct.
+	 */
+	AlphaType _alphaMode;
+
+	/**
+	 @brief Look at every pixel to find out which AlphaType fits the surface.
+	 */
+	AlphaType detectAlphaMode() const;
+
 	/**
 	 @brief renders the surface to another surface
 	 @param pDest a pointer to the target image. In most cases this is the framebuffer.
@@ -102,6 +125,8 @@ struct TransparentSurface : public Graphics::Surface {
 	 The images will be scaled if the output width of the screen section differs from the image section.<br>
 	 The value -1 determines that the image should not be scaled.<br>
 	 The default value is -1.
+	 @param blendMode BLEND_ADDITIVE adds the image to the target instead of blending it.<br>
+	 The default value is BLEND_NORMAL.
 	 @return returns false if the rendering failed.
 	 */
 
@@ -109,16 +134,12 @@ struct TransparentSurface : public Graphics::Surface {
 	                  int flipping = FLIP_NONE,
 	                  Common::Rect *pPartRect = nullptr,
 	                  uint color = BS_ARGB(255, 255, 255, 255),
-	                  int width = -1, int height = -1);
+	                  int width = -1, int height = -1,
+	                  TSpriteBlendMode blendMode = BLEND_NORMAL);
 	void applyColorKey(uint8 r, uint8 g, uint8 b, bool overwriteAlpha = false);
 
 	TransparentSurface *scale(uint16 newWidth, uint16 newHeight) const;
 	TransparentSurface *rotoscale(const TransformStruct &transform) const;
-	static byte *_lookup;
-	static void destroyLookup();
-private:
-	static void doBlitAlpha(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep);
-	static void generateLookup();
 };
 
 /**
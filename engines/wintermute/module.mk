@@ -53,6 +53,7 @@ MODULE_OBJS := \
 	base/gfx/osystem/base_surface_osystem.o \
 	base/gfx/osystem/base_render_osystem.o \
 	base/gfx/osystem/render_ticket.o \
+	base/gfx/osystem/transform_cache.o \
 	base/particles/part_particle.o \
 	base/particles/part_emitter.o \
 	base/particles/part_force.o \
@@ -89,6 +90,7 @@ MODULE_OBJS := \
 	base/save_thumb_helper.o \
 	base/timer.o \
 	detection.o \
+	graphics/blit_kernels.o \
 	graphics/transform_struct.o \
 	graphics/transform_tools.o \
 	graphics/transparent_surface.o \
@@ -73,6 +73,7 @@ WintermuteEngine::WintermuteEngine(OSystem *syst, const ADGameDescription *desc)
 	DebugMan.addDebugChannel(kWintermuteDebugFileAccess, "file-access", "Non-critical problems like missing files");
 	DebugMan.addDebugChannel(kWintermuteDebugAudio, "audio", "audio-playback-related issues");
 	DebugMan.addDebugChannel(kWintermuteDebugGeneral, "general", "various issues not covered by any of the above");
+	DebugMan.addDebugChannel(kWintermuteDebugRender, "render", "Per-frame statistics of the renderer");
 
 	_game = nullptr;
 	_debugger = nullptr;
@@ -22,8 +22,13 @@
 #include "graphics/conversion.h"
 #include "graphics/pixelformat.h"
 
+#include "common/cpudetect.h"
 #include "common/endian.h"
 
+#ifdef SCUMMVM_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Graphics {
 
 // TODO: YUV to RGB conversion function
@@ -95,6 +100,299 @@ inline void crossBlitLogic3BppSource(byte *dst, const byte *src, const uint w, c
 	}
 }
 
+template<typename DstColor, bool backward>
+inline void crossBlitMapLogic(byte *dst, const byte *src, const uint w, const uint h,
+                              const uint32 *map, const uint srcDelta, const uint dstDelta) {
+	for (uint y = 0; y < h; ++y) {
+		for (uint x = 0; x < w; ++x) {
+			*(DstColor *)dst = map[*src];
+
+			if (backward) {
+				src -= 1;
+				dst -= sizeof(DstColor);
+			} else {
+				src += 1;
+				dst += sizeof(DstColor);
+			}
+		}
+
+		if (backward) {
+			src -= srcDelta;
+			dst -= dstDelta;
+		} else {
+			src += srcDelta;
+			dst += dstDelta;
+		}
+	}
+}
+
+#ifdef SCUMMVM_SSE2
+
+#pragma mark --- SSE2 conversion ---
+#pragma mark -
+
+/**
+ * colorToARGB() followed by ARGBToColor() only moves the bits of each
+ * component around, so that it can be done as
+ *
+ *   dstColor = constant | ((srcColor & mask[i]) << leftShift[i]) >> rightShift[i] | ...
+ *
+ * with one term per component, which maps nicely to SIMD instructions.
+ */
+struct FormatConversion {
+	uint32 constant;
+	uint numComponents;
+	uint32 mask[4];
+	uint leftShift[4];
+	uint rightShift[4];
+
+	FormatConversion(const PixelFormat &srcFmt, const PixelFormat &dstFmt) : constant(0), numComponents(0) {
+		addComponent(srcFmt.rShift, srcFmt.rLoss, dstFmt.rShift, dstFmt.rLoss);
+		addComponent(srcFmt.gShift, srcFmt.gLoss, dstFmt.gShift, dstFmt.gLoss);
+		addComponent(srcFmt.bShift, srcFmt.bLoss, dstFmt.bShift, dstFmt.bLoss);
+
+		// Sources without alpha channel are treated as opaque
+		if (srcFmt.aBits() == 0)
+			constant = (0xFF >> dstFmt.aLoss) << dstFmt.aShift;
+		else
+			addComponent(srcFmt.aShift, srcFmt.aLoss, dstFmt.aShift, dstFmt.aLoss);
+	}
+
+	void addComponent(int srcShift, int srcLoss, int dstShift, int dstLoss) {
+		if (srcLoss >= 8 || dstLoss >= 8)
+			return;
+
+		// The lowest bits of the component might not fit into the destination
+		uint32 bits = 0xFF >> srcLoss;
+		if (dstLoss > srcLoss)
+			bits &= ~((1 << (dstLoss - srcLoss)) - 1);
+		if (!bits)
+			return;
+
+		const int shift = dstShift - dstLoss + srcLoss - srcShift;
+		mask[numComponents] = bits << srcShift;
+		leftShift[numComponents] = MAX(shift, 0);
+		rightShift[numComponents] = MAX(-shift, 0);
+		++numComponents;
+	}
+
+	inline uint32 convert(uint32 color) const {
+		uint32 result = constant;
+		for (uint i = 0; i < numComponents; ++i)
+			result |= ((color & mask[i]) << leftShift[i]) >> rightShift[i];
+		return result;
+	}
+};
+
+/** FormatConversion prepared for use with SSE2 registers. */
+struct SSE2Conversion {
+	__m128i constant32, constant16;
+	__m128i mask32[4], mask16[4];
+	__m128i leftShift[4], rightShift[4];
+	uint numComponents;
+
+	SSE2Conversion(const FormatConversion &conv) : numComponents(conv.numComponents) {
+		constant32 = _mm_set1_epi32(conv.constant);
+		constant16 = _mm_set1_epi16((int16)conv.constant);
+		for (uint i = 0; i < numComponents; ++i) {
+			mask32[i] = _mm_set1_epi32(conv.mask[i]);
+			mask16[i] = _mm_set1_epi16((int16)conv.mask[i]);
+			leftShift[i] = _mm_cvtsi32_si128(conv.leftShift[i]);
+			rightShift[i] = _mm_cvtsi32_si128(conv.rightShift[i]);
+		}
+	}
+
+	/** Convert four 32 bit colors, or colors with fewer bits zero-extended to 32 bit. */
+	inline __m128i convert32(__m128i colors) const {
+		__m128i result = constant32;
+		for (uint i = 0; i < numComponents; ++i) {
+			const __m128i component = _mm_and_si128(colors, mask32[i]);
+			result = _mm_or_si128(result, _mm_srl_epi32(_mm_sll_epi32(component, leftShift[i]), rightShift[i]));
+		}
+		return result;
+	}
+
+	/** Convert eight 16 bit colors to 16 bit colors. */
+	inline __m128i convert16(__m128i colors) const {
+		__m128i result = constant16;
+		for (uint i = 0; i < numComponents; ++i) {
+			const __m128i component = _mm_and_si128(colors, mask16[i]);
+			result = _mm_or_si128(result, _mm_srl_epi16(_mm_sll_epi16(component, leftShift[i]), rightShift[i]));
+		}
+		return result;
+	}
+};
+
+/** Load four 3Bpp colors into 32 bit lanes. This reads 16 bytes. */
+inline __m128i load3Bpp(const byte *src) {
+	const __m128i colors = _mm_loadu_si128((const __m128i *)src);
+	const __m128i c0 = _mm_and_si128(colors, _mm_set_epi32(0, 0, 0, 0x00FFFFFF));
+	const __m128i c1 = _mm_and_si128(_mm_slli_si128(colors, 1), _mm_set_epi32(0, 0, 0x00FFFFFF, 0));
+	const __m128i c2 = _mm_and_si128(_mm_slli_si128(colors, 2), _mm_set_epi32(0, 0x00FFFFFF, 0, 0));
+	const __m128i c3 = _mm_and_si128(_mm_slli_si128(colors, 3), _mm_set_epi32(0x00FFFFFF, 0, 0, 0));
+	return _mm_or_si128(_mm_or_si128(c0, c1), _mm_or_si128(c2, c3));
+}
+
+/** Truncate the 32 bit lanes of two registers to 16 bit. */
+inline __m128i pack32To16(__m128i a, __m128i b) {
+	// _mm_packs_epi32 saturates, so sign-extend the lower halves first
+	a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+	b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+	return _mm_packs_epi32(a, b);
+}
+
+/**
+ * Conversion of blocks of kPixels pixels. A block reads the source pixels
+ * of kReadPixels pixels, which is more than kPixels when a register load
+ * goes beyond the block.
+ */
+template<uint srcBpp, uint dstBpp>
+struct SSE2Block;
+
+template<>
+struct SSE2Block<2, 2> {
+	enum { kPixels = 8, kReadPixels = 8 };
+
+	static inline void convert(byte *dst, const byte *src, const SSE2Conversion &conv) {
+		const __m128i colors = _mm_loadu_si128((const __m128i *)src);
+		_mm_storeu_si128((__m128i *)dst, conv.convert16(colors));
+	}
+};
+
+template<>
+struct SSE2Block<2, 4> {
+	enum { kPixels = 8, kReadPixels = 8 };
+
+	static inline void convert(byte *dst, const byte *src, const SSE2Conversion &conv) {
+		const __m128i colors = _mm_loadu_si128((const __m128i *)src);
+		const __m128i zero = _mm_setzero_si128();
+		_mm_storeu_si128((__m128i *)dst, conv.convert32(_mm_unpacklo_epi16(colors, zero)));
+		_mm_storeu_si128((__m128i *)(dst + 16), conv.convert32(_mm_unpackhi_epi16(colors, zero)));
+	}
+};
+
+template<>
+struct SSE2Block<3, 2> {
+	enum { kPixels = 8, kReadPixels = 10 };
+
+	static inline void convert(byte *dst, const byte *src, const SSE2Conversion &conv) {
+		const __m128i a = conv.convert32(load3Bpp(src));
+		const __m128i b = conv.convert32(load3Bpp(src + 12));
+		_mm_storeu_si128((__m128i *)dst, pack32To16(a, b));
+	}
+};
+
+template<>
+struct SSE2Block<3, 4> {
+	enum { kPixels = 4, kReadPixels = 6 };
+
+	static inline void convert(byte *dst, const byte *src, const SSE2Conversion &conv) {
+		_mm_storeu_si128((__m128i *)dst, conv.convert32(load3Bpp(src)));
+	}
+};
+
+template<>
+struct SSE2Block<4, 2> {
+	enum { kPixels = 8, kReadPixels = 8 };
+
+	static inline void convert(byte *dst, const byte *src, const SSE2Conversion &conv) {
+		const __m128i a = conv.convert32(_mm_loadu_si128((const __m128i *)src));
+		const __m128i b = conv.convert32(_mm_loadu_si128((const __m128i *)(src + 16)));
+		_mm_storeu_si128((__m128i *)dst, pack32To16(a, b));
+	}
+};
+
+template<>
+struct SSE2Block<4, 4> {
+	enum { kPixels = 4, kReadPixels = 4 };
+
+	static inline void convert(byte *dst, const byte *src, const SSE2Conversion &conv) {
+		const __m128i colors = _mm_loadu_si128((const __m128i *)src);
+		_mm_storeu_si128((__m128i *)dst, conv.convert32(colors));
+	}
+};
+
+template<uint srcBpp, uint dstBpp>
+inline void convertPixel(byte *dst, const byte *src, const FormatConversion &conv) {
+	uint32 color;
+	if (srcBpp == 2)
+		color = *(const uint16 *)src;
+	else if (srcBpp == 3)
+		color = READ_LE_UINT24(src);
+	else
+		color = *(const uint32 *)src;
+
+	if (dstBpp == 2)
+		*(uint16 *)dst = conv.convert(color);
+	else
+		*(uint32 *)dst = conv.convert(color);
+}
+
+/**
+ * Convert the rows in blocks, and the remaining pixels of each row one
+ * by one. Like crossBlitLogic, this works backwards if the destination
+ * pixels are bigger, so that surfaces can be converted in place.
+ */
+template<uint srcBpp, uint dstBpp, bool backward>
+void crossBlitSSE2Logic(byte *dst, const byte *src, const uint dstPitch, const uint srcPitch,
+                        const uint w, const uint h, const FormatConversion &conv) {
+	typedef SSE2Block<srcBpp, dstBpp> Block;
+	const SSE2Conversion sse2Conv(conv);
+	const uint blocks = (w >= (uint)Block::kReadPixels) ? (w - Block::kReadPixels) / Block::kPixels + 1 : 0;
+	const uint blockWidth = blocks * Block::kPixels;
+
+	for (uint i = 0; i < h; ++i) {
+		const uint y = backward ? h - 1 - i : i;
+		byte *dstRow = dst + y * dstPitch;
+		const byte *srcRow = src + y * srcPitch;
+
+		if (backward) {
+			for (uint x = w; x-- > blockWidth; )
+				convertPixel<srcBpp, dstBpp>(dstRow + x * dstBpp, srcRow + x * srcBpp, conv);
+			for (uint b = blocks; b-- > 0; )
+				Block::convert(dstRow + b * Block::kPixels * dstBpp, srcRow + b * Block::kPixels * srcBpp, sse2Conv);
+		} else {
+			for (uint b = 0; b < blocks; ++b)
+				Block::convert(dstRow + b * Block::kPixels * dstBpp, srcRow + b * Block::kPixels * srcBpp, sse2Conv);
+			for (uint x = blockWidth; x < w; ++x)
+				convertPixel<srcBpp, dstBpp>(dstRow + x * dstBpp, srcRow + x * srcBpp, conv);
+		}
+	}
+}
+
+bool crossBlitSSE2(byte *dst, const byte *src, const uint dstPitch, const uint srcPitch,
+                   const uint w, const uint h, const PixelFormat &dstFmt, const PixelFormat &srcFmt) {
+	if (!Common::hasCPUFeature(Common::kCpuFeatureSSE2))
+		return false;
+
+	const FormatConversion conv(srcFmt, dstFmt);
+
+	switch (srcFmt.bytesPerPixel * 10 + dstFmt.bytesPerPixel) {
+	case 22:
+		crossBlitSSE2Logic<2, 2, false>(dst, src, dstPitch, srcPitch, w, h, conv);
+		return true;
+	case 24:
+		crossBlitSSE2Logic<2, 4, true>(dst, src, dstPitch, srcPitch, w, h, conv);
+		return true;
+	case 32:
+		crossBlitSSE2Logic<3, 2, false>(dst, src, dstPitch, srcPitch, w, h, conv);
+		return true;
+	case 34:
+		crossBlitSSE2Logic<3, 4, true>(dst, src, dstPitch, srcPitch, w, h, conv);
+		return true;
+	case 42:
+		crossBlitSSE2Logic<4, 2, false>(dst, src, dstPitch, srcPitch, w, h, conv);
+		return true;
+	case 44:
+		crossBlitSSE2Logic<4, 4, false>(dst, src, dstPitch, srcPitch, w, h, conv);
+		return true;
+	default:
+		return false;
+	}
+}
+
+#endif // SCUMMVM_SSE2
+
 } // End of anonymous namespace
 
 // Function to blit a rect from one color format to another
@@ -125,6 +423,11 @@ bool crossBlit(byte *dst, const byte *src,
 		return true;
 	}
 
+#ifdef SCUMMVM_SSE2
+	if (crossBlitSSE2(dst, src, dstPitch, srcPitch, w, h, dstFmt, srcFmt))
+		return true;
+#endif
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta = (srcPitch - w * srcFmt.bytesPerPixel);
 	const uint dstDelta = (dstPitch - w * dstFmt.bytesPerPixel);
@@ -166,4 +469,27 @@ bool crossBlit(byte *dst, const byte *src,
 	return true;
 }
 
+bool crossBlitMap(byte *dst, const byte *src,
+                  const uint dstPitch, const uint srcPitch,
+                  const uint w, const uint h,
+                  const uint bytesPerPixel, const uint32 *map) {
+	const uint srcDelta = (srcPitch - w);
+	const uint dstDelta = (dstPitch - w * bytesPerPixel);
+
+	if (bytesPerPixel == 2) {
+		// Blit from bottom right to top left, like crossBlit does, so that
+		// surfaces can be converted in place.
+		dst += h * dstPitch - dstDelta - bytesPerPixel;
+		src += h * srcPitch - srcDelta - 1;
+		crossBlitMapLogic<uint16, true>(dst, src, w, h, map, srcDelta, dstDelta);
+	} else if (bytesPerPixel == 4) {
+		dst += h * dstPitch - dstDelta - bytesPerPixel;
+		src += h * srcPitch - srcDelta - 1;
+		crossBlitMapLogic<uint32, true>(dst, src, w, h, map, srcDelta, dstDelta);
+	} else {
+		return false;
+	}
+	return true;
+}
+
 } // End of namespace Graphics
@@ -66,12 +66,38 @@ inline static void RGB2YUV(byte r, byte g, byte b, byte &y, byte &u, byte &v) {
  *       must at least equal the dstBpp / srcBpp ratio for
  *       dstPitch >= srcPitch and at most dstBpp / srcBpp for
  *       dstPitch < srcPitch though.
+ * @note Conversions between 2Bpp, 3Bpp and 4Bpp formats use SSE2 if the
+ *       CPU supports it. The result is the same as with the plain C++
+ *       code.
  */
 bool crossBlit(byte *dst, const byte *src,
                const uint dstPitch, const uint srcPitch,
                const uint w, const uint h,
                const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt);
 
+/**
+ * Blits a rectangle from a 1Bpp buffer to a 2Bpp or 4Bpp one, replacing
+ * each pixel value by the corresponding entry of a color map.
+ *
+ * @param dstbuf	the buffer which will recieve the converted graphics data
+ * @param srcbuf	the buffer containing the original graphics data
+ * @param dstpitch	width in bytes of one full line of the dest buffer
+ * @param srcpitch	width in bytes of one full line of the source buffer
+ * @param w			the width of the graphics data
+ * @param h			the height of the graphics data
+ * @param bytesPerPixel	the size of a destination pixel
+ * @param map		the colors in the destination format, indexed by the
+ *					source pixel values
+ * @return			true if conversion completes successfully,
+ *					false if there is an error.
+ *
+ * @note Like crossBlit(), this can convert a surface in place.
+ */
+bool crossBlitMap(byte *dst, const byte *src,
+                  const uint dstPitch, const uint srcPitch,
+                  const uint w, const uint h,
+                  const uint bytesPerPixel, const uint32 *map);
+
 } // End of namespace Graphics
 
 #endif // GRAPHICS_CONVERSION_H
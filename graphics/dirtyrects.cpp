@@ -0,0 +1,242 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "graphics/dirtyrects.h"
+#include "common/util.h"
+
+namespace Graphics {
+
+static inline uint countBits(uint32 x) {
+	x = x - ((x >> 1) & 0x55555555);
+	x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+	return (((x + (x >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+/** Return a word with the bits from..to-1 set (0 <= from < to <= 32). */
+static inline uint32 bitRange(int from, int to) {
+	const uint32 high = (to == 32) ? 0xFFFFFFFF : (1U << to) - 1;
+	return high & ~((1U << from) - 1);
+}
+
+DirtyRectTracker::DirtyRectTracker()
+	: _width(0), _height(0), _tilesPerRow(0), _tileRows(0), _wordsPerRow(0), _dirtyTiles(0) {
+}
+
+void DirtyRectTracker::resize(int width, int height) {
+	_width = width;
+	_height = height;
+	_tilesPerRow = (width + kTileSize - 1) >> kTileShift;
+	_tileRows = (height + kTileSize - 1) >> kTileShift;
+	_wordsPerRow = (_tilesPerRow + 31) / 32;
+
+	_bits.resize(_wordsPerRow * _tileRows);
+	// A row has at most one run per two tiles
+	_runs.resize(_tilesPerRow + 2);
+	_open.resize(_tilesPerRow / 2 + 1);
+	_nextOpen.resize(_tilesPerRow / 2 + 1);
+	clear();
+}
+
+void DirtyRectTracker::addRect(const Common::Rect &r) {
+	const int left = MAX<int>(r.left, 0);
+	const int top = MAX<int>(r.top, 0);
+	const int right = MIN<int>(r.right, _width);
+	const int bottom = MIN<int>(r.bottom, _height);
+	if (left >= right || top >= bottom)
+		return;
+
+	const int tx0 = left >> kTileShift;
+	const int tx1 = ((right - 1) >> kTileShift) + 1;
+	const int ty0 = top >> kTileShift;
+	const int ty1 = ((bottom - 1) >> kTileShift) + 1;
+
+	for (int ty = ty0; ty < ty1; ++ty) {
+		uint32 *row = &_bits[ty * _wordsPerRow];
+		for (int word = tx0 / 32; word * 32 < tx1; ++word) {
+			const uint32 mask = bitRange(MAX(tx0 - word * 32, 0), MIN(tx1 - word * 32, 32));
+			_dirtyTiles += countBits(mask & ~row[word]);
+			row[word] |= mask;
+		}
+	}
+}
+
+void DirtyRectTracker::markAll() {
+	addRect(Common::Rect(_width, _height));
+}
+
+void DirtyRectTracker::clear() {
+	for (uint i = 0; i < _bits.size(); ++i)
+		_bits[i] = 0;
+	_dirtyTiles = 0;
+}
+
+uint32 DirtyRectTracker::getDirtyArea() const {
+	if (isEmpty())
+		return 0;
+
+	// Tiles in the last column and row may be cut off
+	uint32 area = 0;
+	for (int ty = 0; ty < _tileRows; ++ty) {
+		const int tileHeight = MIN<int>(kTileSize, _height - ty * kTileSize);
+		for (int word = 0; word < _wordsPerRow; ++word) {
+			const uint32 bits = _bits[ty * _wordsPerRow + word];
+			if (!bits)
+				continue;
+			area += countBits(bits) * kTileSize * tileHeight;
+			const int last = _tilesPerRow - 1;
+			if ((last >> 5) == word && (bits & (1U << (last & 31))))
+				area -= (_tilesPerRow * kTileSize - _width) * tileHeight;
+		}
+	}
+	return area;
+}
+
+int DirtyRectTracker::findRuns(int row, int16 *runs) const {
+	const uint32 *bits = &_bits[row * _wordsPerRow];
+	int numRuns = 0;
+	bool inRun = false;
+
+	for (int word = 0; word < _wordsPerRow; ++word) {
+		const uint32 w = bits[word];
+		// Skip words which don't end or start a run
+		if ((!inRun && w == 0) || (inRun && w == 0xFFFFFFFF))
+			continue;
+
+		const int end = MIN(32, _tilesPerRow - word * 32);
+		for (int i = 0; i < end; ++i) {
+			const bool dirty = (w & (1U << i)) != 0;
+			if (dirty != inRun) {
+				runs[numRuns++] = word * 32 + i;
+				inRun = dirty;
+			}
+		}
+	}
+
+	if (inRun)
+		runs[numRuns++] = _tilesPerRow;
+	return numRuns / 2;
+}
+
+bool DirtyRectTracker::getRowExtent(int row, int &left, int &right) const {
+	const uint32 *bits = &_bits[row * _wordsPerRow];
+	left = -1;
+
+	for (int word = 0; word < _wordsPerRow; ++word) {
+		const uint32 w = bits[word];
+		if (!w)
+			continue;
+		for (int i = 0; i < 32; ++i) {
+			if (w & (1U << i)) {
+				if (left < 0)
+					left = word * 32 + i;
+				right = word * 32 + i + 1;
+			}
+		}
+	}
+
+	return left >= 0;
+}
+
+void DirtyRectTracker::toPixels(Common::Rect &r) const {
+	r.left <<= kTileShift;
+	r.top <<= kTileShift;
+	r.right = MIN<int>(r.right << kTileShift, _width);
+	r.bottom = MIN<int>(r.bottom << kTileShift, _height);
+}
+
+int DirtyRectTracker::getRects(Common::Rect *rects, int maxRects) {
+	if (isEmpty() || maxRects <= 0)
+		return 0;
+
+	// Rectangles (in tile coordinates) are extended downwards as long as
+	// the next row has a run of dirty tiles with the same extent. The
+	// indices of the ones which reach the current row are kept in x order.
+	int *open = _open.begin();
+	int *nextOpen = _nextOpen.begin();
+	int numOpen = 0;
+	int count = 0;
+
+	for (int ty = 0; ty < _tileRows; ++ty) {
+		const int numRuns = findRuns(ty, _runs.begin());
+		int numNextOpen = 0;
+		int o = 0;
+
+		for (int i = 0; i < numRuns; ++i) {
+			const int left = _runs[2 * i];
+			const int right = _runs[2 * i + 1];
+
+			while (o < numOpen && rects[open[o]].left < left)
+				++o;
+
+			int index;
+			if (o < numOpen && rects[open[o]].left == left && rects[open[o]].right == right) {
+				index = open[o++];
+				rects[index].bottom++;
+			} else {
+				if (count == maxRects)
+					return getBands(rects, maxRects);
+				index = count++;
+				rects[index] = Common::Rect(left, ty, right, ty + 1);
+			}
+			nextOpen[numNextOpen++] = index;
+		}
+
+		SWAP(open, nextOpen);
+		numOpen = numNextOpen;
+	}
+
+	for (int i = 0; i < count; ++i)
+		toPixels(rects[i]);
+	return count;
+}
+
+int DirtyRectTracker::getBands(Common::Rect *rects, int maxRects) const {
+	const int bandRows = (_tileRows + maxRects - 1) / maxRects;
+	int count = 0;
+
+	for (int top = 0; top < _tileRows; top += bandRows) {
+		const int bottom = MIN(top + bandRows, _tileRows);
+		int left = _tilesPerRow, right = 0;
+
+		for (int ty = top; ty < bottom; ++ty) {
+			int rowLeft, rowRight;
+			if (getRowExtent(ty, rowLeft, rowRight)) {
+				left = MIN(left, rowLeft);
+				right = MAX(right, rowRight);
+			}
+		}
+
+		if (left >= right)
+			continue;
+
+		if (count > 0 && rects[count - 1].bottom == top && rects[count - 1].left == left && rects[count - 1].right == right)
+			rects[count - 1].bottom = bottom;
+		else
+			rects[count++] = Common::Rect(left, top, right, bottom);
+	}
+
+	for (int i = 0; i < count; ++i)
+		toPixels(rects[i]);
+	return count;
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,109 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef GRAPHICS_DIRTYRECTS_H
+#define GRAPHICS_DIRTYRECTS_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Graphics {
+
+/**
+ * Keeps track of the parts of a screen which have to be redrawn.
+ *
+ * The screen is divided into square tiles, and each rectangle added marks
+ * the tiles it touches. Any number of rectangles can be added, and
+ * overlapping ones cost nothing extra. When the screen is drawn, the dirty
+ * tiles are combined into a limited number of rectangles again.
+ */
+class DirtyRectTracker {
+public:
+	enum {
+		kTileShift = 3,
+		kTileSize = 1 << kTileShift
+	};
+
+	DirtyRectTracker();
+
+	/**
+	 * Set the size of the tracked area. This clears all dirty tiles.
+	 */
+	void resize(int width, int height);
+
+	int getWidth() const { return _width; }
+	int getHeight() const { return _height; }
+
+	/**
+	 * Mark the tiles touched by the given rectangle as dirty. The rectangle
+	 * is clipped to the tracked area.
+	 */
+	void addRect(const Common::Rect &r);
+
+	/** Mark the whole area as dirty. */
+	void markAll();
+
+	/** Mark all tiles as clean. */
+	void clear();
+
+	/** Return true if no tile is dirty. */
+	bool isEmpty() const { return _dirtyTiles == 0; }
+
+	/** Return the number of pixels in the dirty tiles. */
+	uint32 getDirtyArea() const;
+
+	/**
+	 * Combine the dirty tiles into at most maxRects rectangles, which cover
+	 * all dirty tiles and don't overlap. Adjacent dirty tiles in a row are
+	 * joined, and so are equally wide runs of tiles in consecutive rows.
+	 * If this needs more than maxRects rectangles, the rows are merged into
+	 * bands of the width of their dirty tiles instead, so that the result
+	 * always fits. The rectangles are clipped to the tracked area.
+	 *
+	 * @return the number of rectangles stored in rects
+	 */
+	int getRects(Common::Rect *rects, int maxRects);
+
+private:
+	/** Store the runs of dirty tiles in a row as tile coordinates, return their number. */
+	int findRuns(int row, int16 *runs) const;
+	/** Whether any tile in the row is dirty; returns the extent of the dirty tiles. */
+	bool getRowExtent(int row, int &left, int &right) const;
+	int getBands(Common::Rect *rects, int maxRects) const;
+	void toPixels(Common::Rect &r) const;
+
+	int _width, _height;
+	int _tilesPerRow, _tileRows;
+	int _wordsPerRow;
+	uint32 _dirtyTiles;
+
+	/** One bit per tile, row by row */
+	Common::Array<uint32> _bits;
+	/** Scratch space for getRects() */
+	Common::Array<int16> _runs;
+	Common::Array<int> _open, _nextOpen;
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -3,6 +3,7 @@ MODULE := graphics
 MODULE_OBJS := \
 	conversion.o \
 	cursorman.o \
+	dirtyrects.o \
 	font.o \
 	fontman.o \
 	fonts/bdf.o \
@@ -14,9 +15,11 @@ MODULE_OBJS := \
 	maccursor.o \
 	primitives.o \
 	scaler.o \
+	scaler/parallel.o \
 	scaler/thumbnail_intern.o \
 	sjis.o \
 	surface.o \
+	surface_pool.o \
 	thumbnail.o \
 	VectorRenderer.o \
 	VectorRendererSpec.o \
@@ -49,7 +52,8 @@ endif
 ifdef USE_HQ_SCALERS
 MODULE_OBJS += \
 	scaler/hq2x.o \
-	scaler/hq3x.o
+	scaler/hq3x.o \
+	scaler/hq_patterns.o
 
 ifdef USE_NASM
 MODULE_OBJS += \
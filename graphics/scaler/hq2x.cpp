@@ -21,6 +21,9 @@
  */
 
 #include "graphics/scaler/intern.h"
+#include "graphics/scaler/hq_patterns.h"
+#include "common/cpudetect.h"
+#include "common/util.h"
 
 #ifdef USE_NASM
 // Assembly version of HQ2x
@@ -95,16 +98,27 @@ void HQ2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 
 extern "C" uint32   *RGBtoYUV;
 #define YUV(x)	RGBtoYUV[w ## x]
+#define DIFF(a, b)	(precomputed ? (pattern & Graphics::kHQDiff ## a ## b) : diffYUV(YUV(a), YUV(b)))
+
+enum {
+	kPatternChunkSize = 256
+};
 
 /*
  * The HQ2x high quality 2x graphics filter.
  * Original author Maxim Stepin (see http://www.hiend3d.com/hq2x.html).
  * Adapted for ScummVM to 16 bit output and optimized by Max Horn.
+ *
+ * If precomputed is set, the patterns are determined in chunks by the
+ * (SIMD) classify function. Otherwise, they are computed on the fly.
  */
-template<typename ColorMask>
-static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
+template<typename ColorMask, bool precomputed>
+static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, Graphics::HQPatternProc classify) {
 	register int w1, w2, w3, w4, w5, w6, w7, w8, w9;
 
+	uint16 patterns[kPatternChunkSize];
+	const uint16 *nextPattern = patterns;
+
 	const uint32 nextlineSrc = srcPitch / sizeof(uint16);
 	const uint16 *p = (const uint16 *)srcPtr;
 
@@ -132,7 +146,15 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 		w8 = *(p + nextlineSrc);
 
 		int tmpWidth = width;
+		int chunkLeft = 0;
 		while (tmpWidth--) {
+			if (precomputed && chunkLeft == 0) {
+				chunkLeft = MIN<int>(tmpWidth + 1, kPatternChunkSize);
+				classify(p, nextlineSrc, patterns, chunkLeft);
+				nextPattern = patterns;
+			}
+			chunkLeft--;
+
 			p++;
 
 			w3 = *(p - nextlineSrc);
@@ -140,17 +162,21 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			w9 = *(p + nextlineSrc);
 
 			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
+			if (precomputed) {
+				pattern = *nextPattern++;
+			} else {
+				const int yuv5 = YUV(5);
+				if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
+				if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
+				if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
+				if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
+				if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
+				if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
+				if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
+				if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
+			}
 
-			switch (pattern) {
+			switch (pattern & Graphics::kHQPatternMask) {
 			case 0:
 			case 1:
 			case 4:
@@ -283,7 +309,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 18:
 			case 50:
 				PIXEL00_22
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_20
@@ -296,7 +322,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL00_20
 				PIXEL01_22
 				PIXEL10_21
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_20
@@ -306,7 +332,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 76:
 				PIXEL00_21
 				PIXEL01_20
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_20
@@ -315,7 +341,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 10:
 			case 138:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_20
@@ -371,7 +397,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 22:
 			case 54:
 				PIXEL00_22
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
@@ -384,7 +410,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL00_20
 				PIXEL01_22
 				PIXEL10_21
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
@@ -394,7 +420,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 108:
 				PIXEL00_21
 				PIXEL01_20
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
@@ -403,7 +429,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 11:
 			case 139:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
@@ -414,7 +440,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 19:
 			case 51:
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL00_11
 					PIXEL01_10
 				} else {
@@ -427,7 +453,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 146:
 			case 178:
 				PIXEL00_22
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 					PIXEL11_12
 				} else {
@@ -439,7 +465,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 84:
 			case 85:
 				PIXEL00_20
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL01_11
 					PIXEL11_10
 				} else {
@@ -452,7 +478,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 113:
 				PIXEL00_20
 				PIXEL01_22
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL10_12
 					PIXEL11_10
 				} else {
@@ -464,7 +490,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 204:
 				PIXEL00_21
 				PIXEL01_20
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 					PIXEL11_11
 				} else {
@@ -474,7 +500,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 73:
 			case 77:
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL00_12
 					PIXEL10_10
 				} else {
@@ -486,7 +512,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 42:
 			case 170:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 					PIXEL10_11
 				} else {
@@ -498,7 +524,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 14:
 			case 142:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 					PIXEL01_12
 				} else {
@@ -558,12 +584,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 26:
 			case 31:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
@@ -574,13 +600,13 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 82:
 			case 214:
 				PIXEL00_22
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
 				}
 				PIXEL10_21
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
@@ -590,12 +616,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 248:
 				PIXEL00_21
 				PIXEL01_22
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
@@ -603,13 +629,13 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 74:
 			case 107:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
 				}
 				PIXEL01_21
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
@@ -617,7 +643,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_22
 				break;
 			case 27:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
@@ -628,7 +654,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 86:
 				PIXEL00_22
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
@@ -640,7 +666,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL00_21
 				PIXEL01_22
 				PIXEL10_10
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
@@ -649,7 +675,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 106:
 				PIXEL00_10
 				PIXEL01_21
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
@@ -658,7 +684,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 30:
 				PIXEL00_10
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
@@ -670,7 +696,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL00_22
 				PIXEL01_10
 				PIXEL10_21
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
@@ -679,7 +705,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 120:
 				PIXEL00_21
 				PIXEL01_22
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
@@ -687,7 +713,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_10
 				break;
 			case 75:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
@@ -769,12 +795,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_12
 				break;
 			case 58:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
@@ -784,13 +810,13 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 83:
 				PIXEL00_11
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
 				}
 				PIXEL10_21
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
@@ -799,25 +825,25 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 92:
 				PIXEL00_21
 				PIXEL01_11
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
 				}
 				break;
 			case 202:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
 				}
 				PIXEL01_21
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
@@ -825,13 +851,13 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_11
 				break;
 			case 78:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
 				}
 				PIXEL01_12
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
@@ -839,12 +865,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_22
 				break;
 			case 154:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
@@ -854,13 +880,13 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 114:
 				PIXEL00_22
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
 				}
 				PIXEL10_12
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
@@ -869,34 +895,34 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 89:
 				PIXEL00_12
 				PIXEL01_22
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
 				}
 				break;
 			case 90:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
 				}
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
@@ -904,7 +930,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 55:
 			case 23:
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL00_11
 					PIXEL01_0
 				} else {
@@ -917,7 +943,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 182:
 			case 150:
 				PIXEL00_22
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 					PIXEL11_12
 				} else {
@@ -929,7 +955,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 213:
 			case 212:
 				PIXEL00_20
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL01_11
 					PIXEL11_0
 				} else {
@@ -942,7 +968,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 240:
 				PIXEL00_20
 				PIXEL01_22
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL10_12
 					PIXEL11_0
 				} else {
@@ -954,7 +980,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 232:
 				PIXEL00_21
 				PIXEL01_20
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 					PIXEL11_11
 				} else {
@@ -964,7 +990,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 109:
 			case 105:
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL00_12
 					PIXEL10_0
 				} else {
@@ -976,7 +1002,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 171:
 			case 43:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 					PIXEL10_11
 				} else {
@@ -988,7 +1014,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 143:
 			case 15:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 					PIXEL01_12
 				} else {
@@ -1001,7 +1027,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 124:
 				PIXEL00_21
 				PIXEL01_11
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
@@ -1009,7 +1035,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_10
 				break;
 			case 203:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
@@ -1020,7 +1046,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 62:
 				PIXEL00_10
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
@@ -1032,7 +1058,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL00_11
 				PIXEL01_10
 				PIXEL10_21
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
@@ -1040,7 +1066,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 118:
 				PIXEL00_22
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
@@ -1052,7 +1078,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL00_12
 				PIXEL01_22
 				PIXEL10_10
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
@@ -1061,7 +1087,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 110:
 				PIXEL00_10
 				PIXEL01_12
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
@@ -1069,7 +1095,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_22
 				break;
 			case 155:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
@@ -1129,24 +1155,24 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 220:
 				PIXEL00_21
 				PIXEL01_11
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
 				}
 				break;
 			case 158:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
@@ -1155,13 +1181,13 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_12
 				break;
 			case 234:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
 				}
 				PIXEL01_21
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
@@ -1170,25 +1196,25 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 242:
 				PIXEL00_22
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
 				}
 				PIXEL10_12
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
 				}
 				break;
 			case 59:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
@@ -1199,12 +1225,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 121:
 				PIXEL00_12
 				PIXEL01_22
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
@@ -1212,26 +1238,26 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 87:
 				PIXEL00_11
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
 				}
 				PIXEL10_21
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
 				}
 				break;
 			case 79:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
 				}
 				PIXEL01_12
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
@@ -1239,88 +1265,88 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_22
 				break;
 			case 122:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
 				}
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
 				}
 				break;
 			case 94:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
 				}
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
 				}
 				break;
 			case 218:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
 				}
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
 				}
 				break;
 			case 91:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
 				}
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
@@ -1351,12 +1377,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_12
 				break;
 			case 186:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
@@ -1366,13 +1392,13 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 115:
 				PIXEL00_11
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
 				}
 				PIXEL10_12
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
@@ -1381,25 +1407,25 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 93:
 				PIXEL00_12
 				PIXEL01_11
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
 				}
 				break;
 			case 206:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
 				}
 				PIXEL01_12
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
@@ -1410,7 +1436,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 201:
 				PIXEL00_12
 				PIXEL01_20
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_10
 				} else {
 					PIXEL10_70
@@ -1419,7 +1445,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 174:
 			case 46:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_10
 				} else {
 					PIXEL00_70
@@ -1431,7 +1457,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 179:
 			case 147:
 				PIXEL00_11
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_10
 				} else {
 					PIXEL01_70
@@ -1444,7 +1470,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL00_20
 				PIXEL01_11
 				PIXEL10_12
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_10
 				} else {
 					PIXEL11_70
@@ -1464,12 +1490,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 126:
 				PIXEL00_10
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
 				}
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
@@ -1477,21 +1503,21 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_10
 				break;
 			case 219:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
 				}
 				PIXEL01_10
 				PIXEL10_10
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
 				}
 				break;
 			case 125:
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL00_12
 					PIXEL10_0
 				} else {
@@ -1503,7 +1529,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 221:
 				PIXEL00_12
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL01_11
 					PIXEL11_0
 				} else {
@@ -1513,7 +1539,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL10_10
 				break;
 			case 207:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 					PIXEL01_12
 				} else {
@@ -1526,7 +1552,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 238:
 				PIXEL00_10
 				PIXEL01_12
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 					PIXEL11_11
 				} else {
@@ -1536,7 +1562,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 190:
 				PIXEL00_10
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 					PIXEL11_12
 				} else {
@@ -1546,7 +1572,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL10_11
 				break;
 			case 187:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 					PIXEL10_11
 				} else {
@@ -1559,7 +1585,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 243:
 				PIXEL00_11
 				PIXEL01_10
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL10_12
 					PIXEL11_0
 				} else {
@@ -1568,7 +1594,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				}
 				break;
 			case 119:
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL00_11
 					PIXEL01_0
 				} else {
@@ -1582,7 +1608,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 233:
 				PIXEL00_12
 				PIXEL01_20
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_100
@@ -1591,7 +1617,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 175:
 			case 47:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_100
@@ -1603,7 +1629,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 183:
 			case 151:
 				PIXEL00_11
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_100
@@ -1616,7 +1642,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL00_20
 				PIXEL01_11
 				PIXEL10_12
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_100
@@ -1625,25 +1651,25 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 250:
 				PIXEL00_10
 				PIXEL01_10
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
 				}
 				break;
 			case 123:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
 				}
 				PIXEL01_10
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
@@ -1651,12 +1677,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_10
 				break;
 			case 95:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
@@ -1666,13 +1692,13 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 222:
 				PIXEL00_10
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
 				}
 				PIXEL10_10
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
@@ -1681,12 +1707,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 252:
 				PIXEL00_21
 				PIXEL01_11
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_100
@@ -1695,25 +1721,25 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 249:
 				PIXEL00_12
 				PIXEL01_22
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_100
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
 				}
 				break;
 			case 235:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
 				}
 				PIXEL01_21
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_100
@@ -1721,13 +1747,13 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_11
 				break;
 			case 111:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_100
 				}
 				PIXEL01_12
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
@@ -1735,12 +1761,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_22
 				break;
 			case 63:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_100
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
@@ -1749,12 +1775,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_21
 				break;
 			case 159:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_100
@@ -1764,13 +1790,13 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 215:
 				PIXEL00_11
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_100
 				}
 				PIXEL10_21
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
@@ -1778,13 +1804,13 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 246:
 				PIXEL00_22
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
 				}
 				PIXEL10_12
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_100
@@ -1792,17 +1818,17 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 254:
 				PIXEL00_10
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
 				}
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_100
@@ -1811,43 +1837,43 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			case 253:
 				PIXEL00_12
 				PIXEL01_11
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_100
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_100
 				}
 				break;
 			case 251:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
 				}
 				PIXEL01_10
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_100
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
 				}
 				break;
 			case 239:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_100
 				}
 				PIXEL01_12
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_100
@@ -1855,17 +1881,17 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_11
 				break;
 			case 127:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_100
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_20
 				}
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_20
@@ -1873,12 +1899,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_10
 				break;
 			case 191:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_100
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_100
@@ -1887,18 +1913,18 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				PIXEL11_12
 				break;
 			case 223:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_20
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_100
 				}
 				PIXEL10_10
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_20
@@ -1906,35 +1932,35 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			case 247:
 				PIXEL00_11
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_100
 				}
 				PIXEL10_12
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_100
 				}
 				break;
 			case 255:
-				if (diffYUV(YUV(4), YUV(2))) {
+				if (DIFF(4, 2)) {
 					PIXEL00_0
 				} else {
 					PIXEL00_100
 				}
-				if (diffYUV(YUV(2), YUV(6))) {
+				if (DIFF(2, 6)) {
 					PIXEL01_0
 				} else {
 					PIXEL01_100
 				}
-				if (diffYUV(YUV(8), YUV(4))) {
+				if (DIFF(8, 4)) {
 					PIXEL10_0
 				} else {
 					PIXEL10_100
 				}
-				if (diffYUV(YUV(6), YUV(8))) {
+				if (DIFF(6, 8)) {
 					PIXEL11_0
 				} else {
 					PIXEL11_100
@@ -1959,10 +1985,21 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 
 void HQ2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
 	extern int gBitFormat;
+#ifdef SCUMMVM_SSE2
+	// Only instantiate the precomputed variants if there is SIMD code
+	const Graphics::HQPatternProc classify = Graphics::getHQPatternProc();
+	if (classify) {
+		if (gBitFormat == 565)
+			HQ2x_implementation<Graphics::ColorMasks<565>, true>(srcPtr, srcPitch, dstPtr, dstPitch, width, height, classify);
+		else
+			HQ2x_implementation<Graphics::ColorMasks<555>, true>(srcPtr, srcPitch, dstPtr, dstPitch, width, height, classify);
+		return;
+	}
+#endif
 	if (gBitFormat == 565)
-		HQ2x_implementation<Graphics::ColorMasks<565> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+		HQ2x_implementation<Graphics::ColorMasks<565>, false>(srcPtr, srcPitch, dstPtr, dstPitch, width, height, 0);
 	else
-		HQ2x_implementation<Graphics::ColorMasks<555> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+		HQ2x_implementation<Graphics::ColorMasks<555>, false>(srcPtr, srcPitch, dstPtr, dstPitch, width, height, 0);
 }
 
 #endif // Assembly version
@@ -0,0 +1,237 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "graphics/scaler/hq_patterns.h"
+#include "graphics/scaler/intern.h"
+#include "common/cpudetect.h"
+#include "common/util.h"
+
+#ifdef SCUMMVM_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifndef USE_NASM
+
+extern "C" uint32 *RGBtoYUV;
+extern int gBitFormat;
+
+namespace Graphics {
+
+#define YUV(x)	RGBtoYUV[w ## x]
+#define DIFF(a, b)	(w ## a != w ## b && diffYUV(YUV(a), YUV(b)))
+
+void classifyHQPatterns(const uint16 *p, uint32 nextline, uint16 *patterns, int width) {
+	int w1, w2, w3, w4, w5, w6, w7, w8, w9;
+
+	w1 = *(p - 1 - nextline);
+	w4 = *(p - 1);
+	w7 = *(p - 1 + nextline);
+
+	w2 = *(p - nextline);
+	w5 = *(p);
+	w8 = *(p + nextline);
+
+	for (int i = 0; i < width; ++i) {
+		p++;
+
+		w3 = *(p - nextline);
+		w6 = *(p);
+		w9 = *(p + nextline);
+
+		int pattern = 0;
+		const int yuv5 = YUV(5);
+		if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
+		if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
+		if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
+		if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
+		if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
+		if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
+		if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
+		if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
+
+		if (DIFF(4, 2)) pattern |= kHQDiff42;
+		if (DIFF(2, 6)) pattern |= kHQDiff26;
+		if (DIFF(6, 8)) pattern |= kHQDiff68;
+		if (DIFF(8, 4)) pattern |= kHQDiff84;
+
+		patterns[i] = pattern;
+
+		w1 = w2;
+		w4 = w5;
+		w7 = w8;
+
+		w2 = w3;
+		w5 = w6;
+		w8 = w9;
+	}
+}
+
+#undef DIFF
+#undef YUV
+
+#ifdef SCUMMVM_SSE2
+
+// The SSE2 classifier does not use the RGBtoYUV table. It computes the
+// same values as InitLUT() does:
+//   Y = (r + g + b) >> 2
+//   U = 128 + ((r - b) >> 2)
+//   V = 128 + ((-r + 2 * g - b) >> 3)
+// where r, g and b are the color components shifted up to 8 bits without
+// replicating the low bits (see PixelFormat::colorToRGB()). All three
+// components fit into an unsigned byte, so diffYUV() boils down to
+// comparing the absolute byte differences against the thresholds, which
+// can be done for 16 pixels at once.
+
+enum {
+	kBlockSize = 256
+};
+
+/** The Y, U and V planes of a block of pixels and one pixel around it. */
+struct YUVPlanes {
+	uint8 y[kBlockSize + 2];
+	uint8 u[kBlockSize + 2];
+	uint8 v[kBlockSize + 2];
+};
+
+struct YUVVector {
+	__m128i y, u, v;
+};
+
+/** Convert the colors src[-1] to src[width] to YUV planes. */
+template<int bitFormat>
+static void convertToYUV(const uint16 *src, YUVPlanes &planes, int width) {
+	const __m128i mask5 = _mm_set1_epi16(0xF8);
+	const __m128i offset = _mm_set1_epi16(128);
+
+	for (int x = -1; x <= width; x += 8) {
+		// The last group overlaps the previous one, so that nothing after
+		// src[width] is read
+		const int pos = MIN(x, width - 7);
+		const __m128i c = _mm_loadu_si128((const __m128i *)(src + pos));
+		__m128i r, g, b;
+
+		if (bitFormat == 565) {
+			r = _mm_and_si128(_mm_srli_epi16(c, 8), mask5);
+			g = _mm_and_si128(_mm_srli_epi16(c, 3), _mm_set1_epi16(0xFC));
+		} else {
+			r = _mm_and_si128(_mm_srli_epi16(c, 7), mask5);
+			g = _mm_and_si128(_mm_srli_epi16(c, 2), mask5);
+		}
+		b = _mm_and_si128(_mm_slli_epi16(c, 3), mask5);
+
+		const __m128i rb = _mm_add_epi16(r, b);
+		const __m128i y = _mm_srli_epi16(_mm_add_epi16(rb, g), 2);
+		const __m128i u = _mm_add_epi16(_mm_srai_epi16(_mm_sub_epi16(r, b), 2), offset);
+		const __m128i v = _mm_add_epi16(_mm_srai_epi16(_mm_sub_epi16(_mm_add_epi16(g, g), rb), 3), offset);
+
+		_mm_storel_epi64((__m128i *)(planes.y + pos + 1), _mm_packus_epi16(y, y));
+		_mm_storel_epi64((__m128i *)(planes.u + pos + 1), _mm_packus_epi16(u, u));
+		_mm_storel_epi64((__m128i *)(planes.v + pos + 1), _mm_packus_epi16(v, v));
+	}
+}
+
+static inline YUVVector loadYUV(const YUVPlanes &planes, int x) {
+	YUVVector yuv;
+	yuv.y = _mm_loadu_si128((const __m128i *)(planes.y + x + 1));
+	yuv.u = _mm_loadu_si128((const __m128i *)(planes.u + x + 1));
+	yuv.v = _mm_loadu_si128((const __m128i *)(planes.v + x + 1));
+	return yuv;
+}
+
+static inline __m128i absDiff(__m128i a, __m128i b) {
+	return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+}
+
+/** Return 'bit' in every byte in which the two colors differ visibly. */
+static inline __m128i diffYUVBit(const YUVVector &a, const YUVVector &b, int bit) {
+	__m128i diff = _mm_subs_epu8(absDiff(a.y, b.y), _mm_set1_epi8(0x30));
+	diff = _mm_or_si128(diff, _mm_subs_epu8(absDiff(a.u, b.u), _mm_set1_epi8(0x07)));
+	diff = _mm_or_si128(diff, _mm_subs_epu8(absDiff(a.v, b.v), _mm_set1_epi8(0x06)));
+	return _mm_andnot_si128(_mm_cmpeq_epi8(diff, _mm_setzero_si128()), _mm_set1_epi8(bit));
+}
+
+template<int bitFormat>
+static void classifySSE2(const uint16 *p, uint32 nextline, uint16 *patterns, int width) {
+	YUVPlanes above, current, below;
+
+	while (width >= 16) {
+		const int blockWidth = MIN<int>(width, kBlockSize) & ~15;
+
+		convertToYUV<bitFormat>(p - nextline, above, blockWidth);
+		convertToYUV<bitFormat>(p, current, blockWidth);
+		convertToYUV<bitFormat>(p + nextline, below, blockWidth);
+
+		for (int x = 0; x < blockWidth; x += 16) {
+			const YUVVector w1 = loadYUV(above, x - 1);
+			const YUVVector w2 = loadYUV(above, x);
+			const YUVVector w3 = loadYUV(above, x + 1);
+			const YUVVector w4 = loadYUV(current, x - 1);
+			const YUVVector w5 = loadYUV(current, x);
+			const YUVVector w6 = loadYUV(current, x + 1);
+			const YUVVector w7 = loadYUV(below, x - 1);
+			const YUVVector w8 = loadYUV(below, x);
+			const YUVVector w9 = loadYUV(below, x + 1);
+
+			__m128i low = diffYUVBit(w5, w1, 0x01);
+			low = _mm_or_si128(low, diffYUVBit(w5, w2, 0x02));
+			low = _mm_or_si128(low, diffYUVBit(w5, w3, 0x04));
+			low = _mm_or_si128(low, diffYUVBit(w5, w4, 0x08));
+			low = _mm_or_si128(low, diffYUVBit(w5, w6, 0x10));
+			low = _mm_or_si128(low, diffYUVBit(w5, w7, 0x20));
+			low = _mm_or_si128(low, diffYUVBit(w5, w8, 0x40));
+			low = _mm_or_si128(low, diffYUVBit(w5, w9, 0x80));
+
+			__m128i high = diffYUVBit(w4, w2, kHQDiff42 >> 8);
+			high = _mm_or_si128(high, diffYUVBit(w2, w6, kHQDiff26 >> 8));
+			high = _mm_or_si128(high, diffYUVBit(w6, w8, kHQDiff68 >> 8));
+			high = _mm_or_si128(high, diffYUVBit(w8, w4, kHQDiff84 >> 8));
+
+			_mm_storeu_si128((__m128i *)(patterns + x), _mm_unpacklo_epi8(low, high));
+			_mm_storeu_si128((__m128i *)(patterns + x + 8), _mm_unpackhi_epi8(low, high));
+		}
+
+		p += blockWidth;
+		patterns += blockWidth;
+		width -= blockWidth;
+	}
+
+	if (width > 0)
+		classifyHQPatterns(p, nextline, patterns, width);
+}
+
+#endif
+
+HQPatternProc getHQPatternProc() {
+#ifdef SCUMMVM_SSE2
+	if (Common::hasCPUFeature(Common::kCpuFeatureSSE2)) {
+		if (gBitFormat == 565)
+			return classifySSE2<565>;
+		else if (gBitFormat == 555)
+			return classifySSE2<555>;
+	}
+#endif
+	return 0;
+}
+
+} // End of namespace Graphics
+
+#endif // !USE_NASM
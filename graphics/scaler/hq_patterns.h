@@ -0,0 +1,85 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef GRAPHICS_SCALER_HQ_PATTERNS_H
+#define GRAPHICS_SCALER_HQ_PATTERNS_H
+
+#include "common/scummsys.h"
+
+namespace Graphics {
+
+/**
+ * The HQnx scalers decide how to interpolate a pixel by looking at which of
+ * its eight neighbours differ visibly (in the sense of diffYUV()) from it:
+ *
+ *	 +----+----+----+
+ *	 | w1 | w2 | w3 |
+ *	 +----+----+----+
+ *	 | w4 | w5 | w6 |
+ *	 +----+----+----+
+ *	 | w7 | w8 | w9 |
+ *	 +----+----+----+
+ *
+ * The low byte of a pattern has bit 0 set if w1 differs from w5, bit 1 if
+ * w2 differs from w5, and so on up to bit 7 for w9. The remaining flags
+ * tell whether the edge neighbours differ from each other, which some of
+ * the interpolation rules depend on.
+ */
+enum {
+	kHQPatternMask = 0x00FF,
+	kHQDiff42      = 0x0100,
+	kHQDiff26      = 0x0200,
+	kHQDiff68      = 0x0400,
+	kHQDiff84      = 0x0800
+};
+
+/**
+ * Compute the patterns of 'width' consecutive pixels of a 16 bit surface.
+ * Like the scalers themselves, this reads one pixel around the row, i.e.
+ * src[-1 - pitch] to src[width + pitch].
+ *
+ * @param src       the first pixel of the row
+ * @param pitch     the distance between two rows, in pixels
+ * @param patterns  receives one pattern per pixel
+ * @param width     the number of pixels to classify
+ */
+typedef void (*HQPatternProc)(const uint16 *src, uint32 pitch, uint16 *patterns, int width);
+
+/**
+ * The plain C++ pattern classifier, based on the RGBtoYUV table.
+ */
+void classifyHQPatterns(const uint16 *src, uint32 pitch, uint16 *patterns, int width);
+
+/**
+ * Return a SIMD pattern classifier for the current gBitFormat, taking
+ * features disabled with Common::setDisabledCPUFeatures() into account. It
+ * produces the same result as classifyHQPatterns().
+ *
+ * Returns 0 if the CPU or the pixel format is not supported. The scalers
+ * then compute the patterns while scaling, as that is faster than calling
+ * classifyHQPatterns() up front.
+ */
+HQPatternProc getHQPatternProc();
+
+} // End of namespace Graphics
+
+#endif
@@ -0,0 +1,65 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "graphics/scaler/parallel.h"
+#include "common/util.h"
+
+namespace Graphics {
+
+ParallelScaler::ParallelScaler(uint numThreads)
+	: _pool(MIN<uint>(numThreads, kMaxThreads)) {
+}
+
+void ParallelScaler::scaleBand(void *param) {
+	const Band &band = *(const Band *)param;
+	band.scaler(band.srcPtr, band.srcPitch, band.dstPtr, band.dstPitch, band.width, band.height);
+}
+
+void ParallelScaler::scale(ScalerProc *scaler, int scaleFactor, const uint8 *srcPtr, uint32 srcPitch,
+							uint8 *dstPtr, uint32 dstPitch, int width, int height) {
+	const int numBands = MIN<int>(getThreadCount() + 1, height / kMinBandHeight);
+	if (numBands <= 1) {
+		scaler(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+		return;
+	}
+
+	const int bandHeight = (height / numBands) & ~3;
+	for (int i = 0; i < numBands; ++i) {
+		Band &band = _bands[i];
+		band.scaler = scaler;
+		band.srcPtr = srcPtr + i * bandHeight * srcPitch;
+		band.srcPitch = srcPitch;
+		band.dstPtr = dstPtr + i * bandHeight * scaleFactor * dstPitch;
+		band.dstPitch = dstPitch;
+		band.width = width;
+		band.height = (i == numBands - 1) ? height - i * bandHeight : bandHeight;
+	}
+
+	// Hand out all bands but the first, which this thread scales itself
+	for (int i = 1; i < numBands; ++i)
+		_pool.addJob(scaleBand, &_bands[i]);
+	scaleBand(&_bands[0]);
+
+	_pool.waitForJobs();
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,94 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef GRAPHICS_SCALER_PARALLEL_H
+#define GRAPHICS_SCALER_PARALLEL_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+#include "common/threadpool.h"
+#include "graphics/scaler.h"
+
+namespace Graphics {
+
+/**
+ * Runs a ScalerProc on horizontal bands of a rectangle concurrently, using
+ * a pool of worker threads.
+ *
+ * Scalers look at the pixels around each source pixel, so every band also
+ * reads the source row above and below it. These belong to the neighbouring
+ * bands (or to the border around the rectangle, which the caller has to
+ * provide anyway). The source is only read, and the destination rows of the
+ * bands don't overlap, so the bands can be scaled independently and the
+ * result is identical to scaling the whole rectangle at once.
+ */
+class ParallelScaler : Common::NonCopyable {
+public:
+	enum {
+		kMaxThreads = 15,
+		/**
+		 * Rectangles are only split into bands of at least this many
+		 * source rows. The band height is always a multiple of 4, so that
+		 * scalers with row patterns (like DotMatrix) are not affected.
+		 */
+		kMinBandHeight = 16
+	};
+
+	/**
+	 * Create a scaler using the given number of worker threads (at most
+	 * kMaxThreads). The calling thread scales one band itself, so with 0
+	 * threads, everything runs serially.
+	 */
+	explicit ParallelScaler(uint numThreads);
+
+	/** Return the number of worker threads actually started. */
+	uint getThreadCount() const { return _pool.getThreadCount(); }
+
+	/**
+	 * Scale a rectangle, with the same parameters as the ScalerProc, and
+	 * wait until it is done.
+	 *
+	 * @param scaleFactor	the number of destination rows per source row
+	 */
+	void scale(ScalerProc *scaler, int scaleFactor, const uint8 *srcPtr, uint32 srcPitch,
+				uint8 *dstPtr, uint32 dstPitch, int width, int height);
+
+private:
+	struct Band {
+		ScalerProc *scaler;
+		const uint8 *srcPtr;
+		uint32 srcPitch;
+		uint8 *dstPtr;
+		uint32 dstPitch;
+		int width;
+		int height;
+	};
+
+	static void scaleBand(void *param);
+
+	Common::ThreadPool _pool;
+	Band _bands[kMaxThreads + 1];
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -0,0 +1,75 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "graphics/surface_pool.h"
+#include "graphics/surface.h"
+
+namespace Graphics {
+
+SurfacePool::~SurfacePool() {
+	clear();
+}
+
+Surface *SurfacePool::acquire(uint16 width, uint16 height, const PixelFormat &format) {
+	// Prefer the most recently released surface, its memory is most likely
+	// still in the cache
+	for (int i = (int)_free.size() - 1; i >= 0; i--) {
+		Surface *surface = _free[i];
+
+		if (surface->w == width && surface->h == height && surface->format == format) {
+			_free.remove_at(i);
+			return surface;
+		}
+	}
+
+	// If there is no match, recycle the oldest surface instead of keeping
+	// surfaces of a size nobody asks for any more
+	Surface *surface;
+
+	if (!_free.empty()) {
+		surface = _free.front();
+		_free.remove_at(0);
+		surface->free();
+	} else {
+		surface = new Surface();
+	}
+
+	surface->create(width, height, format);
+	_allocations++;
+	return surface;
+}
+
+void SurfacePool::release(Surface *surface) {
+	if (surface)
+		_free.push_back(surface);
+}
+
+void SurfacePool::clear() {
+	for (uint i = 0; i < _free.size(); i++) {
+		_free[i]->free();
+		delete _free[i];
+	}
+
+	_free.clear();
+}
+
+} // End of namespace Graphics
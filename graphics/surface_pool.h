@@ -0,0 +1,80 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef GRAPHICS_SURFACE_POOL_H
+#define GRAPHICS_SURFACE_POOL_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/noncopyable.h"
+
+#include "graphics/pixelformat.h"
+
+namespace Graphics {
+
+struct Surface;
+
+/**
+ * A pool of surfaces, to avoid allocating new ones for every frame.
+ *
+ * Surfaces which are no longer needed are handed back to the pool, and are
+ * reused by the next request for a surface of the same size and format.
+ * This is meant for code which needs short-lived surfaces over and over
+ * again, like video decoders converting or queueing frames.
+ *
+ * The pool is not thread safe.
+ */
+class SurfacePool : Common::NonCopyable {
+public:
+	SurfacePool() : _allocations(0) {}
+	~SurfacePool();
+
+	/**
+	 * Get a surface of the given size and format. A released surface is
+	 * reused if possible, otherwise a new one is created. The contents of
+	 * the surface are undefined.
+	 */
+	Surface *acquire(uint16 width, uint16 height, const PixelFormat &format);
+
+	/**
+	 * Hand a surface back to the pool. It must have been created with
+	 * Surface::create(), though not necessarily by the pool.
+	 */
+	void release(Surface *surface);
+
+	/** Free all surfaces in the pool. */
+	void clear();
+
+	/** Return the number of surfaces waiting to be reused. */
+	uint getFreeCount() const { return _free.size(); }
+
+	/** Return the number of surfaces the pool had to create so far. */
+	uint32 getAllocationCount() const { return _allocations; }
+
+private:
+	Common::Array<Surface *> _free;
+	uint32 _allocations;
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -85,6 +85,14 @@
 
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
+#include "common/cpudetect.h"
+
+#ifdef SCUMMVM_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SCUMMVM_AVX2
+#include <immintrin.h>
+#endif
 
 namespace Common {
 DECLARE_SINGLETON(Graphics::YUVToRGBManager);
@@ -192,6 +200,389 @@ const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, Y
 	return _lookup;
 }
 
+#pragma mark --- SIMD conversion ---
+#pragma mark -
+
+// The SIMD converters compute the same values as the tables above, using
+// fixed point arithmetic. The chroma contributions trunc(k * (c - 128)) are
+// computed from 2 * |c - 128| with an unsigned 16 bit high multiplication,
+// and so is the scaling of ITU luminance values, (y - 16) * 255 / 219. The
+// factors are round(k * 32768), which gives exactly the same results as the
+// floating point computation of the tables for all 256 input values.
+enum {
+	kCrRFactor = 45919, // 0.419 / 0.299
+	kCrGFactor = 23383, // 0.299 / 0.419
+	kCbGFactor = 11286, // 0.114 / 0.331
+	kCbBFactor = 58111, // 0.587 / 0.331
+	kITUFactor = 38155  // 255 / 219
+};
+
+/**
+ * Where the 8 bit components go in a pixel of the destination format, as
+ * done by PixelFormat::RGBToColor(). The SIMD converters build the lower
+ * and upper 16 bits of the pixels separately, so each component has a
+ * shift for both of them. A shift of 16 means that the component does not
+ * go there.
+ */
+struct YUVToRGBPacking {
+	int loss[3];
+	int lowShift[3], highShift[3];
+	uint16 lowAlpha, highAlpha;
+	/** Whether this is possible at all, i.e. no component crosses bit 16. */
+	bool valid;
+
+	YUVToRGBPacking(const Graphics::PixelFormat &format) : valid(true) {
+		const byte losses[3] = { format.rLoss, format.gLoss, format.bLoss };
+		const byte shifts[3] = { format.rShift, format.gShift, format.bShift };
+
+		for (int i = 0; i < 3; i++) {
+			loss[i] = losses[i];
+			lowShift[i] = (shifts[i] < 16) ? shifts[i] : 16;
+			highShift[i] = (shifts[i] >= 16) ? shifts[i] - 16 : 16;
+			if (losses[i] < 8 && shifts[i] < 16 && shifts[i] + 8 - losses[i] > 16)
+				valid = false;
+		}
+
+		const uint32 alpha = (0xFF >> format.aLoss) << format.aShift;
+		lowAlpha = alpha & 0xFFFF;
+		highAlpha = alpha >> 16;
+	}
+};
+
+#ifdef SCUMMVM_SSE2
+
+struct PackingSSE2 {
+	__m128i loss[3];
+	__m128i lowShift[3], highShift[3];
+	__m128i lowAlpha, highAlpha;
+
+	PackingSSE2(const YUVToRGBPacking &packing) {
+		for (int i = 0; i < 3; i++) {
+			loss[i] = _mm_cvtsi32_si128(packing.loss[i]);
+			lowShift[i] = _mm_cvtsi32_si128(packing.lowShift[i]);
+			highShift[i] = _mm_cvtsi32_si128(packing.highShift[i]);
+		}
+		lowAlpha = _mm_set1_epi16(packing.lowAlpha);
+		highAlpha = _mm_set1_epi16(packing.highAlpha);
+	}
+
+	/** Combine the components of eight pixels to the lower or upper 16 bits of the pixels. */
+	inline __m128i pack(__m128i r, __m128i g, __m128i b, __m128i alpha, const __m128i *shift) const {
+		__m128i color = _mm_or_si128(alpha, _mm_sll_epi16(r, shift[0]));
+		color = _mm_or_si128(color, _mm_sll_epi16(g, shift[1]));
+		return _mm_or_si128(color, _mm_sll_epi16(b, shift[2]));
+	}
+};
+
+/** trunc(factor / 32768 * c) for the 16 bit lanes of c, given 2 * |c| and the sign of c. */
+static inline __m128i chromaProductSSE2(__m128i abs2, __m128i sign, int factor) {
+	const __m128i product = _mm_mulhi_epu16(abs2, _mm_set1_epi16((int16)factor));
+	return _mm_sub_epi16(_mm_xor_si128(product, sign), sign);
+}
+
+/** Compute the red, green and blue offsets of eight chroma samples, given in 16 bit lanes. */
+template<YUVToRGBManager::LuminanceScale scale>
+static inline void chromaSSE2(__m128i u, __m128i v, __m128i &crR, __m128i &crbG, __m128i &cbB) {
+	const __m128i cb = _mm_sub_epi16(u, _mm_set1_epi16(128));
+	const __m128i cr = _mm_sub_epi16(v, _mm_set1_epi16(128));
+	const __m128i cbSign = _mm_srai_epi16(cb, 15);
+	const __m128i crSign = _mm_srai_epi16(cr, 15);
+	const __m128i cbAbs2 = _mm_slli_epi16(_mm_max_epi16(cb, _mm_sub_epi16(_mm_setzero_si128(), cb)), 1);
+	const __m128i crAbs2 = _mm_slli_epi16(_mm_max_epi16(cr, _mm_sub_epi16(_mm_setzero_si128(), cr)), 1);
+
+	crR = chromaProductSSE2(crAbs2, crSign, kCrRFactor);
+	crbG = _mm_sub_epi16(_mm_setzero_si128(), _mm_add_epi16(chromaProductSSE2(crAbs2, crSign, kCrGFactor), chromaProductSSE2(cbAbs2, cbSign, kCbGFactor)));
+	cbB = chromaProductSSE2(cbAbs2, cbSign, kCbBFactor);
+
+	// See componentSSE2()
+	if (scale == YUVToRGBManager::kScaleITU) {
+		crR = _mm_slli_epi16(crR, 1);
+		crbG = _mm_slli_epi16(crbG, 1);
+		cbB = _mm_slli_epi16(cbB, 1);
+	}
+}
+
+/** Compute one 8 bit component from luminance and chroma offset. */
+template<YUVToRGBManager::LuminanceScale scale>
+static inline __m128i componentSSE2(__m128i y, __m128i offset) {
+	const __m128i value = _mm_add_epi16(y, offset);
+
+	if (scale == YUVToRGBManager::kScaleFull)
+		return _mm_min_epi16(_mm_max_epi16(value, _mm_setzero_si128()), _mm_set1_epi16(255));
+
+	// Luminance and offsets are doubled and 16 is subtracted from the
+	// luminance in advance, so that this only needs to clip to 0..2 * 219
+	// before scaling.
+	const __m128i clipped = _mm_min_epi16(_mm_max_epi16(value, _mm_setzero_si128()), _mm_set1_epi16(2 * 219));
+	return _mm_mulhi_epu16(clipped, _mm_set1_epi16((int16)kITUFactor));
+}
+
+/** Convert eight pixels and store them in the destination format. */
+template<typename PixelInt, YUVToRGBManager::LuminanceScale scale>
+static inline void putPixelsSSE2(byte *dst, __m128i y, __m128i crR, __m128i crbG, __m128i cbB, const PackingSSE2 &packing) {
+	if (scale == YUVToRGBManager::kScaleITU)
+		y = _mm_slli_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)), 1);
+
+	const __m128i r = _mm_srl_epi16(componentSSE2<scale>(y, crR), packing.loss[0]);
+	const __m128i g = _mm_srl_epi16(componentSSE2<scale>(y, crbG), packing.loss[1]);
+	const __m128i b = _mm_srl_epi16(componentSSE2<scale>(y, cbB), packing.loss[2]);
+	const __m128i low = packing.pack(r, g, b, packing.lowAlpha, packing.lowShift);
+
+	if (sizeof(PixelInt) == 2) {
+		_mm_storeu_si128((__m128i *)dst, low);
+	} else {
+		const __m128i high = packing.pack(r, g, b, packing.highAlpha, packing.highShift);
+		_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(low, high));
+		_mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi16(low, high));
+	}
+}
+
+/** Load eight bytes into 16 bit lanes. */
+static inline __m128i loadBytesSSE2(const byte *src) {
+	return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)src), _mm_setzero_si128());
+}
+
+template<typename PixelInt, YUVToRGBManager::LuminanceScale scale>
+static void convertYUV444ToRGBSSE2(byte *dstPtr, int dstPitch, const YUVToRGBPacking &packing, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const PackingSSE2 sse2Packing(packing);
+
+	for (int h = 0; h < yHeight; h++) {
+		for (int w = 0; w < yWidth; w += 8) {
+			__m128i crR, crbG, cbB;
+			chromaSSE2<scale>(loadBytesSSE2(uSrc + w), loadBytesSSE2(vSrc + w), crR, crbG, cbB);
+			putPixelsSSE2<PixelInt, scale>(dstPtr + w * sizeof(PixelInt), loadBytesSSE2(ySrc + w), crR, crbG, cbB, sse2Packing);
+		}
+
+		dstPtr += dstPitch;
+		ySrc += yPitch;
+		uSrc += uvPitch;
+		vSrc += uvPitch;
+	}
+}
+
+template<typename PixelInt, YUVToRGBManager::LuminanceScale scale>
+static void convertYUV420ToRGBSSE2(byte *dstPtr, int dstPitch, const YUVToRGBPacking &packing, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const PackingSSE2 sse2Packing(packing);
+
+	// Convert two rows at once, which share their chroma samples
+	for (int h = 0; h < yHeight; h += 2) {
+		for (int w = 0; w < yWidth; w += 16) {
+			__m128i crR, crbG, cbB;
+			chromaSSE2<scale>(loadBytesSSE2(uSrc + w / 2), loadBytesSSE2(vSrc + w / 2), crR, crbG, cbB);
+
+			// Each chroma sample covers two pixels of a row
+			const __m128i crRLow = _mm_unpacklo_epi16(crR, crR), crRHigh = _mm_unpackhi_epi16(crR, crR);
+			const __m128i crbGLow = _mm_unpacklo_epi16(crbG, crbG), crbGHigh = _mm_unpackhi_epi16(crbG, crbG);
+			const __m128i cbBLow = _mm_unpacklo_epi16(cbB, cbB), cbBHigh = _mm_unpackhi_epi16(cbB, cbB);
+
+			for (int row = 0; row < 2; row++) {
+				byte *dst = dstPtr + row * dstPitch + w * sizeof(PixelInt);
+				const byte *y = ySrc + row * yPitch + w;
+				putPixelsSSE2<PixelInt, scale>(dst, loadBytesSSE2(y), crRLow, crbGLow, cbBLow, sse2Packing);
+				putPixelsSSE2<PixelInt, scale>(dst + 8 * sizeof(PixelInt), loadBytesSSE2(y + 8), crRHigh, crbGHigh, cbBHigh, sse2Packing);
+			}
+		}
+
+		dstPtr += dstPitch * 2;
+		ySrc += yPitch * 2;
+		uSrc += uvPitch;
+		vSrc += uvPitch;
+	}
+}
+
+#endif // SCUMMVM_SSE2
+
+#ifdef SCUMMVM_AVX2
+
+struct PackingAVX2 {
+	__m128i loss[3];
+	__m128i lowShift[3], highShift[3];
+	__m256i lowAlpha, highAlpha;
+
+	SCUMMVM_TARGET_AVX2
+	PackingAVX2(const YUVToRGBPacking &packing) {
+		for (int i = 0; i < 3; i++) {
+			loss[i] = _mm_cvtsi32_si128(packing.loss[i]);
+			lowShift[i] = _mm_cvtsi32_si128(packing.lowShift[i]);
+			highShift[i] = _mm_cvtsi32_si128(packing.highShift[i]);
+		}
+		lowAlpha = _mm256_set1_epi16(packing.lowAlpha);
+		highAlpha = _mm256_set1_epi16(packing.highAlpha);
+	}
+
+	SCUMMVM_TARGET_AVX2
+	inline __m256i pack(__m256i r, __m256i g, __m256i b, __m256i alpha, const __m128i *shift) const {
+		__m256i color = _mm256_or_si256(alpha, _mm256_sll_epi16(r, shift[0]));
+		color = _mm256_or_si256(color, _mm256_sll_epi16(g, shift[1]));
+		return _mm256_or_si256(color, _mm256_sll_epi16(b, shift[2]));
+	}
+};
+
+SCUMMVM_TARGET_AVX2
+static inline __m256i chromaProductAVX2(__m256i abs2, __m256i sign, int factor) {
+	const __m256i product = _mm256_mulhi_epu16(abs2, _mm256_set1_epi16((int16)factor));
+	return _mm256_sub_epi16(_mm256_xor_si256(product, sign), sign);
+}
+
+template<YUVToRGBManager::LuminanceScale scale>
+SCUMMVM_TARGET_AVX2
+static inline void chromaAVX2(__m256i u, __m256i v, __m256i &crR, __m256i &crbG, __m256i &cbB) {
+	const __m256i cb = _mm256_sub_epi16(u, _mm256_set1_epi16(128));
+	const __m256i cr = _mm256_sub_epi16(v, _mm256_set1_epi16(128));
+	const __m256i cbSign = _mm256_srai_epi16(cb, 15);
+	const __m256i crSign = _mm256_srai_epi16(cr, 15);
+	const __m256i cbAbs2 = _mm256_slli_epi16(_mm256_abs_epi16(cb), 1);
+	const __m256i crAbs2 = _mm256_slli_epi16(_mm256_abs_epi16(cr), 1);
+
+	crR = chromaProductAVX2(crAbs2, crSign, kCrRFactor);
+	crbG = _mm256_sub_epi16(_mm256_setzero_si256(), _mm256_add_epi16(chromaProductAVX2(crAbs2, crSign, kCrGFactor), chromaProductAVX2(cbAbs2, cbSign, kCbGFactor)));
+	cbB = chromaProductAVX2(cbAbs2, cbSign, kCbBFactor);
+
+	// See componentAVX2()
+	if (scale == YUVToRGBManager::kScaleITU) {
+		crR = _mm256_slli_epi16(crR, 1);
+		crbG = _mm256_slli_epi16(crbG, 1);
+		cbB = _mm256_slli_epi16(cbB, 1);
+	}
+}
+
+template<YUVToRGBManager::LuminanceScale scale>
+SCUMMVM_TARGET_AVX2
+static inline __m256i componentAVX2(__m256i y, __m256i offset) {
+	const __m256i value = _mm256_add_epi16(y, offset);
+
+	if (scale == YUVToRGBManager::kScaleFull)
+		return _mm256_min_epi16(_mm256_max_epi16(value, _mm256_setzero_si256()), _mm256_set1_epi16(255));
+
+	// Luminance and offsets are doubled and 16 is subtracted from the
+	// luminance in advance, so that this only needs to clip to 0..2 * 219
+	// before scaling.
+	const __m256i clipped = _mm256_min_epi16(_mm256_max_epi16(value, _mm256_setzero_si256()), _mm256_set1_epi16(2 * 219));
+	return _mm256_mulhi_epu16(clipped, _mm256_set1_epi16((int16)kITUFactor));
+}
+
+/** Convert sixteen pixels and store them in the destination format. */
+template<typename PixelInt, YUVToRGBManager::LuminanceScale scale>
+SCUMMVM_TARGET_AVX2
+static inline void putPixelsAVX2(byte *dst, __m256i y, __m256i crR, __m256i crbG, __m256i cbB, const PackingAVX2 &packing) {
+	if (scale == YUVToRGBManager::kScaleITU)
+		y = _mm256_slli_epi16(_mm256_sub_epi16(y, _mm256_set1_epi16(16)), 1);
+
+	const __m256i r = _mm256_srl_epi16(componentAVX2<scale>(y, crR), packing.loss[0]);
+	const __m256i g = _mm256_srl_epi16(componentAVX2<scale>(y, crbG), packing.loss[1]);
+	const __m256i b = _mm256_srl_epi16(componentAVX2<scale>(y, cbB), packing.loss[2]);
+	const __m256i low = packing.pack(r, g, b, packing.lowAlpha, packing.lowShift);
+
+	if (sizeof(PixelInt) == 2) {
+		_mm256_storeu_si256((__m256i *)dst, low);
+	} else {
+		// Interleaving works on each 128 bit half, so the results need to be
+		// put back into order
+		const __m256i high = packing.pack(r, g, b, packing.highAlpha, packing.highShift);
+		const __m256i first = _mm256_unpacklo_epi16(low, high);
+		const __m256i second = _mm256_unpackhi_epi16(low, high);
+		_mm256_storeu_si256((__m256i *)dst, _mm256_permute2x128_si256(first, second, 0x20));
+		_mm256_storeu_si256((__m256i *)(dst + 32), _mm256_permute2x128_si256(first, second, 0x31));
+	}
+}
+
+template<typename PixelInt, YUVToRGBManager::LuminanceScale scale>
+SCUMMVM_TARGET_AVX2
+static void convertYUV444ToRGBAVX2(byte *dstPtr, int dstPitch, const YUVToRGBPacking &packing, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const PackingAVX2 avx2Packing(packing);
+
+	for (int h = 0; h < yHeight; h++) {
+		for (int w = 0; w < yWidth; w += 16) {
+			const __m256i u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(uSrc + w)));
+			const __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(vSrc + w)));
+			const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(ySrc + w)));
+
+			__m256i crR, crbG, cbB;
+			chromaAVX2<scale>(u, v, crR, crbG, cbB);
+			putPixelsAVX2<PixelInt, scale>(dstPtr + w * sizeof(PixelInt), y, crR, crbG, cbB, avx2Packing);
+		}
+
+		dstPtr += dstPitch;
+		ySrc += yPitch;
+		uSrc += uvPitch;
+		vSrc += uvPitch;
+	}
+}
+
+template<typename PixelInt, YUVToRGBManager::LuminanceScale scale>
+SCUMMVM_TARGET_AVX2
+static void convertYUV420ToRGBAVX2(byte *dstPtr, int dstPitch, const YUVToRGBPacking &packing, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const PackingAVX2 avx2Packing(packing);
+
+	// Convert two rows at once, which share their chroma samples
+	for (int h = 0; h < yHeight; h += 2) {
+		for (int w = 0; w < yWidth; w += 16) {
+			// Each chroma sample covers two pixels of a row
+			const __m128i u = _mm_loadl_epi64((const __m128i *)(uSrc + w / 2));
+			const __m128i v = _mm_loadl_epi64((const __m128i *)(vSrc + w / 2));
+
+			__m256i crR, crbG, cbB;
+			chromaAVX2<scale>(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(u, u)), _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(v, v)), crR, crbG, cbB);
+
+			for (int row = 0; row < 2; row++) {
+				const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(ySrc + row * yPitch + w)));
+				putPixelsAVX2<PixelInt, scale>(dstPtr + row * dstPitch + w * sizeof(PixelInt), y, crR, crbG, cbB, avx2Packing);
+			}
+		}
+
+		dstPtr += dstPitch * 2;
+		ySrc += yPitch * 2;
+		uSrc += uvPitch;
+		vSrc += uvPitch;
+	}
+}
+
+#endif // SCUMMVM_AVX2
+
+typedef void (*YUVToRGBSIMDProc)(byte *dstPtr, int dstPitch, const YUVToRGBPacking &packing, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
+
+/**
+ * Convert as many columns as possible of the image with SIMD code.
+ *
+ * @return the number of columns converted, which is a multiple of the
+ *         block size of the converter used, or 0 if there is none
+ */
+static int convertYUVToRGBSIMD(bool is420, Graphics::Surface *dst, YUVToRGBManager::LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const bool full = (scale == YUVToRGBManager::kScaleFull);
+	const bool is16 = (dst->format.bytesPerPixel == 2);
+	YUVToRGBSIMDProc proc = 0;
+	int blockWidth = 1;
+
+#define SELECT_PROC(func) \
+	(is16 ? (full ? &func<uint16, YUVToRGBManager::kScaleFull> : &func<uint16, YUVToRGBManager::kScaleITU>) \
+	      : (full ? &func<uint32, YUVToRGBManager::kScaleFull> : &func<uint32, YUVToRGBManager::kScaleITU>))
+
+#ifdef SCUMMVM_AVX2
+	if (Common::hasCPUFeature(Common::kCpuFeatureAVX2)) {
+		proc = is420 ? SELECT_PROC(convertYUV420ToRGBAVX2) : SELECT_PROC(convertYUV444ToRGBAVX2);
+		blockWidth = 16;
+	}
+#endif
+#ifdef SCUMMVM_SSE2
+	if (!proc && Common::hasCPUFeature(Common::kCpuFeatureSSE2)) {
+		proc = is420 ? SELECT_PROC(convertYUV420ToRGBSSE2) : SELECT_PROC(convertYUV444ToRGBSSE2);
+		blockWidth = is420 ? 16 : 8;
+	}
+#endif
+
+#undef SELECT_PROC
+
+	const YUVToRGBPacking packing(dst->format);
+	const int simdWidth = yWidth - yWidth % blockWidth;
+	if (!proc || !packing.valid || !simdWidth)
+		return 0;
+
+	proc((byte *)dst->getPixels(), dst->pitch, packing, ySrc, uSrc, vSrc, simdWidth, yHeight, yPitch, uvPitch);
+	return simdWidth;
+}
+
+#pragma mark -
+
 #define PUT_PIXEL(s, d) \
 	L = &rgbToPix[(s)]; \
 	*((PixelInt *)(d)) = (L[cr_r] | L[crb_g] | L[cb_b])
@@ -233,13 +624,22 @@ void YUVToRGBManager::convert444(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert(dst->format.bytesPerPixel == 2 || dst->format.bytesPerPixel == 4);
 	assert(ySrc && uSrc && vSrc);
 
+	// Convert the image with SIMD code, and the remaining columns with the tables
+	const int simdWidth = convertYUVToRGBSIMD(false, dst, scale, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	if (simdWidth == yWidth)
+		return;
+
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
+	byte *dstPtr = (byte *)dst->getBasePtr(simdWidth, 0);
+	ySrc += simdWidth;
+	uSrc += simdWidth;
+	vSrc += simdWidth;
 
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
-		convertYUV444ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		convertYUV444ToRGB<uint16>(dstPtr, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth - simdWidth, yHeight, yPitch, uvPitch);
 	else
-		convertYUV444ToRGB<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		convertYUV444ToRGB<uint32>(dstPtr, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth - simdWidth, yHeight, yPitch, uvPitch);
 }
 
 template<typename PixelInt>
@@ -274,7 +674,7 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 			dstPtr += sizeof(PixelInt);
 		}
 
-		dstPtr += dstPitch;
+		dstPtr += (dstPitch << 1) - yWidth * sizeof(PixelInt);
 		ySrc += (yPitch << 1) - yWidth;
 		uSrc += uvPitch - halfWidth;
 		vSrc += uvPitch - halfWidth;
@@ -289,13 +689,22 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert((yWidth & 1) == 0);
 	assert((yHeight & 1) == 0);
 
+	// Convert the image with SIMD code, and the remaining columns with the tables
+	const int simdWidth = convertYUVToRGBSIMD(true, dst, scale, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	if (simdWidth == yWidth)
+		return;
+
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
+	byte *dstPtr = (byte *)dst->getBasePtr(simdWidth, 0);
+	ySrc += simdWidth;
+	uSrc += simdWidth / 2;
+	vSrc += simdWidth / 2;
 
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
-		convertYUV420ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		convertYUV420ToRGB<uint16>(dstPtr, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth - simdWidth, yHeight, yPitch, uvPitch);
 	else
-		convertYUV420ToRGB<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		convertYUV420ToRGB<uint32>(dstPtr, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth - simdWidth, yHeight, yPitch, uvPitch);
 }
 
 #define READ_QUAD(ptr, prefix) \
@@ -105,6 +105,20 @@ public:
 	 */
 	void convert410(Graphics::Surface *dst, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
 
+	/**
+	 * Build the lookup tables for the given destination format, unless they
+	 * are built already.
+	 *
+	 * The conversion functions rebuild the tables whenever the destination
+	 * format changes, which is not thread safe. To convert parts of an image
+	 * on several threads, call this on the calling thread first, and convert
+	 * to the same format and scale on all of them.
+	 *
+	 * @param format  the format of the destination surface
+	 * @param scale   the scale of the luminance values
+	 */
+	void prepareLookup(Graphics::PixelFormat format, LuminanceScale scale) { getLookup(format, scale); }
+
 private:
 	friend class Common::Singleton<SingletonBaseType>;
 	YUVToRGBManager();
@@ -24,8 +24,12 @@
 #define FORBIDDEN_SYMBOL_ALLOW_ALL
 
 #include "common/debug-channels.h"
+#include "common/file.h"
 #include "common/system.h"
 
+#include "audio/mixer.h"
+#include "audio/mixer_profile.h"
+
 #include "engines/engine.h"
 
 #include "gui/debugger.h"
@@ -64,6 +68,8 @@ Debugger::Debugger() {
 	DCmd_Register("debugflag_list",		WRAP_METHOD(Debugger, Cmd_DebugFlagsList));
 	DCmd_Register("debugflag_enable",	WRAP_METHOD(Debugger, Cmd_DebugFlagEnable));
 	DCmd_Register("debugflag_disable",	WRAP_METHOD(Debugger, Cmd_DebugFlagDisable));
+
+	DCmd_Register("mixer_profile",		WRAP_METHOD(Debugger, Cmd_MixerProfile));
 }
 
 Debugger::~Debugger() {
@@ -537,6 +543,70 @@ bool Debugger::Cmd_DebugFlagDisable(int argc, const char **argv) {
 	return true;
 }
 
+bool Debugger::Cmd_MixerProfile(int argc, const char **argv) {
+	Audio::MixerProfile *profile = g_system->getMixer()->getProfile();
+	if (!profile) {
+		DebugPrintf("Mixer profiling not supported on this system\n");
+		return true;
+	}
+
+	if (argc >= 2) {
+		const Common::String cmd = argv[1];
+
+		if (cmd == "on") {
+			profile->setEnabled(true);
+			DebugPrintf("Mixer profiling enabled\n");
+		} else if (cmd == "off") {
+			profile->setEnabled(false);
+			DebugPrintf("Mixer profiling disabled\n");
+		} else if (cmd == "reset") {
+			profile->reset();
+		} else if (cmd == "dump" && argc >= 3) {
+			Common::DumpFile out;
+			if (!out.open(argv[2])) {
+				DebugPrintf("Failed to open '%s'\n", argv[2]);
+			} else {
+				profile->dump(out);
+				out.finalize();
+				DebugPrintf("Mixer statistics written to '%s'\n", argv[2]);
+			}
+		} else {
+			DebugPrintf("mixer_profile [on|off|reset|dump <file>]\n");
+		}
+		return true;
+	}
+
+	const Audio::MixerProfile::Stats &stats = profile->getStats();
+
+	DebugPrintf("Mixer profiling is %s\n", profile->isEnabled() ? "enabled" : "disabled");
+	DebugPrintf("Callbacks: %u, average %u us, max %u us\n", stats.callbacks,
+		stats.callbacks ? stats.totalMicros / stats.callbacks : 0, stats.maxMicros);
+	DebugPrintf("Over budget: %u, late: %u, prefetch underruns: %u\n",
+		stats.overBudget, stats.late, stats.prefetchUnderruns);
+
+	DebugPrintf("Callback time histogram:\n");
+	for (int i = 0; i < Audio::MixerProfile::kHistogramBuckets; i++) {
+		const uint32 limit = Audio::MixerProfile::getBucketLimit(i);
+		if (limit)
+			DebugPrintf("  < %6u us: %u\n", limit, stats.histogram[i]);
+		else
+			DebugPrintf("  >= %5u us: %u\n", Audio::MixerProfile::getBucketLimit(i - 1), stats.histogram[i]);
+	}
+
+	DebugPrintf("Channels:\n");
+	for (int i = 0; i < Audio::MixerProfile::kMaxChannels; i++) {
+		const Audio::MixerProfile::ChannelStats &chan = stats.channels[i];
+		if (!chan.mixes)
+			continue;
+
+		DebugPrintf("%c%2d %-6s id %4d: decode %u us, convert %u us, max %u us (%u mixes)\n",
+			chan.active ? '+' : ' ', i, Audio::MixerProfile::getSoundTypeName(chan.type), chan.id,
+			chan.decodeMicros, chan.convertMicros, chan.maxMicros, chan.mixes);
+	}
+
+	return true;
+}
+
 // Console handler
 #ifndef USE_TEXT_CONSOLE_FOR_DEBUGGER
 bool Debugger::debuggerInputCallback(GUI::ConsoleDialog *console, const char *input, void *refCon) {
@@ -0,0 +1,104 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mixer_profile.h"
+
+#include "common/memstream.h"
+#include "common/str.h"
+
+class MixerProfileTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_callback_histogram() {
+		Audio::MixerProfile profile;
+		profile.setEnabled(true);
+
+		// 441 frames at 44.1kHz last 10ms
+		profile.beginCallback(1000, 441, 44100);
+		profile.endCallback(1100, 0);
+		profile.beginCallback(11000, 441, 44100);
+		profile.endCallback(11300, 0);
+		profile.beginCallback(21000, 441, 44100);
+		profile.endCallback(71000, 0);
+
+		const Audio::MixerProfile::Stats &stats = profile.getStats();
+		TS_ASSERT_EQUALS(stats.callbacks, 3u);
+		TS_ASSERT_EQUALS(stats.totalMicros, 50400u);
+		TS_ASSERT_EQUALS(stats.maxMicros, 50000u);
+		TS_ASSERT_EQUALS(stats.overBudget, 1u);
+		TS_ASSERT_EQUALS(stats.late, 0u);
+
+		TS_ASSERT_EQUALS(stats.histogram[0], 1u);	// 100us
+		TS_ASSERT_EQUALS(stats.histogram[2], 1u);	// 300us
+		TS_ASSERT_EQUALS(stats.histogram[Audio::MixerProfile::kHistogramBuckets - 1], 1u);	// 50ms
+	}
+
+	void test_late_callbacks() {
+		Audio::MixerProfile profile;
+		profile.setEnabled(true);
+
+		profile.beginCallback(0 - 5000, 441, 44100);	// wraps around
+		profile.endCallback(0 - 4900, 0);
+		profile.beginCallback(5000, 441, 44100);
+		profile.endCallback(5100, 0);
+		profile.beginCallback(40000, 441, 44100);
+		profile.endCallback(40100, 3);
+
+		TS_ASSERT_EQUALS(profile.getStats().late, 1u);
+		TS_ASSERT_EQUALS(profile.getStats().prefetchUnderruns, 3u);
+
+		// Resetting takes effect with the next callback
+		profile.reset();
+		profile.beginCallback(200000, 441, 44100);
+		profile.endCallback(200100, 0);
+		TS_ASSERT_EQUALS(profile.getStats().callbacks, 1u);
+		TS_ASSERT_EQUALS(profile.getStats().late, 0u);
+	}
+
+	void test_channels() {
+		Audio::MixerProfile profile;
+		profile.setEnabled(true);
+
+		profile.beginCallback(0, 441, 44100);
+		profile.recordChannel(3, 35, 7, Audio::Mixer::kMusicSoundType, 441, 100, 150);
+		profile.endCallback(200, 0);
+		profile.beginCallback(10000, 441, 44100);
+		profile.recordChannel(3, 35, 7, Audio::Mixer::kMusicSoundType, 441, 200, 220);
+		profile.endCallback(10300, 0);
+
+		const Audio::MixerProfile::ChannelStats &chan = profile.getStats().channels[3];
+		TS_ASSERT(chan.active);
+		TS_ASSERT_EQUALS(chan.mixes, 2u);
+		TS_ASSERT_EQUALS(chan.frames, 882u);
+		TS_ASSERT_EQUALS(chan.decodeMicros, 300u);
+		TS_ASSERT_EQUALS(chan.convertMicros, 70u);
+		TS_ASSERT_EQUALS(chan.maxMicros, 220u);
+		TS_ASSERT_EQUALS(profile.getStats().typeDecodeMicros[Audio::Mixer::kMusicSoundType], 300u);
+
+		// A new sound in the same slot starts from scratch
+		profile.recordChannel(3, 51, -1, Audio::Mixer::kSFXSoundType, 100, 10, 20);
+		TS_ASSERT_EQUALS(chan.mixes, 1u);
+		TS_ASSERT_EQUALS(chan.id, -1);
+		TS_ASSERT_EQUALS(chan.type, Audio::Mixer::kSFXSoundType);
+
+		profile.setChannelInactive(3);
+		TS_ASSERT(!chan.active);
+	}
+
+	void test_dump() {
+		Audio::MixerProfile profile;
+		profile.setEnabled(true);
+
+		profile.beginCallback(0, 441, 44100);
+		profile.recordChannel(1, 17, 42, Audio::Mixer::kSpeechSoundType, 441, 5, 8);
+		profile.endCallback(10, 0);
+
+		Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+		profile.dump(out);
+		const Common::String text((const char *)out.getData(), out.size());
+
+		TS_ASSERT(text.hasPrefix("mixer callbacks 1\n"));
+		TS_ASSERT(text.contains("\nhistogram 128 1\n"));
+		TS_ASSERT(text.contains("\ntype speech decode_us 5\n"));
+		TS_ASSERT(text.contains("\nchannel 1 handle 17 id 42 type speech active 1 mixes 1 frames 441 decode_us 5 convert_us 3 max_us 8\n"));
+	}
+};
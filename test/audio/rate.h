@@ -0,0 +1,190 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/rate.h"
+#include "audio/rate_kernels.h"
+#include "audio/mixer.h"
+#include "common/cpudetect.h"
+
+#include "helper.h"
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kSamples = 1003
+	};
+
+	/** Deterministic noise covering the whole sample range. */
+	static void fillNoise(int16 *buf, int count, uint32 seed) {
+		for (int i = 0; i < count; ++i) {
+			seed = seed * 1103515245 + 12345;
+			buf[i] = (int16)(seed >> 16);
+		}
+		buf[0] = -32768;
+		buf[1] = 32767;
+	}
+
+	void compareKernels(const Audio::RateKernels &kernels, Audio::st_volume_t volL, Audio::st_volume_t volR) {
+		const Audio::RateKernels &reference = Audio::getScalarRateKernels();
+
+		int16 src[kSamples * 2], last[kSamples], cur[kSamples];
+		int16 expected[kSamples * 2], actual[kSamples * 2];
+		frac_t pos[kSamples];
+		fillNoise(src, kSamples * 2, 1);
+		fillNoise(last, kSamples, 2);
+		fillNoise(cur, kSamples, 3);
+		for (int i = 0; i < kSamples; ++i)
+			pos[i] = (i * 4099) & (FRAC_ONE - 1);
+
+		for (int reverse = 0; reverse < 2; ++reverse) {
+			fillNoise(expected, kSamples * 2, 4);
+			fillNoise(actual, kSamples * 2, 4);
+			reference.mixStereo(expected, src, kSamples, volL, volR, reverse != 0);
+			kernels.mixStereo(actual, src, kSamples, volL, volR, reverse != 0);
+			TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(expected)), 0);
+		}
+
+		fillNoise(expected, kSamples * 2, 5);
+		fillNoise(actual, kSamples * 2, 5);
+		reference.mixMono(expected, src, kSamples, volL, volR);
+		kernels.mixMono(actual, src, kSamples, volL, volR);
+		TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(expected)), 0);
+
+		reference.interpolate(expected, last, cur, pos, kSamples);
+		kernels.interpolate(actual, last, cur, pos, kSamples);
+		TS_ASSERT_EQUALS(memcmp(expected, actual, kSamples * sizeof(int16)), 0);
+
+		// Coefficients are limited to 14 bits, as in the sinc converter
+		int16 coefs[32];
+		for (int i = 0; i < 32; ++i)
+			coefs[i] = (i * 1237) % 32768 - 16384;
+		TS_ASSERT_EQUALS(reference.convolve(src, coefs, 16), kernels.convolve(src, coefs, 16));
+		TS_ASSERT_EQUALS(reference.convolve(src + 5, coefs, 32), kernels.convolve(src + 5, coefs, 32));
+	}
+
+	/** Convert a sine with the current kernels, and with the C++ ones. */
+	void compareConverter(int inRate, int outRate, bool stereo, bool reverseStereo,
+	                      Audio::RateConverterQuality quality = Audio::kRateConverterQualityFast) {
+		const int outFrames = 4000;
+		int16 expected[outFrames * 2], actual[outFrames * 2];
+		int expectedLen, actualLen;
+
+		memset(expected, 0, sizeof(expected));
+		memset(actual, 0, sizeof(actual));
+
+		Common::setDisabledCPUFeatures(0xFFFFFFFF);
+		Audio::SeekableAudioStream *s = createSineStream<int16>(inRate, 1, 0, false, stereo);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, stereo, reverseStereo, quality);
+		expectedLen = converter->flow(*s, expected, outFrames, 200, 77);
+		delete converter;
+		delete s;
+
+		Common::setDisabledCPUFeatures(0);
+		s = createSineStream<int16>(inRate, 1, 0, false, stereo);
+		converter = Audio::makeRateConverter(inRate, outRate, stereo, reverseStereo, quality);
+		actualLen = converter->flow(*s, actual, outFrames, 200, 77);
+		delete converter;
+		delete s;
+
+		TS_ASSERT_EQUALS(expectedLen, actualLen);
+		TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(expected)), 0);
+	}
+
+	/**
+	 * Resample a sine with the sinc converter, and return the largest
+	 * difference to the exact sine at the output rate.
+	 */
+	int sincError(int inRate, int outRate, bool stereo, Audio::RateConverterQuality quality) {
+		const int channels = stereo ? 2 : 1;
+		const int inFrames = inRate / 4;
+		const int outFrames = outRate / 4;
+		const double frequency = 1000.0;
+		const double amplitude = 16000.0;
+
+		int16 *input = (int16 *)malloc(inFrames * channels * sizeof(int16));
+		for (int i = 0; i < inFrames; ++i)
+			for (int c = 0; c < channels; ++c)
+				input[i * channels + c] = (int16)floor(amplitude * sin(2 * M_PI * frequency * i / inRate) + 0.5);
+
+		Common::SeekableReadStream *data = new Common::MemoryReadStream((const byte *)input, inFrames * channels * sizeof(int16), DisposeAfterUse::YES);
+		Audio::AudioStream *s = Audio::makeRawStream(data, inRate,
+			Audio::FLAG_16BITS | (stereo ? Audio::FLAG_STEREO : 0)
+#ifdef SCUMM_LITTLE_ENDIAN
+			| Audio::FLAG_LITTLE_ENDIAN
+#endif
+			);
+
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, stereo, false, quality);
+		int16 *output = new int16[outFrames * 2];
+		memset(output, 0, outFrames * 2 * sizeof(int16));
+		const int len = converter->flow(*s, output, outFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		delete converter;
+		delete s;
+
+		// Skip the start and end, where the filter window is not full
+		int maxError = 0;
+		for (int i = 100; i < len - 100; ++i) {
+			const double exact = amplitude * sin(2 * M_PI * frequency * i / outRate);
+			for (int c = 0; c < 2; ++c)
+				maxError = MAX(maxError, (int)fabs(output[i * 2 + c] - exact));
+		}
+		delete[] output;
+
+		// The last half window of input is not converted
+		TS_ASSERT(len >= outFrames - 16 * outRate / inRate - 1);
+		return maxError;
+	}
+
+public:
+	void test_scalar_copy_mixing() {
+		const int16 src[4] = { 1000, -1000, 32767, -32768 };
+		int16 dst[4] = { 0, 0, 32000, -32000 };
+
+		Audio::getScalarRateKernels().mixStereo(dst, src, 2, Audio::Mixer::kMaxMixerVolume / 2, Audio::Mixer::kMaxMixerVolume, false);
+		TS_ASSERT_EQUALS(dst[0], 500);
+		TS_ASSERT_EQUALS(dst[1], -1000);
+		TS_ASSERT_EQUALS(dst[2], 32767);
+		TS_ASSERT_EQUALS(dst[3], -32768);
+	}
+
+	void test_kernels_match_scalar() {
+		// Check the best kernels, and the second best ones as well
+		const uint32 disabled[2] = { 0, Common::kCpuFeatureAVX2 };
+
+		for (int i = 0; i < 2; ++i) {
+			Common::setDisabledCPUFeatures(disabled[i]);
+			const Audio::RateKernels &kernels = Audio::getRateKernels();
+
+			compareKernels(kernels, 256, 256);
+			compareKernels(kernels, 255, 3);
+			compareKernels(kernels, 0, 129);
+			compareKernels(kernels, 40000, 1);
+		}
+
+		Common::setDisabledCPUFeatures(0);
+	}
+
+	void test_converters_match_scalar() {
+		compareConverter(22050, 22050, false, false);
+		compareConverter(22050, 22050, true, false);
+		compareConverter(22050, 22050, true, true);
+		compareConverter(44100, 22050, false, false);
+		compareConverter(44100, 22050, true, true);
+		compareConverter(11025, 48000, false, false);
+		compareConverter(22050, 44100, true, false);
+		compareConverter(22050, 48000, true, true);
+		compareConverter(22050, 44100, false, false, Audio::kRateConverterQualityGood);
+		compareConverter(11025, 48000, true, true, Audio::kRateConverterQualityBest);
+		compareConverter(48000, 22050, true, false, Audio::kRateConverterQualityBest);
+	}
+
+	void test_sinc_accuracy() {
+		// A 1 kHz sine is well inside the pass band, so it should come out
+		// almost unchanged (16000 is the amplitude).
+		TS_ASSERT_LESS_THAN(sincError(22050, 44100, false, Audio::kRateConverterQualityGood), 40);
+		TS_ASSERT_LESS_THAN(sincError(11025, 48000, true, Audio::kRateConverterQualityGood), 40);
+		TS_ASSERT_LESS_THAN(sincError(22050, 44100, true, Audio::kRateConverterQualityBest), 20);
+		TS_ASSERT_LESS_THAN(sincError(8000, 44100, false, Audio::kRateConverterQualityBest), 20);
+		TS_ASSERT_LESS_THAN(sincError(44100, 22050, false, Audio::kRateConverterQualityBest), 20);
+	}
+};
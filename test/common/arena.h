@@ -0,0 +1,140 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/arena.h"
+
+struct ArenaTestNode {
+	int x, y;
+	ArenaTestNode *parent;
+};
+
+class ArenaTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_size_classes() {
+		typedef Common::SizeClassAllocator SCA;
+		TS_ASSERT_EQUALS(SCA::getSizeClass(0), 0);
+		TS_ASSERT_EQUALS(SCA::getSizeClass(1), 0);
+		TS_ASSERT_EQUALS(SCA::getSizeClass(16), 0);
+		TS_ASSERT_EQUALS(SCA::getSizeClass(17), 1);
+		TS_ASSERT_EQUALS(SCA::getSizeClass(64), 3);
+		TS_ASSERT_EQUALS(SCA::getSizeClass(65), 4);
+		TS_ASSERT_EQUALS(SCA::getSizeClass(SCA::kMaxSize), SCA::kNumSizeClasses - 1);
+		TS_ASSERT_EQUALS(SCA::getSizeClass(SCA::kMaxSize + 1), -1);
+
+		for (size_t size = 1; size <= SCA::kMaxSize; ++size) {
+			const int sizeClass = SCA::getSizeClass(size);
+			TS_ASSERT(SCA::getClassSize(sizeClass) >= size);
+			if (sizeClass > 0)
+				TS_ASSERT(SCA::getClassSize(sizeClass - 1) < size);
+		}
+	}
+
+	void test_allocate() {
+		Common::SizeClassAllocator allocator(false);
+		byte *small = (byte *)allocator.allocate(10);
+		byte *medium = (byte *)allocator.allocate(200);
+		byte *big = (byte *)allocator.allocate(5000);
+
+		memset(small, 1, 10);
+		memset(medium, 2, 200);
+		memset(big, 3, 5000);
+		TS_ASSERT_EQUALS(small[9], 1);
+		TS_ASSERT_EQUALS(medium[199], 2);
+		TS_ASSERT_EQUALS(big[4999], 3);
+
+		Common::AllocatorStats stats = allocator.getStats();
+		TS_ASSERT_EQUALS(stats.allocations, 3u);
+		TS_ASSERT_EQUALS(stats.bytesInUse, 5210u);
+		// One page for each size class, plus the big block
+		TS_ASSERT_EQUALS(stats.mallocs, 3u);
+
+		allocator.deallocate(small, 10);
+		allocator.deallocate(medium, 200);
+		allocator.deallocate(big, 5000);
+		stats = allocator.getStats();
+		TS_ASSERT_EQUALS(stats.deallocations, 3u);
+		TS_ASSERT_EQUALS(stats.bytesInUse, 0u);
+		TS_ASSERT_EQUALS(stats.peakBytesInUse, 5210u);
+
+		// Freed chunks are reused without new mallocs
+		allocator.resetStats();
+		void *again = allocator.allocate(12);
+		TS_ASSERT_EQUALS(again, (void *)small);
+		TS_ASSERT_EQUALS(allocator.getStats().mallocs, 0u);
+		allocator.deallocate(again, 12);
+	}
+
+	void test_cache() {
+		Common::SizeClassAllocator allocator(false);
+		void *ptrs[100];
+		{
+			Common::SizeClassAllocator::Cache cache(allocator);
+			for (int i = 0; i < 100; ++i) {
+				ptrs[i] = cache.allocate(24);
+				memset(ptrs[i], i, 24);
+			}
+			for (int i = 0; i < 100; ++i) {
+				TS_ASSERT_EQUALS(((byte *)ptrs[i])[23], i);
+				for (int j = 0; j < i; ++j)
+					TS_ASSERT_DIFFERS(ptrs[i], ptrs[j]);
+			}
+
+			// Blocks may be freed through another cache
+			Common::SizeClassAllocator::Cache other(allocator);
+			for (int i = 0; i < 50; ++i)
+				other.deallocate(ptrs[i], 24);
+			other.flush();
+
+			for (int i = 50; i < 100; ++i)
+				cache.deallocate(ptrs[i], 24);
+		}
+
+		const Common::AllocatorStats stats = allocator.getStats();
+		TS_ASSERT_EQUALS(stats.allocations, 100u);
+		TS_ASSERT_EQUALS(stats.deallocations, 100u);
+		TS_ASSERT_EQUALS(stats.bytesInUse, 0u);
+		TS_ASSERT(stats.peakBytesInUse >= 1200u);
+	}
+
+	void test_frame_arena() {
+		Common::FrameArena arena(1024);
+		for (int frame = 0; frame < 3; ++frame) {
+			byte *prev = 0;
+			for (int i = 0; i < 100; ++i) {
+				byte *ptr = (byte *)arena.allocate(i % 50 + 1);
+				TS_ASSERT_EQUALS((size_t)ptr % Common::FrameArena::kAlignment, 0u);
+				memset(ptr, i, i % 50 + 1);
+				if (prev)
+					TS_ASSERT_EQUALS(*prev, (byte)(i - 1));
+				prev = ptr;
+			}
+
+			void *big = arena.allocate(4000);
+			TS_ASSERT_EQUALS((size_t)big % Common::FrameArena::kAlignment, 0u);
+			memset(big, 0, 4000);
+			TS_ASSERT_EQUALS(arena.getFrameAllocations(), 101u);
+			arena.reset();
+			TS_ASSERT_EQUALS(arena.getFrameAllocations(), 0u);
+			TS_ASSERT_EQUALS(arena.getStats().bytesInUse, 0u);
+
+			// Blocks are kept, so only big allocations need memory from now on
+			if (frame == 0)
+				arena.resetStats();
+		}
+
+		TS_ASSERT_EQUALS(arena.getStats().mallocs, 2u);
+		TS_ASSERT_EQUALS(arena.getStats().allocations, 202u);
+		TS_ASSERT_EQUALS(arena.getStats().deallocations, 202u);
+	}
+
+	void test_frame_arena_placement_new() {
+		Common::FrameArena arena;
+		ArenaTestNode *a = new (arena) ArenaTestNode();
+		ArenaTestNode *b = new (arena) ArenaTestNode();
+		b->parent = a;
+		a->x = 5;
+		TS_ASSERT_EQUALS(b->parent->x, 5);
+		TS_ASSERT(a->parent == 0);
+		arena.reset();
+	}
+};
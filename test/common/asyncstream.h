@@ -0,0 +1,189 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/asyncstream.h"
+#include "common/memstream.h"
+#include "common/system.h"
+#include "test/system.h"
+
+/** A memory stream which fails to read past a given position. */
+class FailingReadStream : public Common::MemoryReadStream {
+public:
+	FailingReadStream(const byte *data, uint32 size, uint32 failPos)
+		: Common::MemoryReadStream(data, size), _failPos(failPos), _failed(false) {}
+
+	virtual bool err() const { return _failed; }
+	virtual void clearErr() { _failed = false; Common::MemoryReadStream::clearErr(); }
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize) {
+		const uint32 start = pos();
+		if (start + dataSize > _failPos) {
+			dataSize = (start < _failPos) ? _failPos - start : 0;
+			_failed = true;
+		}
+		return Common::MemoryReadStream::read(dataPtr, dataSize);
+	}
+
+private:
+	uint32 _failPos;
+	bool _failed;
+};
+
+class AsyncReadStreamTestSuite : public CxxTest::TestSuite {
+public:
+	enum {
+		kSize = 1000
+	};
+
+	byte _contents[kSize];
+	OSystem *_system;
+
+	void setUp() {
+		for (int i = 0; i < kSize; ++i)
+			_contents[i] = (byte)(i ^ (i >> 8));
+
+		// The stream reads ahead on a thread pool, which needs a system
+		_system = 0;
+		if (!g_system)
+			g_system = _system = createTestSystem();
+	}
+
+	void tearDown() {
+		if (_system) {
+			destroyTestSystem(_system);
+			g_system = 0;
+		}
+	}
+
+	bool checkRead(Common::ReadStream &stream, uint32 start, uint32 size) {
+		byte buf[kSize];
+		if (stream.read(buf, size) != size)
+			return false;
+		return memcmp(buf, _contents + start, size) == 0;
+	}
+
+	void test_read_across_blocks() {
+		Common::MemoryReadStream ms(_contents, kSize);
+		Common::SeekableReadStream &srs = *Common::wrapAsyncReadStream(&ms, 64, DisposeAfterUse::NO);
+
+		TS_ASSERT_EQUALS(srs.size(), kSize);
+
+		// Reads of 100 bytes straddle the 64 byte blocks, and the
+		// last read is partial
+		byte buf[100];
+		for (int i = 0; i < 10; ++i) {
+			TS_ASSERT(!srs.eos());
+			TS_ASSERT_EQUALS(srs.pos(), i * 100);
+			TS_ASSERT_EQUALS(srs.read(buf, 100), 100U);
+			TS_ASSERT_EQUALS(memcmp(buf, _contents + i * 100, 100), 0);
+		}
+
+		TS_ASSERT(!srs.eos());
+		TS_ASSERT_EQUALS(srs.read(buf, 100), 0U);
+		TS_ASSERT(srs.eos());
+		TS_ASSERT(!srs.err());
+
+		delete &srs;
+	}
+
+	void test_seek() {
+		Common::MemoryReadStream ms(_contents, kSize);
+		Common::SeekableReadStream &srs = *Common::wrapAsyncReadStream(&ms, 64, DisposeAfterUse::NO);
+
+		// Inside the current block
+		TS_ASSERT(checkRead(srs, 0, 10));
+		TS_ASSERT(srs.seek(5));
+		TS_ASSERT_EQUALS(srs.pos(), 5);
+		TS_ASSERT(checkRead(srs, 5, 10));
+		TS_ASSERT(srs.seek(-15, SEEK_CUR));
+		TS_ASSERT(checkRead(srs, 0, 64));
+
+		// Into the block read ahead
+		TS_ASSERT(srs.seek(100));
+		TS_ASSERT(checkRead(srs, 100, 20));
+
+		// Outside the buffered data, forwards and backwards
+		TS_ASSERT(srs.seek(700));
+		TS_ASSERT(checkRead(srs, 700, 150));
+		TS_ASSERT(srs.seek(-990, SEEK_END));
+		TS_ASSERT_EQUALS(srs.pos(), 10);
+		TS_ASSERT(checkRead(srs, 10, 200));
+
+		// Out of range
+		TS_ASSERT(!srs.seek(-1));
+		TS_ASSERT(!srs.seek(kSize + 1));
+		TS_ASSERT_EQUALS(srs.pos(), 210);
+
+		// Seeking clears the end of stream flag
+		TS_ASSERT(srs.seek(-4, SEEK_END));
+		byte buf[8];
+		TS_ASSERT_EQUALS(srs.read(buf, 8), 4U);
+		TS_ASSERT(srs.eos());
+		TS_ASSERT(srs.seek(kSize / 2));
+		TS_ASSERT(!srs.eos());
+		TS_ASSERT(checkRead(srs, kSize / 2, kSize / 2));
+
+		delete &srs;
+	}
+
+	void test_parent_position() {
+		Common::MemoryReadStream ms(_contents, kSize);
+		ms.seek(300);
+
+		// Reading starts at the position of the parent stream
+		Common::SeekableReadStream &srs = *Common::wrapAsyncReadStream(&ms, 64, DisposeAfterUse::NO);
+		TS_ASSERT_EQUALS(srs.pos(), 300);
+		TS_ASSERT(checkRead(srs, 300, 100));
+
+		delete &srs;
+	}
+
+	void test_err() {
+		FailingReadStream fs(_contents, kSize, 500);
+		Common::SeekableReadStream &srs = *Common::wrapAsyncReadStream(&fs, 64, DisposeAfterUse::NO);
+
+		// The data before the error is delivered, then reading stops
+		byte buf[kSize];
+		TS_ASSERT_EQUALS(srs.read(buf, kSize), 500U);
+		TS_ASSERT_EQUALS(memcmp(buf, _contents, 500), 0);
+		TS_ASSERT(srs.err());
+		TS_ASSERT(srs.eos());
+
+		srs.clearErr();
+		TS_ASSERT(!srs.err());
+		TS_ASSERT(!srs.eos());
+
+		// Data before the failing position can still be read
+		fs.clearErr();
+		TS_ASSERT(srs.seek(100));
+		TS_ASSERT(checkRead(srs, 100, 100));
+		TS_ASSERT(!srs.err());
+
+		delete &srs;
+	}
+
+	void test_block_size() {
+		// The read ahead block size must not change the data read,
+		// whether blocks are tiny, odd, or larger than the whole stream
+		const uint32 blockSizes[] = { 1, 7, 64, kSize, 4 * kSize };
+		for (int i = 0; i < ARRAYSIZE(blockSizes); ++i) {
+			Common::MemoryReadStream ms(_contents, kSize);
+			Common::AsyncReadStream srs(&ms, blockSizes[i], DisposeAfterUse::NO);
+			TS_ASSERT_EQUALS(srs.getBlockSize(), blockSizes[i]);
+
+			TS_ASSERT(checkRead(srs, 0, 333));
+			TS_ASSERT(srs.seek(900));
+			TS_ASSERT(checkRead(srs, 900, 100));
+			TS_ASSERT(srs.seek(1));
+			TS_ASSERT(checkRead(srs, 1, 998));
+		}
+
+		TS_ASSERT(!Common::wrapAsyncReadStream(0, 64, DisposeAfterUse::NO));
+	}
+
+	void test_dispose() {
+		Common::MemoryReadStream *ms = new Common::MemoryReadStream(_contents, kSize);
+		Common::SeekableReadStream *srs = Common::wrapAsyncReadStream(ms, 64, DisposeAfterUse::YES);
+		TS_ASSERT(checkRead(*srs, 0, 10));
+		delete srs;
+	}
+};
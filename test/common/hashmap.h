@@ -3,6 +3,12 @@
 #include "common/hashmap.h"
 #include "common/hash-str.h"
 
+// Maps all keys to only a few hash values, so that lookups have to probe
+// many slots (and groups of slots).
+struct BadIntHash {
+	uint operator()(int x) const { return x & 3; }
+};
+
 class HashMapTestSuite : public CxxTest::TestSuite
 {
 	public:
@@ -230,5 +236,150 @@ class HashMapTestSuite : public CxxTest::TestSuite
 		TS_ASSERT(found == 16+8+4);
 }
 
+	void test_many_collisions() {
+		Common::HashMap<int, int, BadIntHash> h;
+
+		for (int i = 0; i < 200; ++i)
+			h[i] = i * 2;
+		TS_ASSERT_EQUALS(h.size(), 200u);
+
+		for (int i = 0; i < 200; i += 2)
+			h.erase(i);
+		TS_ASSERT_EQUALS(h.size(), 100u);
+
+		for (int i = 0; i < 200; ++i) {
+			TS_ASSERT_EQUALS(h.contains(i), (i & 1) != 0);
+			if (i & 1)
+				TS_ASSERT_EQUALS(h[i], i * 2);
+		}
+
+		// Slots of erased keys get reused
+		for (int i = 0; i < 200; i += 2)
+			h[i] = -i;
+		TS_ASSERT_EQUALS(h.size(), 200u);
+		for (int i = 0; i < 200; ++i)
+			TS_ASSERT_EQUALS(h[i], (i & 1) ? i * 2 : -i);
+	}
+
+	void test_erase_insert_churn() {
+		// Keep the size constant while inserting ever new keys, which
+		// fills the map with deleted entries unless they are cleaned up.
+		Common::HashMap<int, int> h;
+		for (int i = 0; i < 10000; ++i) {
+			h[i] = i;
+			if (i >= 10)
+				h.erase(i - 10);
+		}
+
+		TS_ASSERT_EQUALS(h.size(), 10u);
+		for (int i = 9990; i < 10000; ++i)
+			TS_ASSERT_EQUALS(h.getVal(i, -1), i);
+		TS_ASSERT(!h.contains(9989));
+	}
+
+	void test_erase_while_iterating() {
+		Common::HashMap<int, int> h;
+		for (int i = 0; i < 100; ++i)
+			h[i] = i;
+
+		for (Common::HashMap<int, int>::iterator i = h.begin(); i != h.end(); ++i) {
+			if (i->_key % 3 == 0)
+				h.erase(i);
+		}
+
+		TS_ASSERT_EQUALS(h.size(), 66u);
+		for (int i = 0; i < 100; ++i)
+			TS_ASSERT_EQUALS(h.contains(i), i % 3 != 0);
+	}
+
+	void test_references_stay_valid() {
+		Common::StringMap h;
+		Common::String &value = h["first"];
+		value = "value";
+
+		// Growing the map must not move existing entries
+		for (int i = 0; i < 1000; ++i)
+			h[Common::String::format("key%d", i)] = "x";
+
+		TS_ASSERT_EQUALS(&h["first"], &value);
+		TS_ASSERT_EQUALS(value, "value");
+	}
+
+	void test_copy_with_deleted_entries() {
+		Common::HashMap<int, int, BadIntHash> h;
+		for (int i = 0; i < 50; ++i)
+			h[i] = i;
+		for (int i = 0; i < 50; i += 5)
+			h.erase(i);
+
+		Common::HashMap<int, int, BadIntHash> copy(h);
+		TS_ASSERT_EQUALS(copy.size(), 40u);
+		for (int i = 0; i < 50; ++i)
+			TS_ASSERT_EQUALS(copy.getVal(i, -1), (i % 5) ? i : -1);
+	}
+
+	void test_clear_shrink() {
+		Common::HashMap<int, int> h;
+		for (int i = 0; i < 1000; ++i)
+			h[i] = i;
+
+		h.clear(true);
+		TS_ASSERT(h.empty());
+		TS_ASSERT(!h.contains(5));
+
+		h[5] = 6;
+		TS_ASSERT_EQUALS(h[5], 6);
+		TS_ASSERT_EQUALS(h.size(), 1u);
+	}
+
+	void test_c_string_lookup() {
+		Common::StringMap map;
+		map["Foo"] = "1";
+		map["this key is too long to fit into the String buffer"] = "2";
+
+		const char *foo = "fOO";
+		TS_ASSERT(map.contains(foo));
+		TS_ASSERT(!map.contains("bar"));
+		TS_ASSERT_EQUALS(map[foo], "1");
+		TS_ASSERT_EQUALS(map.getVal("THIS KEY IS TOO LONG TO FIT INTO THE STRING BUFFER"), "2");
+		TS_ASSERT_EQUALS(map.getVal("bar", "x"), "x");
+		TS_ASSERT(map.find(foo) != map.end());
+		TS_ASSERT_EQUALS(map.find(foo)->_key, "Foo");
+		TS_ASSERT(map.find("bar") == map.end());
+
+		const Common::StringMap &constMap = map;
+		TS_ASSERT_EQUALS(constMap["foo"], "1");
+		TS_ASSERT_EQUALS(constMap["bar"], "");
+		TS_ASSERT(constMap.find("bar") == constMap.end());
+		TS_ASSERT_EQUALS(map.size(), 2u);
+
+		// Missing keys are inserted, just as with String lookups
+		map["bar"] = "3";
+		TS_ASSERT_EQUALS(map.size(), 3u);
+		TS_ASSERT_EQUALS(map.getVal(Common::String("BAR")), "3");
+
+		map.erase("FOO");
+		TS_ASSERT(!map.contains("foo"));
+		TS_ASSERT_EQUALS(map.size(), 2u);
+	}
+
+	void test_c_string_lookup_case_sensitive() {
+		Common::HashMap<Common::String, int> map;
+		map["Foo"] = 1;
+		TS_ASSERT(map.contains("Foo"));
+		TS_ASSERT(!map.contains("foo"));
+		TS_ASSERT_EQUALS(map.getVal("Foo", 0), 1);
+		TS_ASSERT_EQUALS(map.getVal("foo", 0), 0);
+	}
+
+	void test_grow_keeps_string_keys() {
+		Common::StringMap map;
+		for (int i = 0; i < 1000; ++i)
+			map[Common::String::format("key%d", i)] = Common::String::format("%d", i);
+
+		for (int i = 0; i < 1000; ++i)
+			TS_ASSERT_EQUALS(map.getVal(Common::String::format("KEY%d", i).c_str()), Common::String::format("%d", i));
+	}
+
 	// TODO: Add test cases for iterators, find, ...
 };
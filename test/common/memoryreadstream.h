@@ -100,4 +100,19 @@ class MemoryReadStreamTestSuite : public CxxTest::TestSuite {
 		ms.seek(0, SEEK_SET);
 		TS_ASSERT(!ms.eos());
 	}
+
+	void test_view() {
+		byte contents[] = { 1, 2, 3, 4, 5, 6, 7 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		TS_ASSERT_EQUALS(ms.getView(0, 7), contents);
+		TS_ASSERT_EQUALS(ms.getView(2, 3), contents + 2);
+		TS_ASSERT_EQUALS(ms.getView(7, 0), contents + 7);
+		TS_ASSERT(ms.getView(5, 3) == 0);
+		TS_ASSERT(ms.getView(8, 0) == 0);
+		TS_ASSERT(ms.getView(1, 0xFFFFFFFF) == 0);
+
+		// The position is not affected
+		TS_ASSERT_EQUALS(ms.pos(), 0);
+	}
 };
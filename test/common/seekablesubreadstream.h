@@ -70,4 +70,15 @@ class SeekableSubReadStreamTestSuite : public CxxTest::TestSuite {
 		b = ssrs.readByte();
 		TS_ASSERT_EQUALS(b, 1);
 	}
+
+	void test_view() {
+		byte contents[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+		Common::MemoryReadStream ms(contents, 10);
+		Common::SeekableSubReadStream ssrs(&ms, 2, 8);
+
+		TS_ASSERT_EQUALS(ssrs.getView(0, 6), contents + 2);
+		TS_ASSERT_EQUALS(ssrs.getView(3, 2), contents + 5);
+		TS_ASSERT(ssrs.getView(3, 4) == 0);
+		TS_ASSERT(ssrs.getView(7, 0) == 0);
+	}
 };
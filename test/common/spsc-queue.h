@@ -0,0 +1,101 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/spsc-queue.h"
+
+class SPSCQueueTestSuite : public CxxTest::TestSuite {
+public:
+	void test_empty_full() {
+		Common::SPSCQueue<int, 4> queue;
+		TS_ASSERT(queue.empty());
+		TS_ASSERT(!queue.full());
+		TS_ASSERT_EQUALS(queue.size(), 0U);
+		TS_ASSERT_EQUALS(queue.capacity(), 4U);
+
+		for (int i = 0; i < 4; ++i)
+			TS_ASSERT(queue.push(i));
+
+		TS_ASSERT(queue.full());
+		TS_ASSERT(!queue.push(4));
+		TS_ASSERT_EQUALS(queue.size(), 4U);
+
+		int value;
+		TS_ASSERT(queue.pop(value));
+		TS_ASSERT(!queue.full());
+		TS_ASSERT(queue.push(4));
+	}
+
+	void test_fifo_order() {
+		Common::SPSCQueue<int, 8> queue;
+		int value = -1;
+
+		TS_ASSERT(!queue.pop(value));
+		TS_ASSERT_EQUALS(value, -1);
+
+		queue.push(42);
+		queue.push(-23);
+		queue.push(7);
+
+		TS_ASSERT(queue.pop(value));
+		TS_ASSERT_EQUALS(value, 42);
+		TS_ASSERT(queue.pop(value));
+		TS_ASSERT_EQUALS(value, -23);
+		TS_ASSERT(queue.pop(value));
+		TS_ASSERT_EQUALS(value, 7);
+		TS_ASSERT(queue.empty());
+	}
+
+	void test_wraparound() {
+		Common::SPSCQueue<int, 4> queue;
+		int value;
+
+		// Push and pop many more items than fit, so that the indices wrap
+		for (int i = 0; i < 100; ++i) {
+			TS_ASSERT(queue.push(i));
+			TS_ASSERT(queue.push(i + 1000));
+			TS_ASSERT(queue.pop(value));
+			TS_ASSERT_EQUALS(value, i);
+			TS_ASSERT(queue.pop(value));
+			TS_ASSERT_EQUALS(value, i + 1000);
+		}
+
+		TS_ASSERT(queue.empty());
+	}
+
+	void test_ring_partial_transfers() {
+		Common::SPSCRingBuffer<int16> ring(8);
+		const int16 input[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+		int16 output[10];
+
+		TS_ASSERT_EQUALS(ring.capacity(), 8u);
+		TS_ASSERT_EQUALS(ring.read(output, 4), 0u);
+
+		// Only as much as fits is written...
+		TS_ASSERT_EQUALS(ring.write(input, 10), 8u);
+		TS_ASSERT_EQUALS(ring.size(), 8u);
+		TS_ASSERT_EQUALS(ring.space(), 0u);
+
+		// ...and only as much as is available is read
+		TS_ASSERT_EQUALS(ring.read(output, 5), 5u);
+		TS_ASSERT_EQUALS(ring.read(output + 5, 5), 3u);
+		for (int i = 0; i < 8; ++i)
+			TS_ASSERT_EQUALS(output[i], input[i]);
+		TS_ASSERT_EQUALS(ring.size(), 0u);
+	}
+
+	void test_ring_wraparound() {
+		Common::SPSCRingBuffer<int16> ring(16);
+		int16 input[7], output[7];
+		int16 next = 0, expected = 0;
+
+		// Blocks which do not divide the capacity force copies across the end
+		for (int i = 0; i < 50; ++i) {
+			for (int j = 0; j < 7; ++j)
+				input[j] = next++;
+			TS_ASSERT_EQUALS(ring.write(input, 7), 7u);
+
+			TS_ASSERT_EQUALS(ring.read(output, 7), 7u);
+			for (int j = 0; j < 7; ++j)
+				TS_ASSERT_EQUALS(output[j], expected++);
+		}
+	}
+};
@@ -0,0 +1,140 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/conversion.h"
+#include "graphics/pixelformat.h"
+#include "graphics/surface.h"
+#include "common/cpudetect.h"
+
+class ConversionTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		// Odd sizes, so that the SIMD code has to handle leftover pixels
+		kWidth = 37,
+		kHeight = 5,
+		// Some padding at the end of each row, which must stay untouched
+		kSrcPitch = kWidth * 4 + 3,
+		kDstPitch = kWidth * 4 + 5,
+		kNumFormats = 10
+	};
+
+	static Graphics::PixelFormat getFormat(int i) {
+		static const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0),
+			Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15),
+			Graphics::PixelFormat(2, 4, 4, 4, 4, 12, 8, 4, 0),
+			Graphics::PixelFormat(3, 8, 8, 8, 0, 16, 8, 0, 0),
+			Graphics::PixelFormat(3, 8, 8, 8, 0, 0, 8, 16, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24),
+			Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0)
+		};
+		return formats[i];
+	}
+
+	static void fillRandom(byte *buf, int size, uint32 seed) {
+		for (int i = 0; i < size; ++i) {
+			seed = seed * 1103515245 + 12345;
+			buf[i] = seed >> 24;
+		}
+	}
+
+	static void fillSurface(Graphics::Surface &surface, const Graphics::PixelFormat &format, uint32 seed) {
+		surface.create(kWidth, kHeight, format);
+		fillRandom((byte *)surface.getPixels(), surface.pitch * surface.h, seed);
+	}
+
+public:
+	void test_crossBlit() {
+		byte src[kSrcPitch * kHeight];
+		byte expected[kDstPitch * kHeight], actual[kDstPitch * kHeight];
+
+		for (int s = 0; s < kNumFormats; ++s) {
+			for (int d = 0; d < kNumFormats; ++d) {
+				const Graphics::PixelFormat srcFmt = getFormat(s);
+				const Graphics::PixelFormat dstFmt = getFormat(d);
+				if (dstFmt.bytesPerPixel == 3)
+					continue;
+
+				fillRandom(src, sizeof(src), s * kNumFormats + d);
+				memset(expected, 0x55, sizeof(expected));
+				memset(actual, 0x55, sizeof(actual));
+
+				Common::setDisabledCPUFeatures(0xFFFFFFFF);
+				TS_ASSERT(Graphics::crossBlit(expected, src, kDstPitch, kSrcPitch, kWidth, kHeight, dstFmt, srcFmt));
+				Common::setDisabledCPUFeatures(0);
+				TS_ASSERT(Graphics::crossBlit(actual, src, kDstPitch, kSrcPitch, kWidth, kHeight, dstFmt, srcFmt));
+
+				TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(expected)), 0);
+			}
+		}
+	}
+
+	void test_convertToInPlace() {
+		for (int s = 0; s < kNumFormats; ++s) {
+			for (int d = 0; d < kNumFormats; ++d) {
+				const Graphics::PixelFormat srcFmt = getFormat(s);
+				const Graphics::PixelFormat dstFmt = getFormat(d);
+				if (dstFmt.bytesPerPixel == 3)
+					continue;
+
+				Graphics::Surface expected, actual;
+				fillSurface(expected, srcFmt, s * kNumFormats + d);
+				fillSurface(actual, srcFmt, s * kNumFormats + d);
+
+				Common::setDisabledCPUFeatures(0xFFFFFFFF);
+				Graphics::Surface *converted = expected.convertTo(dstFmt);
+				Common::setDisabledCPUFeatures(0);
+				actual.convertToInPlace(dstFmt);
+
+				TS_ASSERT_EQUALS(actual.format, dstFmt);
+				TS_ASSERT_EQUALS(actual.pitch, converted->pitch);
+				TS_ASSERT_EQUALS(memcmp(actual.getPixels(), converted->getPixels(), actual.pitch * actual.h), 0);
+
+				converted->free();
+				delete converted;
+				expected.free();
+				actual.free();
+			}
+		}
+	}
+
+	void test_crossBlitMap() {
+		byte palette[256 * 3];
+		fillRandom(palette, sizeof(palette), 1);
+
+		for (int d = 0; d < kNumFormats; ++d) {
+			const Graphics::PixelFormat dstFmt = getFormat(d);
+			if (dstFmt.bytesPerPixel == 3)
+				continue;
+
+			Graphics::Surface src;
+			fillSurface(src, Graphics::PixelFormat::createFormatCLUT8(), d);
+			byte indices[kWidth * kHeight];
+			memcpy(indices, src.getPixels(), sizeof(indices));
+
+			Graphics::Surface *converted = src.convertTo(dstFmt, palette);
+			src.convertToInPlace(dstFmt, palette);
+			TS_ASSERT_EQUALS(memcmp(src.getPixels(), converted->getPixels(), src.pitch * src.h), 0);
+
+			for (int y = 0; y < kHeight; ++y) {
+				for (int x = 0; x < kWidth; ++x) {
+					const byte *entry = palette + indices[y * kWidth + x] * 3;
+					const uint32 color = dstFmt.RGBToColor(entry[0], entry[1], entry[2]);
+
+					if (dstFmt.bytesPerPixel == 2) {
+						TS_ASSERT_EQUALS(*(const uint16 *)converted->getBasePtr(x, y), color);
+					} else {
+						TS_ASSERT_EQUALS(*(const uint32 *)converted->getBasePtr(x, y), color);
+					}
+				}
+			}
+
+			converted->free();
+			delete converted;
+			src.free();
+		}
+	}
+};
@@ -0,0 +1,146 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/dirtyrects.h"
+
+class DirtyRectTrackerTestSuite : public CxxTest::TestSuite
+{
+private:
+	/** Check that the rects are inside the area, disjoint and cover 'added'. */
+	static void checkCover(const Common::Rect *rects, int count, const Common::Rect *added, int numAdded, int width, int height) {
+		for (int i = 0; i < count; ++i) {
+			TS_ASSERT(rects[i].isValidRect());
+			TS_ASSERT(Common::Rect(width, height).contains(rects[i]));
+			for (int j = i + 1; j < count; ++j)
+				TS_ASSERT(!rects[i].intersects(rects[j]));
+		}
+
+		for (int a = 0; a < numAdded; ++a) {
+			Common::Rect r = added[a];
+			r.clip(Common::Rect(width, height));
+			for (int y = r.top; y < r.bottom; ++y) {
+				for (int x = r.left; x < r.right; ++x) {
+					bool covered = false;
+					for (int i = 0; i < count && !covered; ++i)
+						covered = rects[i].contains(x, y);
+					TS_ASSERT(covered);
+				}
+			}
+		}
+	}
+
+public:
+	void test_empty() {
+		Graphics::DirtyRectTracker tracker;
+		tracker.resize(320, 200);
+		Common::Rect rects[10];
+
+		TS_ASSERT(tracker.isEmpty());
+		TS_ASSERT_EQUALS(tracker.getRects(rects, 10), 0);
+
+		// Rects outside of the area are ignored
+		tracker.addRect(Common::Rect(320, 0, 330, 10));
+		tracker.addRect(Common::Rect(-10, -10, 0, 0));
+		TS_ASSERT(tracker.isEmpty());
+		TS_ASSERT_EQUALS(tracker.getDirtyArea(), 0u);
+	}
+
+	void test_tile_alignment() {
+		Graphics::DirtyRectTracker tracker;
+		tracker.resize(100, 50);
+		Common::Rect rects[10];
+
+		tracker.addRect(Common::Rect(3, 9, 11, 10));
+		TS_ASSERT_EQUALS(tracker.getRects(rects, 10), 1);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(0, 8, 16, 16));
+		TS_ASSERT_EQUALS(tracker.getDirtyArea(), 128u);
+
+		// Tiles at the border are clipped to the area
+		tracker.clear();
+		tracker.addRect(Common::Rect(95, 45, 200, 200));
+		TS_ASSERT_EQUALS(tracker.getRects(rects, 10), 1);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(88, 40, 100, 50));
+		TS_ASSERT_EQUALS(tracker.getDirtyArea(), 120u);
+
+		tracker.markAll();
+		TS_ASSERT_EQUALS(tracker.getDirtyArea(), 5000u);
+		TS_ASSERT_EQUALS(tracker.getRects(rects, 10), 1);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(100, 50));
+	}
+
+	void test_coalesce() {
+		Graphics::DirtyRectTracker tracker;
+		tracker.resize(640, 480);
+		Common::Rect rects[10];
+
+		// Overlapping and adjacent rects in the same tiles make one rect
+		tracker.addRect(Common::Rect(10, 10, 30, 30));
+		tracker.addRect(Common::Rect(20, 20, 40, 40));
+		tracker.addRect(Common::Rect(8, 16, 40, 40));
+		tracker.addRect(Common::Rect(8, 8, 40, 16));
+		TS_ASSERT_EQUALS(tracker.getRects(rects, 10), 1);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(8, 8, 40, 40));
+
+		// Runs of different widths are not merged
+		tracker.clear();
+		tracker.addRect(Common::Rect(0, 0, 64, 8));
+		tracker.addRect(Common::Rect(0, 8, 32, 16));
+		tracker.addRect(Common::Rect(300, 0, 310, 16));
+		TS_ASSERT_EQUALS(tracker.getRects(rects, 10), 3);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(0, 0, 64, 8));
+		TS_ASSERT_EQUALS(rects[1], Common::Rect(296, 0, 312, 16));
+		TS_ASSERT_EQUALS(rects[2], Common::Rect(0, 8, 32, 16));
+	}
+
+	void test_many_rects() {
+		// More small sprites than the old 100 entry list could hold
+		Graphics::DirtyRectTracker tracker;
+		tracker.resize(640, 480);
+		Common::Rect added[300];
+		Common::Rect rects[100];
+
+		uint32 seed = 1;
+		for (int i = 0; i < ARRAYSIZE(added); ++i) {
+			seed = seed * 1103515245 + 12345;
+			const int x = (seed >> 8) % 660 - 10;
+			const int y = (seed >> 16) % 500 - 10;
+			added[i] = Common::Rect(x, y, x + 1 + (seed & 15), y + 1 + ((seed >> 4) & 15));
+			tracker.addRect(added[i]);
+		}
+
+		const int count = tracker.getRects(rects, ARRAYSIZE(rects));
+		TS_ASSERT_LESS_THAN_EQUALS(count, ARRAYSIZE(rects));
+		checkCover(rects, count, added, ARRAYSIZE(added), 640, 480);
+
+		// Far less than the full screen has to be redrawn
+		uint32 area = 0;
+		for (int i = 0; i < count; ++i)
+			area += rects[i].width() * rects[i].height();
+		TS_ASSERT_LESS_THAN(area, 640u * 480u);
+	}
+
+	void test_random() {
+		Graphics::DirtyRectTracker tracker;
+		tracker.resize(333, 211);
+		Common::Rect added[20];
+		Common::Rect rects[40];
+
+		uint32 seed = 7;
+		for (int round = 0; round < 50; ++round) {
+			tracker.clear();
+			const int numAdded = round % ARRAYSIZE(added) + 1;
+			for (int i = 0; i < numAdded; ++i) {
+				seed = seed * 1103515245 + 12345;
+				const int x = (seed >> 8) % 350 - 10;
+				const int y = (seed >> 16) % 230 - 10;
+				added[i] = Common::Rect(x, y, x + 1 + (seed & 63), y + 1 + ((seed >> 6) & 31));
+				tracker.addRect(added[i]);
+			}
+
+			// Also force the fallback to bands now and then
+			const int maxRects = (round & 1) ? ARRAYSIZE(rects) : 3;
+			const int count = tracker.getRects(rects, maxRects);
+			TS_ASSERT_LESS_THAN_EQUALS(count, maxRects);
+			checkCover(rects, count, added, numAdded, 333, 211);
+		}
+	}
+};
@@ -0,0 +1,107 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/scaler.h"
+#include "graphics/scaler/hq_patterns.h"
+#include "common/cpudetect.h"
+
+class HQxTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		// Odd sizes, so that the SIMD code has to handle leftover pixels, and
+		// more than one chunk of patterns per row
+		kWidth = 277,
+		kHeight = 7,
+		// The scalers read one pixel around the rectangle
+		kSrcPitch = kWidth + 2
+	};
+
+	/**
+	 * Fill the source with variations of a few colors. The components only
+	 * differ by small amounts, so that the YUV differences are around the
+	 * thresholds the scalers use.
+	 */
+	static void fillSource(uint16 *src, int count, uint32 seed, int bitFormat) {
+		static const uint16 base[] = { 0x0000, 0x8410, 0x4208, 0xF800, 0x07E0, 0x001F, 0xFFFF, 0x39E7 };
+
+		for (int i = 0; i < count; ++i) {
+			seed = seed * 1103515245 + 12345;
+			uint16 color = base[(seed >> 16) & 7];
+			if (seed & 0x80000000)
+				color ^= (seed >> 8) & 0x0C63;
+			if (bitFormat == 555 && (seed & 0x40))
+				color |= 0x8000;
+			src[i] = color;
+		}
+	}
+
+	static void compareScaler(ScalerProc *scaler, int scale, int bitFormat) {
+		uint16 src[kSrcPitch * (kHeight + 2)];
+		uint16 expected[kWidth * 3 * kHeight * 3], actual[kWidth * 3 * kHeight * 3];
+		const uint8 *srcPtr = (const uint8 *)(src + kSrcPitch + 1);
+		const uint32 dstPitch = kWidth * scale * sizeof(uint16);
+
+		InitScalers(bitFormat);
+		for (uint32 seed = 0; seed < 20; ++seed) {
+			fillSource(src, ARRAYSIZE(src), seed, bitFormat);
+
+			memset(expected, 0, sizeof(expected));
+			memset(actual, 0xFF, sizeof(actual));
+
+			Common::setDisabledCPUFeatures(0xFFFFFFFF);
+			scaler(srcPtr, kSrcPitch * sizeof(uint16), (uint8 *)expected, dstPitch, kWidth, kHeight);
+			Common::setDisabledCPUFeatures(0);
+			scaler(srcPtr, kSrcPitch * sizeof(uint16), (uint8 *)actual, dstPitch, kWidth, kHeight);
+
+			TS_ASSERT_EQUALS(memcmp(expected, actual, dstPitch * kHeight * scale), 0);
+		}
+		DestroyScalers();
+	}
+
+	static void comparePatterns(int bitFormat) {
+		uint16 src[kSrcPitch * 3];
+		uint16 expected[kWidth], actual[kWidth];
+
+		InitScalers(bitFormat);
+		const Graphics::HQPatternProc classify = Graphics::getHQPatternProc();
+		if (!classify) {
+			// No SIMD code for this CPU
+			DestroyScalers();
+			return;
+		}
+
+		for (uint32 seed = 0; seed < 100; ++seed) {
+			fillSource(src, ARRAYSIZE(src), seed, bitFormat);
+			Graphics::classifyHQPatterns(src + kSrcPitch + 1, kSrcPitch, expected, kWidth);
+			classify(src + kSrcPitch + 1, kSrcPitch, actual, kWidth);
+			for (int i = 0; i < kWidth; ++i)
+				TS_ASSERT_EQUALS(expected[i], actual[i]);
+		}
+		DestroyScalers();
+	}
+
+public:
+	void test_patterns_565() {
+		comparePatterns(565);
+	}
+
+	void test_patterns_555() {
+		comparePatterns(555);
+	}
+
+	void test_hq2x_565() {
+		compareScaler(HQ2x, 2, 565);
+	}
+
+	void test_hq2x_555() {
+		compareScaler(HQ2x, 2, 555);
+	}
+
+	void test_hq3x_565() {
+		compareScaler(HQ3x, 3, 565);
+	}
+
+	void test_hq3x_555() {
+		compareScaler(HQ3x, 3, 555);
+	}
+};
@@ -0,0 +1,64 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/surface.h"
+#include "graphics/surface_pool.h"
+
+class SurfacePoolTestSuite : public CxxTest::TestSuite
+{
+public:
+	void test_reuse() {
+		const Graphics::PixelFormat format(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		Graphics::SurfacePool pool;
+
+		Graphics::Surface *a = pool.acquire(16, 8, format);
+		TS_ASSERT_EQUALS(a->w, 16);
+		TS_ASSERT_EQUALS(a->h, 8);
+		TS_ASSERT_EQUALS(a->format, format);
+		TS_ASSERT(a->getPixels());
+
+		Graphics::Surface *b = pool.acquire(16, 8, format);
+		TS_ASSERT_DIFFERS(a, b);
+		TS_ASSERT_EQUALS(pool.getAllocationCount(), 2U);
+
+		pool.release(a);
+		pool.release(b);
+		TS_ASSERT_EQUALS(pool.getFreeCount(), 2U);
+
+		// The last surface released is handed out first
+		TS_ASSERT_EQUALS(pool.acquire(16, 8, format), b);
+		TS_ASSERT_EQUALS(pool.acquire(16, 8, format), a);
+		TS_ASSERT_EQUALS(pool.getFreeCount(), 0U);
+		TS_ASSERT_EQUALS(pool.getAllocationCount(), 2U);
+
+		pool.release(a);
+		pool.release(b);
+	}
+
+	void test_mismatch() {
+		const Graphics::PixelFormat format16(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		const Graphics::PixelFormat format32(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		Graphics::SurfacePool pool;
+
+		Graphics::Surface *large = pool.acquire(16, 8, format16);
+		Graphics::Surface *small = pool.acquire(8, 8, format16);
+		pool.release(large);
+		pool.release(small);
+
+		// Neither size nor format match, so the oldest surface is recreated
+		Graphics::Surface *surface = pool.acquire(16, 8, format32);
+		TS_ASSERT_EQUALS(surface->w, 16);
+		TS_ASSERT_EQUALS(surface->format, format32);
+		TS_ASSERT_EQUALS(surface->pitch, 16 * 4);
+		TS_ASSERT_EQUALS(pool.getFreeCount(), 1U);
+		TS_ASSERT_EQUALS(pool.getAllocationCount(), 3U);
+
+		// The 8x8 surface is still there
+		TS_ASSERT_EQUALS(pool.acquire(8, 8, format16), small);
+		TS_ASSERT_EQUALS(pool.getAllocationCount(), 3U);
+
+		pool.release(surface);
+		pool.release(small);
+		pool.clear();
+		TS_ASSERT_EQUALS(pool.getFreeCount(), 0U);
+	}
+};
@@ -0,0 +1,130 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+#include "common/cpudetect.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		// All chroma values appear in the first 256 columns and rows of the
+		// chroma planes, the rest is left over for the SIMD code
+		kChromaSize = 256,
+		kExtraColumns = 6,
+		// The destination surfaces are wider than the image
+		kDstPadding = 3
+	};
+
+	static Graphics::PixelFormat getFormat(int i) {
+		static const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0),
+			Graphics::PixelFormat(2, 4, 4, 4, 4, 12, 8, 4, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 0, 0, 8, 16, 0)
+		};
+		return formats[i];
+	}
+
+	static void fillLuma(byte *plane, int width, int height) {
+		for (int y = 0; y < height; ++y)
+			for (int x = 0; x < width; ++x)
+				plane[y * width + x] = (x * 7 + y * 13 + x * y) & 0xFF;
+	}
+
+	static void fillChroma(byte *u, byte *v, int width, int height) {
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				u[y * width + x] = x & 0xFF;
+				v[y * width + x] = (y + x / 256 * 77) & 0xFF;
+			}
+		}
+	}
+
+	/** Convert with each available converter and compare to the table based one. */
+	static void compare(bool is420, int chromaHeight) {
+		const int width = kChromaSize * (is420 ? 2 : 1) + kExtraColumns;
+		const int height = chromaHeight * (is420 ? 2 : 1);
+		const int chromaWidth = is420 ? width / 2 : width;
+
+		byte *yPlane = new byte[width * height];
+		byte *uPlane = new byte[chromaWidth * chromaHeight];
+		byte *vPlane = new byte[chromaWidth * chromaHeight];
+		fillLuma(yPlane, width, height);
+		fillChroma(uPlane, vPlane, chromaWidth, chromaHeight);
+
+		static const uint32 disabledFeatures[] = { 0, Common::kCpuFeatureAVX2 };
+
+		for (int f = 0; f < 6; ++f) {
+			for (int s = 0; s < 2; ++s) {
+				const Graphics::YUVToRGBManager::LuminanceScale scale = s ? Graphics::YUVToRGBManager::kScaleITU : Graphics::YUVToRGBManager::kScaleFull;
+
+				Graphics::Surface expected, actual;
+				expected.create(width + kDstPadding, height, getFormat(f));
+				actual.create(width + kDstPadding, height, getFormat(f));
+				const uint32 size = expected.pitch * height;
+				memset(expected.getPixels(), 0x55, size);
+
+				Common::setDisabledCPUFeatures(0xFFFFFFFF);
+				if (is420)
+					YUVToRGBMan.convert420(&expected, scale, yPlane, uPlane, vPlane, width, height, width, chromaWidth);
+				else
+					YUVToRGBMan.convert444(&expected, scale, yPlane, uPlane, vPlane, width, height, width, chromaWidth);
+
+				for (int i = 0; i < ARRAYSIZE(disabledFeatures); ++i) {
+					memset(actual.getPixels(), 0x55, size);
+
+					Common::setDisabledCPUFeatures(disabledFeatures[i]);
+					if (is420)
+						YUVToRGBMan.convert420(&actual, scale, yPlane, uPlane, vPlane, width, height, width, chromaWidth);
+					else
+						YUVToRGBMan.convert444(&actual, scale, yPlane, uPlane, vPlane, width, height, width, chromaWidth);
+
+					TS_ASSERT_EQUALS(memcmp(expected.getPixels(), actual.getPixels(), size), 0);
+				}
+
+				expected.free();
+				actual.free();
+			}
+		}
+
+		Common::setDisabledCPUFeatures(0);
+		delete[] yPlane;
+		delete[] uPlane;
+		delete[] vPlane;
+	}
+
+public:
+	void test_convert444() {
+		compare(false, kChromaSize);
+	}
+
+	void test_convert420() {
+		compare(true, 32);
+	}
+
+	void test_convert420_padding() {
+		// The table based converter used to ignore the destination pitch
+		const Graphics::PixelFormat format(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		byte yPlane[4 * 4], uPlane[2 * 2], vPlane[2 * 2];
+		fillLuma(yPlane, 4, 4);
+		fillChroma(uPlane, vPlane, 2, 2);
+
+		Graphics::Surface wide, narrow;
+		wide.create(7, 4, format);
+		narrow.create(4, 4, format);
+
+		Common::setDisabledCPUFeatures(0xFFFFFFFF);
+		YUVToRGBMan.convert420(&wide, Graphics::YUVToRGBManager::kScaleFull, yPlane, uPlane, vPlane, 4, 4, 4, 2);
+		YUVToRGBMan.convert420(&narrow, Graphics::YUVToRGBManager::kScaleFull, yPlane, uPlane, vPlane, 4, 4, 4, 2);
+		Common::setDisabledCPUFeatures(0);
+
+		for (int y = 0; y < 4; ++y)
+			TS_ASSERT_EQUALS(memcmp(wide.getBasePtr(0, y), narrow.getBasePtr(0, y), 4 * 2), 0);
+
+		wide.free();
+		narrow.free();
+	}
+};
@@ -0,0 +1,229 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+// We use POSIX threads and the standard C library directly
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/system.h"
+
+// The test headers in test/common shadow the headers of the same name in
+// common/ here, so only include headers without a test of the same name
+#include "audio/mixer_intern.h"
+#include "common/system.h"
+#include "graphics/pixelformat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef POSIX
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+class TestSystem : public OSystem {
+public:
+	TestSystem() : _mixer(0) {}
+	virtual ~TestSystem() { delete _mixer; }
+
+	// Graphics and input: not available
+
+	virtual const GraphicsMode *getSupportedGraphicsModes() const { return s_noGraphicsModes; }
+	virtual int getDefaultGraphicsMode() const { return 0; }
+	virtual bool setGraphicsMode(int mode) { return false; }
+	virtual int getGraphicsMode() const { return 0; }
+	virtual Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	virtual Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	virtual void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+	virtual int16 getHeight() { return 0; }
+	virtual int16 getWidth() { return 0; }
+	virtual PaletteManager *getPaletteManager() { return 0; }
+	virtual void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual Graphics::Surface *lockScreen() { return 0; }
+	virtual void unlockScreen() {}
+	virtual void fillScreen(uint32 col) {}
+	virtual void updateScreen() {}
+	virtual void setShakePos(int shakeOffset) {}
+	virtual void showOverlay() {}
+	virtual void hideOverlay() {}
+	virtual Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0); }
+	virtual void clearOverlay() {}
+	virtual void grabOverlay(void *buf, int pitch) {}
+	virtual void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual int16 getOverlayHeight() { return 0; }
+	virtual int16 getOverlayWidth() { return 0; }
+	virtual bool showMouse(bool visible) { return false; }
+	virtual void warpMouse(int x, int y) {}
+	virtual void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {}
+	virtual void quit() { exit(0); }
+	virtual void displayMessageOnOSD(const char *msg) {}
+
+	// Sound
+
+	virtual Audio::Mixer *getMixer() {
+		// Created on demand, as the mixer needs mutexes from g_system. It
+		// accepts sounds, but never plays them.
+		if (!_mixer) {
+			_mixer = new Audio::MixerImpl(this, 44100);
+			_mixer->setReady(true);
+		}
+		return _mixer;
+	}
+
+	// Time
+
+	virtual uint32 getMillis(bool skipRecord = false) { return getMicros() / 1000; }
+	virtual void getTimeAndDate(TimeDate &t) const {}
+
+#ifdef POSIX
+	virtual uint32 getMicros() {
+		struct timeval tv;
+		gettimeofday(&tv, 0);
+		return (uint32)tv.tv_sec * 1000000 + tv.tv_usec;
+	}
+
+	virtual void delayMillis(uint msecs) { usleep(msecs * 1000); }
+#else
+	virtual void delayMillis(uint msecs) {}
+#endif
+
+	// Mutexes, threads and semaphores
+
+#ifdef POSIX
+	virtual MutexRef createMutex() {
+		pthread_mutex_t *mutex = new pthread_mutex_t;
+		pthread_mutex_init(mutex, 0);
+		return (MutexRef)mutex;
+	}
+
+	virtual void lockMutex(MutexRef mutex) { pthread_mutex_lock((pthread_mutex_t *)mutex); }
+	virtual void unlockMutex(MutexRef mutex) { pthread_mutex_unlock((pthread_mutex_t *)mutex); }
+
+	virtual void deleteMutex(MutexRef mutex) {
+		pthread_mutex_destroy((pthread_mutex_t *)mutex);
+		delete (pthread_mutex_t *)mutex;
+	}
+
+	virtual ThreadRef createThread(ThreadProc proc, void *param) {
+		Thread *thread = new Thread;
+		thread->proc = proc;
+		thread->param = param;
+		if (pthread_create(&thread->handle, 0, threadEntry, thread) != 0) {
+			delete thread;
+			return 0;
+		}
+		return (ThreadRef)thread;
+	}
+
+	virtual void joinThread(ThreadRef thread) {
+		pthread_join(((Thread *)thread)->handle, 0);
+		delete (Thread *)thread;
+	}
+
+	virtual SemaphoreRef createSemaphore(uint initialValue) {
+		Semaphore *sem = new Semaphore;
+		pthread_mutex_init(&sem->mutex, 0);
+		pthread_cond_init(&sem->cond, 0);
+		sem->value = initialValue;
+		return (SemaphoreRef)sem;
+	}
+
+	virtual void waitSemaphore(SemaphoreRef semaphore) {
+		Semaphore *sem = (Semaphore *)semaphore;
+		pthread_mutex_lock(&sem->mutex);
+		while (sem->value == 0)
+			pthread_cond_wait(&sem->cond, &sem->mutex);
+		sem->value--;
+		pthread_mutex_unlock(&sem->mutex);
+	}
+
+	virtual void postSemaphore(SemaphoreRef semaphore) {
+		Semaphore *sem = (Semaphore *)semaphore;
+		pthread_mutex_lock(&sem->mutex);
+		sem->value++;
+		pthread_cond_signal(&sem->cond);
+		pthread_mutex_unlock(&sem->mutex);
+	}
+
+	virtual void deleteSemaphore(SemaphoreRef semaphore) {
+		Semaphore *sem = (Semaphore *)semaphore;
+		pthread_cond_destroy(&sem->cond);
+		pthread_mutex_destroy(&sem->mutex);
+		delete sem;
+	}
+#else
+	// Without threads, mutexes are not needed
+	virtual MutexRef createMutex() { return 0; }
+	virtual void lockMutex(MutexRef mutex) {}
+	virtual void unlockMutex(MutexRef mutex) {}
+	virtual void deleteMutex(MutexRef mutex) {}
+#endif
+
+	// Logging
+
+	virtual void logMessage(LogMessageType::Type type, const char *message) {
+		FILE *output = (type == LogMessageType::kError || type == LogMessageType::kWarning) ? stderr : stdout;
+		fputs(message, output);
+		fflush(output);
+	}
+
+private:
+	static const GraphicsMode s_noGraphicsModes[];
+
+	Audio::MixerImpl *_mixer;
+
+#ifdef POSIX
+	struct Thread {
+		pthread_t handle;
+		ThreadProc proc;
+		void *param;
+	};
+
+	struct Semaphore {
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
+		uint value;
+	};
+
+	static void *threadEntry(void *param) {
+		Thread *thread = (Thread *)param;
+		thread->proc(thread->param);
+		return 0;
+	}
+#endif
+};
+
+const OSystem::GraphicsMode TestSystem::s_noGraphicsModes[] = {
+	{ 0, 0, 0 }
+};
+
+} // End of anonymous namespace
+
+OSystem *createTestSystem() {
+	return new TestSystem();
+}
+
+void destroyTestSystem(OSystem *system) {
+	delete (TestSystem *)system;
+}
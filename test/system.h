@@ -0,0 +1,39 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef TEST_SYSTEM_H
+#define TEST_SYSTEM_H
+
+class OSystem;
+
+/**
+ * Create a minimal OSystem for running engine-independent code outside of
+ * a backend, as in the unit tests and the benchmark tool. It only provides mutexes, the time and logging, plus threads
+ * and semaphores on POSIX systems. There is no graphics or input, and the
+ * mixer never plays the sounds it is given.
+ */
+OSystem *createTestSystem();
+
+/** Destroy a system created by createTestSystem(). */
+void destroyTestSystem(OSystem *system);
+
+#endif
@@ -449,6 +449,10 @@ Graphics::PixelFormat AVIDecoder::AVIVideoTrack::getPixelFormat() const {
 	return Graphics::PixelFormat();
 }
 
+bool AVIDecoder::AVIVideoTrack::setOutputPixelFormat(const Graphics::PixelFormat &format) {
+	return _videoCodec && _videoCodec->setOutputPixelFormat(format);
+}
+
 Codec *AVIDecoder::AVIVideoTrack::createCodec() {
 	switch (_vidsHeader.streamHandler) {
 	case ID_CRAM:
@@ -31,6 +31,7 @@
 #include "common/textconsole.h"
 #include "common/math.h"
 #include "common/stream.h"
+#include "common/memstream.h"
 #include "common/substream.h"
 #include "common/file.h"
 #include "common/str.h"
@@ -39,6 +40,7 @@
 #include "common/rdft.h"
 #include "common/dct.h"
 #include "common/system.h"
+#include "common/threadpool.h"
 
 #include "graphics/yuv_to_rgb.h"
 #include "graphics/surface.h"
@@ -59,14 +61,31 @@ static const uint16 kAudioFlagStereo = 0x2000;
 // Number of bits used to store first DC value in bundle
 static const uint32 kDCStartBits = 11;
 
+// Frames are only converted to RGB in parallel in bands of at least that many rows
+static const int kMinConversionBandHeight = 32;
+
 namespace Video {
 
 BinkDecoder::BinkDecoder() {
 	_bink = 0;
+	_pool = 0;
 }
 
 BinkDecoder::~BinkDecoder() {
 	close();
+
+	delete _pool;
+}
+
+void BinkDecoder::setThreadCount(uint numThreads) {
+	delete _pool;
+	_pool = 0;
+
+	if (numThreads > 0)
+		_pool = new Common::ThreadPool(numThreads);
+
+	if (isVideoLoaded())
+		((BinkVideoTrack *)getTrack(0))->setThreadPool(_pool);
 }
 
 bool BinkDecoder::loadStream(Common::SeekableReadStream *stream) {
@@ -102,8 +121,10 @@ bool BinkDecoder::loadStream(Common::SeekableReadStream *stream) {
 	uint32 videoFlags = _bink->readUint32LE();
 
 	// BIKh and BIKi swap the chroma planes
-	addTrack(new BinkVideoTrack(width, height, getDefaultHighColorFormat(), frameCount,
-			Common::Rational(frameRateNum, frameRateDen), (id == kBIKhID || id == kBIKiID), videoFlags & kVideoFlagAlpha, id));
+	BinkVideoTrack *videoTrack = new BinkVideoTrack(width, height, getDefaultHighColorFormat(), frameCount,
+			Common::Rational(frameRateNum, frameRateDen), (id == kBIKhID || id == kBIKiID), videoFlags & kVideoFlagAlpha, id);
+	videoTrack->setThreadPool(_pool);
+	addTrack(videoTrack);
 
 	uint32 audioTrackCount = _bink->readUint32LE();
 
@@ -169,6 +190,9 @@ void BinkDecoder::readNextPacket() {
 
 	uint32 frameSize = frame.size;
 
+	// With worker threads, the audio is decoded while we decode the video
+	const bool asyncAudio = _pool && _pool->getThreadCount() > 0;
+
 	for (uint32 i = 0; i < _audioTracks.size(); i++) {
 		AudioInfo &audio = _audioTracks[i];
 
@@ -188,13 +212,26 @@ void BinkDecoder::readNextPacket() {
 			//                  Number of samples in bytes
 			audio.sampleCount = _bink->readUint32LE() / (2 * audio.channels);
 
-			audio.bits = new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
-					audioPacketStart + 4, audioPacketEnd), true);
+			if (asyncAudio) {
+				// The worker gets its own copy of the packet, so that the
+				// threads don't have to share the stream
+				uint32 dataSize = audioPacketLength - 4;
+				byte *data = (byte *)malloc(dataSize);
+				_bink->read(data, dataSize);
+
+				audio.bits = new Common::BitStream32LELSB(new Common::MemoryReadStream(data,
+						dataSize, DisposeAfterUse::YES), true);
+
+				_pool->addJob(decodeAudioJob, audioTrack);
+			} else {
+				audio.bits = new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
+						audioPacketStart + 4, audioPacketEnd), true);
 
-			audioTrack->decodePacket();
+				audioTrack->decodePacket();
 
-			delete audio.bits;
-			audio.bits = 0;
+				delete audio.bits;
+				audio.bits = 0;
+			}
 
 			_bink->seek(audioPacketEnd);
 
@@ -212,6 +249,19 @@ void BinkDecoder::readNextPacket() {
 
 	delete frame.bits;
 	frame.bits = 0;
+
+	if (asyncAudio) {
+		_pool->waitForJobs();
+
+		for (uint32 i = 0; i < _audioTracks.size(); i++) {
+			delete _audioTracks[i].bits;
+			_audioTracks[i].bits = 0;
+		}
+	}
+}
+
+void BinkDecoder::decodeAudioJob(void *param) {
+	((BinkAudioTrack *)param)->decodePacket();
 }
 
 BinkDecoder::VideoFrame::VideoFrame() : bits(0) {
@@ -237,6 +287,7 @@ BinkDecoder::AudioInfo::~AudioInfo() {
 BinkDecoder::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, const Graphics::PixelFormat &format, uint32 frameCount, const Common::Rational &frameRate, bool swapPlanes, bool hasAlpha, uint32 id) :
 		_frameCount(frameCount), _frameRate(frameRate), _swapPlanes(swapPlanes), _hasAlpha(hasAlpha), _id(id) {
 	_curFrame = -1;
+	_pool = 0;
 
 	for (int i = 0; i < 16; i++)
 		_huffman[i] = 0;
@@ -345,11 +396,8 @@ void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 
 	// Convert the YUV data we have to our format
 	// We're ignoring alpha for now
-	// The width used here is the surface-width, and not the video-width
-	// to allow for odd-sized videos.
 	assert(_curPlanes[0] && _curPlanes[1] && _curPlanes[2]);
-	YUVToRGBMan.convert420(&_surface, Graphics::YUVToRGBManager::kScaleITU, _curPlanes[0], _curPlanes[1], _curPlanes[2],
-			_surfaceWidth, _surfaceHeight, _surfaceWidth, _surfaceWidth >> 1);
+	convertToRGB();
 
 	// And swap the planes with the reference planes
 	for (int i = 0; i < 4; i++)
@@ -358,6 +406,73 @@ void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 	_curFrame++;
 }
 
+bool BinkDecoder::BinkVideoTrack::setOutputPixelFormat(const Graphics::PixelFormat &format) {
+	// The planes of the current frame are only kept until the next one is
+	// decoded, so the format can't be changed afterwards
+	if (_curFrame >= 0 || (format.bytesPerPixel != 2 && format.bytesPerPixel != 4))
+		return false;
+
+	uint16 width = _surface.w, height = _surface.h;
+	_surface.free();
+	_surface.create(_surfaceWidth, _surfaceHeight, format);
+	_surface.w = width;
+	_surface.h = height;
+	return true;
+}
+
+void BinkDecoder::BinkVideoTrack::convertToRGB() {
+	int bandCount = 1;
+
+	if (_pool)
+		bandCount = MIN<int>(_pool->getThreadCount() + 1, _surfaceHeight / kMinConversionBandHeight);
+
+	if (bandCount <= 1) {
+		convertBand(0, _surfaceHeight);
+		return;
+	}
+
+	// The chroma planes have half the resolution, so each band starts
+	// on an even row
+	const int bandHeight = ((_surfaceHeight + bandCount - 1) / bandCount + 1) & ~1;
+
+	_bands.resize(bandCount);
+
+	// Create the converter and its lookup tables before the pool threads
+	// use them, as neither is thread safe
+	YUVToRGBMan.prepareLookup(_surface.format, Graphics::YUVToRGBManager::kScaleITU);
+
+	for (int i = 0; i < bandCount; i++) {
+		_bands[i].track  = this;
+		_bands[i].y      = i * bandHeight;
+		_bands[i].height = MIN(bandHeight, _surfaceHeight - _bands[i].y);
+	}
+
+	// We convert the first band ourselves
+	for (int i = 1; i < bandCount; i++)
+		if (_bands[i].height > 0)
+			_pool->addJob(convertBandJob, &_bands[i]);
+
+	convertBand(_bands[0].y, _bands[0].height);
+	_pool->waitForJobs();
+}
+
+void BinkDecoder::BinkVideoTrack::convertBand(int y, int height) {
+	// The width used here is the surface-width, and not the video-width
+	// to allow for odd-sized videos.
+	Graphics::Surface dst;
+	dst.init(_surfaceWidth, height, _surface.pitch, _surface.getBasePtr(0, y), _surface.format);
+
+	const int uvOffset = (y >> 1) * (_surfaceWidth >> 1);
+
+	YUVToRGBMan.convert420(&dst, Graphics::YUVToRGBManager::kScaleITU, _curPlanes[0] + y * _surfaceWidth,
+			_curPlanes[1] + uvOffset, _curPlanes[2] + uvOffset, _surfaceWidth, height, _surfaceWidth, _surfaceWidth >> 1);
+}
+
+void BinkDecoder::BinkVideoTrack::convertBandJob(void *param) {
+	ConversionBand *band = (ConversionBand *)param;
+	band->track->convertBand(band->y, band->height);
+}
+
 void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, bool isChroma) {
 	uint32 blockWidth  = isChroma ? ((_surface.w  + 15) >> 4) : ((_surface.w  + 7) >> 3);
 	uint32 blockHeight = isChroma ? ((_surface.h + 15) >> 4) : ((_surface.h + 7) >> 3);
@@ -50,6 +50,8 @@ class Huffman;
 
 class RDFT;
 class DCT;
+
+class ThreadPool;
 }
 
 namespace Graphics {
@@ -72,6 +74,17 @@ public:
 	bool loadStream(Common::SeekableReadStream *stream);
 	void close();
 
+	/**
+	 * Use the given number of worker threads, in addition to the calling
+	 * thread, to decode the audio while the video is decoded and to convert
+	 * the video frames to RGB in bands. With 0, the default, everything is
+	 * done in the calling thread.
+	 *
+	 * This must not be called while frames are decoded in the background
+	 * (see setAsyncDecoding()).
+	 */
+	void setThreadCount(uint numThreads);
+
 protected:
 	void readNextPacket();
 
@@ -145,6 +158,7 @@ private:
 		uint16 getWidth() const { return _surface.w; }
 		uint16 getHeight() const { return _surface.h; }
 		Graphics::PixelFormat getPixelFormat() const { return _surface.format; }
+		bool setOutputPixelFormat(const Graphics::PixelFormat &format);
 		int getCurFrame() const { return _curFrame; }
 		int getFrameCount() const { return _frameCount; }
 		const Graphics::Surface *decodeNextFrame() { return &_surface; }
@@ -152,10 +166,20 @@ private:
 		/** Decode a video packet. */
 		void decodePacket(VideoFrame &frame);
 
+		/** Set the worker threads for converting frames, or 0 for none. */
+		void setThreadPool(Common::ThreadPool *pool) { _pool = pool; }
+
 	protected:
 		Common::Rational getFrameRate() const { return _frameRate; }
 
 	private:
+		/** A band of rows converted to RGB by one thread. */
+		struct ConversionBand {
+			BinkVideoTrack *track;
+			int y;
+			int height;
+		};
+
 		/** A decoder state. */
 		struct DecodeContext {
 			VideoFrame *video;
@@ -255,6 +279,9 @@ private:
 		byte *_curPlanes[4]; ///< The 4 color planes, YUVA, current frame.
 		byte *_oldPlanes[4]; ///< The 4 color planes, YUVA, last frame.
 
+		Common::ThreadPool *_pool;            ///< Worker threads, if any.
+		Common::Array<ConversionBand> _bands; ///< Bands for converting to RGB.
+
 		/** Initialize the bundles. */
 		void initBundles();
 		/** Deinitialize the bundles. */
@@ -266,6 +293,12 @@ private:
 		/** Decode a plane. */
 		void decodePlane(VideoFrame &video, int planeIdx, bool isChroma);
 
+		/** Convert the current planes to RGB, in parallel if possible. */
+		void convertToRGB();
+		/** Convert some rows of the current planes to RGB. */
+		void convertBand(int y, int height);
+		static void convertBandJob(void *param);
+
 		/** Read/Initialize a bundle for decoding a plane. */
 		void readBundle(VideoFrame &video, Source source);
 
@@ -347,10 +380,14 @@ private:
 
 	Common::SeekableReadStream *_bink;
 
+	Common::ThreadPool *_pool; ///< Worker threads, if any.
+
 	Common::Array<AudioInfo> _audioTracks; ///< All audio tracks.
 	Common::Array<VideoFrame> _frames;      ///< All video frames.
 
 	void initAudioTrack(AudioInfo &audio);
+
+	static void decodeAudioJob(void *param);
 };
 
 } // End of namespace Video
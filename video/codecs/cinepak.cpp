@@ -34,22 +34,10 @@
 
 namespace Video {
 
-#define PUT_PIXEL(offset, lum, u, v) \
-	if (_pixelFormat.bytesPerPixel != 1) { \
-		byte r = _clipTable[lum + (v << 1)]; \
-		byte g = _clipTable[lum - (u >> 1) - v]; \
-		byte b = _clipTable[lum + (u << 1)]; \
-		\
-		if (_pixelFormat.bytesPerPixel == 2) \
-			*((uint16 *)_curFrame.surface->getPixels() + offset) = _pixelFormat.RGBToColor(r, g, b); \
-		else \
-			*((uint32 *)_curFrame.surface->getPixels() + offset) = _pixelFormat.RGBToColor(r, g, b); \
-	} else \
-		*((byte *)_curFrame.surface->getPixels() + offset) = lum
-
-CinepakDecoder::CinepakDecoder(int bitsPerPixel) : Codec() {
+CinepakDecoder::CinepakDecoder(int bitsPerPixel) : Codec(), _bitsPerPixel(bitsPerPixel) {
 	_curFrame.surface = NULL;
 	_curFrame.strips = NULL;
+	_stripsAllocated = 0;
 	_y = 0;
 
 	if (bitsPerPixel == 8)
@@ -73,6 +61,32 @@ CinepakDecoder::CinepakDecoder(int bitsPerPixel) : Codec() {
 	_clipTable = _clipTableBuf + 512;
 }
 
+bool CinepakDecoder::setOutputPixelFormat(const Graphics::PixelFormat &format) {
+	// Palettized video stays palettized
+	if (_bitsPerPixel == 8 || (format.bytesPerPixel != 2 && format.bytesPerPixel != 4))
+		return false;
+
+	if (format == _pixelFormat)
+		return true;
+
+	_pixelFormat = format;
+
+	if (_curFrame.surface) {
+		_curFrame.surface->free();
+		_curFrame.surface->create(_curFrame.width, _curFrame.height, _pixelFormat);
+	}
+
+	// The codebooks are kept across frames, so convert them again
+	for (uint16 i = 0; i < _stripsAllocated; i++) {
+		for (uint16 j = 0; j < 256; j++) {
+			convertCodebookEntry(_curFrame.strips[i].v1_codebook[j]);
+			convertCodebookEntry(_curFrame.strips[i].v4_codebook[j]);
+		}
+	}
+
+	return true;
+}
+
 CinepakDecoder::~CinepakDecoder() {
 	if (_curFrame.surface) {
 		_curFrame.surface->free();
@@ -91,8 +105,18 @@ const Graphics::Surface *CinepakDecoder::decodeImage(Common::SeekableReadStream
 	_curFrame.height = stream->readUint16BE();
 	_curFrame.stripCount = stream->readUint16BE();
 
-	if (_curFrame.strips == NULL)
-		_curFrame.strips = new CinepakStrip[_curFrame.stripCount];
+	// The strips keep their codebooks from frame to frame, so they are only
+	// reallocated if a frame has more strips than any before
+	if (_curFrame.stripCount > _stripsAllocated) {
+		CinepakStrip *strips = new CinepakStrip[_curFrame.stripCount];
+
+		for (uint16 i = 0; i < _stripsAllocated; i++)
+			strips[i] = _curFrame.strips[i];
+
+		delete[] _curFrame.strips;
+		_curFrame.strips = strips;
+		_stripsAllocated = _curFrame.stripCount;
+	}
 
 	debug(4, "Cinepak Frame: Width = %d, Height = %d, Strip Count = %d", _curFrame.width, _curFrame.height, _curFrame.stripCount);
 
@@ -211,11 +235,42 @@ void CinepakDecoder::loadCodebook(Common::SeekableReadStream *stream, uint16 str
 				codebook[i].u = 0;
 				codebook[i].v = 0;
 			}
+
+			convertCodebookEntry(codebook[i]);
+		}
+	}
+}
+
+void CinepakDecoder::convertCodebookEntry(CinepakCodebook &entry) const {
+	// The vectors only ever use these four colors, so convert them to the
+	// output format once instead of for every pixel
+	for (byte i = 0; i < 4; i++) {
+		if (_pixelFormat.bytesPerPixel == 1) {
+			entry.color[i] = entry.y[i];
+		} else {
+			byte r = _clipTable[entry.y[i] + (entry.v << 1)];
+			byte g = _clipTable[entry.y[i] - (entry.u >> 1) - entry.v];
+			byte b = _clipTable[entry.y[i] + (entry.u << 1)];
+			entry.color[i] = _pixelFormat.RGBToColor(r, g, b);
 		}
 	}
 }
 
 void CinepakDecoder::decodeVectors(Common::SeekableReadStream *stream, uint16 strip, byte chunkID, uint32 chunkSize) {
+	if (_pixelFormat.bytesPerPixel == 1)
+		decodeVectorsTmpl<byte>(stream, strip, chunkID, chunkSize);
+	else if (_pixelFormat.bytesPerPixel == 2)
+		decodeVectorsTmpl<uint16>(stream, strip, chunkID, chunkSize);
+	else
+		decodeVectorsTmpl<uint32>(stream, strip, chunkID, chunkSize);
+}
+
+#define PUT_PIXEL(offset, index) \
+	dst[offset] = (PixelInt)codebook->color[index]
+
+template<typename PixelInt>
+void CinepakDecoder::decodeVectorsTmpl(Common::SeekableReadStream *stream, uint16 strip, byte chunkID, uint32 chunkSize) {
+	PixelInt *dst = (PixelInt *)_curFrame.surface->getPixels();
 	uint32 flag = 0, mask = 0;
 	uint32 iy[4];
 	int32 startPos = stream->pos();
@@ -249,54 +304,54 @@ void CinepakDecoder::decodeVectors(Common::SeekableReadStream *stream, uint16 st
 						return;
 
 					// Get the codebook
-					CinepakCodebook codebook = _curFrame.strips[strip].v1_codebook[stream->readByte()];
-
-					PUT_PIXEL(iy[0] + 0, codebook.y[0], codebook.u, codebook.v);
-					PUT_PIXEL(iy[0] + 1, codebook.y[0], codebook.u, codebook.v);
-					PUT_PIXEL(iy[1] + 0, codebook.y[0], codebook.u, codebook.v);
-					PUT_PIXEL(iy[1] + 1, codebook.y[0], codebook.u, codebook.v);
-
-					PUT_PIXEL(iy[0] + 2, codebook.y[1], codebook.u, codebook.v);
-					PUT_PIXEL(iy[0] + 3, codebook.y[1], codebook.u, codebook.v);
-					PUT_PIXEL(iy[1] + 2, codebook.y[1], codebook.u, codebook.v);
-					PUT_PIXEL(iy[1] + 3, codebook.y[1], codebook.u, codebook.v);
-
-					PUT_PIXEL(iy[2] + 0, codebook.y[2], codebook.u, codebook.v);
-					PUT_PIXEL(iy[2] + 1, codebook.y[2], codebook.u, codebook.v);
-					PUT_PIXEL(iy[3] + 0, codebook.y[2], codebook.u, codebook.v);
-					PUT_PIXEL(iy[3] + 1, codebook.y[2], codebook.u, codebook.v);
-
-					PUT_PIXEL(iy[2] + 2, codebook.y[3], codebook.u, codebook.v);
-					PUT_PIXEL(iy[2] + 3, codebook.y[3], codebook.u, codebook.v);
-					PUT_PIXEL(iy[3] + 2, codebook.y[3], codebook.u, codebook.v);
-					PUT_PIXEL(iy[3] + 3, codebook.y[3], codebook.u, codebook.v);
+					const CinepakCodebook *codebook = &_curFrame.strips[strip].v1_codebook[stream->readByte()];
+
+					PUT_PIXEL(iy[0] + 0, 0);
+					PUT_PIXEL(iy[0] + 1, 0);
+					PUT_PIXEL(iy[1] + 0, 0);
+					PUT_PIXEL(iy[1] + 1, 0);
+
+					PUT_PIXEL(iy[0] + 2, 1);
+					PUT_PIXEL(iy[0] + 3, 1);
+					PUT_PIXEL(iy[1] + 2, 1);
+					PUT_PIXEL(iy[1] + 3, 1);
+
+					PUT_PIXEL(iy[2] + 0, 2);
+					PUT_PIXEL(iy[2] + 1, 2);
+					PUT_PIXEL(iy[3] + 0, 2);
+					PUT_PIXEL(iy[3] + 1, 2);
+
+					PUT_PIXEL(iy[2] + 2, 3);
+					PUT_PIXEL(iy[2] + 3, 3);
+					PUT_PIXEL(iy[3] + 2, 3);
+					PUT_PIXEL(iy[3] + 3, 3);
 				} else if (flag & mask) {
 					if ((stream->pos() - startPos + 4) > (int32)chunkSize)
 						return;
 
-					CinepakCodebook codebook = _curFrame.strips[strip].v4_codebook[stream->readByte()];
-					PUT_PIXEL(iy[0] + 0, codebook.y[0], codebook.u, codebook.v);
-					PUT_PIXEL(iy[0] + 1, codebook.y[1], codebook.u, codebook.v);
-					PUT_PIXEL(iy[1] + 0, codebook.y[2], codebook.u, codebook.v);
-					PUT_PIXEL(iy[1] + 1, codebook.y[3], codebook.u, codebook.v);
-
-					codebook = _curFrame.strips[strip].v4_codebook[stream->readByte()];
-					PUT_PIXEL(iy[0] + 2, codebook.y[0], codebook.u, codebook.v);
-					PUT_PIXEL(iy[0] + 3, codebook.y[1], codebook.u, codebook.v);
-					PUT_PIXEL(iy[1] + 2, codebook.y[2], codebook.u, codebook.v);
-					PUT_PIXEL(iy[1] + 3, codebook.y[3], codebook.u, codebook.v);
-
-					codebook = _curFrame.strips[strip].v4_codebook[stream->readByte()];
-					PUT_PIXEL(iy[2] + 0, codebook.y[0], codebook.u, codebook.v);
-					PUT_PIXEL(iy[2] + 1, codebook.y[1], codebook.u, codebook.v);
-					PUT_PIXEL(iy[3] + 0, codebook.y[2], codebook.u, codebook.v);
-					PUT_PIXEL(iy[3] + 1, codebook.y[3], codebook.u, codebook.v);
-
-					codebook = _curFrame.strips[strip].v4_codebook[stream->readByte()];
-					PUT_PIXEL(iy[2] + 2, codebook.y[0], codebook.u, codebook.v);
-					PUT_PIXEL(iy[2] + 3, codebook.y[1], codebook.u, codebook.v);
-					PUT_PIXEL(iy[3] + 2, codebook.y[2], codebook.u, codebook.v);
-					PUT_PIXEL(iy[3] + 3, codebook.y[3], codebook.u, codebook.v);
+					const CinepakCodebook *codebook = &_curFrame.strips[strip].v4_codebook[stream->readByte()];
+					PUT_PIXEL(iy[0] + 0, 0);
+					PUT_PIXEL(iy[0] + 1, 1);
+					PUT_PIXEL(iy[1] + 0, 2);
+					PUT_PIXEL(iy[1] + 1, 3);
+
+					codebook = &_curFrame.strips[strip].v4_codebook[stream->readByte()];
+					PUT_PIXEL(iy[0] + 2, 0);
+					PUT_PIXEL(iy[0] + 3, 1);
+					PUT_PIXEL(iy[1] + 2, 2);
+					PUT_PIXEL(iy[1] + 3, 3);
+
+					codebook = &_curFrame.strips[strip].v4_codebook[stream->readByte()];
+					PUT_PIXEL(iy[2] + 0, 0);
+					PUT_PIXEL(iy[2] + 1, 1);
+					PUT_PIXEL(iy[3] + 0, 2);
+					PUT_PIXEL(iy[3] + 1, 3);
+
+					codebook = &_curFrame.strips[strip].v4_codebook[stream->readByte()];
+					PUT_PIXEL(iy[2] + 2, 0);
+					PUT_PIXEL(iy[2] + 3, 1);
+					PUT_PIXEL(iy[3] + 2, 2);
+					PUT_PIXEL(iy[3] + 3, 3);
 				}
 			}
 
@@ -306,4 +361,6 @@ void CinepakDecoder::decodeVectors(Common::SeekableReadStream *stream, uint16 st
 	}
 }
 
+#undef PUT_PIXEL
+
 } // End of namespace Video
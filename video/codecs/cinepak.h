@@ -39,6 +39,9 @@ struct CinepakCodebook {
 	// These are not in the normal YUV colorspace, but in the Cinepak YUV colorspace instead.
 	byte y[4]; // [0, 255]
 	int8 u, v; // [-128, 127]
+
+	// The four pixels in the output format
+	uint32 color[4];
 };
 
 struct CinepakStrip {
@@ -73,15 +76,21 @@ public:
 
 	const Graphics::Surface *decodeImage(Common::SeekableReadStream *stream);
 	Graphics::PixelFormat getPixelFormat() const { return _pixelFormat; }
+	bool setOutputPixelFormat(const Graphics::PixelFormat &format);
 
 private:
+	int _bitsPerPixel;
 	CinepakFrame _curFrame;
+	uint16 _stripsAllocated;
 	int32 _y;
 	Graphics::PixelFormat _pixelFormat;
 	byte *_clipTable, *_clipTableBuf;
 
 	void loadCodebook(Common::SeekableReadStream *stream, uint16 strip, byte codebookType, byte chunkID, uint32 chunkSize);
+	void convertCodebookEntry(CinepakCodebook &entry) const;
 	void decodeVectors(Common::SeekableReadStream *stream, uint16 strip, byte chunkID, uint32 chunkSize);
+	template<typename PixelInt>
+	void decodeVectorsTmpl(Common::SeekableReadStream *stream, uint16 strip, byte chunkID, uint32 chunkSize);
 };
 
 } // End of namespace Video
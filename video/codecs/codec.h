@@ -61,6 +61,16 @@ public:
 	 */
 	virtual Graphics::PixelFormat getPixelFormat() const = 0;
 
+	/**
+	 * Request the frames returned from decodeImage() to be in the given
+	 * format, so that they don't have to be converted again afterwards.
+	 * Codecs which support this write the frames in that format directly.
+	 *
+	 * @return true if getPixelFormat() now returns the given format,
+	 *         false if the codec can't decode to it
+	 */
+	virtual bool setOutputPixelFormat(const Graphics::PixelFormat &format) { return false; }
+
 	/**
 	 * Can this codec's frames contain a palette?
 	 */
@@ -40,7 +40,8 @@
 
 namespace Video {
 
-Indeo3Decoder::Indeo3Decoder(uint16 width, uint16 height) : _ModPred(0), _corrector_type(0) {
+Indeo3Decoder::Indeo3Decoder(uint16 width, uint16 height) : _ModPred(0), _corrector_type(0),
+		_inData(0), _inDataSize(0), _chromaData(0), _chromaDataSize(0) {
 	_iv_frame[0].the_buf = 0;
 	_iv_frame[1].the_buf = 0;
 
@@ -60,12 +61,30 @@ Indeo3Decoder::~Indeo3Decoder() {
 	delete[] _iv_frame[0].the_buf;
 	delete[] _ModPred;
 	delete[] _corrector_type;
+	delete[] _inData;
+	delete[] _chromaData;
 }
 
 Graphics::PixelFormat Indeo3Decoder::getPixelFormat() const {
 	return _pixelFormat;
 }
 
+bool Indeo3Decoder::setOutputPixelFormat(const Graphics::PixelFormat &format) {
+	if (format.bytesPerPixel != 2 && format.bytesPerPixel != 4)
+		return false;
+
+	if (format != _pixelFormat) {
+		_pixelFormat = format;
+
+		uint16 width = _surface->w, height = _surface->h;
+		_surface->free();
+		_surface->create(width, height, _pixelFormat);
+		_surfacePool.clear();
+	}
+
+	return true;
+}
+
 bool Indeo3Decoder::isIndeo3(Common::SeekableReadStream &stream) {
 	// Less than 16 bytes? This can't be right
 	if (stream.size() < 16)
@@ -228,12 +247,17 @@ const Graphics::Surface *Indeo3Decoder::decodeImage(Common::SeekableReadStream *
 
 	uint32 dataSize = stream->size() - hPos;
 
-	byte *inData = new byte[dataSize];
+	// The buffers are kept from frame to frame, as the size hardly changes
+	if (_inDataSize < dataSize) {
+		delete[] _inData;
+		_inData = new byte[dataSize];
+		_inDataSize = dataSize;
+	}
+
+	byte *inData = _inData;
 
-	if (stream->read(inData, dataSize) != dataSize) {
-		delete[] inData;
+	if (stream->read(inData, dataSize) != dataSize)
 		return 0;
-	}
 
 	byte *hdr_pos = inData;
 	byte *buf_pos;
@@ -259,16 +283,22 @@ const Graphics::Surface *Indeo3Decoder::decodeImage(Common::SeekableReadStream *
 	decodeChunk(_cur_frame->Ubuf, _ref_frame->Ubuf, chromaWidth, chromaHeight,
 			buf_pos + offs * 2, flags2, hdr_pos, buf_pos, MIN<int>(chromaWidth, 40));
 
-	delete[] inData;
-
 	const byte *srcY = _cur_frame->Ybuf;
 	const byte *srcU = _cur_frame->Ubuf;
 	const byte *srcV = _cur_frame->Vbuf;
 
 	// Create buffers for U/V with an extra row/column copied from the second-to-last
 	// row/column.
-	byte *tempU = new byte[(chromaWidth + 1) * (chromaHeight + 1)];
-	byte *tempV = new byte[(chromaWidth + 1) * (chromaHeight + 1)];
+	const uint32 chromaSize = (chromaWidth + 1) * (chromaHeight + 1);
+
+	if (_chromaDataSize < chromaSize * 2) {
+		delete[] _chromaData;
+		_chromaData = new byte[chromaSize * 2];
+		_chromaDataSize = chromaSize * 2;
+	}
+
+	byte *tempU = _chromaData;
+	byte *tempV = _chromaData + chromaSize;
 
 	for (uint i = 0; i < chromaHeight; i++) {
 		memcpy(tempU + (chromaWidth + 1) * i, srcU + chromaWidth * i, chromaWidth);
@@ -292,8 +322,7 @@ const Graphics::Surface *Indeo3Decoder::decodeImage(Common::SeekableReadStream *
 				fWidth, fHeight, fWidth, chromaWidth + 1);
 	} else {
 		// Need to upscale, so decode to a temp surface first
-		Graphics::Surface tempSurface;
-		tempSurface.create(fWidth, fHeight, _surface->format);
+		Graphics::Surface &tempSurface = *_surfacePool.acquire(fWidth, fHeight, _surface->format);
 
 		YUVToRGBMan.convert410(&tempSurface, Graphics::YUVToRGBManager::kScaleITU, srcY, tempU, tempV,
 				fWidth, fHeight, fWidth, chromaWidth + 1);
@@ -310,12 +339,9 @@ const Graphics::Surface *Indeo3Decoder::decodeImage(Common::SeekableReadStream *
  			}
 		}
 
-		tempSurface.free();
+		_surfacePool.release(&tempSurface);
 	}
 
-	delete[] tempU;
-	delete[] tempV;
-
 	return _surface;
 }
 
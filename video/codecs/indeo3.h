@@ -33,6 +33,7 @@
 #define VIDEO_CODECS_INDEO3_H
 
 #include "video/codecs/codec.h"
+#include "graphics/surface_pool.h"
 
 namespace Video {
 
@@ -50,6 +51,7 @@ public:
 
 	const Graphics::Surface *decodeImage(Common::SeekableReadStream *stream);
 	Graphics::PixelFormat getPixelFormat() const;
+	bool setOutputPixelFormat(const Graphics::PixelFormat &format);
 
 	static bool isIndeo3(Common::SeekableReadStream &stream);
 
@@ -81,6 +83,13 @@ private:
 	byte *_ModPred;
 	uint16 *_corrector_type;
 
+	// Scratch space for decoding frames
+	byte *_inData;
+	uint32 _inDataSize;
+	byte *_chromaData;
+	uint32 _chromaDataSize;
+	Graphics::SurfacePool _surfacePool;
+
 	void buildModPred();
 	void allocFrames();
 
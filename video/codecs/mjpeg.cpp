@@ -23,6 +23,7 @@
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
 #include "graphics/decoders/jpeg.h"
 
 #include "video/codecs/mjpeg.h"
@@ -45,6 +46,15 @@ JPEGDecoder::~JPEGDecoder() {
 	}
 }
 
+bool JPEGDecoder::setOutputPixelFormat(const Graphics::PixelFormat &format) {
+	if (format.bytesPerPixel != 2 && format.bytesPerPixel != 4)
+		return false;
+
+	// The surface is recreated in the new format with the next frame
+	_pixelFormat = format;
+	return true;
+}
+
 const Graphics::Surface *JPEGDecoder::decodeImage(Common::SeekableReadStream *stream) {
 	Graphics::JPEGDecoder jpeg;
 
@@ -53,12 +63,21 @@ const Graphics::Surface *JPEGDecoder::decodeImage(Common::SeekableReadStream *st
 		return 0;
 	}
 
-	if (_surface) {
+	// Convert straight to our format, reusing the surface of the last frame
+	if (!_surface) {
+		_surface = new Graphics::Surface();
+	} else if (_surface->w != jpeg.getWidth() || _surface->h != jpeg.getHeight() || _surface->format != _pixelFormat) {
 		_surface->free();
-		delete _surface;
 	}
 
-	_surface = jpeg.getSurface()->convertTo(_pixelFormat);
+	if (!_surface->getPixels())
+		_surface->create(jpeg.getWidth(), jpeg.getHeight(), _pixelFormat);
+
+	const Graphics::Surface *yComponent = jpeg.getComponent(1);
+	const Graphics::Surface *uComponent = jpeg.getComponent(2);
+	const Graphics::Surface *vComponent = jpeg.getComponent(3);
+
+	YUVToRGBMan.convert444(_surface, Graphics::YUVToRGBManager::kScaleFull, (const byte *)yComponent->getPixels(), (const byte *)uComponent->getPixels(), (const byte *)vComponent->getPixels(), yComponent->w, yComponent->h, yComponent->pitch, uComponent->pitch);
 
 	return _surface;
 }
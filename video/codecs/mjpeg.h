@@ -49,6 +49,7 @@ public:
 
 	const Graphics::Surface *decodeImage(Common::SeekableReadStream *stream);
 	Graphics::PixelFormat getPixelFormat() const { return _pixelFormat; }
+	bool setOutputPixelFormat(const Graphics::PixelFormat &format);
 
 private:
 	Graphics::PixelFormat _pixelFormat;
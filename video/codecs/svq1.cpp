@@ -50,6 +50,7 @@ SVQ1Decoder::SVQ1Decoder(uint16 width, uint16 height) {
 	_height = height;
 	_frameWidth = _frameHeight = 0;
 	_surface = 0;
+	_pixelFormat = g_system->getScreenFormat();
 
 	_last[0] = 0;
 	_last[1] = 0;
@@ -91,6 +92,22 @@ SVQ1Decoder::~SVQ1Decoder() {
 
 #define ALIGN(x, a) (((x)+(a)-1)&~((a)-1))
 
+bool SVQ1Decoder::setOutputPixelFormat(const Graphics::PixelFormat &format) {
+	if (format.bytesPerPixel != 2 && format.bytesPerPixel != 4)
+		return false;
+
+	_pixelFormat = format;
+
+	// Recreated with the next frame
+	if (_surface) {
+		_surface->free();
+		delete _surface;
+		_surface = 0;
+	}
+
+	return true;
+}
+
 const Graphics::Surface *SVQ1Decoder::decodeImage(Common::SeekableReadStream *stream) {
 	debug(1, "SVQ1Decoder::decodeImage()");
 
@@ -252,7 +269,7 @@ const Graphics::Surface *SVQ1Decoder::decodeImage(Common::SeekableReadStream *st
 	// Now we'll create the surface
 	if (!_surface) {
 		_surface = new Graphics::Surface();
-		_surface->create(yWidth, yHeight, g_system->getScreenFormat());
+		_surface->create(yWidth, yHeight, _pixelFormat);
 		_surface->w = _width;
 		_surface->h = _height;
 	}
@@ -45,9 +45,11 @@ public:
 	~SVQ1Decoder();
 
 	const Graphics::Surface *decodeImage(Common::SeekableReadStream *stream);
-	Graphics::PixelFormat getPixelFormat() const { return _surface->format; }
+	Graphics::PixelFormat getPixelFormat() const { return _pixelFormat; }
+	bool setOutputPixelFormat(const Graphics::PixelFormat &format);
 
 private:
+	Graphics::PixelFormat _pixelFormat;
 	Graphics::Surface *_surface;
 	uint16 _width, _height;
 	uint16 _frameWidth, _frameHeight;
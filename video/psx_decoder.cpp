@@ -153,6 +153,8 @@ PSXStreamDecoder::PSXStreamDecoder(CDSpeed speed, uint32 frameCount) : _speed(sp
 	_stream = 0;
 	_videoTrack = 0;
 	_audioTrack = 0;
+	_frameBuffer = 0;
+	_frameBufferSize = 0;
 }
 
 PSXStreamDecoder::~PSXStreamDecoder() {
@@ -183,6 +185,10 @@ void PSXStreamDecoder::close() {
 
 	delete _stream;
 	_stream = 0;
+
+	free(_frameBuffer);
+	_frameBuffer = 0;
+	_frameBufferSize = 0;
 }
 
 #define VIDEO_DATA_CHUNK_SIZE   2016
@@ -190,7 +196,6 @@ void PSXStreamDecoder::close() {
 
 void PSXStreamDecoder::readNextPacket() {
 	Common::SeekableReadStream *sector = 0;
-	byte *partialFrame = 0;
 	int sectorsRead = 0;
 
 	while (_stream->pos() < _stream->size()) {
@@ -225,15 +230,19 @@ void PSXStreamDecoder::readNextPacket() {
 				if (curSector >= sectorCount)
 					error("Bad sector");
 
-				if (!partialFrame)
-					partialFrame = (byte *)malloc(sectorCount * VIDEO_DATA_CHUNK_SIZE);
+				// The frames are assembled in a buffer kept from frame to frame
+				if (_frameBufferSize < sectorCount * VIDEO_DATA_CHUNK_SIZE) {
+					free(_frameBuffer);
+					_frameBufferSize = sectorCount * VIDEO_DATA_CHUNK_SIZE;
+					_frameBuffer = (byte *)malloc(_frameBufferSize);
+				}
 
 				sector->seek(VIDEO_DATA_HEADER_SIZE);
-				sector->read(partialFrame + curSector * VIDEO_DATA_CHUNK_SIZE, VIDEO_DATA_CHUNK_SIZE);
+				sector->read(_frameBuffer + curSector * VIDEO_DATA_CHUNK_SIZE, VIDEO_DATA_CHUNK_SIZE);
 
 				if (curSector == sectorCount - 1) {
 					// Done assembling the frame
-					Common::SeekableReadStream *frame = new Common::MemoryReadStream(partialFrame, frameSize, DisposeAfterUse::YES);
+					Common::SeekableReadStream *frame = new Common::MemoryReadStream(_frameBuffer, frameSize);
 
 					_videoTrack->decodeFrame(frame, sectorsRead);
 
@@ -340,7 +349,7 @@ void PSXStreamDecoder::PSXAudioTrack::queueAudioFromSector(Common::SeekableReadS
 	// TODO: RTZ PSX needs the same audio code in a regular AudioStream class. Probably
 	// will do something similar to QuickTime and creating a base class 'ISOMode2Parser'
 	// or something similar.
-	byte *buf = new byte[AUDIO_DATA_CHUNK_SIZE];
+	byte buf[AUDIO_DATA_CHUNK_SIZE];
 	sector->read(buf, AUDIO_DATA_CHUNK_SIZE);
 
 	int channels = _audStream->isStereo() ? 2 : 1;
@@ -414,7 +423,6 @@ void PSXStreamDecoder::PSXAudioTrack::queueAudioFromSector(Common::SeekableReadS
 #endif
 
 	_audStream->queueBuffer((byte *)dst, AUDIO_DATA_SAMPLE_COUNT * 2, DisposeAfterUse::YES, flags);
-	delete[] buf;
 }
 
 Audio::AudioStream *PSXStreamDecoder::PSXAudioTrack::getAudioStream() const {
@@ -464,6 +472,25 @@ const Graphics::Surface *PSXStreamDecoder::PSXVideoTrack::decodeNextFrame() {
 	return _surface;
 }
 
+bool PSXStreamDecoder::PSXVideoTrack::setOutputPixelFormat(const Graphics::PixelFormat &format) {
+	if (format.bytesPerPixel != 2 && format.bytesPerPixel != 4)
+		return false;
+
+	uint16 width = _surface->w, height = _surface->h;
+	_surface->free();
+	_surface->create(width, height, format);
+
+	// Loading the stream already decoded the first frame, convert it again
+	if (_curFrame >= 0)
+		convertFrame();
+
+	return true;
+}
+
+void PSXStreamDecoder::PSXVideoTrack::convertFrame() {
+	YUVToRGBMan.convert420(_surface, Graphics::YUVToRGBManager::kScaleFull, _yBuffer, _cbBuffer, _crBuffer, _surface->w, _surface->h, _macroBlocksW * 16, _macroBlocksW * 8);
+}
+
 void PSXStreamDecoder::PSXVideoTrack::decodeFrame(Common::SeekableReadStream *frame, uint sectorCount) {
 	// A frame is essentially an MPEG-1 intra frame
 
@@ -485,7 +512,7 @@ void PSXStreamDecoder::PSXVideoTrack::decodeFrame(Common::SeekableReadStream *fr
 			decodeMacroBlock(&bits, mbX, mbY, scale, version);
 
 	// Output data onto the frame
-	YUVToRGBMan.convert420(_surface, Graphics::YUVToRGBManager::kScaleFull, _yBuffer, _cbBuffer, _crBuffer, _surface->w, _surface->h, _macroBlocksW * 16, _macroBlocksW * 8);
+	convertFrame();
 
 	_curFrame++;
 
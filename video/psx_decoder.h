@@ -84,6 +84,7 @@ private:
 		uint16 getWidth() const { return _surface->w; }
 		uint16 getHeight() const { return _surface->h; }
 		Graphics::PixelFormat getPixelFormat() const { return _surface->format; }
+		bool setOutputPixelFormat(const Graphics::PixelFormat &format);
 		bool endOfTrack() const { return _endOfTrack; }
 		int getCurFrame() const { return _curFrame; }
 		int getFrameCount() const { return _frameCount; }
@@ -108,6 +109,7 @@ private:
 
 		uint16 _macroBlocksW, _macroBlocksH;
 		byte *_yBuffer, *_cbBuffer, *_crBuffer;
+		void convertFrame();
 		void decodeMacroBlock(Common::BitStream *bits, int mbX, int mbY, uint16 scale, uint16 version);
 		void decodeBlock(Common::BitStream *bits, byte *block, int pitch, uint16 scale, uint16 version, PlaneType plane);
 
@@ -151,6 +153,10 @@ private:
 	PSXVideoTrack *_videoTrack;
 	PSXAudioTrack *_audioTrack;
 
+	// The frame being assembled from its sectors
+	byte *_frameBuffer;
+	uint32 _frameBufferSize;
+
 	Common::SeekableReadStream *readSector();
 };
 
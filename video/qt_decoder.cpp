@@ -430,6 +430,18 @@ Graphics::PixelFormat QuickTimeDecoder::VideoTrackHandler::getPixelFormat() cons
 	return ((VideoSampleDesc *)_parent->sampleDescs[0])->_videoCodec->getPixelFormat();
 }
 
+bool QuickTimeDecoder::VideoTrackHandler::setOutputPixelFormat(const Graphics::PixelFormat &format) {
+	// Each sample description has its own codec
+	for (uint32 i = 0; i < _parent->sampleDescs.size(); i++) {
+		Codec *codec = ((VideoSampleDesc *)_parent->sampleDescs[i])->_videoCodec;
+
+		if (!codec || !codec->setOutputPixelFormat(format))
+			return false;
+	}
+
+	return true;
+}
+
 int QuickTimeDecoder::VideoTrackHandler::getFrameCount() const {
 	return _parent->frameCount;
 }
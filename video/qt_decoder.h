@@ -72,6 +72,10 @@ public:
 protected:
 	Common::QuickTimeParser::SampleDesc *readSampleDesc(Common::QuickTimeParser::Track *track, uint32 format, uint32 descSize);
 
+	// The audio is buffered in decodeNextFrame(), from the stream the
+	// video track reads its frames from
+	bool supportsAsyncDecoding() const { return false; }
+
 private:
 	void init();
 
@@ -130,6 +134,7 @@ private:
 		uint16 getWidth() const;
 		uint16 getHeight() const;
 		Graphics::PixelFormat getPixelFormat() const;
+		bool setOutputPixelFormat(const Graphics::PixelFormat &format);
 		int getCurFrame() const { return _curFrame; }
 		int getFrameCount() const;
 		uint32 getNextFrameStartTime() const;
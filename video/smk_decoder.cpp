@@ -282,6 +282,8 @@ SmackerDecoder::SmackerDecoder(Audio::Mixer::SoundType soundType) : _soundType(s
 	_firstFrameStart = 0;
 	_frameTypes = 0;
 	_frameSizes = 0;
+	_packetBuffer = 0;
+	_packetBufferSize = 0;
 }
 
 SmackerDecoder::~SmackerDecoder() {
@@ -406,6 +408,22 @@ void SmackerDecoder::close() {
 
 	delete[] _frameSizes;
 	_frameSizes = 0;
+
+	free(_packetBuffer);
+	_packetBuffer = 0;
+	_packetBufferSize = 0;
+}
+
+byte *SmackerDecoder::getPacketBuffer(uint32 size) {
+	// Audio and video chunks are read into the same buffer, which is kept
+	// from frame to frame
+	if (_packetBufferSize < size) {
+		free(_packetBuffer);
+		_packetBuffer = (byte *)malloc(size);
+		_packetBufferSize = size;
+	}
+
+	return _packetBuffer;
 }
 
 bool SmackerDecoder::rewind() {
@@ -464,13 +482,13 @@ void SmackerDecoder::readNextPacket() {
 
 	uint32 frameDataSize = frameSize - (_fileStream->pos() - startPos);
 
-	byte *frameData = (byte *)malloc(frameDataSize + 1);
+	byte *frameData = getPacketBuffer(frameDataSize + 1);
 	// Padding to keep the BigHuffmanTrees from reading past the data end
 	frameData[frameDataSize] = 0x00;
 
 	_fileStream->read(frameData, frameDataSize);
 
-	Common::BitStream8LSB bs(new Common::MemoryReadStream(frameData, frameDataSize + 1, DisposeAfterUse::YES), true);
+	Common::BitStream8LSB bs(new Common::MemoryReadStream(frameData, frameDataSize + 1), true);
 	videoTrack->decodeFrame(bs);
 
 	_fileStream->seek(startPos + frameSize);
@@ -482,22 +500,22 @@ void SmackerDecoder::handleAudioTrack(byte track, uint32 chunkSize, uint32 unpac
 		SmackerAudioTrack *audioTrack = (SmackerAudioTrack *)getTrack(track + 1);
 
 		// If it's track 0, play the audio data
-		byte *soundBuffer = (byte *)malloc(chunkSize + 1);
-		// Padding to keep the SmallHuffmanTrees from reading past the data end
-		soundBuffer[chunkSize] = 0x00;
-
-		_fileStream->read(soundBuffer, chunkSize);
-
 		if (_header.audioInfo[track].compression == kCompressionRDFT || _header.audioInfo[track].compression == kCompressionDCT) {
 			// TODO: Compressed audio (Bink RDFT/DCT encoded)
-			free(soundBuffer);
-			return;
+			_fileStream->skip(chunkSize);
 		} else if (_header.audioInfo[track].compression == kCompressionDPCM) {
 			// Compressed audio (Huffman DPCM encoded)
+			byte *soundBuffer = getPacketBuffer(chunkSize + 1);
+			// Padding to keep the SmallHuffmanTrees from reading past the data end
+			soundBuffer[chunkSize] = 0x00;
+
+			_fileStream->read(soundBuffer, chunkSize);
 			audioTrack->queueCompressedBuffer(soundBuffer, chunkSize + 1, unpackedSize);
-			free(soundBuffer);
 		} else {
-			// Uncompressed audio (PCM)
+			// Uncompressed audio (PCM), which is queued as it is
+			byte *soundBuffer = (byte *)malloc(chunkSize);
+
+			_fileStream->read(soundBuffer, chunkSize);
 			audioTrack->queuePCM(soundBuffer, chunkSize);
 		}
 	} else {
@@ -185,6 +185,10 @@ private:
 
 	uint32 _firstFrameStart;
 
+	byte *_packetBuffer;
+	uint32 _packetBufferSize;
+	byte *getPacketBuffer(uint32 size);
+
 	Audio::Mixer::SoundType _soundType;
 };
 
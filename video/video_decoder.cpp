@@ -25,11 +25,15 @@
 #include "audio/audiostream.h"
 #include "audio/mixer.h" // for kMaxChannelVolume
 
+#include "common/asyncstream.h"
+#include "common/debug.h"
 #include "common/rational.h"
 #include "common/file.h"
 #include "common/system.h"
+#include "common/threadpool.h"
 
 #include "graphics/palette.h"
+#include "graphics/surface.h"
 
 namespace Video {
 
@@ -46,6 +50,19 @@ VideoDecoder::VideoDecoder() {
 	_endTime = 0;
 	_endTimeSet = false;
 	_nextVideoTrack = 0;
+	_readAheadBlockSize = 0;
+	_asyncQueueLength = 0;
+	_asyncDropLateFrames = false;
+	_asyncCurrent = 0;
+	_asyncPool = 0;
+	_asyncTrack = 0;
+	_asyncReadySemaphore = 0;
+	_asyncRead = _asyncReady = 0;
+	_asyncDecoding = _asyncEnd = _asyncStop = false;
+	memset(&_asyncStats, 0, sizeof(_asyncStats));
+	_asyncCurFrame = -1;
+	_asyncNextFrameStartTime = 0;
+	_asyncEndOfTrack = false;
 
 	// Find the best format for output
 	_defaultHighColorFormat = g_system->getScreenFormat();
@@ -54,10 +71,20 @@ VideoDecoder::VideoDecoder() {
 		_defaultHighColorFormat = Graphics::PixelFormat(4, 8, 8, 8, 8, 8, 16, 24, 0);
 }
 
+VideoDecoder::~VideoDecoder() {
+	// Subclasses close() the video in their destructor, this is just a fallback
+	discardAsyncFrames();
+	freeAsyncFrames();
+}
+
 void VideoDecoder::close() {
 	if (isPlaying())
 		stop();
 
+	discardAsyncFrames();
+	freeAsyncFrames();
+	memset(&_asyncStats, 0, sizeof(_asyncStats));
+
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		delete *it;
 
@@ -83,6 +110,9 @@ bool VideoDecoder::loadFile(const Common::String &filename) {
 		return false;
 	}
 
+	if (_readAheadBlockSize)
+		return loadStream(Common::wrapAsyncReadStream(file, _readAheadBlockSize, DisposeAfterUse::YES));
+
 	return loadStream(file);
 }
 
@@ -165,9 +195,42 @@ Graphics::PixelFormat VideoDecoder::getPixelFormat() const {
 	return Graphics::PixelFormat();
 }
 
+bool VideoDecoder::setOutputPixelFormat(const Graphics::PixelFormat &format) {
+	// Too late, frames have been decoded in the background already
+	if (_asyncTrack)
+		return false;
+
+	bool result = false;
+
+	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() != Track::kTrackTypeVideo)
+			continue;
+
+		VideoTrack *track = (VideoTrack *)*it;
+
+		if (track->getPixelFormat() != format && !track->setOutputPixelFormat(format))
+			return false;
+
+		result = true;
+	}
+
+	return result;
+}
+
 const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	_needsUpdate = false;
 
+	// Once the frames decoded ahead are used up after stopping the
+	// background thread, the track is where the caller is
+	if (_asyncTrack && !_asyncPool && !_asyncReady)
+		discardAsyncFrames();
+
+	if (_asyncQueueLength && !_asyncTrack)
+		startAsyncDecoding();
+
+	if (_asyncTrack)
+		return decodeNextFrameAsync();
+
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -196,6 +259,9 @@ bool VideoDecoder::setReverse(bool reverse) {
 	// Attempt to make sure all the tracks are in the requested direction
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)*it)->isReversed() != reverse) {
+			if (!rewindAsyncDecoding())
+				return false;
+
 			if (!((VideoTrack *)*it)->setReverse(reverse))
 				return false;
 
@@ -213,6 +279,9 @@ const byte *VideoDecoder::getPalette() {
 }
 
 int VideoDecoder::getCurFrame() const {
+	if (_asyncTrack)
+		return _asyncCurFrame;
+
 	int32 frame = -1;
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
@@ -258,7 +327,7 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 		return 0;
 
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+	uint32 nextFrameStartTime = trackNextFrameStartTime(_nextVideoTrack);
 
 	if (_nextVideoTrack->isReversed()) {
 		// For reversed videos, we need to handle the time difference the opposite way.
@@ -277,7 +346,7 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 
 bool VideoDecoder::endOfVideo() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if (!(*it)->endOfTrack() && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
+		if (!trackAtEnd(*it) && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || trackNextFrameStartTime((VideoTrack *)*it) < (uint)_endTime.msecs()))
 			return false;
 
 	return true;
@@ -298,6 +367,8 @@ bool VideoDecoder::rewind() {
 	if (!isRewindable())
 		return false;
 
+	discardAsyncFrames();
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
@@ -332,6 +403,8 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	if (!isSeekable())
 		return false;
 
+	discardAsyncFrames();
+
 	// Stop all tracks so they can be seeked
 	if (isPlaying())
 		stopAudio();
@@ -727,7 +800,7 @@ const VideoDecoder::Track *VideoDecoder::getTrack(uint track) const {
 
 bool VideoDecoder::endOfVideoTracks() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack())
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !trackAtEnd(*it))
 			return false;
 
 	return true;
@@ -782,7 +855,7 @@ bool VideoDecoder::hasFramesLeft() const {
 	// This is only used for needsUpdate() atm so that setEndTime() works properly
 	// And unlike endOfVideoTracks(), this takes into account _endTime
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack() && (!isPlaying() || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !trackAtEnd(*it) && (!isPlaying() || !_endTimeSet || trackNextFrameStartTime((VideoTrack *)*it) < (uint)_endTime.msecs()))
 			return true;
 
 	return false;
@@ -796,4 +869,316 @@ bool VideoDecoder::hasAudio() const {
 	return false;
 }
 
+bool VideoDecoder::trackAtEnd(const Track *track) const {
+	// The background thread is ahead of what the caller has seen so far
+	if (track == _asyncTrack)
+		return _asyncEndOfTrack;
+
+	return track->endOfTrack();
+}
+
+uint32 VideoDecoder::trackNextFrameStartTime(const VideoTrack *track) const {
+	if (track == _asyncTrack)
+		return _asyncNextFrameStartTime;
+
+	return track->getNextFrameStartTime();
+}
+
+void VideoDecoder::setAsyncDecoding(uint queueLength, bool dropLateFrames) {
+	// The frames decoded so far are still handed out, the new queue length
+	// takes effect after them
+	if (queueLength != _asyncQueueLength)
+		stopAsyncDecoding();
+
+	_asyncQueueLength = queueLength;
+	_asyncDropLateFrames = dropLateFrames;
+}
+
+VideoDecoder::AsyncDecodingStats VideoDecoder::getAsyncDecodingStats() const {
+	Common::StackLock lock(_asyncMutex);
+	return _asyncStats;
+}
+
+bool VideoDecoder::startAsyncDecoding() {
+	assert(!_asyncTrack);
+
+	if (!supportsAsyncDecoding())
+		return false;
+
+	// We can only decode ahead when there is just one video track to care
+	// about, and only forwards
+	VideoTrack *track = 0;
+
+	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			if (track)
+				return false;
+
+			track = (VideoTrack *)*it;
+		}
+	}
+
+	if (!track || track->isReversed() || track->endOfTrack())
+		return false;
+
+	Common::ThreadPool *pool = new Common::ThreadPool(1);
+
+	if (pool->getThreadCount() == 0) {
+		debug(1, "VideoDecoder: No threads available, decoding frames synchronously");
+		delete pool;
+		_asyncQueueLength = 0;
+		return false;
+	}
+
+	// Reuse the frames from before seeking, if possible. Their surfaces
+	// are taken from the pool once the size of the frames is known.
+	while (_asyncQueue.size() > _asyncQueueLength) {
+		_surfacePool.release(_asyncQueue.back()->surface);
+		delete _asyncQueue.back();
+		_asyncQueue.pop_back();
+	}
+
+	while (_asyncQueue.size() < _asyncQueueLength) {
+		AsyncFrame *frame = new AsyncFrame();
+		frame->surface = 0;
+		_asyncQueue.push_back(frame);
+	}
+
+	if (!_asyncCurrent) {
+		_asyncCurrent = new AsyncFrame();
+		_asyncCurrent->surface = 0;
+	}
+
+	_asyncPool = pool;
+	_asyncTrack = track;
+	_asyncReadySemaphore = g_system->createSemaphore(0);
+	_asyncRead = _asyncReady = 0;
+	_asyncEnd = _asyncStop = false;
+	_asyncDecoding = false;
+	_asyncCurFrame = track->getCurFrame();
+	_asyncNextFrameStartTime = track->getNextFrameStartTime();
+	_asyncEndOfTrack = false;
+
+	startAsyncJob();
+	return true;
+}
+
+void VideoDecoder::stopAsyncDecoding() {
+	if (!_asyncPool)
+		return;
+
+	// The background thread stops after the frame it is working on. The
+	// frames decoded ahead stay queued, and decodeNextFrame() hands them
+	// out before decoding on the calling thread.
+	{
+		Common::StackLock lock(_asyncMutex);
+		_asyncStop = true;
+	}
+
+	_asyncPool->waitForJobs();
+	delete _asyncPool;
+	_asyncPool = 0;
+
+	g_system->deleteSemaphore(_asyncReadySemaphore);
+	_asyncReadySemaphore = 0;
+}
+
+void VideoDecoder::discardAsyncFrames() {
+	// Only to be used when the track is moved anyway, or when it is where
+	// the caller is: the frames decoded ahead are lost.
+	stopAsyncDecoding();
+
+	_asyncRead = _asyncReady = 0;
+	_asyncEnd = false;
+	_asyncTrack = 0;
+}
+
+bool VideoDecoder::rewindAsyncDecoding() {
+	if (!_asyncTrack)
+		return true;
+
+	stopAsyncDecoding();
+
+	// Seek the track back to the frame after the one last handed out. If
+	// that is not possible, the frames decoded ahead are kept.
+	if (_asyncReady) {
+		VideoTrack *track = _asyncTrack;
+
+		if (!track->isSeekable())
+			return false;
+
+		Audio::Timestamp time = track->getFrameTime(_asyncCurFrame + 1);
+
+		if (time < 0 || !track->seek(time))
+			return false;
+	}
+
+	discardAsyncFrames();
+	return true;
+}
+
+void VideoDecoder::freeAsyncFrames() {
+	assert(!_asyncTrack);
+
+	for (uint i = 0; i < _asyncQueue.size(); i++) {
+		_surfacePool.release(_asyncQueue[i]->surface);
+		delete _asyncQueue[i];
+	}
+
+	_asyncQueue.clear();
+
+	if (_asyncCurrent) {
+		_surfacePool.release(_asyncCurrent->surface);
+		delete _asyncCurrent;
+		_asyncCurrent = 0;
+	}
+
+	_surfacePool.clear();
+}
+
+void VideoDecoder::startAsyncJob() {
+	{
+		Common::StackLock lock(_asyncMutex);
+
+		if (_asyncDecoding || _asyncEnd || _asyncReady == _asyncQueue.size())
+			return;
+
+		_asyncDecoding = true;
+	}
+
+	_asyncPool->addJob(asyncDecodeJob, this);
+}
+
+void VideoDecoder::asyncDecodeJob(void *param) {
+	((VideoDecoder *)param)->decodeAsyncFrames();
+}
+
+void VideoDecoder::decodeAsyncFrames() {
+	for (;;) {
+		AsyncFrame *frame;
+
+		{
+			Common::StackLock lock(_asyncMutex);
+
+			if (_asyncStop || _asyncEnd || _asyncReady == _asyncQueue.size()) {
+				_asyncDecoding = false;
+				return;
+			}
+
+			frame = _asyncQueue[(_asyncRead + _asyncReady) % _asyncQueue.size()];
+		}
+
+		readNextPacket();
+		const Graphics::Surface *surface = _asyncTrack->decodeNextFrame();
+
+		// Copy the frame, as the track reuses its surface for the next one.
+		// The pool is only used by this thread while decoding in the
+		// background.
+		frame->hasSurface = (surface != 0);
+
+		if (surface) {
+			Graphics::Surface *dst = frame->surface;
+
+			if (!dst || dst->w != surface->w || dst->h != surface->h || dst->format != surface->format) {
+				_surfacePool.release(dst);
+				dst = frame->surface = _surfacePool.acquire(surface->w, surface->h, surface->format);
+			}
+
+			for (int y = 0; y < surface->h; y++)
+				memcpy(dst->getBasePtr(0, y), surface->getBasePtr(0, y), surface->w * surface->format.bytesPerPixel);
+		}
+
+		frame->dirtyPalette = _asyncTrack->hasDirtyPalette();
+
+		if (frame->dirtyPalette)
+			memcpy(frame->palette, _asyncTrack->getPalette(), sizeof(frame->palette));
+
+		frame->curFrame = _asyncTrack->getCurFrame();
+		frame->nextFrameStartTime = _asyncTrack->getNextFrameStartTime();
+		frame->endOfTrack = _asyncTrack->endOfTrack();
+
+		{
+			Common::StackLock lock(_asyncMutex);
+			_asyncReady++;
+			_asyncStats.decodedFrames++;
+
+			if (frame->endOfTrack)
+				_asyncEnd = true;
+		}
+
+		g_system->postSemaphore(_asyncReadySemaphore);
+	}
+}
+
+VideoDecoder::AsyncFrame *VideoDecoder::takeAsyncFrame() {
+	{
+		Common::StackLock lock(_asyncMutex);
+
+		if (!_asyncReady) {
+			if (_asyncEnd)
+				return 0;
+
+			// Without the background thread, all frames left are ready
+			assert(_asyncPool);
+			_asyncStats.lateFrames++;
+		}
+	}
+
+	// The frames are finished in order, so this waits for the next one
+	if (_asyncPool)
+		g_system->waitSemaphore(_asyncReadySemaphore);
+
+	Common::StackLock lock(_asyncMutex);
+
+	// Hand out the frame and put the previous one back into the queue
+	SWAP(_asyncQueue[_asyncRead], _asyncCurrent);
+	_asyncRead = (_asyncRead + 1) % _asyncQueue.size();
+	_asyncReady--;
+	return _asyncCurrent;
+}
+
+const Graphics::Surface *VideoDecoder::decodeNextFrameAsync() {
+	AsyncFrame *frame = takeAsyncFrame();
+
+	if (!frame)
+		return 0;
+
+	if (_asyncDropLateFrames) {
+		uint32 time = getTime();
+
+		while (!frame->endOfTrack && !frame->dirtyPalette && frame->nextFrameStartTime <= time) {
+			{
+				Common::StackLock lock(_asyncMutex);
+
+				if (!_asyncReady)
+					break;
+
+				_asyncStats.droppedFrames++;
+			}
+
+			frame = takeAsyncFrame();
+		}
+	}
+
+	if (_asyncPool)
+		startAsyncJob();
+
+	_asyncCurFrame = frame->curFrame;
+	_asyncNextFrameStartTime = frame->nextFrameStartTime;
+	_asyncEndOfTrack = frame->endOfTrack;
+
+	// The frame goes back into the queue with the next call
+	if (frame->dirtyPalette) {
+		memcpy(_asyncPalette, frame->palette, sizeof(_asyncPalette));
+		_palette = _asyncPalette;
+		_dirtyPalette = true;
+	}
+
+	// Like findNextVideoTrack() would do
+	if (frame->endOfTrack)
+		_nextVideoTrack = 0;
+
+	return frame->hasSurface ? frame->surface : 0;
+}
+
 } // End of namespace Video
@@ -26,9 +26,11 @@
 #include "audio/mixer.h"
 #include "audio/timestamp.h"	// TODO: Move this to common/ ?
 #include "common/array.h"
+#include "common/mutex.h"
 #include "common/rational.h"
 #include "common/str.h"
 #include "graphics/pixelformat.h"
+#include "graphics/surface_pool.h"
 
 namespace Audio {
 class AudioStream;
@@ -38,6 +40,7 @@ class SeekableAudioStream;
 
 namespace Common {
 class SeekableReadStream;
+class ThreadPool;
 }
 
 namespace Graphics {
@@ -52,7 +55,7 @@ namespace Video {
 class VideoDecoder {
 public:
 	VideoDecoder();
-	virtual ~VideoDecoder() {}
+	virtual ~VideoDecoder();
 
 	/////////////////////////////////////////
 	// Opening/Closing a Video
@@ -68,6 +71,16 @@ public:
 	 */
 	virtual bool loadFile(const Common::String &filename);
 
+	/**
+	 * Let the default loadFile() implementation read the file ahead on a
+	 * background thread, in blocks of the given size (see
+	 * Common::AsyncReadStream). This helps when playing videos from slow
+	 * storage. A size of 0, the default, reads the file directly.
+	 *
+	 * This must be set before calling loadFile().
+	 */
+	void setReadAheadBlockSize(uint32 blockSize) { _readAheadBlockSize = blockSize; }
+
 	/**
 	 * Load a video from a generic read stream. The ownership of the
 	 * stream object transfers to this VideoDecoder instance, which is
@@ -289,6 +302,20 @@ public:
 	 */
 	Graphics::PixelFormat getPixelFormat() const;
 
+	/**
+	 * Decode the frames of the loaded video straight to the given pixel
+	 * format, usually the screen format. This avoids converting every frame
+	 * again before it can be shown. Only formats with 2 or 4 bytes per
+	 * pixel are supported, and only by codecs converting from YUV.
+	 *
+	 * This must be called after loadStream() and before decoding the
+	 * first frame.
+	 *
+	 * @return true if the frames of all video tracks are decoded to the
+	 *         given format, false otherwise
+	 */
+	bool setOutputPixelFormat(const Graphics::PixelFormat &format);
+
 	/**
 	 * Get the duration of the video.
 	 *
@@ -344,6 +371,46 @@ public:
 	 */
 	virtual const Graphics::Surface *decodeNextFrame();
 
+	/**
+	 * Decode frames ahead on a background thread, so that decodeNextFrame()
+	 * usually just has to hand out a frame which is already there. Up to
+	 * queueLength decoded frames are kept in a queue of reusable surfaces.
+	 *
+	 * If dropLateFrames is set, decodeNextFrame() skips queued frames whose
+	 * successor is already due, so that playback catches up when the caller
+	 * falls behind. Frames changing the palette are never skipped.
+	 *
+	 * This only takes effect for videos with a single video track playing
+	 * forward, if the decoder supports it (see supportsAsyncDecoding()),
+	 * and only if the backend supports threads. Otherwise, frames
+	 * are decoded in decodeNextFrame() as usual. While frames are decoded in
+	 * the background, callers must stick to the functions of this class and
+	 * not access the tracks or any decoder specific state directly.
+	 *
+	 * @param queueLength		the number of frames to decode ahead, 0 to disable
+	 * @param dropLateFrames	whether to skip frames which are overdue
+	 */
+	void setAsyncDecoding(uint queueLength, bool dropLateFrames = false);
+
+	/**
+	 * Statistics about decoding frames in the background for the current
+	 * video, see setAsyncDecoding().
+	 */
+	struct AsyncDecodingStats {
+		/** The number of frames decoded by the background thread */
+		uint32 decodedFrames;
+		/** The number of frames decodeNextFrame() had to wait for */
+		uint32 lateFrames;
+		/** The number of frames skipped to catch up */
+		uint32 droppedFrames;
+	};
+
+	/**
+	 * Get the statistics about decoding frames in the background. They are
+	 * reset by close().
+	 */
+	AsyncDecodingStats getAsyncDecodingStats() const;
+
 	/**
 	 * Set the default high color format for videos that convert from YUV.
 	 *
@@ -519,6 +586,14 @@ protected:
 		 */
 		virtual Graphics::PixelFormat getPixelFormat() const = 0;
 
+		/**
+		 * Decode the frames to the given pixel format from now on.
+		 *
+		 * @see VideoDecoder::setOutputPixelFormat()
+		 * @return true if getPixelFormat() now returns the given format
+		 */
+		virtual bool setOutputPixelFormat(const Graphics::PixelFormat &format) { return false; }
+
 		/**
 		 * Get the current frame of this track
 		 *
@@ -771,6 +846,16 @@ protected:
 	 */
 	virtual bool useAudioSync() const { return true; }
 
+	/**
+	 * Whether frames may be decoded on a background thread, see
+	 * setAsyncDecoding().
+	 *
+	 * A subclass has to override this to disable it if it does any work
+	 * in decodeNextFrame() itself, or reads from the stream outside of
+	 * readNextPacket() and its tracks.
+	 */
+	virtual bool supportsAsyncDecoding() const { return true; }
+
 	/**
 	 * Get the given track based on its index.
 	 *
@@ -848,7 +933,58 @@ private:
 	// Default PixelFormat settings
 	Graphics::PixelFormat _defaultHighColorFormat;
 
+	// Block size for reading files ahead, 0 if disabled
+	uint32 _readAheadBlockSize;
+
+	// Decoding frames ahead, see setAsyncDecoding()
+	struct AsyncFrame {
+		Graphics::Surface *surface;
+		bool hasSurface;
+		int curFrame;
+		uint32 nextFrameStartTime;
+		bool endOfTrack;
+		bool dirtyPalette;
+		byte palette[256 * 3];
+	};
+
+	uint _asyncQueueLength;
+	bool _asyncDropLateFrames;
+	// Ring buffer of frames decoded ahead, and the frame last handed out
+	Common::Array<AsyncFrame *> _asyncQueue;
+	AsyncFrame *_asyncCurrent;
+	Graphics::SurfacePool _surfacePool;
+	// The palette of the frame last handed out, which outlives its AsyncFrame
+	byte _asyncPalette[256 * 3];
+	// Only set while frames are decoded in the background
+	Common::ThreadPool *_asyncPool;
+	// Set as long as frames decoded ahead are left to hand out
+	VideoTrack *_asyncTrack;
+	// Posted once for each decoded frame
+	OSystem::SemaphoreRef _asyncReadySemaphore;
+	// Shared with the background thread, protected by _asyncMutex
+	mutable Common::Mutex _asyncMutex;
+	uint _asyncRead, _asyncReady;
+	bool _asyncDecoding, _asyncEnd, _asyncStop;
+	AsyncDecodingStats _asyncStats;
+	// What the caller has seen of _asyncTrack so far
+	int _asyncCurFrame;
+	uint32 _asyncNextFrameStartTime;
+	bool _asyncEndOfTrack;
+
+	bool startAsyncDecoding();
+	void stopAsyncDecoding();
+	void discardAsyncFrames();
+	bool rewindAsyncDecoding();
+	void freeAsyncFrames();
+	void startAsyncJob();
+	static void asyncDecodeJob(void *param);
+	void decodeAsyncFrames();
+	AsyncFrame *takeAsyncFrame();
+	const Graphics::Surface *decodeNextFrameAsync();
+
 	// Internal helper functions
+	bool trackAtEnd(const Track *track) const;
+	uint32 trackNextFrameStartTime(const VideoTrack *track) const;
 	void stopAudio();
 	void startAudio();
 	void startAudioLimit(const Audio::Timestamp &limit);